@@ -1,17 +1,32 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome import automation
+from esphome.components import sensor
 from esphome.const import (
     CONF_ID,
+    CONF_SENSOR,
     CONF_TRIGGER_ID,
 )
-from esphome.core import coroutine_with_priority
+from esphome.core import CORE, coroutine_with_priority
+
+AUTO_LOAD = ["now_mqtt_protocol"]
 
 # =============================================================================
 # Configuration Keys
 # =============================================================================
 CONF_CHANNEL = "wifi_channel"
 CONF_LONG_RANGE = "long_range_mode"
+CONF_BATCH_WINDOW = "batch_window"
+CONF_REPORT_INTERVAL = "report_interval"
+CONF_PAIRING = "pairing"
+CONF_UNPAIR_AFTER_FAILURES = "unpair_after_failures"
+CONF_DEADBANDS = "deadbands"
+CONF_ABSOLUTE = "absolute"
+CONF_PERCENTAGE = "percentage"
+CONF_HEARTBEAT = "heartbeat"
+CONF_UPLOAD_EVERY = "upload_every"
+CONF_COMPACT_FRAMES = "compact_frames"
+MAX_DEADBANDS = 16
 CONF_ON_SEND = "on_sent"
 CONF_ON_SEND_SUCCESS = "on_send_success"
 CONF_ON_SEND_FAILURE = "on_send_failure"
@@ -39,7 +54,35 @@ ESPNowSendFailureTrigger = now_mqtt_ns.class_(
 # =============================================================================
 # Configuration Schema
 # =============================================================================
-CONFIG_SCHEMA = cv.Schema({
+DEADBAND_SCHEMA = cv.All(
+    cv.Schema({
+        cv.Required(CONF_SENSOR): cv.use_id(sensor.Sensor),
+        # Send when the value moved more than this (in the sensor's unit) ...
+        cv.Exclusive(CONF_ABSOLUTE, "threshold"): cv.positive_float,
+        # ... or more than this fraction of the last sent value
+        cv.Exclusive(CONF_PERCENTAGE, "threshold"): cv.positive_not_null_percentage,
+    }),
+    cv.has_exactly_one_key(CONF_ABSOLUTE, CONF_PERCENTAGE),
+)
+
+
+def validate_quiet_reporting(config):
+    for key in (CONF_DEADBANDS, CONF_UPLOAD_EVERY):
+        if key in config and CONF_REPORT_INTERVAL not in config:
+            raise cv.Invalid(
+                f"'{CONF_REPORT_INTERVAL}' is required with '{key}' so the bridge "
+                "knows how long the node may stay quiet"
+            )
+    if CONF_DEADBANDS in config:
+        sensors = [conf[CONF_SENSOR] for conf in config[CONF_DEADBANDS]]
+        if len(set(sensors)) != len(sensors):
+            raise cv.Invalid("Each sensor can only have one deadband")
+    if CONF_UPLOAD_EVERY in config and not CORE.is_esp32:
+        raise cv.Invalid(f"'{CONF_UPLOAD_EVERY}' needs ESP32 RTC memory")
+    return config
+
+
+CONFIG_SCHEMA = cv.All(cv.Schema({
     cv.GenerateID(): cv.declare_id(Now_MQTTComponent),
     
     # WiFi channel (1-14, default 1)
@@ -48,6 +91,32 @@ CONFIG_SCHEMA = cv.Schema({
     # Long range mode (default true for backward compatibility)
     cv.Optional(CONF_LONG_RANGE, default=True): cv.boolean,
     
+    # Coalesce readings into one frame for this long (omit to send each reading immediately)
+    cv.Optional(CONF_BATCH_WINDOW): cv.positive_time_period_milliseconds,
+    
+    # How often this node reports (e.g. its deep sleep cycle); tells the bridge when to mark it offline
+    cv.Optional(CONF_REPORT_INTERVAL): cv.All(
+        cv.positive_time_period_seconds, cv.Range(min=cv.TimePeriod(seconds=1), max=cv.TimePeriod(days=7))
+    ),
+    
+    # Learn the bridge MAC and send unicast with hardware ACKs (broadcast until paired)
+    cv.Optional(CONF_PAIRING, default=True): cv.boolean,
+    
+    # Consecutive failed frames before dropping the pairing and broadcasting again
+    cv.Optional(CONF_UNPAIR_AFTER_FAILURES, default=3): cv.int_range(min=1, max=20),
+    
+    # Change-only reporting: only send these sensors when they move past their deadband
+    cv.Optional(CONF_DEADBANDS): cv.All(cv.ensure_list(DEADBAND_SCHEMA), cv.Length(max=MAX_DEADBANDS)),
+    
+    # ... but send anyway after this many suppressed updates (one per wake with deep sleep)
+    cv.Optional(CONF_HEARTBEAT, default=10): cv.int_range(min=1, max=255),
+    
+    # Store-and-forward: keep readings in RTC memory and transmit only every Nth wake
+    cv.Optional(CONF_UPLOAD_EVERY): cv.int_range(min=1, max=255),
+    
+    # Refer to metadata the paired bridge already has by schema ID instead of resending it
+    cv.Optional(CONF_COMPACT_FRAMES, default=True): cv.boolean,
+    
     # Automation triggers
     cv.Optional(CONF_ON_SEND): automation.validate_automation({
         cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(ESPNowSendTrigger),
@@ -58,7 +127,7 @@ CONFIG_SCHEMA = cv.Schema({
     cv.Optional(CONF_ON_SEND_FAILURE): automation.validate_automation({
         cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(ESPNowSendFailureTrigger),
     }),
-})
+}), validate_quiet_reporting)
 
 # =============================================================================
 # Code Generation
@@ -71,6 +140,22 @@ async def to_code(config):
     # Set configuration options
     cg.add(var.set_wifi_channel(config[CONF_CHANNEL]))
     cg.add(var.set_long_range_mode(config[CONF_LONG_RANGE]))
+    if CONF_BATCH_WINDOW in config:
+        cg.add(var.set_batch_window(config[CONF_BATCH_WINDOW]))
+    if CONF_REPORT_INTERVAL in config:
+        cg.add(var.set_report_interval(config[CONF_REPORT_INTERVAL]))
+    cg.add(var.set_pairing(config[CONF_PAIRING]))
+    cg.add(var.set_unpair_after_failures(config[CONF_UNPAIR_AFTER_FAILURES]))
+    cg.add(var.set_heartbeat(config[CONF_HEARTBEAT]))
+    if CONF_UPLOAD_EVERY in config:
+        cg.add(var.set_upload_every(config[CONF_UPLOAD_EVERY]))
+    cg.add(var.set_compact_frames(config[CONF_COMPACT_FRAMES]))
+    for conf in config.get(CONF_DEADBANDS, []):
+        sens = await cg.get_variable(conf[CONF_SENSOR])
+        if CONF_PERCENTAGE in conf:
+            cg.add(var.add_deadband(sens, conf[CONF_PERCENTAGE], True))
+        else:
+            cg.add(var.add_deadband(sens, conf[CONF_ABSOLUTE], False))
     
     # Build automation triggers
     for conf in config.get(CONF_ON_SEND, []):
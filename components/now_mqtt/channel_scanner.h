@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace now_mqtt
+    {
+        // =============================================================================
+        // Channel Scanner
+        // =============================================================================
+        // Sweeps Wi-Fi channels 1-13 looking for a bridge, starting from a given channel
+        // and wrapping around. Channel 14 (Japan only) is swept only by a scan that
+        // starts there. Pure state machine with no radio access: whenever poll()
+        // returns a channel the caller tunes the radio there and sends a probe; a bridge
+        // reply is reported with on_reply(). Each channel gets dwell_ms to answer.
+        class ChannelScanner
+        {
+        public:
+            static constexpr uint8_t MIN_CHANNEL = 1;
+            static constexpr uint8_t MAX_CHANNEL = 14;
+            static constexpr uint8_t SWEEP_MAX_CHANNEL = 13;
+
+            struct Config {
+                uint32_t dwell_ms;
+                uint8_t max_sweeps;
+            };
+
+            explicit ChannelScanner(const Config &config) : config_(config) {}
+
+            static bool valid_channel(uint8_t channel) { return channel >= MIN_CHANNEL && channel <= MAX_CHANNEL; }
+
+            void start(uint8_t first_channel, uint32_t now)
+            {
+                this->first_ = valid_channel(first_channel) ? first_channel : MIN_CHANNEL;
+                this->count_ = std::max(this->first_, SWEEP_MAX_CHANNEL) - MIN_CHANNEL + 1;
+                this->probed_ = 0;
+                this->current_ = 0;
+                this->result_ = 0;
+                this->due_ms_ = now;
+                this->state_ = State::SCANNING;
+            }
+
+            // Channel to tune to and probe on now; 0 while waiting on the current channel,
+            // or once the scan has finished
+            uint8_t poll(uint32_t now)
+            {
+                if (this->state_ != State::SCANNING || static_cast<int32_t>(now - this->due_ms_) < 0) {
+                    return 0;
+                }
+                if (this->probed_ >= this->count_ * this->config_.max_sweeps) {
+                    this->state_ = State::EXHAUSTED;
+                    return 0;
+                }
+                this->current_ = MIN_CHANNEL + (this->first_ - MIN_CHANNEL + this->probed_) % this->count_;
+                this->probed_++;
+                this->due_ms_ = now + this->config_.dwell_ms;
+                return this->current_;
+            }
+
+            // A bridge answered; it reports the channel it is on (0 = the probed channel)
+            void on_reply(uint8_t bridge_channel)
+            {
+                if (this->state_ != State::SCANNING || this->current_ == 0) {
+                    return;
+                }
+                this->result_ = valid_channel(bridge_channel) ? bridge_channel : this->current_;
+                this->state_ = State::FOUND;
+            }
+
+            void cancel() { this->state_ = State::IDLE; }
+
+            bool scanning() const { return this->state_ == State::SCANNING; }
+            bool found() const { return this->state_ == State::FOUND; }
+            bool exhausted() const { return this->state_ == State::EXHAUSTED; }
+            uint8_t result() const { return this->result_; }
+            uint16_t probes() const { return this->probed_; }
+            uint8_t last_channel() const { return MIN_CHANNEL + this->count_ - 1; }
+
+        protected:
+            enum class State : uint8_t { IDLE, SCANNING, FOUND, EXHAUSTED };
+
+            Config config_;
+            State state_ = State::IDLE;
+            uint8_t first_ = MIN_CHANNEL;
+            uint8_t count_ = SWEEP_MAX_CHANNEL - MIN_CHANNEL + 1;  // Channels per sweep
+            uint8_t current_ = 0;
+            uint8_t result_ = 0;
+            uint16_t probed_ = 0;
+            uint32_t due_ms_ = 0;
+        };
+
+    } // namespace now_mqtt
+} // namespace esphome
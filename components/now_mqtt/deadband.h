@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace now_mqtt
+    {
+        // =============================================================================
+        // Deadband Filter
+        // =============================================================================
+        // Change-only reporting for numeric sensors. A reading is sent when it moved
+        // more than the threshold (absolute, or a fraction of the last sent value) away
+        // from the last value sent, or when the entity has been quiet for `heartbeat`
+        // updates in a row. TrackedValue lives in RTC memory, so "last sent" survives
+        // deep sleep and a node that wakes to an unchanged reading never starts the radio.
+        struct Deadband {
+            float threshold;
+            bool percentage;  // threshold is a fraction of |last sent|
+        };
+
+        struct TrackedValue {
+            float last;
+            uint8_t quiet;  // Updates suppressed since the last send
+            uint8_t valid;
+            uint8_t reserved[2];
+        };
+
+        // Decide whether value goes on the air; updates the tracked state either way.
+        // heartbeat 0 = never force a send.
+        inline bool deadband_should_send(TrackedValue &tracked, const Deadband &band, uint8_t heartbeat, float value)
+        {
+            bool send;
+            if (!tracked.valid) {
+                send = true;
+            } else if (std::isnan(value) || std::isnan(tracked.last)) {
+                // Sensor going unavailable (or coming back) is always a change
+                send = std::isnan(value) != std::isnan(tracked.last);
+            } else {
+                float limit = band.percentage ? std::fabs(tracked.last) * band.threshold : band.threshold;
+                send = std::fabs(value - tracked.last) > limit;
+            }
+
+            if (!send && heartbeat != 0 && tracked.quiet + 1 >= heartbeat) {
+                send = true;
+            }
+
+            if (send) {
+                tracked.last = value;
+                tracked.quiet = 0;
+                tracked.valid = 1;
+            } else if (tracked.quiet < UINT8_MAX) {
+                tracked.quiet++;
+            }
+            return send;
+        }
+
+    } // namespace now_mqtt
+} // namespace esphome
@@ -3,18 +3,25 @@
 #include "esphome/core/application.h"
 #include "esphome/core/version.h"
 #include <esphome/core/helpers.h>
+#include <algorithm>
 
 #ifdef USE_ESP32
 #include "Arduino.h"
 #include <esp_now.h>
 #include <WiFi.h>
 #include <esp_wifi.h>
+#include <esp_attr.h>
+#include <esp_idf_version.h>
+#include <sys/time.h>
 #endif
 
 #ifdef USE_ESP8266
 #include "Arduino.h"
 #include <espnow.h>
 #include <ESP8266WiFi.h>
+extern "C" {
+#include <user_interface.h>
+}
 #endif
 
 namespace esphome
@@ -26,6 +33,28 @@ namespace esphome
         // Static instance pointer for ESP-NOW callbacks
         Now_MQTTComponent *Now_MQTTComponent::instance_ = nullptr;
 
+        static const uint8_t BROADCAST_ADDRESS[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+#ifdef USE_ESP32
+        // Survive deep sleep; cleared on power-on
+        static RTC_DATA_ATTR LinkState rtc_link_state;
+        static RTC_DATA_ATTR ReportState rtc_report_state;
+        static RTC_DATA_ATTR StoreState rtc_store_state;
+        static RTC_DATA_ATTR SchemaState rtc_schema_state;
+        static RTC_DATA_ATTR SequenceState rtc_sequence_state;
+#endif
+
+        // Store ranges travel as send queue tags: begin offset in the high half, end in
+        // the low half. 0 (an empty range) marks a frame that carries no stored readings.
+        // TAG_ANNOUNCE marks a full frame whose schemas become known to the bridge once
+        // it is acknowledged (offsets stay below STORE_SIZE, so bit 31 is free).
+        static constexpr uint32_t TAG_ANNOUNCE = 0x80000000;
+        // Every fragment of a message but the last; only the last one reports success
+        static constexpr uint32_t TAG_FRAGMENT = 0x40000000;
+        static uint32_t make_store_tag(size_t begin, size_t end) { return (uint32_t(begin) << 16) | end; }
+        static size_t store_tag_begin(uint32_t tag) { return (tag & ~(TAG_ANNOUNCE | TAG_FRAGMENT)) >> 16; }
+        static size_t store_tag_end(uint32_t tag) { return tag & 0xFFFF; }
+
         // =============================================================================
         // Lifecycle Methods
         // =============================================================================
@@ -40,34 +69,164 @@ namespace esphome
             ESP_LOGD(TAG, "Setting up ESP-NOW MQTT component...");
             
             instance_ = this;
-            
-            this->init_esp_now_();
-            
-            if (this->is_failed()) {
+
+            if (!this->build_frame_header_()) {
                 return;
             }
-            
+
+            this->have_saved_link_ = this->load_link_state_();
+            this->load_sequence_state_();
+            this->load_report_state_();
+            this->begin_frame_();
             this->register_sensor_callbacks_();
+            this->load_store_();
+            this->load_schema_state_();
             
-            ESP_LOGI(TAG, "ESP-NOW MQTT initialized (channel=%d, long_range=%s)",
-                     this->wifi_channel_, this->long_range_mode_ ? "yes" : "no");
+            ESP_LOGI(TAG, "ESP-NOW MQTT initialized (long_range=%s, batch_window=%ums, %u deadband(s), upload_every=%u); "
+                     "radio starts with the first frame",
+                     this->long_range_mode_ ? "yes" : "no", this->batch_window_ms_,
+                     (unsigned) this->deadbands_.size(), this->upload_every_);
         }
 
         void Now_MQTTComponent::loop()
         {
-            // Nothing to do in loop - we send on sensor updates
+            // The staged MAC stays untouched until the flag is cleared
+            if (this->pair_pending_.load(std::memory_order_acquire)) {
+                if (this->scanner_.scanning()) {
+                    this->scanner_.on_reply(this->pending_channel_);
+                    this->process_scan_();
+                } else {
+                    this->misses_ = 0;
+                    this->pair_with_(this->pending_bridge_mac_);
+                }
+                this->pair_pending_.store(false, std::memory_order_release);
+            }
+
+            // The bridge lost our schemas (restarted without them, or replaced)
+            if (this->schema_request_pending_.exchange(false, std::memory_order_acq_rel)) {
+                ESP_LOGI(TAG, "Bridge asked for metadata, sending full frames");
+                this->reset_schema_state_();
+            }
+
+#ifdef USE_ESP8266
+            if (this->report_state_dirty_) {
+                this->save_report_state_();
+            }
+#endif
+
+            // Nothing is sent while the channel sweep runs; readings keep queuing
+            if (this->scanner_.scanning()) {
+                this->process_scan_();
+                if (this->scanner_.scanning()) {
+                    return;
+                }
+            }
+
+            // Flush a batched frame once its window expires
+            if (this->batch_window_ms_ > 0 && this->frame_writer_.count() > 0 &&
+                millis() - this->frame_started_ms_ >= this->batch_window_ms_) {
+                this->flush_frame_();
+            }
+
+            // Nodes that stay awake (or fill the store within one wake) upload from here
+            if (this->store_state_ != nullptr) {
+                if (!this->upload_active_ && this->store_upload_due_(false)) {
+                    this->start_upload_();
+                }
+                this->pump_upload_();
+            }
+
+            this->pump_fragments_();
+            this->process_send_queue_();
+        }
+
+        void Now_MQTTComponent::on_shutdown()
+        {
+            // Called by deep_sleep (via the shutdown hooks) right before the chip sleeps.
+            // The main loop no longer runs, so drive the queue here until it drains.
+            // An unfinished channel sweep is abandoned; the next wake starts it again.
+            if (this->scanner_.scanning()) {
+                this->scanner_.cancel();
+                this->set_channel_(this->channel_);
+            }
+            this->flush_frame_();
+
+            // Every Nth wake (or after a failed upload) the store goes out with this one
+            if (this->store_state_ != nullptr) {
+                if (this->store_state_->wakes < UINT8_MAX) {
+                    this->store_state_->wakes++;
+                }
+                if (!this->upload_active_ && this->store_upload_due_(true)) {
+                    this->start_upload_();
+                }
+            }
+
+            uint32_t start = millis();
+            while ((!this->send_queue_.idle() || this->upload_active_ || this->message_len_ != 0) &&
+                   millis() - start < SHUTDOWN_DRAIN_MS) {
+                this->pump_upload_();
+                this->pump_fragments_();
+                this->process_send_queue_();
+                delay(1);
+            }
+            if (this->upload_active_) {
+                // Out of time: whatever is still in flight is sent again next upload
+                this->upload_failed_ = true;
+                this->finish_upload_();
+            }
+#ifdef USE_ESP8266
+            if (this->report_state_dirty_) {
+                this->save_report_state_();
+            }
+#endif
         }
 
         // =============================================================================
         // Initialization Helpers
         // =============================================================================
 
+        bool Now_MQTTComponent::start_radio_()
+        {
+            if (this->radio_started_) {
+                return true;
+            }
+            if (this->is_failed()) {
+                return false;
+            }
+            uint32_t start = millis();
+
+            // Start on the channel a bridge last answered on, if known
+            const LinkState &state = this->saved_link_;
+            bool have_state = this->have_saved_link_;
+            this->channel_ = have_state ? state.channel : this->wifi_channel_;
+
+            this->init_esp_now_();
+            if (this->is_failed()) {
+                return false;
+            }
+            this->radio_started_ = true;
+
+            if (have_state && this->pairing_) {
+                this->misses_ = state.misses;
+                this->scans_ = state.scans;
+                memcpy(this->bridge_mac_, state.bridge_mac, 6);
+                if (state.paired) {
+                    this->pair_with_(state.bridge_mac);
+                }
+                // The previous wake(s) ended without reaching the bridge
+                if (this->misses_ >= this->unpair_after_failures_) {
+                    this->start_scan_();
+                }
+            }
+
+            ESP_LOGD(TAG, "Radio started on channel %u%s in %u ms", this->channel_,
+                     this->channel_ != this->wifi_channel_ ? " (cached)" : "", (unsigned) (millis() - start));
+            return true;
+        }
+
         void Now_MQTTComponent::init_esp_now_()
         {
 #ifdef USE_ESP32
-            uint8_t broadcast_address[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-            esp_now_peer_info_t peer_info = {};
-
             // Initialize WiFi stack (without connecting to AP)
             esp_err_t err;
             
@@ -96,7 +255,7 @@ namespace esphome
             ESP_ERROR_CHECK(esp_wifi_set_storage(WIFI_STORAGE_RAM));
             ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
             ESP_ERROR_CHECK(esp_wifi_start());
-            ESP_ERROR_CHECK(esp_wifi_set_channel(this->wifi_channel_, WIFI_SECOND_CHAN_NONE));
+            ESP_ERROR_CHECK(esp_wifi_set_channel(this->channel_, WIFI_SECOND_CHAN_NONE));
 
             // Initialize ESP-NOW
             if (esp_now_init() != ESP_OK) {
@@ -108,6 +267,20 @@ namespace esphome
             // Register send callback for delivery confirmation
             esp_now_register_send_cb(Now_MQTTComponent::send_callback_);
 
+            // Listen for the bridge's PAIR_ACK
+            if (this->pairing_) {
+                esp_wifi_get_mac(WIFI_IF_STA, this->own_mac_);
+#if ESP_IDF_VERSION_MAJOR >= 5
+                esp_now_register_recv_cb([](const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+                    on_control_frame_(info->src_addr, data, len);
+                });
+#else
+                esp_now_register_recv_cb([](const uint8_t *mac, const uint8_t *data, int len) {
+                    on_control_frame_(mac, data, len);
+                });
+#endif
+            }
+
             // Set long range mode if enabled
             if (this->long_range_mode_) {
                 esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_LR);
@@ -115,11 +288,7 @@ namespace esphome
             }
 
             // Add broadcast peer
-            memcpy(peer_info.peer_addr, broadcast_address, 6);
-            peer_info.channel = this->wifi_channel_;
-            peer_info.encrypt = false;
-
-            if (esp_now_add_peer(&peer_info) != ESP_OK) {
+            if (!this->add_peer_(BROADCAST_ADDRESS)) {
                 ESP_LOGE(TAG, "Failed to add broadcast peer");
                 this->mark_failed();
                 return;
@@ -127,10 +296,9 @@ namespace esphome
 #endif
 
 #ifdef USE_ESP8266
-            uint8_t broadcast_address[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-            
             WiFi.mode(WIFI_STA);
             WiFi.disconnect();
+            wifi_set_channel(this->channel_);
             
             if (esp_now_init() != 0) {
                 ESP_LOGE(TAG, "esp_now_init failed");
@@ -139,234 +307,1101 @@ namespace esphome
             }
             
             esp_now_set_self_role(ESP_NOW_ROLE_COMBO);
-            esp_now_add_peer(broadcast_address, ESP_NOW_ROLE_COMBO, this->wifi_channel_, NULL, 0);
+            esp_now_register_send_cb([](uint8_t *mac_addr, uint8_t status) {
+                if (instance_ != nullptr) {
+                    instance_->send_queue_.on_send_complete(status == 0);
+                }
+            });
+            if (this->pairing_) {
+                WiFi.macAddress(this->own_mac_);
+                esp_now_register_recv_cb([](uint8_t *mac, uint8_t *data, uint8_t len) {
+                    on_control_frame_(mac, data, len);
+                });
+            }
+            this->add_peer_(BROADCAST_ADDRESS);
 #endif
         }
 
         void Now_MQTTComponent::register_sensor_callbacks_()
         {
-            // Register callbacks for all sensors
+            // Everything constant about an entity is encoded here, once; the state
+            // callbacks below only append a value to the pending frame.
             for (auto *obj : App.get_sensors()) {
-                obj->add_on_state_callback([this, obj](float state) {
-                    this->on_sensor_update(obj, state);
+                std::string device_class = obj->get_device_class();
+                std::string state_class = state_class_to_string(obj->get_state_class());
+                std::string unit = obj->get_unit_of_measurement();
+                std::string icon = obj->get_icon();
+
+                now_mqtt_protocol::EntityMeta meta;
+                meta.device_class = device_class;
+                meta.state_class = state_class;
+                meta.unit = unit;
+                meta.icon = icon;
+                meta.accuracy = obj->get_accuracy_decimals();
+                meta.has_accuracy = true;
+
+                int entity = this->add_entity_(now_mqtt_protocol::ReadingType::SENSOR, obj->get_name(), meta);
+                if (entity < 0) {
+                    continue;
+                }
+                for (size_t i = 0; i < this->deadbands_.size(); i++) {
+                    if (this->deadbands_[i].sensor == obj) {
+                        this->entities_[entity].tracked = i;
+                    }
+                }
+                obj->add_on_state_callback([this, obj, entity](float state) {
+                    this->on_sensor_update(obj, entity, state);
                 });
             }
 
 #ifdef USE_BINARY_SENSOR
             for (auto *obj : App.get_binary_sensors()) {
-                obj->add_on_state_callback([this, obj](bool state) {
-                    this->on_binary_sensor_update(obj, state);
+                std::string device_class = obj->get_device_class();
+                std::string icon = obj->get_icon();
+
+                now_mqtt_protocol::EntityMeta meta;
+                meta.device_class = device_class;
+                meta.icon = icon;
+
+                int entity = this->add_entity_(now_mqtt_protocol::ReadingType::BINARY_SENSOR, obj->get_name(), meta);
+                if (entity < 0) {
+                    continue;
+                }
+                obj->add_on_state_callback([this, obj, entity](bool state) {
+                    this->on_binary_sensor_update(obj, entity, state);
                 });
             }
 #endif
 
 #ifdef USE_TEXT_SENSOR
             for (auto *obj : App.get_text_sensors()) {
-                obj->add_on_state_callback([this, obj](std::string state) {
-                    this->on_text_sensor_update(obj, state);
+                std::string icon = obj->get_icon();
+
+                now_mqtt_protocol::EntityMeta meta;
+                meta.icon = icon;
+
+                int entity = this->add_entity_(now_mqtt_protocol::ReadingType::TEXT_SENSOR, obj->get_name(), meta);
+                if (entity < 0) {
+                    continue;
+                }
+                obj->add_on_state_callback([this, obj, entity](const std::string &state) {
+                    this->on_text_sensor_update(obj, entity, state);
                 });
             }
 #endif
+
+            // Schema references for compact frames
+            for (size_t i = 0; i < this->entities_.size() && i < MAX_COMPACT_ENTITIES; i++) {
+                EntityDescriptor &entity = this->entities_[i];
+                if (entity.prefix_len > now_mqtt_protocol::MAX_SCHEMA_SIZE) {
+                    continue;
+                }
+                now_mqtt_protocol::RecordPrefix prefix = this->full_prefix_(i);
+                uint32_t schema = now_mqtt_protocol::schema_id(prefix.data, prefix.len);
+                entity.compact = now_mqtt_protocol::encode_schema_ref(entity.schema_ref, sizeof(entity.schema_ref),
+                                                                      schema) != 0;
+            }
+
+            this->prefix_arena_.shrink_to_fit();
+            this->entities_.shrink_to_fit();
+            ESP_LOGD(TAG, "Encoded %u entity prefixes (%u bytes)",
+                     (unsigned) this->entities_.size(), (unsigned) this->prefix_arena_.size());
         }
 
         // =============================================================================
         // Send Methods
         // =============================================================================
 
+#ifdef USE_ESP32
         void Now_MQTTComponent::send_callback_(const uint8_t *mac_addr, esp_now_send_status_t status)
         {
+            // Runs in the Wi-Fi task: only hand the status over to the send queue
             if (instance_ != nullptr) {
-                instance_->last_send_success_ = (status == ESP_NOW_SEND_SUCCESS);
-                instance_->send_in_progress_ = false;
+                instance_->send_queue_.on_send_complete(status == ESP_NOW_SEND_SUCCESS);
             }
         }
+#endif
 
-        bool Now_MQTTComponent::send_with_retry_(const uint8_t *data, size_t len)
+        void Now_MQTTComponent::process_send_queue_()
         {
-            uint8_t broadcast_address[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-            
-            for (uint8_t attempt = 0; attempt <= MAX_RETRIES; attempt++) {
-                if (attempt > 0) {
-                    ESP_LOGD(TAG, "Retry attempt %d/%d", attempt, MAX_RETRIES);
-                    delay(RETRY_DELAY_MS);
-                }
-                
-                this->send_in_progress_ = true;
-                this->last_send_success_ = false;
-                
+            this->send_queue_.process(
+                millis(),
+                [this](const uint8_t *data, size_t len) { return this->transmit_(data, len); },
+                [this](bool success, uint32_t tag) { this->send_completed_(success, tag); });
+        }
+
+        bool Now_MQTTComponent::transmit_(const uint8_t *data, size_t len)
+        {
+            const uint8_t *destination = this->paired_ ? this->bridge_mac_ : BROADCAST_ADDRESS;
+
 #ifdef USE_ESP32
-                esp_err_t result = esp_now_send(broadcast_address, data, len);
-                if (result != ESP_OK) {
-                    ESP_LOGW(TAG, "esp_now_send failed: %s", esp_err_to_name(result));
-                    this->send_in_progress_ = false;
-                    continue;
+            esp_err_t result = esp_now_send(destination, data, len);
+            if (result != ESP_OK) {
+                ESP_LOGW(TAG, "esp_now_send failed: %s", esp_err_to_name(result));
+                return false;
+            }
+#endif
+
+#ifdef USE_ESP8266
+            int result = esp_now_send(const_cast<uint8_t*>(destination), const_cast<uint8_t*>(data), len);
+            if (result != 0) {
+                ESP_LOGW(TAG, "esp_now_send failed: %d", result);
+                return false;
+            }
+#endif
+
+            return true;
+        }
+
+        void Now_MQTTComponent::send_completed_(bool success, uint32_t tag)
+        {
+            if (tag & TAG_FRAGMENT) {
+                if (success) {
+                    return;
+                }
+                tag &= ~TAG_FRAGMENT;
+            }
+
+            // Only the paired bridge acknowledges a frame, so only then is it known to
+            // hold the schemas of a full frame
+            if (tag & TAG_ANNOUNCE) {
+                if (success && this->paired_) {
+                    this->schema_delivered_();
+                } else {
+                    memset(this->announcing_, 0, sizeof(this->announcing_));
+                }
+                tag &= ~TAG_ANNOUNCE;
+            }
+
+            // A stored range is delivered, or stays in the store for the next upload
+            bool stored = tag != 0;
+            if (stored && this->upload_active_) {
+                if (success) {
+                    this->store_.mark(store_tag_begin(tag), store_tag_end(tag), ReadingStore::DELIVERED);
+                } else {
+                    this->upload_failed_ = true;
+                }
+            }
+
+            if (success) {
+                this->delivered_++;
+                this->send_success_callback_.call();
+            } else {
+                this->failed_++;
+                ESP_LOGW(TAG, "Send failed after %d attempts", MAX_RETRIES + 1);
+                // The bridge may have missed a change; resend every tracked sensor next time
+                // (stored readings are kept and resent anyway)
+                if (!stored) {
+                    this->invalidate_report_state_();
+                }
+                this->send_failure_callback_.call();
+            }
+
+            // Broadcasts always "succeed"; unpaired, a frame only counts as heard once
+            // the bridge answers its pair request. A bridge that never does (pairing
+            // off, or an older firmware) gets a bounded number of scans, not endless ones.
+            if (this->paired_ && success) {
+                if (this->misses_ != 0) {
+                    this->misses_ = 0;
+                    this->save_link_state_();
+                }
+            } else if (this->pairing_ && (this->paired_ || this->scans_ < MAX_UNANSWERED_SCANS)) {
+                this->note_miss_();
+            }
+        }
+
+        // =============================================================================
+        // Bridge Pairing
+        // =============================================================================
+
+        void Now_MQTTComponent::on_control_frame_(const uint8_t *mac, const uint8_t *data, int len)
+        {
+            // Runs in the Wi-Fi task: validate and stage the bridge MAC for loop()
+            if (instance_ == nullptr || len <= 0 || instance_->pair_pending_.load(std::memory_order_acquire)) {
+                return;
+            }
+
+            uint8_t node_mac[6];
+            if (now_mqtt_protocol::decode_schema_request(data, len, node_mac)) {
+                if (memcmp(node_mac, instance_->own_mac_, 6) == 0 && memcmp(mac, instance_->bridge_mac_, 6) == 0) {
+                    instance_->schema_request_pending_.store(true, std::memory_order_release);
+                }
+                return;
+            }
+
+            uint8_t channel;
+            if (!now_mqtt_protocol::decode_pair_ack(data, len, node_mac, &channel) ||
+                memcmp(node_mac, instance_->own_mac_, 6) != 0) {
+                return;
+            }
+
+            memcpy(instance_->pending_bridge_mac_, mac, 6);
+            instance_->pending_channel_ = channel;
+            instance_->pair_pending_.store(true, std::memory_order_release);
+        }
+
+        void Now_MQTTComponent::pair_with_(const uint8_t *mac)
+        {
+            if (!this->paired_ || memcmp(mac, this->bridge_mac_, 6) != 0) {
+                if (this->paired_) {
+                    this->remove_peer_(this->bridge_mac_);
                 }
+                if (!this->add_peer_(mac)) {
+                    ESP_LOGW(TAG, "Failed to add bridge peer, staying on broadcast");
+                    this->paired_ = false;
+                    return;
+                }
+                // A different bridge has none of our schemas
+                if (memcmp(mac, this->bridge_mac_, 6) != 0) {
+                    this->reset_schema_state_();
+                }
+                memcpy(this->bridge_mac_, mac, 6);
+                this->paired_ = true;
+                this->scans_ = 0;
+                ESP_LOGI(TAG, "Paired with bridge %02X:%02X:%02X:%02X:%02X:%02X on channel %u, sending unicast",
+                         mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], this->channel_);
+            }
+            this->save_link_state_();
+        }
+
+        void Now_MQTTComponent::unpair_()
+        {
+            this->remove_peer_(this->bridge_mac_);
+            this->paired_ = false;
+            this->save_link_state_();
+        }
+
+        void Now_MQTTComponent::note_miss_()
+        {
+            if (this->misses_ < UINT8_MAX) {
+                this->misses_++;
+            }
+            if (this->misses_ < this->unpair_after_failures_) {
+                this->save_link_state_();
+                return;
+            }
+
+            // The bridge stopped answering (moved channel, offline, replaced): forget it and
+            // look for it, starting on the current channel
+            if (this->paired_) {
+                ESP_LOGW(TAG, "Bridge not acknowledging after %u failed frames, falling back to broadcast",
+                         this->misses_);
+                this->unpair_();
+            }
+            if (!this->scanner_.scanning()) {
+                this->start_scan_();
+            }
+        }
+
+        bool Now_MQTTComponent::load_link_state_()
+        {
+            LinkState *state = &this->saved_link_;
+#ifdef USE_ESP32
+            *state = rtc_link_state;
+#endif
+#ifdef USE_ESP8266
+            this->link_pref_ = global_preferences->make_preference<LinkState>(
+                fnv1_hash("now_mqtt_link"), false);  // RTC memory on ESP8266
+            if (!this->link_pref_.load(state)) {
+                return false;
+            }
 #endif
+            return state->magic == LINK_STATE_MAGIC && state->configured_channel == this->wifi_channel_ &&
+                   ChannelScanner::valid_channel(state->channel);
+        }
 
+        void Now_MQTTComponent::save_link_state_()
+        {
+            LinkState state = {};
+            state.magic = LINK_STATE_MAGIC;
+            memcpy(state.bridge_mac, this->bridge_mac_, 6);
+            state.channel = this->channel_;
+            state.configured_channel = this->wifi_channel_;
+            state.paired = this->paired_;
+            state.misses = this->misses_;
+            state.scans = this->scans_;
+#ifdef USE_ESP32
+            rtc_link_state = state;
+#endif
 #ifdef USE_ESP8266
-                int result = esp_now_send(broadcast_address, const_cast<uint8_t*>(data), len);
-                if (result != 0) {
-                    ESP_LOGW(TAG, "esp_now_send failed: %d", result);
-                    this->send_in_progress_ = false;
+            this->link_pref_.save(&state);
+#endif
+        }
+
+        // =============================================================================
+        // Change-Only Reporting
+        // =============================================================================
+
+        void Now_MQTTComponent::load_report_state_()
+        {
+            if (this->deadbands_.size() > MAX_DEADBANDS) {
+                ESP_LOGW(TAG, "Only the first %u deadbands are used", (unsigned) MAX_DEADBANDS);
+                this->deadbands_.resize(MAX_DEADBANDS);
+            }
+
+            // Identify what the stored values belong to: sensor names, thresholds, heartbeat
+            std::string layout_key = std::to_string(this->heartbeat_);
+            for (const auto &deadband : this->deadbands_) {
+                char threshold[24];
+                snprintf(threshold, sizeof(threshold), ":%g%c:", deadband.band.threshold,
+                         deadband.band.percentage ? '%' : 'a');
+                layout_key += threshold;
+                layout_key += deadband.sensor->get_name();
+            }
+            uint32_t layout = fnv1_hash(layout_key);
+
+#ifdef USE_ESP32
+            this->report_state_ = &rtc_report_state;
+#endif
+#ifdef USE_ESP8266
+            this->report_state_ = &this->report_state_storage_;
+            this->report_pref_ = global_preferences->make_preference<ReportState>(
+                fnv1_hash("now_mqtt_report"), false);  // RTC memory on ESP8266
+            if (!this->report_pref_.load(this->report_state_)) {
+                this->report_state_->magic = 0;
+            }
+#endif
+
+            if (this->report_state_->magic != REPORT_STATE_MAGIC || this->report_state_->layout != layout) {
+                *this->report_state_ = {};
+                this->report_state_->magic = REPORT_STATE_MAGIC;
+                this->report_state_->layout = layout;
+            }
+        }
+
+        void Now_MQTTComponent::save_report_state_()
+        {
+            // ESP32 writes RTC memory directly; ESP8266 goes through its RTC preference
+#ifdef USE_ESP8266
+            this->report_pref_.save(this->report_state_);
+            this->report_state_dirty_ = false;
+#endif
+        }
+
+        void Now_MQTTComponent::invalidate_report_state_()
+        {
+            if (this->deadbands_.empty()) {
+                return;
+            }
+            for (auto &tracked : this->report_state_->values) {
+                tracked.valid = 0;
+            }
+#ifdef USE_ESP8266
+            this->report_state_dirty_ = true;
+#endif
+        }
+
+        // =============================================================================
+        // Store-and-Forward
+        // =============================================================================
+        // A wake that does not upload never starts the radio. An upload turns the
+        // store's PENDING entries into frames as send queue slots free up (oldest
+        // first, each record carrying its age), and completions mark each frame's
+        // range DELIVERED. Once everything has completed the store is compacted.
+
+        void Now_MQTTComponent::load_store_()
+        {
+            if (this->upload_every_ == 0) {
+                return;
+            }
+#ifdef USE_ESP32
+            // Entries refer to entities by index; a different entity set discards them
+            std::string prefixes(this->prefix_arena_.begin(), this->prefix_arena_.end());
+            uint32_t layout = fnv1_hash(prefixes);
+
+            this->store_state_ = &rtc_store_state;
+            if (this->store_state_->magic != STORE_STATE_MAGIC || this->store_state_->layout != layout) {
+                *this->store_state_ = {};
+                this->store_state_->magic = STORE_STATE_MAGIC;
+                this->store_state_->layout = layout;
+            }
+            this->store_.init(this->store_state_->data, STORE_SIZE, &this->store_state_->used);
+            this->store_.compact();  // An upload cut short by a reset leaves SENT entries
+
+            ESP_LOGD(TAG, "Store: %u reading(s) (%u/%u bytes), wake %u of %u, %u dropped",
+                     (unsigned) this->store_.count(ReadingStore::PENDING), (unsigned) this->store_.used(),
+                     (unsigned) STORE_SIZE, this->store_state_->wakes + 1, this->upload_every_,
+                     (unsigned) this->store_state_->dropped);
+#else
+            ESP_LOGW(TAG, "Store-and-forward needs ESP32 RTC memory, sending readings as they arrive");
+            this->upload_every_ = 0;
+#endif
+        }
+
+        void Now_MQTTComponent::store_reading_(uint16_t entity, const void *value, uint8_t len)
+        {
+            uint32_t now_s = store_clock_s_();
+            if (this->store_.append(entity, now_s, value, len)) {
+                return;
+            }
+
+            // Full. Offsets must stay put while an upload is in flight; otherwise make
+            // room by dropping the oldest readings.
+            bool stored = false;
+            if (!this->upload_active_) {
+                this->store_.compact();
+                while (!(stored = this->store_.append(entity, now_s, value, len)) && this->store_.drop_oldest()) {
+                    this->store_state_->dropped++;
+                }
+            }
+            if (!stored) {
+                this->store_state_->dropped++;
+            }
+            ESP_LOGW(TAG, "Store full, %u reading(s) dropped so far", (unsigned) this->store_state_->dropped);
+        }
+
+        bool Now_MQTTComponent::store_upload_due_(bool sleeping) const
+        {
+            if (this->store_.empty()) {
+                return false;
+            }
+            if (this->store_.used() * 100 >= this->store_.capacity() * STORE_UPLOAD_FILL_PERCENT) {
+                return true;
+            }
+            if (sleeping) {
+                return this->store_state_->wakes >= this->upload_every_ || this->store_state_->retry;
+            }
+
+            // Awake for a whole upload period (a node that does not deep sleep)
+            ReadingStore::Entry oldest;
+            return this->store_.read(0, &oldest) && this->report_interval_s_ > 0 &&
+                   store_clock_s_() - oldest.time_s >= this->report_interval_s_ * this->upload_every_;
+        }
+
+        void Now_MQTTComponent::start_upload_()
+        {
+            ESP_LOGD(TAG, "Uploading %u stored reading(s)", (unsigned) this->store_.count(ReadingStore::PENDING));
+            this->upload_active_ = true;
+            this->upload_cursor_ = 0;
+            this->upload_failed_ = false;
+        }
+
+        void Now_MQTTComponent::pump_upload_()
+        {
+            if (!this->upload_active_) {
+                return;
+            }
+
+            uint32_t now_s = store_clock_s_();
+            ReadingStore::Entry entry;
+            while (this->send_queue_.available() > 0 && this->store_.read(this->upload_cursor_, &entry)) {
+                // Fill one frame with the next run of stored readings; the first one
+                // decides whether the frame is compact
+                this->frame_compact_ = entry.entity < this->entities_.size() && this->compact_ready_(entry.entity);
+                this->begin_frame_();
+                size_t begin = this->upload_cursor_;
+                size_t end = begin;
+                while (this->store_.read(end, &entry)) {
+                    if (!this->add_stored_(entry, now_s)) {
+                        if (this->frame_writer_.count() > 0) {
+                            break;
+                        }
+                        // Does not fit even an empty frame; nothing will ever deliver it
+                        this->store_.mark(end, entry.next, ReadingStore::DELIVERED);
+                        this->store_state_->dropped++;
+                        ESP_LOGW(TAG, "Stored reading of %u bytes does not fit a frame, dropped", entry.len);
+                        begin = entry.next;
+                    }
+                    end = entry.next;
+                }
+                this->upload_cursor_ = end;
+                if (this->frame_writer_.count() == 0) {
                     continue;
                 }
+                this->store_.mark(begin, end, ReadingStore::SENT);
+                this->flush_frame_(make_store_tag(begin, end));
+            }
+
+            // Everything built and completed
+            if (!this->store_.read(this->upload_cursor_, &entry) && this->send_queue_.idle()) {
+                this->finish_upload_();
+            }
+        }
+
+        void Now_MQTTComponent::finish_upload_()
+        {
+            this->upload_active_ = false;
+            this->store_.compact();
+            this->store_state_->retry = this->upload_failed_ && !this->store_.empty();
+            this->store_state_->wakes = 0;
+            if (this->store_state_->retry) {
+                ESP_LOGW(TAG, "Upload incomplete, %u reading(s) kept for the next wake",
+                         (unsigned) this->store_.count(ReadingStore::PENDING));
+            } else {
+                ESP_LOGD(TAG, "Upload complete");
+            }
+        }
+
+        bool Now_MQTTComponent::add_stored_(const ReadingStore::Entry &entry, uint32_t now_s)
+        {
+            if (entry.entity >= this->entities_.size() || this->compact_ready_(entry.entity) != this->frame_compact_) {
+                return false;
+            }
+            now_mqtt_protocol::RecordPrefix prefix = this->prefix_(entry.entity);
+            uint32_t age_s = now_s - entry.time_s;
+
+            bool added = false;
+            switch (static_cast<now_mqtt_protocol::ReadingType>(this->full_prefix_(entry.entity).data[0])) {
+                case now_mqtt_protocol::ReadingType::SENSOR: {
+                    float value;
+                    if (entry.len != sizeof(value)) {
+                        return false;
+                    }
+                    memcpy(&value, entry.value, sizeof(value));
+                    added = this->frame_writer_.add_sensor(prefix, value, age_s);
+                    break;
+                }
+                case now_mqtt_protocol::ReadingType::BINARY_SENSOR:
+                    added = entry.len == 1 && this->frame_writer_.add_binary_sensor(prefix, entry.value[0] != 0, age_s);
+                    break;
+                case now_mqtt_protocol::ReadingType::TEXT_SENSOR:
+                    added = this->frame_writer_.add_text_sensor(
+                        prefix, std::string_view(reinterpret_cast<const char *>(entry.value), entry.len), age_s);
+                    break;
+            }
+            if (added) {
+                this->entity_staged_(entry.entity);
+            }
+            return added;
+        }
+
+        uint32_t Now_MQTTComponent::store_clock_s_()
+        {
+#ifdef USE_ESP32
+            // ESP-IDF keeps system time running through deep sleep (RTC timer)
+            struct timeval tv;
+            gettimeofday(&tv, nullptr);
+            return tv.tv_sec;
+#else
+            return millis() / 1000;
 #endif
-                
-                // Wait for send callback (with timeout)
-                uint32_t start = millis();
-                while (this->send_in_progress_ && (millis() - start) < 100) {
-                    delay(1);
+        }
+
+        // =============================================================================
+        // Compact Frames
+        // =============================================================================
+        // Once the bridge has acknowledged a full frame, readings of the entities it
+        // carried go out as schema references: 4 bytes instead of name and metadata.
+        // Until then, and for anything the bridge asks for again, frames stay full.
+
+        void Now_MQTTComponent::load_schema_state_()
+        {
+            if (!this->compact_frames_ || this->compact_header_.empty() || !this->pairing_) {
+                return;
+            }
+
+            // Identify the schemas the announced bits refer to
+            uint32_t layout = now_mqtt_protocol::schema_id(this->node_block_().data, this->node_block_().len);
+            for (const auto &entity : this->entities_) {
+                layout = layout * 31 + entity.compact;
+                for (uint8_t byte : entity.schema_ref) {
+                    layout = layout * 31 + byte;
                 }
-                
-                if (this->last_send_success_) {
-                    this->send_success_callback_.call();
-                    return true;
+            }
+
+#ifdef USE_ESP32
+            this->schema_state_ = &rtc_schema_state;
+#endif
+#ifdef USE_ESP8266
+            this->schema_state_ = &this->schema_state_storage_;
+            this->schema_pref_ = global_preferences->make_preference<SchemaState>(
+                fnv1_hash("now_mqtt_schema"), false);  // RTC memory on ESP8266
+            if (!this->schema_pref_.load(this->schema_state_)) {
+                this->schema_state_->magic = 0;
+            }
+#endif
+
+            if (this->schema_state_->magic != SCHEMA_STATE_MAGIC || this->schema_state_->layout != layout) {
+                *this->schema_state_ = {};
+                this->schema_state_->magic = SCHEMA_STATE_MAGIC;
+                this->schema_state_->layout = layout;
+                this->save_schema_state_();
+            }
+        }
+
+        void Now_MQTTComponent::save_schema_state_()
+        {
+#ifdef USE_ESP8266
+            this->schema_pref_.save(this->schema_state_);
+#endif
+        }
+
+        void Now_MQTTComponent::reset_schema_state_()
+        {
+            memset(this->announcing_, 0, sizeof(this->announcing_));
+            if (this->schema_state_ == nullptr) {
+                return;
+            }
+            this->schema_state_->node_announced = 0;
+            memset(this->schema_state_->announced, 0, sizeof(this->schema_state_->announced));
+            this->save_schema_state_();
+        }
+
+        bool Now_MQTTComponent::compact_ready_(uint16_t entity) const
+        {
+            return this->schema_state_ != nullptr && this->schema_state_->node_announced &&
+                   this->entities_[entity].compact &&
+                   (this->schema_state_->announced[entity / 8] & (1 << (entity % 8)));
+        }
+
+        void Now_MQTTComponent::schema_delivered_()
+        {
+            // Entities from full frames still in flight are counted too; if one of those
+            // is lost, the bridge's SCHEMA_REQUEST brings the full frames back
+            bool changed = !this->schema_state_->node_announced;
+            this->schema_state_->node_announced = 1;
+            for (size_t i = 0; i < sizeof(this->announcing_); i++) {
+                changed |= (this->announcing_[i] & ~this->schema_state_->announced[i]) != 0;
+                this->schema_state_->announced[i] |= this->announcing_[i];
+                this->announcing_[i] = 0;
+            }
+            if (changed) {
+                this->save_schema_state_();
+            }
+        }
+
+        // =============================================================================
+        // Channel Discovery
+        // =============================================================================
+        // Happy path: the cached channel is used from setup() and nothing here runs.
+        // After unpair_after_failures misses the node sweeps 1-13 (and 14 when it
+        // starts there) with PROBE frames; the bridge answers with a PAIR_ACK carrying
+        // its channel.
+
+        void Now_MQTTComponent::start_scan_()
+        {
+            ESP_LOGW(TAG, "Searching for the bridge, starting on channel %u", this->channel_);
+            this->scanner_.start(this->channel_, millis());
+        }
+
+        void Now_MQTTComponent::process_scan_()
+        {
+            if (this->scanner_.found()) {
+                this->scanner_.cancel();
+                this->channel_ = this->scanner_.result();
+                this->set_channel_(this->channel_);
+                ESP_LOGI(TAG, "Bridge found on channel %u after %u probe(s)", this->channel_, this->scanner_.probes());
+                this->misses_ = 0;
+                this->pair_with_(this->pending_bridge_mac_);
+                return;
+            }
+
+            // The poll that finds the sweep over ends it here: loop() stops calling in once
+            // the scanner is no longer scanning
+            uint8_t channel = this->scanner_.poll(millis());
+            if (this->scanner_.exhausted()) {
+                this->scanner_.cancel();
+                ESP_LOGW(TAG, "No bridge answered on channels %u-%u, staying on channel %u",
+                         ChannelScanner::MIN_CHANNEL, this->scanner_.last_channel(), this->channel_);
+                this->set_channel_(this->channel_);
+                this->misses_ = 0;  // Try again after another run of misses
+                if (++this->scans_ == MAX_UNANSWERED_SCANS) {
+                    ESP_LOGW(TAG, "Giving up the search after %u scans; broadcasting until a bridge answers",
+                             MAX_UNANSWERED_SCANS);
                 }
+                this->save_link_state_();
+                return;
+            }
+
+            if (channel == 0) {
+                return;
+            }
+            this->set_channel_(channel);
+
+            uint8_t probe[now_mqtt_protocol::PROBE_SIZE];
+            size_t len = now_mqtt_protocol::encode_probe(probe, sizeof(probe));
+#ifdef USE_ESP32
+            bool sent = esp_now_send(BROADCAST_ADDRESS, probe, len) == ESP_OK;
+#endif
+#ifdef USE_ESP8266
+            bool sent = esp_now_send(const_cast<uint8_t *>(BROADCAST_ADDRESS), probe, len) == 0;
+#endif
+            if (sent) {
+                this->send_queue_.skip_ticket();
             }
-            
-            // All retries failed
-            this->send_failure_callback_.call();
-            ESP_LOGW(TAG, "Send failed after %d retries", MAX_RETRIES + 1);
-            return false;
+        }
+
+        void Now_MQTTComponent::set_channel_(uint8_t channel)
+        {
+#ifdef USE_ESP32
+            esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+#endif
+#ifdef USE_ESP8266
+            wifi_set_channel(channel);
+            esp_now_set_peer_channel(const_cast<uint8_t *>(BROADCAST_ADDRESS), channel);
+            if (this->paired_) {
+                esp_now_set_peer_channel(this->bridge_mac_, channel);
+            }
+#endif
+        }
+
+        bool Now_MQTTComponent::add_peer_(const uint8_t *mac)
+        {
+#ifdef USE_ESP32
+            esp_now_peer_info_t peer_info = {};
+            memcpy(peer_info.peer_addr, mac, 6);
+            peer_info.channel = 0;  // Follow the current channel
+            peer_info.encrypt = false;
+            return esp_now_add_peer(&peer_info) == ESP_OK;
+#endif
+#ifdef USE_ESP8266
+            return esp_now_add_peer(const_cast<uint8_t *>(mac), ESP_NOW_ROLE_COMBO, this->channel_, NULL, 0) == 0;
+#endif
+        }
+
+        void Now_MQTTComponent::remove_peer_(const uint8_t *mac)
+        {
+            esp_now_del_peer(const_cast<uint8_t *>(mac));
         }
 
         // =============================================================================
-        // Sensor Update Handlers
+        // Frame Encoding
         // =============================================================================
 
-        std::string Now_MQTTComponent::build_sensor_string_(sensor::Sensor *obj, float state)
+        bool Now_MQTTComponent::build_frame_header_()
         {
-            std::string line;
-            int8_t accuracy = obj->get_accuracy_decimals();
-            
-            line = str_snake_case(App.get_name());
-            line += FIELD_DELIMITER;
-            line += obj->get_device_class().c_str();
-            line += FIELD_DELIMITER;
-            line += state_class_to_string(obj->get_state_class()).c_str();
-            line += FIELD_DELIMITER;
-            line += str_snake_case(obj->get_name().c_str());
-            line += FIELD_DELIMITER;
-            line += obj->get_unit_of_measurement().c_str();
-            line += FIELD_DELIMITER;
-            line += value_accuracy_to_string(state, accuracy);
-            line += FIELD_DELIMITER;
-            
-            if (obj->get_icon().length() != 0) {
-                line += obj->get_icon();
-            } else {
-                line += FIELD_DELIMITER;
+            std::string node_name = str_snake_case(App.get_name());
+
+            now_mqtt_protocol::NodeInfo node;
+            node.name = node_name;
+            node.version = ESPHOME_VERSION;
+            node.board = ESPHOME_BOARD;
+            node.report_interval_s = this->report_interval_s_;
+            // With deadbands a healthy node may stay quiet for up to heartbeat reports;
+            // advertise that as its interval so the bridge does not mark it offline
+            if (!this->deadbands_.empty()) {
+                node.report_interval_s = std::min<uint64_t>(uint64_t(this->report_interval_s_) * this->heartbeat_,
+                                                            UINT32_MAX);
             }
-            
-            line += FIELD_DELIMITER;
-            line += ESPHOME_VERSION;
-            line += FIELD_DELIMITER;
-            line += ESPHOME_BOARD;
-            line += ":sensor:";
-            
-            return line;
+            // Likewise when only every Nth wake uploads
+            if (this->upload_every_ > 0) {
+                node.report_interval_s = std::min<uint64_t>(uint64_t(node.report_interval_s) * this->upload_every_,
+                                                            UINT32_MAX);
+            }
+
+            uint8_t header[now_mqtt_protocol::MAX_FRAME_SIZE];
+            now_mqtt_protocol::FrameWriter writer(header, sizeof(header));
+            if (!writer.begin(node, now_mqtt_protocol::FLAG_SEQUENCE)) {
+                ESP_LOGE(TAG, "Node name too long for frame header");
+                this->mark_failed();
+                return false;
+            }
+
+            this->frame_header_.assign(writer.data(), writer.data() + writer.size());
+
+            // Compact frames replace the node block with its schema ID
+            now_mqtt_protocol::RecordPrefix block = this->node_block_();
+            if (this->compact_frames_ && block.len <= now_mqtt_protocol::MAX_SCHEMA_SIZE &&
+                writer.begin_compact(now_mqtt_protocol::schema_id(block.data, block.len),
+                                     now_mqtt_protocol::FLAG_SEQUENCE)) {
+                this->compact_header_.assign(writer.data(), writer.data() + writer.size());
+            }
+            return true;
         }
 
-        void Now_MQTTComponent::on_sensor_update(sensor::Sensor *obj, float state)
+        int Now_MQTTComponent::add_entity_(now_mqtt_protocol::ReadingType type, const std::string &name,
+                                           const now_mqtt_protocol::EntityMeta &meta)
         {
-            if (!obj->has_state())
+            std::string object_id = str_snake_case(name);
+
+            uint8_t prefix[now_mqtt_protocol::MAX_FRAME_SIZE];
+            size_t len = now_mqtt_protocol::encode_record_prefix(prefix, sizeof(prefix), type, object_id, meta);
+            // Leave room for the largest fixed-width value (float32)
+            if (len == 0 || this->frame_header_.size() + len + 4 > now_mqtt_protocol::MAX_FRAME_SIZE) {
+                ESP_LOGW(TAG, "Metadata for '%s' does not fit in a frame, entity skipped", name.c_str());
+                return -1;
+            }
+
+            EntityDescriptor entity;
+            entity.prefix_offset = this->prefix_arena_.size();
+            entity.prefix_len = len;
+            this->prefix_arena_.insert(this->prefix_arena_.end(), prefix, prefix + len);
+            this->entities_.push_back(entity);
+            return this->entities_.size() - 1;
+        }
+
+        now_mqtt_protocol::RecordPrefix Now_MQTTComponent::node_block_() const
+        {
+            size_t offset = now_mqtt_protocol::FRAME_HEADER_SIZE + now_mqtt_protocol::SEQUENCE_SIZE;
+            return {this->frame_header_.data() + offset, this->frame_header_.size() - offset};
+        }
+
+        now_mqtt_protocol::RecordPrefix Now_MQTTComponent::full_prefix_(uint16_t entity) const
+        {
+            const EntityDescriptor &descriptor = this->entities_[entity];
+            return {this->prefix_arena_.data() + descriptor.prefix_offset, descriptor.prefix_len};
+        }
+
+        now_mqtt_protocol::RecordPrefix Now_MQTTComponent::prefix_(uint16_t entity) const
+        {
+            // What goes in front of the value in the pending frame
+            if (this->frame_compact_) {
+                return {this->entities_[entity].schema_ref, now_mqtt_protocol::SCHEMA_REF_SIZE};
+            }
+            return this->full_prefix_(entity);
+        }
+
+        void Now_MQTTComponent::begin_frame_()
+        {
+            const std::vector<uint8_t> &header = this->frame_compact_ ? this->compact_header_ : this->frame_header_;
+            this->frame_writer_.begin(header.data(), header.size());
+        }
+
+        void Now_MQTTComponent::load_sequence_state_()
+        {
+#ifdef USE_ESP32
+            this->sequence_state_ = &rtc_sequence_state;
+#endif
+#ifdef USE_ESP8266
+            this->sequence_state_ = &this->sequence_state_storage_;
+            this->sequence_pref_ = global_preferences->make_preference<SequenceState>(
+                fnv1_hash("now_mqtt_sequence"), false);  // RTC memory on ESP8266
+            if (!this->sequence_pref_.load(this->sequence_state_)) {
+                this->sequence_state_->magic = 0;
+            }
+#endif
+
+            // A wake from deep sleep carries on; a power cycle starts a new sequence
+            if (this->sequence_state_->magic != SEQUENCE_STATE_MAGIC) {
+                this->sequence_state_->magic = SEQUENCE_STATE_MAGIC;
+                this->sequence_state_->boot_id = random_uint32() & 0xFFFF;
+                this->sequence_state_->next_seq = 0;
+            }
+            ESP_LOGD(TAG, "Boot id %04X, next sequence %u", (unsigned) this->sequence_state_->boot_id,
+                     (unsigned) this->sequence_state_->next_seq);
+        }
+
+        uint16_t Now_MQTTComponent::take_sequence_()
+        {
+            uint16_t seq = this->sequence_state_->next_seq++;
+#ifdef USE_ESP8266
+            this->sequence_pref_.save(this->sequence_state_);
+#endif
+            return seq;
+        }
+
+        void Now_MQTTComponent::select_frame_mode_(uint16_t entity)
+        {
+            // Frames are either compact or full: switching sends what is pending first
+            bool compact = this->compact_ready_(entity);
+            if (compact == this->frame_compact_) {
                 return;
+            }
+            this->flush_frame_();
+            this->frame_compact_ = compact;
+            this->begin_frame_();
+        }
 
-            std::string line = this->build_sensor_string_(obj, state);
-            
-            ESP_LOGI(TAG, "Publishing: %s", line.c_str());
-            
-            this->send_with_retry_(reinterpret_cast<const uint8_t *>(line.c_str()), line.size());
-            this->callback_.call(state);
+        void Now_MQTTComponent::entity_staged_(uint16_t entity)
+        {
+            // A full record teaches the bridge this entity's schema once acknowledged
+            if (!this->frame_compact_ && this->entities_[entity].compact) {
+                this->announcing_[entity / 8] |= 1 << (entity % 8);
+            }
         }
 
-#ifdef USE_BINARY_SENSOR
-        std::string Now_MQTTComponent::build_binary_sensor_string_(binary_sensor::BinarySensor *obj, bool state)
-        {
-            std::string line;
-            const char *state_s = state ? "ON" : "OFF";
-
-            line = str_snake_case(App.get_name());
-            line += FIELD_DELIMITER;
-            line += obj->get_device_class().c_str();
-            line += FIELD_DELIMITER;
-            line += "binary_sensor";
-            line += FIELD_DELIMITER;
-            line += str_snake_case(obj->get_name().c_str());
-            line += FIELD_DELIMITER;
-            line += FIELD_DELIMITER;
-            line += state_s;
-            line += FIELD_DELIMITER;
-            
-            if (obj->get_icon().length() != 0) {
-                line += obj->get_icon();
-            } else {
-                line += FIELD_DELIMITER;
+        void Now_MQTTComponent::reading_staged_()
+        {
+            if (this->frame_writer_.count() == 1) {
+                this->frame_started_ms_ = millis();
             }
-            
-            line += FIELD_DELIMITER;
-            line += ESPHOME_VERSION;
-            line += FIELD_DELIMITER;
-            line += ESPHOME_BOARD;
-            line += "::";
-            
-            return line;
+
+            if (this->batch_window_ms_ == 0) {
+                this->flush_frame_();
+            }
+        }
+
+        void Now_MQTTComponent::flush_frame_(uint32_t tag)
+        {
+            if (this->frame_writer_.count() == 0) {
+                return;
+            }
+            if (!this->start_radio_()) {
+                this->begin_frame_();
+                return;
+            }
+
+            // Retries resend the same bytes, so they keep this sequence number
+            uint16_t seq = this->take_sequence_();
+            this->frame_writer_.set_sequence(this->sequence_state_->boot_id, seq);
+            this->frame_writer_.set_flag(now_mqtt_protocol::FLAG_PAIR_REQUEST, this->pairing_ && !this->paired_);
+            if (!this->frame_compact_ && this->schema_state_ != nullptr) {
+                tag |= TAG_ANNOUNCE;
+            }
+
+            ESP_LOGD(TAG, "Sending %u reading(s) in one %s frame (%u bytes, seq %u)", this->frame_writer_.count(),
+                     this->frame_compact_ ? "compact" : "full", (unsigned) this->frame_writer_.size(), seq);
+
+            if (!this->send_queue_.enqueue(this->frame_writer_.data(), this->frame_writer_.size(), millis(), tag)) {
+                ESP_LOGW(TAG, "Send queue full, dropping frame");
+                if ((tag & ~TAG_ANNOUNCE) == 0) {
+                    this->invalidate_report_state_();
+                } else {
+                    this->upload_failed_ = true;  // Its readings stay in the store
+                }
+                this->send_failure_callback_.call();
+            }
+            this->begin_frame_();
+        }
+
+        bool Now_MQTTComponent::send_fragmented_(uint16_t entity, std::string_view value)
+        {
+            // One message at a time; it goes out as fast as send queue slots free up
+            if (this->message_len_ != 0 || !this->start_radio_()) {
+                return false;
+            }
+            if (value.size() > UINT8_MAX) {
+                ESP_LOGW(TAG, "Text of %u bytes cut to %u", (unsigned) value.size(), (unsigned) UINT8_MAX);
+            }
+            const std::vector<uint8_t> &header = this->frame_compact_ ? this->compact_header_ : this->frame_header_;
+            now_mqtt_protocol::FrameWriter writer(this->message_buffer_, sizeof(this->message_buffer_));
+            if (!writer.begin(header.data(), header.size()) ||
+                !writer.add_text_sensor(this->prefix_(entity), value.substr(0, UINT8_MAX))) {
+                return false;
+            }
+            uint16_t seq = this->take_sequence_();
+            writer.set_sequence(this->sequence_state_->boot_id, seq);
+            writer.set_flag(now_mqtt_protocol::FLAG_PAIR_REQUEST, this->pairing_ && !this->paired_);
+
+            this->message_len_ = writer.size();
+            this->message_next_ = 0;
+            this->message_id_++;
+            ESP_LOGD(TAG, "Sending %u-byte message in %u fragments (seq %u)", (unsigned) this->message_len_,
+                     (unsigned) now_mqtt_protocol::fragment_count(this->message_len_), seq);
+            this->pump_fragments_();
+            return true;
         }
 
-        void Now_MQTTComponent::on_binary_sensor_update(binary_sensor::BinarySensor *obj, float state)
+        void Now_MQTTComponent::pump_fragments_()
+        {
+            uint8_t fragment[now_mqtt_protocol::MAX_FRAME_SIZE];
+            while (this->message_len_ != 0 && this->send_queue_.available() > 0) {
+                size_t total = now_mqtt_protocol::fragment_count(this->message_len_);
+                size_t len = now_mqtt_protocol::encode_fragment(fragment, sizeof(fragment), this->message_id_,
+                                                                this->message_buffer_, this->message_len_,
+                                                                this->message_next_);
+                bool last = this->message_next_ + 1u >= total;
+                if (len > 0) {
+                    this->send_queue_.enqueue(fragment, len, millis(), last ? 0 : TAG_FRAGMENT);
+                }
+                this->message_next_++;
+                if (last) {
+                    this->message_len_ = 0;
+                }
+            }
+        }
+
+        // =============================================================================
+        // Sensor Update Handlers
+        // =============================================================================
+        // Hot path: no heap allocation. Each handler copies the entity's pre-encoded
+        // prefix and value into the static frame buffer, or with store-and-forward
+        // appends the value to the RTC store.
+
+        void Now_MQTTComponent::on_sensor_update(sensor::Sensor *obj, uint16_t entity, float state)
         {
             if (!obj->has_state())
                 return;
 
-            std::string line = this->build_binary_sensor_string_(obj, state != 0.0f);
-            
-            ESP_LOGI(TAG, "Publishing: %s", line.c_str());
-            
-            this->send_with_retry_(reinterpret_cast<const uint8_t *>(line.c_str()), line.size());
+            uint8_t tracked = this->entities_[entity].tracked;
+            if (tracked != NOT_TRACKED &&
+                !deadband_should_send(this->report_state_->values[tracked], this->deadbands_[tracked].band,
+                                      this->heartbeat_, state)) {
+                this->suppressed_++;
+                ESP_LOGV(TAG, "Suppressed: %s = %f (within deadband)", obj->get_name().c_str(), state);
+#ifdef USE_ESP8266
+                this->report_state_dirty_ = true;
+#endif
+                return;
+            }
+#ifdef USE_ESP8266
+            this->report_state_dirty_ |= tracked != NOT_TRACKED;
+#endif
+
+            if (this->store_state_ != nullptr) {
+                ESP_LOGI(TAG, "Storing: %s = %f", obj->get_name().c_str(), state);
+                this->store_reading_(entity, &state, sizeof(state));
+                this->callback_.call(state);
+                return;
+            }
+
+            ESP_LOGI(TAG, "Publishing: %s = %f", obj->get_name().c_str(), state);
+
+            this->select_frame_mode_(entity);
+            if (!this->frame_writer_.add_sensor(this->prefix_(entity), state)) {
+                // Pending frame is full: send it and start an empty one
+                this->flush_frame_();
+                this->frame_writer_.add_sensor(this->prefix_(entity), state);
+            }
+
+            this->entity_staged_(entity);
+            this->reading_staged_();
             this->callback_.call(state);
         }
-#endif
 
-#ifdef USE_TEXT_SENSOR
-        std::string Now_MQTTComponent::build_text_sensor_string_(text_sensor::TextSensor *obj, const std::string &state)
-        {
-            std::string line;
-
-            line = str_snake_case(App.get_name());
-            line += FIELD_DELIMITER;
-            line += FIELD_DELIMITER;
-            line += FIELD_DELIMITER;
-            line += str_snake_case(obj->get_name().c_str());
-            line += FIELD_DELIMITER;
-            line += FIELD_DELIMITER;
-            line += state;
-            line += FIELD_DELIMITER;
-            
-            if (obj->get_icon().length() != 0) {
-                line += obj->get_icon();
-            } else {
-                line += FIELD_DELIMITER;
+#ifdef USE_BINARY_SENSOR
+        void Now_MQTTComponent::on_binary_sensor_update(binary_sensor::BinarySensor *obj, uint16_t entity, float state)
+        {
+            if (!obj->has_state())
+                return;
+
+            bool value = state != 0.0f;
+            if (this->store_state_ != nullptr) {
+                ESP_LOGI(TAG, "Storing: %s = %s", obj->get_name().c_str(), value ? "ON" : "OFF");
+                uint8_t stored = value;
+                this->store_reading_(entity, &stored, sizeof(stored));
+                this->callback_.call(state);
+                return;
             }
-            
-            line += FIELD_DELIMITER;
-            line += ESPHOME_VERSION;
-            line += FIELD_DELIMITER;
-            line += ESPHOME_BOARD;
-            line += "::";
-            
-            return line;
+
+            ESP_LOGI(TAG, "Publishing: %s = %s", obj->get_name().c_str(), value ? "ON" : "OFF");
+
+            this->select_frame_mode_(entity);
+            if (!this->frame_writer_.add_binary_sensor(this->prefix_(entity), value)) {
+                this->flush_frame_();
+                this->frame_writer_.add_binary_sensor(this->prefix_(entity), value);
+            }
+
+            this->entity_staged_(entity);
+            this->reading_staged_();
+            this->callback_.call(state);
         }
+#endif
 
-        void Now_MQTTComponent::on_text_sensor_update(text_sensor::TextSensor *obj, std::string state)
+#ifdef USE_TEXT_SENSOR
+        void Now_MQTTComponent::on_text_sensor_update(text_sensor::TextSensor *obj, uint16_t entity, const std::string &state)
         {
             if (!obj->has_state())
                 return;
 
-            std::string line = this->build_text_sensor_string_(obj, state);
-            
-            ESP_LOGI(TAG, "Publishing: %s", line.c_str());
-            
-            this->send_with_retry_(reinterpret_cast<const uint8_t *>(line.c_str()), line.size());
+            if (this->store_state_ != nullptr) {
+                ESP_LOGI(TAG, "Storing: %s = %s", obj->get_name().c_str(), state.c_str());
+                if (state.size() > UINT8_MAX) {
+                    ESP_LOGW(TAG, "Text of %u bytes cut to %u", (unsigned) state.size(), (unsigned) UINT8_MAX);
+                }
+                this->store_reading_(entity, state.data(), std::min<size_t>(state.size(), UINT8_MAX));
+                this->callback_.call(0.0f);
+                return;
+            }
+
+            ESP_LOGI(TAG, "Publishing: %s = %s", obj->get_name().c_str(), state.c_str());
+
+            this->select_frame_mode_(entity);
+            if (!this->frame_writer_.add_text_sensor(this->prefix_(entity), state)) {
+                this->flush_frame_();
+                if (!this->frame_writer_.add_text_sensor(this->prefix_(entity), state)) {
+                    // Too long for a frame of its own: send it in fragments
+                    if (!this->send_fragmented_(entity, state)) {
+                        ESP_LOGW(TAG, "Reading for '%s' could not be sent in fragments",
+                                 obj->get_name().c_str());
+                    }
+                    this->callback_.call(0.0f);
+                    return;
+                }
+            }
+
+            this->entity_staged_(entity);
+            this->reading_staged_();
             this->callback_.call(0.0f);
         }
 #endif
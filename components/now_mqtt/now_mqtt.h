@@ -3,6 +3,17 @@
 #include "esphome/core/component.h"
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/core/automation.h"
+#include "esphome/components/now_mqtt_protocol/codec.h"
+#include "send_queue.h"
+#include "channel_scanner.h"
+#include "deadband.h"
+#include "reading_store.h"
+#include <atomic>
+#include <vector>
+
+#ifdef USE_ESP8266
+#include "esphome/core/preferences.h"
+#endif
 
 #ifdef USE_BINARY_SENSOR
 #include "esphome/components/binary_sensor/binary_sensor.h"
@@ -21,7 +32,109 @@ namespace esphome
         // =============================================================================
         static constexpr uint8_t MAX_RETRIES = 2;
         static constexpr uint8_t RETRY_DELAY_MS = 10;
-        static constexpr char FIELD_DELIMITER = ':';
+        static constexpr uint32_t SEND_TIMEOUT_MS = 100;      // Wait for send callback per attempt
+        static constexpr uint32_t SHUTDOWN_DRAIN_MS = 500;    // Max time to finish sends before sleep
+        static constexpr size_t SEND_QUEUE_SIZE = 4;
+        static constexpr uint32_t LINK_STATE_MAGIC = 0x4E4D5033;  // "NMP3"
+        static constexpr uint32_t SCAN_DWELL_MS = 60;    // Wait for a PAIR_ACK per channel
+        static constexpr uint8_t SCAN_SWEEPS = 2;
+        static constexpr uint8_t MAX_UNANSWERED_SCANS = 3;  // Then an unpaired node stops searching
+        static constexpr uint32_t REPORT_STATE_MAGIC = 0x4E4D4454;  // "NMDT"
+        static constexpr size_t MAX_DEADBANDS = 16;
+        static constexpr uint8_t NOT_TRACKED = 0xFF;
+        static constexpr uint32_t STORE_STATE_MAGIC = 0x4E4D5346;  // "NMSF"
+        static constexpr size_t STORE_SIZE = 2048;                 // ~170 sensor readings
+        static constexpr uint8_t STORE_UPLOAD_FILL_PERCENT = 75;   // Upload early beyond this
+        static constexpr uint32_t SCHEMA_STATE_MAGIC = 0x4E4D5343;  // "NMSC"
+        static constexpr size_t MAX_COMPACT_ENTITIES = 256;         // Entities beyond this always go out in full
+        static constexpr uint32_t SEQUENCE_STATE_MAGIC = 0x4E4D5351;  // "NMSQ"
+
+        // =============================================================================
+        // Link State
+        // =============================================================================
+        // What the node learned about its bridge: MAC (from a PAIR_ACK) and the channel
+        // it answered on. Kept in RTC memory so a node waking from deep sleep tunes to
+        // the right channel and sends unicast straight away; lost on power cycle.
+        struct LinkState {
+            uint32_t magic;
+            uint8_t bridge_mac[6];
+            uint8_t channel;             // Last channel a bridge answered on
+            uint8_t configured_channel;  // wifi_channel when saved; a config change discards the state
+            uint8_t paired;
+            uint8_t misses;              // Consecutive failed (paired) or unanswered (unpaired) frames
+            uint8_t scans;               // Unanswered scans since the node last paired
+        };
+
+        // =============================================================================
+        // Report State
+        // =============================================================================
+        // Last value sent for each sensor with a deadband, in RTC memory. layout is a
+        // hash of the tracked entities and their settings; a different firmware (or
+        // config) discards the state and every tracked sensor reports on the next wake.
+        struct ReportState {
+            uint32_t magic;
+            uint32_t layout;
+            TrackedValue values[MAX_DEADBANDS];
+        };
+
+        // =============================================================================
+        // Store State
+        // =============================================================================
+        // Store-and-forward buffer in RTC memory (ESP32 only; the ESP8266's user RTC
+        // area is 512 bytes). Readings from every wake, and those whose frame failed,
+        // wait here until an upload delivers them. layout is a hash of the entity
+        // prefixes, since entries refer to entities by index.
+        struct StoreState {
+            uint32_t magic;
+            uint32_t layout;
+            uint16_t used;
+            uint8_t wakes;  // Wakes since the last upload
+            uint8_t retry;  // The last upload left readings undelivered
+            uint32_t dropped;
+            uint8_t data[STORE_SIZE];
+        };
+
+        // =============================================================================
+        // Schema State
+        // =============================================================================
+        // Which schemas the bridge is known to hold: set once a full frame carrying the
+        // node block / an entity's prefix was acknowledged by the paired bridge. Those
+        // readings then go out as compact records. Kept in RTC memory; cleared on power
+        // cycle, a new bridge, or the bridge's SCHEMA_REQUEST. layout hashes every
+        // schema ID, so a firmware change starts over.
+        struct SchemaState {
+            uint32_t magic;
+            uint32_t layout;
+            uint8_t node_announced;
+            uint8_t announced[MAX_COMPACT_ENTITIES / 8];
+        };
+
+        // =============================================================================
+        // Sequence State
+        // =============================================================================
+        // Boot id and next sequence number stamped on frames. Kept in RTC memory so a
+        // deep sleep wake carries on the sequence under the same boot id; only a power
+        // cycle (RTC memory cleared) picks a new random boot id and starts from 0. A
+        // repeated boot id with a restarted sequence would look like retransmissions
+        // to the bridge.
+        struct SequenceState {
+            uint32_t magic;
+            uint16_t boot_id;
+            uint16_t next_seq;
+        };
+
+        // =============================================================================
+        // Entity Descriptor
+        // =============================================================================
+        // Built once in setup(). The record prefix (type, name, metadata block) is
+        // pre-encoded into the prefix arena, so an update only appends its value.
+        struct EntityDescriptor {
+            uint16_t prefix_offset;
+            uint8_t prefix_len;
+            uint8_t tracked = NOT_TRACKED;  // Index into ReportState::values
+            bool compact = false;           // Prefix is short enough to be cached by the bridge
+            uint8_t schema_ref[now_mqtt_protocol::SCHEMA_REF_SIZE] = {};
+        };
 
         // =============================================================================
         // Main Component Class
@@ -31,11 +144,31 @@ namespace esphome
         public:
             void setup() override;
             void loop() override;
+            void on_shutdown() override;
             float get_setup_priority() const override;
 
             // Configuration setters (called from Python codegen)
             void set_wifi_channel(uint8_t channel) { this->wifi_channel_ = channel; }
             void set_long_range_mode(bool enabled) { this->long_range_mode_ = enabled; }
+            void set_batch_window(uint32_t window_ms) { this->batch_window_ms_ = window_ms; }
+            void set_report_interval(uint32_t interval_s) { this->report_interval_s_ = interval_s; }
+            void set_pairing(bool enabled) { this->pairing_ = enabled; }
+            void set_unpair_after_failures(uint8_t failures) { this->unpair_after_failures_ = failures; }
+            void set_heartbeat(uint8_t updates) { this->heartbeat_ = updates; }
+            void set_upload_every(uint8_t wakes) { this->upload_every_ = wakes; }
+            void set_compact_frames(bool enabled) { this->compact_frames_ = enabled; }
+            void add_deadband(sensor::Sensor *sensor, float threshold, bool percentage)
+            {
+                this->deadbands_.push_back({sensor, {threshold, percentage}});
+            }
+
+            // Delivery statistics (only meaningful while paired: broadcasts are never ACKed)
+            bool is_paired() const { return this->paired_; }
+            uint8_t get_channel() const { return this->channel_; }
+            uint32_t get_delivered() const { return this->delivered_; }
+            uint32_t get_failed() const { return this->failed_; }
+            uint32_t get_suppressed() const { return this->suppressed_; }
+            size_t get_stored() const { return this->store_state_ != nullptr ? this->store_.count(ReadingStore::PENDING) : 0; }
 
             // Callback registration
             void add_on_state_callback(std::function<void(float)> callback) { this->callback_.add(callback); }
@@ -46,10 +179,101 @@ namespace esphome
             // Configuration
             uint8_t wifi_channel_ = 1;
             bool long_range_mode_ = true;
+            uint32_t batch_window_ms_ = 0;  // 0 = send every reading immediately
+            uint32_t report_interval_s_ = 0;  // 0 = let the bridge learn it
+            bool pairing_ = true;
+            uint8_t unpair_after_failures_ = 3;
+            uint8_t heartbeat_ = 10;  // Force a send after this many suppressed updates
+
+            // Change-only reporting; see deadband.h
+            struct SensorDeadband {
+                sensor::Sensor *sensor;
+                Deadband band;
+            };
+            std::vector<SensorDeadband> deadbands_;
+            ReportState *report_state_ = nullptr;
+            uint32_t suppressed_ = 0;
+#ifdef USE_ESP8266
+            ReportState report_state_storage_;
+            ESPPreferenceObject report_pref_;
+            bool report_state_dirty_ = false;
+#endif
+
+            // Store-and-forward: with upload_every set, readings go to the RTC store and
+            // are uploaded every Nth wake (or when the store fills up) as a burst of
+            // frames whose tags are the store ranges they carry
+            uint8_t upload_every_ = 0;  // 0 = send as readings arrive
+            StoreState *store_state_ = nullptr;
+            ReadingStore store_;
+            bool upload_active_ = false;
+            size_t upload_cursor_ = 0;
+            bool upload_failed_ = false;
+
+            // A reading too large for one frame, going out as fragments
+            uint8_t message_buffer_[now_mqtt_protocol::MAX_MESSAGE_SIZE];
+            size_t message_len_ = 0;  // 0 = nothing pending
+            uint8_t message_next_ = 0;  // Next fragment to queue
+            uint16_t message_id_ = 0;
+
+            // Compact frames: schema IDs instead of metadata once the bridge has it
+            bool compact_frames_ = true;
+            std::vector<uint8_t> compact_header_;
+            bool frame_compact_ = false;
+            SchemaState *schema_state_ = nullptr;
+            uint8_t announcing_[MAX_COMPACT_ENTITIES / 8] = {};  // In full frames not yet acknowledged
+            std::atomic<bool> schema_request_pending_{false};
+#ifdef USE_ESP8266
+            SchemaState schema_state_storage_;
+            ESPPreferenceObject schema_pref_;
+#endif
+
+            // The radio is started by the first frame that needs sending, so a wake
+            // whose readings are all inside their deadbands never powers it up
+            bool radio_started_ = false;
+            LinkState saved_link_ = {};
+            bool have_saved_link_ = false;
 
-            // State
-            volatile bool send_in_progress_ = false;
-            volatile bool last_send_success_ = false;
+            // Outbound frames, advanced from loop()
+            SendQueue<SEND_QUEUE_SIZE, now_mqtt_protocol::MAX_FRAME_SIZE> send_queue_{
+                {MAX_RETRIES, RETRY_DELAY_MS, SEND_TIMEOUT_MS}};
+
+            // Pre-encoded frame header (magic, node name, node metadata) and entity prefixes
+            std::vector<uint8_t> frame_header_;
+            std::vector<uint8_t> prefix_arena_;
+            std::vector<EntityDescriptor> entities_;
+
+            // Pending frame; readings are staged here until flush_frame_()
+            uint8_t frame_buffer_[now_mqtt_protocol::MAX_FRAME_SIZE];
+            now_mqtt_protocol::FrameWriter frame_writer_{frame_buffer_, sizeof(frame_buffer_)};
+            uint32_t frame_started_ms_ = 0;
+
+            // Stamped on every frame so the bridge can drop retransmissions
+            SequenceState *sequence_state_ = nullptr;
+#ifdef USE_ESP8266
+            SequenceState sequence_state_storage_ = {};
+            ESPPreferenceObject sequence_pref_;
+#endif
+
+            // Unicast to the paired bridge (hardware ACKs), broadcast with FLAG_PAIR_REQUEST
+            // until then. The receive callback only stages a PAIR_ACK for loop().
+            bool paired_ = false;
+            uint8_t bridge_mac_[6] = {};
+            uint8_t own_mac_[6] = {};
+            uint8_t misses_ = 0;
+            uint8_t scans_ = 0;
+            uint32_t delivered_ = 0;
+            uint32_t failed_ = 0;
+            std::atomic<bool> pair_pending_{false};
+            uint8_t pending_bridge_mac_[6] = {};
+            uint8_t pending_channel_ = 0;
+#ifdef USE_ESP8266
+            ESPPreferenceObject link_pref_;
+#endif
+
+            // Operating channel (cached or configured) and the sweep run when the bridge
+            // stops answering; the send queue is paused while it runs
+            uint8_t channel_ = 1;
+            ChannelScanner scanner_{{SCAN_DWELL_MS, SCAN_SWEEPS}};
 
         private:
             // Callback managers
@@ -58,25 +282,77 @@ namespace esphome
             CallbackManager<void()> send_failure_callback_;
 
             // Initialization helpers
+            bool start_radio_();
             void init_esp_now_();
             void register_sensor_callbacks_();
+            void load_report_state_();
+            void save_report_state_();
+            void invalidate_report_state_();
+
+            // Store-and-forward
+            void load_store_();
+            void store_reading_(uint16_t entity, const void *value, uint8_t len);
+            bool store_upload_due_(bool sleeping) const;
+            void start_upload_();
+            void pump_upload_();
+            void finish_upload_();
+            bool add_stored_(const ReadingStore::Entry &entry, uint32_t now_s);
+            static uint32_t store_clock_s_();
+
+            // Compact frames
+            void load_schema_state_();
+            void save_schema_state_();
+            void reset_schema_state_();
+            bool compact_ready_(uint16_t entity) const;
+            void schema_delivered_();
 
             // Send methods
-            bool send_with_retry_(const uint8_t *data, size_t len);
+            void process_send_queue_();
+            bool transmit_(const uint8_t *data, size_t len);
+            void send_completed_(bool success, uint32_t tag);
+#ifdef USE_ESP32
             static void send_callback_(const uint8_t *mac_addr, esp_now_send_status_t status);
+#endif
+
+            // Bridge pairing and channel discovery
+            static void on_control_frame_(const uint8_t *mac, const uint8_t *data, int len);
+            bool load_link_state_();
+            void save_link_state_();
+            void pair_with_(const uint8_t *mac);
+            void unpair_();
+            void note_miss_();
+            bool add_peer_(const uint8_t *mac);
+            void remove_peer_(const uint8_t *mac);
+            void set_channel_(uint8_t channel);
+            void start_scan_();
+            void process_scan_();
+
+            // Frame encoding (v2 binary wire format)
+            bool build_frame_header_();
+            int add_entity_(now_mqtt_protocol::ReadingType type, const std::string &name,
+                            const now_mqtt_protocol::EntityMeta &meta);
+            now_mqtt_protocol::RecordPrefix prefix_(uint16_t entity) const;
+            now_mqtt_protocol::RecordPrefix full_prefix_(uint16_t entity) const;
+            void begin_frame_();
+            void select_frame_mode_(uint16_t entity);
+            void load_sequence_state_();
+            uint16_t take_sequence_();
+            void entity_staged_(uint16_t entity);
+            now_mqtt_protocol::RecordPrefix node_block_() const;
+            void reading_staged_();
+            void flush_frame_(uint32_t tag = 0);
+            bool send_fragmented_(uint16_t entity, std::string_view value);
+            void pump_fragments_();
 
             // Sensor update handlers
-            void on_sensor_update(sensor::Sensor *obj, float state);
-            std::string build_sensor_string_(sensor::Sensor *obj, float state);
+            void on_sensor_update(sensor::Sensor *obj, uint16_t entity, float state);
 
 #ifdef USE_BINARY_SENSOR
-            void on_binary_sensor_update(binary_sensor::BinarySensor *obj, float state);
-            std::string build_binary_sensor_string_(binary_sensor::BinarySensor *obj, bool state);
+            void on_binary_sensor_update(binary_sensor::BinarySensor *obj, uint16_t entity, float state);
 #endif
 
 #ifdef USE_TEXT_SENSOR
-            void on_text_sensor_update(text_sensor::TextSensor *obj, std::string state);
-            std::string build_text_sensor_string_(text_sensor::TextSensor *obj, const std::string &state);
+            void on_text_sensor_update(text_sensor::TextSensor *obj, uint16_t entity, const std::string &state);
 #endif
 
             // Static instance pointer for callbacks
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace esphome
+{
+    namespace now_mqtt
+    {
+        // =============================================================================
+        // Reading Store
+        // =============================================================================
+        // Append-only log of readings over a caller-provided buffer (RTC memory), kept
+        // in the order they were taken. Entries are variable length:
+        //
+        //   state entity[2] time_s[4] len value[len]
+        //
+        // Uploading marks entries SENT; the frame's completion then marks its range
+        // DELIVERED or leaves it for the next upload. compact() removes delivered
+        // entries and must only run while no frame is in flight, since the ranges are
+        // byte offsets into the buffer.
+        class ReadingStore
+        {
+        public:
+            static constexpr size_t ENTRY_HEADER_SIZE = 8;
+
+            enum EntryState : uint8_t {
+                PENDING = 0,
+                SENT = 1,
+                DELIVERED = 2,
+            };
+
+            struct Entry {
+                uint8_t state;
+                uint16_t entity;
+                uint32_t time_s;
+                const uint8_t *value;
+                uint8_t len;
+                size_t next;  // Offset of the following entry
+            };
+
+            void init(uint8_t *buffer, size_t capacity, uint16_t *used)
+            {
+                this->buffer_ = buffer;
+                this->capacity_ = capacity;
+                this->used_ = used;
+                if (*this->used_ > capacity) {
+                    *this->used_ = 0;
+                }
+            }
+
+            void clear() { *this->used_ = 0; }
+
+            bool append(uint16_t entity, uint32_t time_s, const void *value, uint8_t len)
+            {
+                size_t size = ENTRY_HEADER_SIZE + len;
+                if (*this->used_ + size > this->capacity_) {
+                    return false;
+                }
+                uint8_t *out = this->buffer_ + *this->used_;
+                out[0] = PENDING;
+                out[1] = entity & 0xFF;
+                out[2] = entity >> 8;
+                for (int i = 0; i < 4; i++) {
+                    out[3 + i] = (time_s >> (8 * i)) & 0xFF;
+                }
+                out[7] = len;
+                memcpy(out + ENTRY_HEADER_SIZE, value, len);
+                *this->used_ += size;
+                return true;
+            }
+
+            // Decode the entry at offset; false past the end
+            bool read(size_t offset, Entry *entry) const
+            {
+                if (offset + ENTRY_HEADER_SIZE > *this->used_) {
+                    return false;
+                }
+                const uint8_t *in = this->buffer_ + offset;
+                entry->state = in[0];
+                entry->entity = in[1] | (in[2] << 8);
+                entry->time_s = in[3] | (in[4] << 8) | (in[5] << 16) | (uint32_t(in[6]) << 24);
+                entry->len = in[7];
+                entry->value = in + ENTRY_HEADER_SIZE;
+                entry->next = offset + ENTRY_HEADER_SIZE + entry->len;
+                return entry->next <= *this->used_;
+            }
+
+            // Set the state of every entry starting in [begin, end)
+            void mark(size_t begin, size_t end, EntryState state)
+            {
+                Entry entry;
+                for (size_t offset = begin; offset < end && this->read(offset, &entry); offset = entry.next) {
+                    this->buffer_[offset] = state;
+                }
+            }
+
+            // Drop delivered entries; anything still SENT goes back to PENDING
+            void compact()
+            {
+                size_t out = 0;
+                Entry entry;
+                for (size_t offset = 0; this->read(offset, &entry); offset = entry.next) {
+                    if (entry.state == DELIVERED) {
+                        continue;
+                    }
+                    size_t size = entry.next - offset;
+                    memmove(this->buffer_ + out, this->buffer_ + offset, size);
+                    this->buffer_[out] = PENDING;
+                    out += size;
+                }
+                *this->used_ = out;
+            }
+
+            // Make room by discarding the oldest entry (call only after compact())
+            bool drop_oldest()
+            {
+                Entry entry;
+                if (!this->read(0, &entry)) {
+                    return false;
+                }
+                memmove(this->buffer_, this->buffer_ + entry.next, *this->used_ - entry.next);
+                *this->used_ -= entry.next;
+                return true;
+            }
+
+            size_t count(EntryState state) const
+            {
+                size_t n = 0;
+                Entry entry;
+                for (size_t offset = 0; this->read(offset, &entry); offset = entry.next) {
+                    n += entry.state == state;
+                }
+                return n;
+            }
+
+            bool empty() const { return *this->used_ == 0; }
+            size_t used() const { return *this->used_; }
+            size_t capacity() const { return this->capacity_; }
+
+        protected:
+            uint8_t *buffer_ = nullptr;
+            size_t capacity_ = 0;
+            uint16_t *used_ = nullptr;
+        };
+
+    } // namespace now_mqtt
+} // namespace esphome
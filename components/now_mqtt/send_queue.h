@@ -0,0 +1,230 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace esphome
+{
+    namespace now_mqtt
+    {
+        // =============================================================================
+        // Outbound Send Queue
+        // =============================================================================
+        // Fixed pool of outbound frames driven by process() from the main loop. Nothing
+        // here blocks: a frame is transmitted, then tracked as in flight until its send
+        // completion arrives (or times out), then retried or reported.
+        //
+        // ESP-NOW reports completions in the order frames were handed to esp_now_send(),
+        // so each successful transmit takes the next ticket and the n-th completion
+        // belongs to ticket n (plus the skew below). on_send_complete() runs in the
+        // Wi-Fi task and only publishes the status for its ticket; all slot bookkeeping
+        // stays in the loop. Each frame carries an opaque tag that is handed back when
+        // it completes.
+        //
+        // A completion that never arrives would shift every later one onto the wrong
+        // ticket. So once a frame has timed out, the next time nothing is in flight the
+        // count of completions is realigned with the count of transmits. A completion
+        // that was only late then finds no ticket issued for it and is dropped.
+        template<size_t N, size_t FRAME_SIZE>
+        class SendQueue
+        {
+        public:
+            struct Config {
+                uint8_t max_retries;
+                uint32_t retry_delay_ms;
+                uint32_t send_timeout_ms;
+            };
+
+            explicit SendQueue(const Config &config) : config_(config) {}
+
+            // Copy a frame into a free slot. Returns false if the queue is full.
+            bool enqueue(const uint8_t *data, size_t len, uint32_t now, uint32_t tag = 0)
+            {
+                if (len == 0 || len > FRAME_SIZE) {
+                    return false;
+                }
+                for (auto &slot : this->slots_) {
+                    if (slot.state == State::FREE) {
+                        memcpy(slot.data, data, len);
+                        slot.len = len;
+                        slot.attempts = 0;
+                        slot.order = this->next_order_++;
+                        slot.due_ms = now;
+                        slot.tag = tag;
+                        slot.state = State::QUEUED;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Record the completion status of the oldest outstanding transmit (Wi-Fi task)
+            void on_send_complete(bool success)
+            {
+                uint32_t ticket = this->completed_.load(std::memory_order_relaxed);
+                this->statuses_[ticket % STATUS_RING_SIZE] = success;
+                this->completed_.store(ticket + 1, std::memory_order_release);
+            }
+
+            // A frame sent around the queue (e.g. a probe) still produces a completion;
+            // account for its ticket right after a successful esp_now_send() so later
+            // completions keep matching
+            void skip_ticket() { this->issued_++; }
+
+            // Advance the state machine.
+            //   transmit(data, len) -> bool   hand a frame to the radio
+            //   complete(success, tag)        a frame finished (after retries)
+            template<typename TransmitFn, typename CompleteFn>
+            void process(uint32_t now, TransmitFn &&transmit, CompleteFn &&complete)
+            {
+                // 1. Match completions to in-flight frames
+                uint32_t completed = this->completed_.load(std::memory_order_acquire);
+                while (this->processed_ != completed) {
+                    bool success = this->statuses_[this->processed_ % STATUS_RING_SIZE];
+                    uint32_t ticket = this->processed_ + this->ticket_skew_;
+                    Slot *slot = this->find_in_flight_(ticket);
+                    if (slot != nullptr) {
+                        this->finish_attempt_(*slot, success, now, complete);
+                    } else if (int32_t(ticket - this->issued_) >= 0) {
+                        // More completions than transmits: a late one for a frame that timed
+                        // out before the last resync. The next completion takes this ticket.
+                        this->ticket_skew_--;
+                    }
+                    // Otherwise the frame already timed out; its late completion is dropped
+                    this->processed_++;
+                }
+
+                // 2. Expire frames whose completion never showed up in time
+                for (auto &slot : this->slots_) {
+                    if (slot.state == State::IN_FLIGHT && now - slot.sent_ms >= this->config_.send_timeout_ms) {
+                        this->finish_attempt_(slot, false, now, complete);
+                        this->resync_ = true;
+                    }
+                }
+
+                // With nothing in flight, every transmit so far has had its completion or
+                // never will: the next completion belongs to the next ticket
+                if (this->resync_ && this->in_flight() == 0) {
+                    this->ticket_skew_ = this->issued_ - this->processed_;
+                    this->resync_ = false;
+                }
+
+                // 3. Transmit due frames, oldest first
+                Slot *slot;
+                while ((slot = this->next_due_(now)) != nullptr) {
+                    if (transmit(slot->data, slot->len)) {
+                        slot->ticket = this->issued_++;
+                        slot->sent_ms = now;
+                        slot->state = State::IN_FLIGHT;
+                    } else {
+                        this->finish_attempt_(*slot, false, now, complete);
+                        // The radio refused the frame; leave the rest for the next pass
+                        break;
+                    }
+                }
+            }
+
+            bool idle() const
+            {
+                for (const auto &slot : this->slots_) {
+                    if (slot.state != State::FREE) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            size_t pending() const
+            {
+                size_t count = 0;
+                for (const auto &slot : this->slots_) {
+                    if (slot.state != State::FREE) {
+                        count++;
+                    }
+                }
+                return count;
+            }
+
+            size_t available() const { return N - this->pending(); }
+
+            size_t in_flight() const
+            {
+                size_t count = 0;
+                for (const auto &slot : this->slots_) {
+                    if (slot.state == State::IN_FLIGHT) {
+                        count++;
+                    }
+                }
+                return count;
+            }
+
+        protected:
+            // Larger than the pool so a burst of late completions cannot lap the loop
+            static constexpr uint32_t STATUS_RING_SIZE = 4 * N;
+
+            enum class State : uint8_t { FREE, QUEUED, IN_FLIGHT };
+
+            struct Slot {
+                uint8_t data[FRAME_SIZE];
+                size_t len = 0;
+                State state = State::FREE;
+                uint8_t attempts = 0;
+                uint32_t order = 0;
+                uint32_t ticket = 0;
+                uint32_t due_ms = 0;
+                uint32_t sent_ms = 0;
+                uint32_t tag = 0;
+            };
+
+            Slot *find_in_flight_(uint32_t ticket)
+            {
+                for (auto &slot : this->slots_) {
+                    if (slot.state == State::IN_FLIGHT && slot.ticket == ticket) {
+                        return &slot;
+                    }
+                }
+                return nullptr;
+            }
+
+            Slot *next_due_(uint32_t now)
+            {
+                Slot *best = nullptr;
+                for (auto &slot : this->slots_) {
+                    if (slot.state != State::QUEUED || int32_t(now - slot.due_ms) < 0) {
+                        continue;
+                    }
+                    if (best == nullptr || int32_t(slot.order - best->order) < 0) {
+                        best = &slot;
+                    }
+                }
+                return best;
+            }
+
+            template<typename CompleteFn>
+            void finish_attempt_(Slot &slot, bool success, uint32_t now, CompleteFn &complete)
+            {
+                if (!success && slot.attempts < this->config_.max_retries) {
+                    slot.attempts++;
+                    slot.due_ms = now + this->config_.retry_delay_ms;
+                    slot.state = State::QUEUED;
+                    return;
+                }
+                slot.state = State::FREE;
+                complete(success, slot.tag);
+            }
+
+            Config config_;
+            Slot slots_[N];
+            bool statuses_[STATUS_RING_SIZE] = {};
+            std::atomic<uint32_t> completed_{0};
+            uint32_t processed_ = 0;
+            uint32_t issued_ = 0;
+            uint32_t ticket_skew_ = 0;  // Tickets whose completion was lost, minus late ones dropped
+            bool resync_ = false;
+            uint32_t next_order_ = 0;
+        };
+
+    } // namespace now_mqtt
+} // namespace esphome
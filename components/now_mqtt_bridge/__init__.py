@@ -1,6 +1,6 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+from esphome.const import CONF_DEVICE_CLASS, CONF_ID, CONF_QOS, CONF_RETAIN
 from esphome.core import coroutine_with_priority
 
 # =============================================================================
@@ -8,9 +8,25 @@ from esphome.core import coroutine_with_priority
 # =============================================================================
 CONF_CHANNEL = "wifi_channel"
 CONF_PUBLISH_AVAILABILITY = "publish_availability"
+CONF_MAX_FRAMES_PER_LOOP = "max_frames_per_loop"
+CONF_MAX_ENTITIES = "max_entities"
+CONF_MAX_DEVICES = "max_devices"
+CONF_USE_PSRAM = "use_psram"
+CONF_TELEMETRY_INTERVAL = "telemetry_interval"
+CONF_TELEMETRY_DISCOVERY = "telemetry_discovery"
+CONF_DEVICE_DISCOVERY = "device_discovery"
+CONF_SNAPSHOT_INTERVAL = "snapshot_interval"
+CONF_CAPTURE_SIZE = "capture_size"
+CONF_PUBLISH_POLICIES = "publish_policies"
+CONF_NODE = "node"
+CONF_ENTITY = "entity"
+CONF_MIN_INTERVAL = "min_interval"
+CONF_AGGREGATE_WINDOW = "aggregate_window"
+CONF_PASSTHROUGH = "passthrough"
 
 # Ensure MQTT dependency
 DEPENDENCIES = ["mqtt"]
+AUTO_LOAD = ["now_mqtt_protocol"]
 
 # =============================================================================
 # C++ Class References
@@ -24,6 +40,26 @@ Now_MQTT_BridgeComponent = now_mqtt_bridge_ns.class_(
 # =============================================================================
 # Configuration Schema
 # =============================================================================
+# QoS, retain and rate limit for the state topics of matching entities. Every
+# matcher given must equal the reading's; the first matching policy applies.
+PUBLISH_POLICY_SCHEMA = cv.Schema({
+    cv.Optional(CONF_NODE, default=""): cv.string,
+    cv.Optional(CONF_ENTITY, default=""): cv.string,
+    cv.Optional(CONF_DEVICE_CLASS, default=""): cv.string,
+    cv.Optional(CONF_QOS, default=2): cv.int_range(min=0, max=2),
+    cv.Optional(CONF_RETAIN, default=True): cv.boolean,
+    # Publish at most this often, keeping only the latest state in between (omit to publish every state)
+    cv.Optional(CONF_MIN_INTERVAL): cv.All(
+        cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=1))
+    ),
+    # Publish numeric states as min/max/mean/last/count over tumbling windows of this length
+    cv.Optional(CONF_AGGREGATE_WINDOW): cv.All(
+        cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=5))
+    ),
+    # With aggregate_window: keep publishing the raw states as well
+    cv.Optional(CONF_PASSTHROUGH, default=False): cv.boolean,
+})
+
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(): cv.declare_id(Now_MQTT_BridgeComponent),
     
@@ -34,6 +70,45 @@ CONFIG_SCHEMA = cv.Schema({
     
     # Publish availability (online/offline) for each device (default true)
     cv.Optional(CONF_PUBLISH_AVAILABILITY, default=True): cv.boolean,
+    
+    # Received frames parsed and published per loop() iteration
+    cv.Optional(CONF_MAX_FRAMES_PER_LOOP, default=8): cv.int_range(min=1, max=32),
+    
+    # Entities tracked by the discovery cache (discovery is republished every time beyond this)
+    cv.Optional(CONF_MAX_ENTITIES, default=256): cv.int_range(min=1, max=4096),
+    
+    # Sender nodes tracked for availability (names share a 16-bit addressed pool)
+    cv.Optional(CONF_MAX_DEVICES, default=128): cv.int_range(min=1, max=2000),
+    
+    # Place the device table, name pool and discovery cache in PSRAM
+    cv.Optional(CONF_USE_PSRAM, default=False): cv.boolean,
+    
+    # Publish bridge and per-device link statistics as JSON this often (omit to disable)
+    cv.Optional(CONF_TELEMETRY_INTERVAL): cv.All(
+        cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(seconds=10))
+    ),
+    
+    # Also publish Home Assistant discovery for the main telemetry values
+    cv.Optional(CONF_TELEMETRY_DISCOVERY, default=False): cv.boolean,
+    
+    # One device-based discovery config per node instead of one per entity
+    # (Home Assistant 2024.11 or later)
+    cv.Optional(CONF_DEVICE_DISCOVERY, default=False): cv.boolean,
+    
+    # Save the device table and discovery cache to flash at most this often, and
+    # restore them on boot (omit to disable)
+    cv.Optional(CONF_SNAPSHOT_INTERVAL): cv.All(
+        cv.positive_time_period_milliseconds, cv.Range(min=cv.TimePeriod(minutes=1))
+    ),
+    
+    # Record the most recent received frames into a ring of this many bytes, for
+    # dumping and replay over MQTT (omit to disable)
+    cv.Optional(CONF_CAPTURE_SIZE): cv.int_range(min=1024, max=4194304),
+    
+    # Per-entity / per-device-class publish policies (default: QoS 2, retained, every state)
+    cv.Optional(CONF_PUBLISH_POLICIES, default=[]): cv.All(
+        cv.ensure_list(PUBLISH_POLICY_SCHEMA), cv.Length(max=254)
+    ),
 })
 
 # =============================================================================
@@ -46,3 +121,21 @@ async def to_code(config):
     
     cg.add(var.set_wifi_channel(config[CONF_CHANNEL]))
     cg.add(var.set_publish_availability(config[CONF_PUBLISH_AVAILABILITY]))
+    cg.add(var.set_max_frames_per_loop(config[CONF_MAX_FRAMES_PER_LOOP]))
+    cg.add(var.set_max_entities(config[CONF_MAX_ENTITIES]))
+    cg.add(var.set_max_devices(config[CONF_MAX_DEVICES]))
+    cg.add(var.set_use_psram(config[CONF_USE_PSRAM]))
+    if CONF_TELEMETRY_INTERVAL in config:
+        cg.add(var.set_telemetry_interval(config[CONF_TELEMETRY_INTERVAL]))
+    cg.add(var.set_telemetry_discovery(config[CONF_TELEMETRY_DISCOVERY]))
+    cg.add(var.set_device_discovery(config[CONF_DEVICE_DISCOVERY]))
+    if CONF_SNAPSHOT_INTERVAL in config:
+        cg.add(var.set_snapshot_interval(config[CONF_SNAPSHOT_INTERVAL]))
+    if CONF_CAPTURE_SIZE in config:
+        cg.add(var.set_capture_size(config[CONF_CAPTURE_SIZE]))
+    for policy in config[CONF_PUBLISH_POLICIES]:
+        cg.add(var.add_publish_policy(
+            policy[CONF_NODE], policy[CONF_ENTITY], policy[CONF_DEVICE_CLASS],
+            policy[CONF_QOS], policy[CONF_RETAIN], policy.get(CONF_MIN_INTERVAL, 0),
+            policy.get(CONF_AGGREGATE_WINDOW, 0), policy[CONF_PASSTHROUGH],
+        ))
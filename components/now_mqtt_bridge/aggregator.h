@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "timer_wheel.h"
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Window Aggregator
+        // =============================================================================
+        // Tumbling-window min / max / mean / last / count for numeric entities, in
+        // constant memory per entity. As with the coalescer, each entity that needs
+        // one gets a window for good, addressed by a 16-bit handle that is also its
+        // timer in a wheel. A window opens with its first sample and closes window_ms
+        // later; an entity that stops reporting publishes nothing until it resumes.
+        class Aggregator
+        {
+        public:
+            static constexpr uint16_t NONE = 0xFFFF;
+
+            struct Window {
+                float min;
+                float max;
+                float last;
+                uint32_t count;
+                double sum;
+                uint16_t owner;
+                uint16_t topic;    // Derived topic in the caller's topic table
+                uint8_t decimals;  // Most seen in a sample's state, for formatting
+
+                float mean() const { return this->count == 0 ? 0.0f : static_cast<float>(this->sum / this->count); }
+            };
+
+            void init(Window *windows, TimerWheel::Timer *timers, size_t count, uint32_t now)
+            {
+                this->windows_ = windows;
+                this->count_ = count < NONE ? count : NONE;
+                this->used_ = 0;
+                this->timers_.init(timers, this->count_, now);
+            }
+
+            // A window for owner, or NONE once all are taken
+            uint16_t acquire(uint16_t owner, uint16_t topic)
+            {
+                if (this->used_ >= this->count_) {
+                    return NONE;
+                }
+                Window &window = this->windows_[this->used_];
+                window.owner = owner;
+                window.topic = topic;
+                window.count = 0;
+                return this->used_++;
+            }
+
+            Window &at(uint16_t handle) { return this->windows_[handle]; }
+
+            // Add a sample; newest is false for a buffered reading older than the last
+            void add(uint16_t handle, float value, uint8_t decimals, bool newest, uint32_t now, uint32_t window_ms)
+            {
+                Window &window = this->windows_[handle];
+                if (window.count == 0) {
+                    window.min = window.max = window.last = value;
+                    window.sum = 0;
+                    window.decimals = decimals;
+                    this->timers_.schedule(handle, now + window_ms);
+                }
+                window.min = value < window.min ? value : window.min;
+                window.max = value > window.max ? value : window.max;
+                if (newest) {
+                    window.last = value;
+                }
+                window.sum += value;
+                window.count++;
+                window.decimals = decimals > window.decimals ? decimals : window.decimals;
+            }
+
+            // Call close(window) for every window whose time is up, then reset it
+            template<typename F>
+            void advance(uint32_t now, F &&close)
+            {
+                this->timers_.advance(now, [this, &close](uint16_t handle) {
+                    Window &window = this->windows_[handle];
+                    close(window);
+                    window.count = 0;
+                });
+            }
+
+            size_t open() const { return this->timers_.armed_count(); }
+            size_t used() const { return this->used_; }
+            size_t capacity() const { return this->count_; }
+            size_t memory_usage() const { return this->count_ * (sizeof(Window) + sizeof(TimerWheel::Timer)); }
+
+        protected:
+            Window *windows_ = nullptr;
+            size_t count_ = 0;
+            size_t used_ = 0;
+            TimerWheel timers_;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "ingest_ring.h"
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Trace Format
+        // =============================================================================
+        // Received frames as a byte stream, little-endian:
+        //
+        //   header:  "NMTR" version[1] flags[1] reserved[2] count[4]
+        //   record:  dt_us[4] mac[6] rssi[1] len[1] data[len]
+        //
+        // dt_us is the receive time relative to the previous record (0 for the first),
+        // so a trace replays with its original spacing. The stream may be cut into
+        // slices anywhere; concatenating them gives the trace back.
+        static constexpr uint8_t TRACE_MAGIC[4] = {'N', 'M', 'T', 'R'};
+        static constexpr uint8_t TRACE_VERSION = 1;
+        static constexpr size_t TRACE_HEADER_SIZE = 12;
+        static constexpr size_t TRACE_RECORD_HEADER_SIZE = 12;
+        static constexpr size_t TRACE_MAX_RECORD_SIZE = TRACE_RECORD_HEADER_SIZE + sizeof(RawFrame::data);
+
+        inline void put_u32_le(uint8_t *out, uint32_t value)
+        {
+            for (int i = 0; i < 4; i++) {
+                out[i] = value >> (8 * i);
+            }
+        }
+
+        inline uint32_t get_u32_le(const uint8_t *in)
+        {
+            return in[0] | (uint32_t(in[1]) << 8) | (uint32_t(in[2]) << 16) | (uint32_t(in[3]) << 24);
+        }
+
+        // Record with the given time field (dt_us in a trace, rx_us in the ring)
+        inline size_t encode_trace_record(uint8_t *out, const RawFrame &frame, uint32_t time_us)
+        {
+            put_u32_le(out, time_us);
+            memcpy(out + 4, frame.mac, 6);
+            out[10] = static_cast<uint8_t>(frame.rssi);
+            out[11] = frame.len;
+            memcpy(out + TRACE_RECORD_HEADER_SIZE, frame.data, frame.len);
+            return TRACE_RECORD_HEADER_SIZE + frame.len;
+        }
+
+        inline void decode_trace_record(const uint8_t *in, RawFrame *frame, uint32_t *time_us)
+        {
+            *time_us = get_u32_le(in);
+            memcpy(frame->mac, in + 4, 6);
+            frame->rssi = static_cast<int8_t>(in[10]);
+            frame->len = in[11];
+            memcpy(frame->data, in + TRACE_RECORD_HEADER_SIZE, frame->len);
+        }
+
+        // =============================================================================
+        // Capture Ring
+        // =============================================================================
+        // The most recent received frames, as records in a byte ring over a
+        // caller-provided buffer; a new frame evicts the oldest ones until it fits.
+        // Records hold the absolute receive time (micros()). Readers walk it with a
+        // cursor, which stays valid until the next push() or clear().
+        class CaptureRing
+        {
+        public:
+            struct Cursor {
+                size_t pos;
+                size_t left;
+            };
+
+            void init(uint8_t *buffer, size_t size)
+            {
+                this->buffer_ = buffer;
+                this->size_ = buffer != nullptr ? size : 0;
+                this->clear();
+            }
+
+            void clear()
+            {
+                this->head_ = 0;
+                this->tail_ = 0;
+                this->used_ = 0;
+                this->count_ = 0;
+            }
+
+            void push(const RawFrame &frame)
+            {
+                size_t len = TRACE_RECORD_HEADER_SIZE + frame.len;
+                if (len > this->size_) {
+                    return;
+                }
+                while (this->size_ - this->used_ < len) {
+                    size_t oldest = TRACE_RECORD_HEADER_SIZE + this->buffer_[(this->tail_ + 11) % this->size_];
+                    this->tail_ = (this->tail_ + oldest) % this->size_;
+                    this->used_ -= oldest;
+                    this->count_--;
+                    this->evicted_++;
+                }
+                uint8_t record[TRACE_MAX_RECORD_SIZE];
+                encode_trace_record(record, frame, frame.rx_us);
+                this->copy_in_(record, len);
+                this->used_ += len;
+                this->count_++;
+            }
+
+            Cursor begin() const { return {this->tail_, this->count_}; }
+
+            // Next record (oldest first) with its receive time in rx_us; false at the end
+            bool read(Cursor *cursor, RawFrame *frame) const
+            {
+                if (cursor->left == 0) {
+                    return false;
+                }
+                uint8_t record[TRACE_MAX_RECORD_SIZE];
+                this->copy_out_(cursor->pos, record, TRACE_RECORD_HEADER_SIZE);
+                size_t len = TRACE_RECORD_HEADER_SIZE + record[11];
+                this->copy_out_(cursor->pos, record, len);
+                decode_trace_record(record, frame, &frame->rx_us);
+                cursor->pos = (cursor->pos + len) % this->size_;
+                cursor->left--;
+                return true;
+            }
+
+            size_t count() const { return this->count_; }
+            size_t used() const { return this->used_; }
+            size_t capacity() const { return this->size_; }
+            uint32_t evicted() const { return this->evicted_; }
+
+        protected:
+            void copy_in_(const uint8_t *data, size_t len)
+            {
+                size_t first = std::min(len, this->size_ - this->head_);
+                memcpy(this->buffer_ + this->head_, data, first);
+                memcpy(this->buffer_, data + first, len - first);
+                this->head_ = (this->head_ + len) % this->size_;
+            }
+
+            void copy_out_(size_t pos, uint8_t *out, size_t len) const
+            {
+                size_t first = std::min(len, this->size_ - pos);
+                memcpy(out, this->buffer_ + pos, first);
+                memcpy(out + first, this->buffer_, len - first);
+            }
+
+            uint8_t *buffer_ = nullptr;
+            size_t size_ = 0;
+            size_t head_ = 0;  // Next write
+            size_t tail_ = 0;  // Oldest record
+            size_t used_ = 0;
+            size_t count_ = 0;
+            uint32_t evicted_ = 0;
+        };
+
+        // =============================================================================
+        // Trace Encoder / Parser
+        // =============================================================================
+        // The encoder turns a capture ring into a trace, a slice at a time; the ring
+        // must not change until it is done. The parser takes a trace back in slices of
+        // any size and hands out each frame with its receive time rebuilt from the
+        // deltas (starting at 0). Traces may follow each other back to back.
+        class TraceEncoder
+        {
+        public:
+            void start(const CaptureRing *ring)
+            {
+                this->ring_ = ring;
+                this->cursor_ = ring->begin();
+                put_u32_le(this->pending_ + 8, ring->count());
+                memcpy(this->pending_, TRACE_MAGIC, 4);
+                this->pending_[4] = TRACE_VERSION;
+                this->pending_[5] = 0;
+                this->pending_[6] = 0;
+                this->pending_[7] = 0;
+                this->pending_len_ = TRACE_HEADER_SIZE;
+                this->pending_pos_ = 0;
+                this->first_ = true;
+                this->active_ = true;
+            }
+
+            // Fill out with up to cap bytes of the trace; 0 once all of it was read
+            size_t read(uint8_t *out, size_t cap)
+            {
+                size_t written = 0;
+                while (this->active_ && written < cap) {
+                    if (this->pending_pos_ == this->pending_len_ && !this->next_record_()) {
+                        this->active_ = false;
+                        break;
+                    }
+                    size_t n = std::min(cap - written, this->pending_len_ - this->pending_pos_);
+                    memcpy(out + written, this->pending_ + this->pending_pos_, n);
+                    this->pending_pos_ += n;
+                    written += n;
+                }
+                return written;
+            }
+
+            bool active() const { return this->active_; }
+
+        protected:
+            bool next_record_()
+            {
+                RawFrame frame;
+                if (!this->ring_->read(&this->cursor_, &frame)) {
+                    return false;
+                }
+                uint32_t dt_us = this->first_ ? 0 : frame.rx_us - this->last_rx_us_;
+                this->first_ = false;
+                this->last_rx_us_ = frame.rx_us;
+                this->pending_len_ = encode_trace_record(this->pending_, frame, dt_us);
+                this->pending_pos_ = 0;
+                return true;
+            }
+
+            const CaptureRing *ring_ = nullptr;
+            CaptureRing::Cursor cursor_ = {0, 0};
+            uint8_t pending_[TRACE_MAX_RECORD_SIZE];
+            size_t pending_len_ = 0;
+            size_t pending_pos_ = 0;
+            uint32_t last_rx_us_ = 0;
+            bool first_ = true;
+            bool active_ = false;
+        };
+
+        class TraceParser
+        {
+        public:
+            void reset()
+            {
+                this->have_ = 0;
+                this->left_ = 0;
+                this->in_trace_ = false;
+                this->failed_ = false;
+            }
+
+            // Calls on_frame(frame) per complete record; false (and stays false until
+            // reset()) on a bad header or record
+            template<typename F>
+            bool feed(const uint8_t *data, size_t len, F &&on_frame)
+            {
+                while (len > 0 && !this->failed_) {
+                    size_t need = this->needed_();
+                    size_t n = std::min(len, need - this->have_);
+                    memcpy(this->buffer_ + this->have_, data, n);
+                    this->have_ += n;
+                    data += n;
+                    len -= n;
+                    if (this->in_trace_ && this->have_ == TRACE_RECORD_HEADER_SIZE &&
+                        this->buffer_[11] > sizeof(RawFrame::data)) {
+                        this->failed_ = true;
+                        break;
+                    }
+                    if (this->have_ < this->needed_()) {
+                        continue;  // Record header just completed, or more bytes to come
+                    }
+
+                    if (!this->in_trace_) {
+                        if (memcmp(this->buffer_, TRACE_MAGIC, 4) != 0 || this->buffer_[4] != TRACE_VERSION) {
+                            this->failed_ = true;
+                            break;
+                        }
+                        this->left_ = get_u32_le(this->buffer_ + 8);
+                        this->in_trace_ = this->left_ > 0;
+                        this->rx_us_ = 0;
+                    } else {
+                        RawFrame frame;
+                        uint32_t dt_us;
+                        decode_trace_record(this->buffer_, &frame, &dt_us);
+                        this->rx_us_ += dt_us;
+                        frame.rx_us = this->rx_us_;
+                        on_frame(frame);
+                        this->in_trace_ = --this->left_ > 0;
+                    }
+                    this->have_ = 0;
+                }
+                return !this->failed_;
+            }
+
+            // Between traces, i.e. nothing cut off so far
+            bool idle() const { return !this->in_trace_ && this->have_ == 0; }
+
+        protected:
+            size_t needed_() const
+            {
+                if (!this->in_trace_) {
+                    return TRACE_HEADER_SIZE;
+                }
+                if (this->have_ < TRACE_RECORD_HEADER_SIZE) {
+                    return TRACE_RECORD_HEADER_SIZE;
+                }
+                return TRACE_RECORD_HEADER_SIZE + this->buffer_[11];
+            }
+
+            uint8_t buffer_[TRACE_MAX_RECORD_SIZE];
+            size_t have_ = 0;
+            uint32_t left_ = 0;
+            uint32_t rx_us_ = 0;
+            bool in_trace_ = false;
+            bool failed_ = false;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "timer_wheel.h"
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // State Coalescer
+        // =============================================================================
+        // Holds the latest state of rate-limited entities until their publish interval
+        // ends. Each entity that ever needs holding gets one buffer for good (entities
+        // are never removed), addressed by a 16-bit handle that doubles as its timer
+        // in a wheel; owner is the caller's reference back to the entity. Buffers and
+        // timers are caller-provided. States longer than STATE_SIZE are not held.
+        class Coalescer
+        {
+        public:
+            static constexpr uint16_t NONE = 0xFFFF;
+            static constexpr size_t STATE_SIZE = 28;
+
+            struct Buffer {
+                uint16_t owner;
+                uint8_t len;
+                bool held;
+                char state[STATE_SIZE];
+            };
+
+            void init(Buffer *buffers, TimerWheel::Timer *timers, size_t count, uint32_t now)
+            {
+                this->buffers_ = buffers;
+                this->count_ = count < NONE ? count : NONE;
+                this->used_ = 0;
+                this->timers_.init(timers, this->count_, now);
+            }
+
+            // A buffer for owner, or NONE once all are taken
+            uint16_t acquire(uint16_t owner)
+            {
+                if (this->used_ >= this->count_) {
+                    return NONE;
+                }
+                Buffer &buffer = this->buffers_[this->used_];
+                buffer.owner = owner;
+                buffer.held = false;
+                return this->used_++;
+            }
+
+            static bool fits(std::string_view state) { return state.size() <= STATE_SIZE; }
+
+            // Hold state until deadline_ms. Returns true if it replaced a state that was
+            // still waiting, i.e. one update was coalesced away.
+            bool hold(uint16_t handle, std::string_view state, uint32_t deadline_ms)
+            {
+                Buffer &buffer = this->buffers_[handle];
+                bool replaced = buffer.held;
+                memcpy(buffer.state, state.data(), state.size());
+                buffer.len = state.size();
+                buffer.held = true;
+                if (!replaced) {
+                    this->timers_.schedule(handle, deadline_ms);
+                }
+                return replaced;
+            }
+
+            // Forget a waiting state (superseded by one published directly); true if
+            // there was one
+            bool drop(uint16_t handle)
+            {
+                if (handle == NONE || !this->buffers_[handle].held) {
+                    return false;
+                }
+                this->buffers_[handle].held = false;
+                this->timers_.cancel(handle);
+                return true;
+            }
+
+            // Call flush(owner, state) for every held state whose interval has ended
+            template<typename F>
+            void advance(uint32_t now, F &&flush)
+            {
+                this->timers_.advance(now, [this, &flush](uint16_t handle) {
+                    Buffer &buffer = this->buffers_[handle];
+                    buffer.held = false;
+                    flush(buffer.owner, std::string_view(buffer.state, buffer.len));
+                });
+            }
+
+            size_t held() const { return this->timers_.armed_count(); }
+            size_t used() const { return this->used_; }
+            size_t capacity() const { return this->count_; }
+            size_t memory_usage() const { return this->count_ * (sizeof(Buffer) + sizeof(TimerWheel::Timer)); }
+
+        protected:
+            Buffer *buffers_ = nullptr;
+            size_t count_ = 0;
+            size_t used_ = 0;
+            TimerWheel timers_;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Component Table
+        // =============================================================================
+        // Per-device lists of 32-bit schema IDs (one per entity) in an append-only
+        // arena of 32-bit words over a caller-provided buffer. A list is a header word
+        // (count, capacity) followed by its IDs, addressed by a 16-bit word offset.
+        // A full list is moved to the end of the arena with twice the capacity, so the
+        // owner must store the handle add() returns; the old copy is not reused.
+        class ComponentTable
+        {
+        public:
+            static constexpr uint16_t NONE = 0xFFFF;
+            static constexpr uint16_t INITIAL_CAPACITY = 4;
+
+            void init(uint32_t *arena, size_t words)
+            {
+                this->arena_ = arena;
+                this->words_ = words < NONE ? words : NONE;
+                this->used_ = 0;
+            }
+
+            // Append id to list (NONE starts a new one). Returns the list's handle, which
+            // changes when it moves, or NONE if the arena is full (list is unchanged).
+            uint16_t add(uint16_t list, uint32_t id)
+            {
+                uint16_t count = this->size(list);
+                uint16_t capacity = list == NONE ? 0 : this->arena_[list] & 0xFFFF;
+                if (count == capacity) {
+                    if (capacity >= NONE / 2) {
+                        return NONE;
+                    }
+                    uint16_t grown = capacity == 0 ? INITIAL_CAPACITY : capacity * 2;
+                    if (this->used_ + 1 + grown > this->words_) {
+                        return NONE;
+                    }
+                    uint16_t moved = this->used_;
+                    if (count > 0) {
+                        memcpy(this->arena_ + moved + 1, this->arena_ + list + 1, count * sizeof(uint32_t));
+                    }
+                    this->arena_[moved] = (uint32_t(count) << 16) | grown;
+                    this->used_ += 1 + grown;
+                    list = moved;
+                }
+                this->arena_[list + 1 + count] = id;
+                this->arena_[list] += 1UL << 16;
+                return list;
+            }
+
+            void set(uint16_t list, uint16_t index, uint32_t id) { this->arena_[list + 1 + index] = id; }
+
+            bool contains(uint16_t list, uint32_t id) const
+            {
+                for (uint16_t i = 0; i < this->size(list); i++) {
+                    if (this->at(list, i) == id) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            uint16_t size(uint16_t list) const { return list == NONE ? 0 : this->arena_[list] >> 16; }
+            uint32_t at(uint16_t list, uint16_t index) const { return this->arena_[list + 1 + index]; }
+
+            size_t used() const { return this->used_ * sizeof(uint32_t); }
+            size_t capacity() const { return this->words_ * sizeof(uint32_t); }
+
+        protected:
+            uint32_t *arena_ = nullptr;
+            size_t words_ = 0;
+            size_t used_ = 0;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
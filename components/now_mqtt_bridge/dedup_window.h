@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Duplicate Suppression Window
+        // =============================================================================
+        // Sliding bitmap over the last WIDTH sequence numbers seen from one node. Bit i
+        // set = (highest - i) was accepted. Sequence numbers compare modulo 2^16, so
+        // the counter may wrap. A new boot id, or a sequence far outside the window
+        // (node reset without a new boot id), restarts the window instead of being
+        // rejected.
+        class DedupWindow
+        {
+        public:
+            static constexpr uint16_t WIDTH = 32;
+
+            // True if (boot_id, seq) was already accepted; otherwise records it
+            bool is_duplicate(uint16_t boot_id, uint16_t seq)
+            {
+                if (!this->valid_ || boot_id != this->boot_id_) {
+                    this->restart_(boot_id, seq);
+                    return false;
+                }
+
+                int16_t ahead = static_cast<int16_t>(seq - this->highest_);
+                if (ahead > 0) {
+                    this->bitmap_ = ahead >= WIDTH ? 1 : (this->bitmap_ << ahead) | 1;
+                    this->highest_ = seq;
+                    return false;
+                }
+
+                uint16_t behind = -ahead;
+                if (behind >= WIDTH) {
+                    this->restart_(boot_id, seq);
+                    return false;
+                }
+
+                uint32_t bit = 1UL << behind;
+                if (this->bitmap_ & bit) {
+                    return true;
+                }
+                this->bitmap_ |= bit;  // Late but new (reordered)
+                return false;
+            }
+
+        protected:
+            void restart_(uint16_t boot_id, uint16_t seq)
+            {
+                this->boot_id_ = boot_id;
+                this->highest_ = seq;
+                this->bitmap_ = 1;
+                this->valid_ = true;
+            }
+
+            uint32_t bitmap_ = 0;
+            uint16_t boot_id_ = 0;
+            uint16_t highest_ = 0;
+            bool valid_ = false;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
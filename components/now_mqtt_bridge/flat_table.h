@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Hashing
+        // =============================================================================
+        static constexpr uint64_t FNV1A_64_INIT = 0xcbf29ce484222325ULL;
+        static constexpr uint32_t FNV1A_32_INIT = 0x811c9dc5UL;
+
+        inline uint64_t fnv1a_64(uint64_t hash, const void *data, size_t len)
+        {
+            const uint8_t *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < len; i++) {
+                hash ^= bytes[i];
+                hash *= 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        inline uint32_t fnv1a_32(uint32_t hash, const void *data, size_t len)
+        {
+            const uint8_t *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < len; i++) {
+                hash ^= bytes[i];
+                hash *= 0x01000193UL;
+            }
+            return hash;
+        }
+
+        // =============================================================================
+        // Flat Hash Table
+        // =============================================================================
+        // Fixed-capacity open-addressed table with linear probing, keyed by a non-zero
+        // 64-bit key. Storage is handed in by the caller (so it can live in PSRAM) and
+        // never reallocated; find() and insert() do not allocate. Entries are never
+        // removed individually.
+        template<typename V>
+        class FlatTable
+        {
+        public:
+            struct Slot {
+                uint64_t key;  // 0 = empty
+                V value;
+            };
+
+            // Slot count for a table that must hold max_entries at <= 80% load
+            static size_t slots_for(size_t max_entries)
+            {
+                size_t needed = max_entries + max_entries / 4 + 1;
+                size_t slots = 1;
+                while (slots < needed) {
+                    slots <<= 1;
+                }
+                return slots;
+            }
+
+            // slots must be a power of two; max_entries caps the load factor
+            void init(Slot *storage, size_t slots, size_t max_entries)
+            {
+                this->slots_ = storage;
+                this->mask_ = slots - 1;
+                this->max_entries_ = max_entries;
+                this->clear();
+            }
+
+            void clear()
+            {
+                for (size_t i = 0; i <= this->mask_ && this->slots_ != nullptr; i++) {
+                    this->slots_[i].key = 0;
+                    this->slots_[i].value = V{};
+                }
+                this->size_ = 0;
+            }
+
+            V *find(uint64_t key)
+            {
+                if (this->slots_ == nullptr || key == 0) {
+                    return nullptr;
+                }
+                for (size_t i = key & this->mask_;; i = (i + 1) & this->mask_) {
+                    Slot &slot = this->slots_[i];
+                    if (slot.key == key) {
+                        return &slot.value;
+                    }
+                    if (slot.key == 0) {
+                        return nullptr;
+                    }
+                }
+            }
+
+            // Existing or new entry for key; nullptr if the table is full
+            V *insert(uint64_t key, bool *inserted)
+            {
+                *inserted = false;
+                if (this->slots_ == nullptr || key == 0) {
+                    return nullptr;
+                }
+                for (size_t i = key & this->mask_;; i = (i + 1) & this->mask_) {
+                    Slot &slot = this->slots_[i];
+                    if (slot.key == key) {
+                        return &slot.value;
+                    }
+                    if (slot.key == 0) {
+                        if (this->size_ >= this->max_entries_) {
+                            return nullptr;
+                        }
+                        slot.key = key;
+                        slot.value = V{};
+                        this->size_++;
+                        *inserted = true;
+                        return &slot.value;
+                    }
+                }
+            }
+
+            // Slot index of an entry returned by find()/insert(); stable for the table's lifetime
+            size_t index_of(const V *value) const
+            {
+                const char *base = reinterpret_cast<const char *>(&this->slots_[0].value);
+                return (reinterpret_cast<const char *>(value) - base) / sizeof(Slot);
+            }
+
+            V &at(size_t index) { return this->slots_[index].value; }
+            uint64_t key_at(size_t index) const { return this->slots_[index].key; }  // 0 = empty slot
+            size_t slot_count() const { return this->slots_ == nullptr ? 0 : this->mask_ + 1; }
+
+            template<typename F>
+            void for_each(F &&fn)
+            {
+                for (size_t i = 0; i <= this->mask_ && this->slots_ != nullptr; i++) {
+                    if (this->slots_[i].key != 0) {
+                        fn(this->slots_[i].key, this->slots_[i].value);
+                    }
+                }
+            }
+
+            size_t size() const { return this->size_; }
+            size_t max_entries() const { return this->max_entries_; }
+            size_t memory_usage() const { return this->slots_ == nullptr ? 0 : (this->mask_ + 1) * sizeof(Slot); }
+
+        protected:
+            Slot *slots_ = nullptr;
+            size_t mask_ = 0;
+            size_t max_entries_ = 0;
+            size_t size_ = 0;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Raw Frame Slot
+        // =============================================================================
+        // Everything the receive callback captures; parsing happens later in loop().
+        struct RawFrame {
+            uint8_t mac[6];
+            int8_t rssi;
+            uint8_t len;
+            uint32_t rx_us;
+            uint8_t data[250];
+        };
+
+        // =============================================================================
+        // Single-Producer / Single-Consumer Ring
+        // =============================================================================
+        // Lock-free ring over a fixed slot pool. The producer (Wi-Fi task) fills the
+        // slot returned by acquire() and publishes it with commit(); the consumer (main
+        // loop) reads front() and hands it back with pop(). Slots are never allocated
+        // or freed after construction.
+        template<typename T, size_t N>
+        class SpscRing
+        {
+            static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+        public:
+            // ---- Producer side ----
+
+            // Slot to fill, or nullptr (and the drop counter bumped) if the ring is full
+            T *acquire()
+            {
+                uint32_t head = this->head_.load(std::memory_order_relaxed);
+                uint32_t tail = this->tail_.load(std::memory_order_acquire);
+                if (head - tail >= N) {
+                    this->dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                return &this->slots_[head & (N - 1)];
+            }
+
+            void commit()
+            {
+                uint32_t head = this->head_.load(std::memory_order_relaxed) + 1;
+                this->head_.store(head, std::memory_order_release);
+
+                uint32_t depth = head - this->tail_.load(std::memory_order_relaxed);
+                if (depth > this->high_water_.load(std::memory_order_relaxed)) {
+                    this->high_water_.store(depth, std::memory_order_relaxed);
+                }
+            }
+
+            // ---- Consumer side ----
+
+            // Oldest committed slot, or nullptr if empty
+            const T *front() const
+            {
+                uint32_t tail = this->tail_.load(std::memory_order_relaxed);
+                if (tail == this->head_.load(std::memory_order_acquire)) {
+                    return nullptr;
+                }
+                return &this->slots_[tail & (N - 1)];
+            }
+
+            void pop()
+            {
+                this->tail_.store(this->tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+
+            // ---- Statistics (any thread) ----
+
+            static constexpr size_t capacity() { return N; }
+            size_t size() const
+            {
+                return this->head_.load(std::memory_order_acquire) - this->tail_.load(std::memory_order_acquire);
+            }
+            uint32_t dropped() const { return this->dropped_.load(std::memory_order_relaxed); }
+            uint32_t high_water() const { return this->high_water_.load(std::memory_order_relaxed); }
+
+        protected:
+            T slots_[N];
+            std::atomic<uint32_t> head_{0};
+            std::atomic<uint32_t> tail_{0};
+            std::atomic<uint32_t> dropped_{0};
+            std::atomic<uint32_t> high_water_{0};
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // JSON Writer
+        // =============================================================================
+        // Streams compact JSON into a caller-provided buffer with no allocation.
+        // Members come out in call order and strings are escaped the way
+        // ArduinoJson's serializeJson() does it ('"', '\\', \b \f \n \r \t, NUL as
+        // \u0000, everything else verbatim), so payloads match what a JsonDocument
+        // would have produced. A string_view with no data serializes as null, as an
+        // unset JsonDocument member would. Writing past the end sets overflow() and
+        // drops the rest; the buffer is NUL-terminated whenever there is room.
+        class JsonWriter
+        {
+        public:
+            JsonWriter(char *buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) { this->terminate_(); }
+
+            void begin_object()
+            {
+                this->separator_();
+                this->put_('{');
+                this->depth_++;
+                this->first_ |= 1U << this->depth_;
+            }
+
+            void end_object()
+            {
+                this->put_('}');
+                this->first_ &= ~(1U << this->depth_);
+                this->depth_--;
+            }
+
+            // "key": - the key is written as-is and must not need escaping
+            void key(std::string_view key)
+            {
+                this->separator_();
+                this->put_('"');
+                this->append_raw_(key);
+                this->put_('"');
+                this->put_(':');
+                this->value_pending_ = true;
+            }
+
+            void add(std::string_view key, std::string_view value)
+            {
+                this->key(key);
+                this->string(value);
+            }
+
+            void string(std::string_view value)
+            {
+                if (value.data() == nullptr) {
+                    this->raw_value("null");
+                    return;
+                }
+                this->begin_string();
+                this->append(value);
+                this->end_string();
+            }
+
+            // A string value built from several pieces, each escaped on the way
+            void begin_string()
+            {
+                this->separator_();
+                this->put_('"');
+            }
+
+            void append(std::string_view piece)
+            {
+                // Copy runs that need no escaping in one go
+                size_t start = 0;
+                for (size_t i = 0; i < piece.size(); i++) {
+                    char c = piece[i];
+                    if (c != '"' && c != '\\' && static_cast<uint8_t>(c) >= 0x20) {
+                        continue;
+                    }
+                    char escape = escape_char(c);
+                    if (escape == 0 && c != 0) {
+                        continue;  // Other control characters go out verbatim
+                    }
+                    this->append_raw_(piece.substr(start, i - start));
+                    if (escape != 0) {
+                        this->put_('\\');
+                        this->put_(escape);
+                    } else {
+                        this->append_raw_("\\u0000");
+                    }
+                    start = i + 1;
+                }
+                this->append_raw_(piece.substr(start));
+            }
+
+            void end_string() { this->put_('"'); }
+
+            // A value or run of members that is already valid JSON, e.g. a constant
+            // fragment like ,"mf":"espressif". It is copied verbatim, so a fragment
+            // that starts with members must carry its own leading comma.
+            void raw_value(std::string_view json)
+            {
+                this->separator_();
+                this->append_raw_(json);
+            }
+
+            void raw(std::string_view json) { this->append_raw_(json); }
+
+            static char escape_char(char c)
+            {
+                switch (c) {
+                    case '"': return '"';
+                    case '\\': return '\\';
+                    case '\b': return 'b';
+                    case '\f': return 'f';
+                    case '\n': return 'n';
+                    case '\r': return 'r';
+                    case '\t': return 't';
+                    default: return 0;
+                }
+            }
+
+            const char *data() const { return this->buffer_; }
+            size_t size() const { return this->len_; }
+            size_t capacity() const { return this->capacity_; }
+            bool overflow() const { return this->overflow_; }
+
+        protected:
+            // Comma before a member or array element, nothing before a member's value
+            void separator_()
+            {
+                if (this->value_pending_) {
+                    this->value_pending_ = false;
+                    return;
+                }
+                uint32_t bit = 1U << this->depth_;
+                if (this->first_ & bit) {
+                    this->first_ &= ~bit;
+                } else if (this->depth_ > 0) {
+                    this->put_(',');
+                }
+            }
+
+            void put_(char c)
+            {
+                if (this->overflow_ || this->len_ + 1 >= this->capacity_) {
+                    this->overflow_ = true;
+                    return;
+                }
+                this->buffer_[this->len_++] = c;
+                this->buffer_[this->len_] = '\0';
+            }
+
+            void append_raw_(std::string_view text)
+            {
+                if (this->overflow_ || this->len_ + text.size() >= this->capacity_) {
+                    this->overflow_ = true;
+                    return;
+                }
+                memcpy(this->buffer_ + this->len_, text.data(), text.size());
+                this->len_ += text.size();
+                this->buffer_[this->len_] = '\0';
+            }
+
+            void terminate_()
+            {
+                if (this->capacity_ > 0) {
+                    this->buffer_[0] = '\0';
+                }
+            }
+
+            char *buffer_;
+            size_t capacity_;
+            size_t len_ = 0;
+            uint32_t first_ = 0;  // Bit per depth: no member written yet
+            uint8_t depth_ = 0;
+            bool value_pending_ = false;
+            bool overflow_ = false;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -1,7 +1,10 @@
 #include "now_mqtt_bridge.h"
 #include "esphome/core/log.h"
 #include "esphome/core/application.h"
-#include <ArduinoJson.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 namespace esphome
 {
@@ -54,6 +57,47 @@ namespace esphome
                 return;
             }
 
+            if (!this->allocate_tables_()) {
+                this->mark_failed();
+                return;
+            }
+
+            // Home Assistant publishes "online" on its status topic after a restart;
+            // republish discovery with the next readings so it sees every entity again.
+            this->discovery_info_ = mqtt::global_mqtt_client->get_discovery_info();
+            if (this->snapshot_interval_ms_ > 0) {
+                this->restore_snapshot_();
+            }
+            mqtt::global_mqtt_client->subscribe(
+                this->discovery_info_.prefix + "/status",
+                [this](const std::string &topic, const std::string &payload) {
+                    if (payload == "online") {
+                        this->invalidate_discovery_("Home Assistant birth message");
+                    }
+                },
+                1);
+
+            if (this->capture_size_ > 0) {
+                const std::string &prefix = mqtt::global_mqtt_client->get_topic_prefix();
+                mqtt::global_mqtt_client->subscribe(
+                    prefix + "/capture/command",
+                    [this](const std::string &topic, const std::string &payload) { this->on_capture_command_(payload); },
+                    1);
+                mqtt::global_mqtt_client->subscribe(
+                    prefix + "/capture/load",
+                    [this](const std::string &topic, const std::string &payload) { this->on_capture_load_(payload); },
+                    1);
+            }
+
+            // Broadcast peer for PAIR_ACK replies to unpaired nodes
+            esp_now_peer_info_t peer_info = {};
+            memset(peer_info.peer_addr, 0xFF, sizeof(peer_info.peer_addr));
+            peer_info.channel = 0;  // Current channel
+            peer_info.ifidx = WIFI_IF_STA;
+            if (esp_now_add_peer(&peer_info) != ESP_OK) {
+                ESP_LOGW(TAG, "Failed to add broadcast peer, nodes cannot pair");
+            }
+
             // Register receive callback
             esp_now_register_recv_cb(Now_MQTT_BridgeComponent::static_receive_callback_);
 
@@ -62,282 +106,2088 @@ namespace esphome
                      this->publish_availability_ ? "yes" : "no");
         }
 
+        bool Now_MQTT_BridgeComponent::allocate_tables_()
+        {
+            // All tables are sized once here; lookups and inserts never allocate afterwards
+            uint8_t flags = this->use_psram_ ? RAMAllocator<uint8_t>::ALLOC_EXTERNAL : RAMAllocator<uint8_t>::ALLOC_INTERNAL;
+
+            size_t entity_slots = FlatTable<EntityState>::slots_for(this->max_entities_);
+            auto *entity_storage = RAMAllocator<FlatTable<EntityState>::Slot>(flags).allocate(entity_slots);
+
+            size_t device_slots = FlatTable<DeviceInfo>::slots_for(this->max_devices_);
+            auto *device_storage = RAMAllocator<FlatTable<DeviceInfo>::Slot>(flags).allocate(device_slots);
+
+            size_t name_bytes = this->max_devices_ * DEVICE_NAME_BYTES;
+            char *name_arena = RAMAllocator<char>(flags).allocate(name_bytes);
+            auto *name_index = RAMAllocator<FlatTable<uint16_t>::Slot>(flags).allocate(device_slots);
+            auto *timers = RAMAllocator<TimerWheel::Timer>(flags).allocate(device_slots);
+
+            // One schema per entity plus one node block per device
+            size_t max_schemas = size_t(this->max_entities_) + this->max_devices_;
+            size_t schema_bytes = std::min<size_t>(max_schemas * SCHEMA_BYTES_PER_ENTRY, UINT16_MAX);
+            size_t schema_slots = FlatTable<SchemaCache::Entry>::slots_for(max_schemas);
+            uint8_t *schema_arena = RAMAllocator<uint8_t>(flags).allocate(schema_bytes);
+            auto *schema_index = RAMAllocator<FlatTable<SchemaCache::Entry>::Slot>(flags).allocate(schema_slots);
+
+            size_t topic_bytes = std::min<size_t>(this->max_entities_ * TOPIC_BYTES_PER_ENTITY +
+                                                  this->max_devices_ * TOPIC_BYTES_PER_DEVICE,
+                                                  TopicTable::MAX_ARENA_SIZE);
+            char *topic_arena = RAMAllocator<char>(flags).allocate(topic_bytes);
+
+            // Hold buffers and aggregation windows only if some policy uses them; at most
+            // one of each per entity
+            size_t held_count = 0;
+            size_t window_count = 0;
+            for (const auto &policy : this->policies_) {
+                if (policy.min_interval_ms > 0) {
+                    held_count = this->max_entities_;
+                }
+                if (policy.aggregate_ms > 0) {
+                    window_count = this->max_entities_;
+                }
+            }
+            Coalescer::Buffer *held_buffers = nullptr;
+            TimerWheel::Timer *held_timers = nullptr;
+            if (held_count > 0) {
+                held_buffers = RAMAllocator<Coalescer::Buffer>(flags).allocate(held_count);
+                held_timers = RAMAllocator<TimerWheel::Timer>(flags).allocate(held_count);
+                if (held_buffers == nullptr || held_timers == nullptr) {
+                    ESP_LOGW(TAG, "Failed to allocate coalescing buffers; rate-limited states publish immediately");
+                    held_count = 0;
+                }
+            }
+            Aggregator::Window *windows = nullptr;
+            TimerWheel::Timer *window_timers = nullptr;
+            if (window_count > 0) {
+                windows = RAMAllocator<Aggregator::Window>(flags).allocate(window_count);
+                window_timers = RAMAllocator<TimerWheel::Timer>(flags).allocate(window_count);
+                if (windows == nullptr || window_timers == nullptr) {
+                    ESP_LOGW(TAG, "Failed to allocate aggregation windows; states publish unaggregated");
+                    window_count = 0;
+                }
+            }
+
+            // Device discovery: a component list per device, and the buffer its bundle is
+            // rendered into
+            size_t component_words = 0;
+            uint32_t *component_arena = nullptr;
+            if (this->device_discovery_) {
+                component_words = (size_t(this->max_entities_) + this->max_devices_) * COMPONENT_WORDS_PER_ENTITY;
+                component_arena = RAMAllocator<uint32_t>(flags).allocate(component_words);
+                this->device_discovery_payload_ = RAMAllocator<char>(flags).allocate(DEVICE_DISCOVERY_SIZE);
+                if (component_arena == nullptr || this->device_discovery_payload_ == nullptr) {
+                    ESP_LOGW(TAG, "Failed to allocate device discovery tables; using per-entity discovery");
+                    this->device_discovery_ = false;
+                    component_words = 0;
+                }
+            }
+
+            uint8_t *capture_buffer = nullptr;
+            if (this->capture_size_ > 0) {
+                capture_buffer = RAMAllocator<uint8_t>(flags).allocate(this->capture_size_);
+                if (capture_buffer == nullptr) {
+                    ESP_LOGW(TAG, "Failed to allocate %u-byte capture buffer; frames are not captured",
+                             (unsigned) this->capture_size_);
+                    this->capture_size_ = 0;
+                }
+            }
+
+            if (entity_storage == nullptr || device_storage == nullptr || name_arena == nullptr || name_index == nullptr ||
+                timers == nullptr || schema_arena == nullptr || schema_index == nullptr || topic_arena == nullptr) {
+                ESP_LOGE(TAG, "Failed to allocate device tables (%u devices, %u entities%s)",
+                         this->max_devices_, this->max_entities_, this->use_psram_ ? ", PSRAM" : "");
+                return false;
+            }
+
+            this->entities_.init(entity_storage, entity_slots, this->max_entities_);
+            this->devices_.init(device_storage, device_slots, this->max_devices_);
+            this->device_names_.init(name_arena, name_bytes, name_index, device_slots, this->max_devices_);
+            this->device_timers_.init(timers, device_slots, millis());
+            this->schemas_.init(schema_arena, schema_bytes, schema_index, schema_slots, max_schemas);
+            this->topics_.init(topic_arena, topic_bytes);
+            this->coalescer_.init(held_buffers, held_timers, held_count, millis());
+            this->aggregator_.init(windows, window_timers, window_count, millis());
+            this->components_.init(component_arena, component_words);
+            this->capture_.init(capture_buffer, this->capture_size_);
+            return true;
+        }
+
         void Now_MQTT_BridgeComponent::loop()
         {
-            // Periodically check for device timeouts
-            static uint32_t last_check = 0;
+            // A new MQTT session may have lost retained discovery config
+            bool connected = mqtt::global_mqtt_client->is_connected();
+            if (connected && !this->mqtt_connected_) {
+                // Except for what the snapshot restored: that was retained before the restart
+                bool keep_snapshot = this->snapshot_current_ && !this->mqtt_connected_once_;
+                this->invalidate_discovery_("MQTT connected");
+                this->snapshot_current_ = keep_snapshot;
+                this->mqtt_connected_once_ = true;
+            }
+            this->mqtt_connected_ = connected;
+
+            this->drain_ingest_();
+
+            // Only the wheel buckets whose second has passed are visited
             uint32_t now = millis();
-            
-            if (now - last_check > 60000) {  // Check every minute
-                last_check = now;
-                this->check_device_timeouts_();
+            this->device_timers_.advance(now, [this](uint16_t handle) { this->on_device_timeout_(handle); });
+            this->reassembly_.expire(now);
+            this->coalescer_.advance(now, [this](uint16_t entity_index, std::string_view state) {
+                this->flush_held_state_(entity_index, state);
+            });
+            this->aggregator_.advance(now, [this](const Aggregator::Window &window) { this->publish_aggregate_(window); });
+
+            if (this->replay_.active) {
+                this->pump_replay_();
+            }
+            if (this->capture_dump_ != CaptureDump::NONE) {
+                this->pump_capture_dump_();
+            }
+
+            if (this->snapshot_interval_ms_ > 0 && this->snapshot_dirty_ && !this->replay_.active &&
+                now - this->last_snapshot_ms_ >= this->snapshot_interval_ms_) {
+                this->save_snapshot_();
+            }
+
+            if (this->telemetry_interval_ms_ > 0 && mqtt::global_mqtt_client->is_connected()) {
+                this->publish_telemetry_();
+            }
+
+            if (now - this->last_stats_ms_ > STATS_INTERVAL_MS) {
+                this->last_stats_ms_ = now;
+
+                uint32_t dropped = this->ingest_.dropped();
+                if (dropped != this->reported_drops_) {
+                    ESP_LOGW(TAG, "Ingest queue full: dropped %u frame(s) (total %u, high water %u/%u)",
+                             dropped - this->reported_drops_, dropped, this->ingest_.high_water(),
+                             (unsigned) INGEST_QUEUE_SIZE);
+                    this->reported_drops_ = dropped;
+                }
+
+                ESP_LOGD(TAG, "Discovery cache: %u/%u entities, %u hits, %u misses",
+                         (unsigned) this->entities_.size(), this->max_entities_,
+                         this->discovery_hits_, this->discovery_misses_);
+                if (this->reassembly_.completed() > 0 || this->reassembly_.failures() > 0 ||
+                    this->reassembly_.timeouts() > 0) {
+                    ESP_LOGD(TAG, "Reassembly: %u message(s) complete, %u failed, %u timed out",
+                             this->reassembly_.completed(), this->reassembly_.failures(), this->reassembly_.timeouts());
+                }
+                ESP_LOGD(TAG, "Topic table: %u topics (%u/%u bytes)", (unsigned) this->topics_.size(),
+                         (unsigned) this->topics_.used(), (unsigned) this->topics_.capacity());
+                ESP_LOGD(TAG, "Schema cache: %u schemas (%u/%u bytes), %u request(s) sent",
+                         (unsigned) this->schemas_.size(), (unsigned) this->schemas_.used(),
+                         (unsigned) this->schemas_.capacity(), this->schema_requests_);
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::dump_config()
+        {
+            ESP_LOGCONFIG(TAG, "ESP-NOW MQTT Bridge:");
+            ESP_LOGCONFIG(TAG, "  Channel: %d", this->wifi_channel_);
+            ESP_LOGCONFIG(TAG, "  Publish availability: %s", YESNO(this->publish_availability_));
+            ESP_LOGCONFIG(TAG, "  Offline after: %u missed reports (%u s until the interval is known)",
+                          MISSED_REPORTS, (unsigned) (DEVICE_TIMEOUT_MS / 1000));
+            ESP_LOGCONFIG(TAG, "  Ingest queue: %u slots, %u frames per loop",
+                          (unsigned) INGEST_QUEUE_SIZE, this->max_frames_per_loop_);
+            ESP_LOGCONFIG(TAG, "  Device table: %u devices (%u bytes, names %u bytes)",
+                          this->max_devices_, (unsigned) this->devices_.memory_usage(),
+                          (unsigned) this->device_names_.capacity());
+            ESP_LOGCONFIG(TAG, "  Discovery cache: %u entities (%u bytes)",
+                          this->max_entities_, (unsigned) this->entities_.memory_usage());
+            ESP_LOGCONFIG(TAG, "  Topic table: %u bytes", (unsigned) this->topics_.capacity());
+            ESP_LOGCONFIG(TAG, "  Reassembly: %u messages of up to %u bytes, %u ms timeout",
+                          (unsigned) REASSEMBLY_SLOTS, (unsigned) now_mqtt_protocol::MAX_MESSAGE_SIZE,
+                          (unsigned) REASSEMBLY_TIMEOUT_MS);
+            ESP_LOGCONFIG(TAG, "  Schema cache: %u schemas (%u bytes)",
+                          this->max_entities_ + this->max_devices_, (unsigned) this->schemas_.memory_usage());
+            ESP_LOGCONFIG(TAG, "  Tables in PSRAM: %s", YESNO(this->use_psram_));
+            for (const auto &policy : this->policies_) {
+                ESP_LOGCONFIG(TAG, "  Publish policy: node '%s', entity '%s', device class '%s': QoS %u, retain %s, "
+                              "min interval %u ms, aggregate %u ms%s", policy.node.c_str(), policy.entity.c_str(),
+                              policy.device_class.c_str(), policy.qos, YESNO(policy.retain),
+                              (unsigned) policy.min_interval_ms, (unsigned) policy.aggregate_ms,
+                              policy.aggregate_ms > 0 && policy.passthrough ? " (with raw states)" : "");
+            }
+            if (this->coalescer_.capacity() > 0) {
+                ESP_LOGCONFIG(TAG, "  Coalescing: %u entities (%u bytes)", (unsigned) this->coalescer_.capacity(),
+                              (unsigned) this->coalescer_.memory_usage());
+            }
+            if (this->aggregator_.capacity() > 0) {
+                ESP_LOGCONFIG(TAG, "  Aggregation: %u entities (%u bytes)", (unsigned) this->aggregator_.capacity(),
+                              (unsigned) this->aggregator_.memory_usage());
+            }
+            if (this->device_discovery_) {
+                ESP_LOGCONFIG(TAG, "  Device discovery: yes (component table %u bytes, payload %u bytes)",
+                              (unsigned) this->components_.capacity(), (unsigned) DEVICE_DISCOVERY_SIZE);
+            }
+            if (this->telemetry_interval_ms_ > 0) {
+                ESP_LOGCONFIG(TAG, "  Telemetry: every %u s (discovery: %s)",
+                              (unsigned) (this->telemetry_interval_ms_ / 1000), YESNO(this->telemetry_discovery_));
+            }
+            if (this->capture_size_ > 0) {
+                ESP_LOGCONFIG(TAG, "  Frame capture: %u bytes", (unsigned) this->capture_size_);
+            }
+            if (this->snapshot_interval_ms_ > 0) {
+                ESP_LOGCONFIG(TAG, "  State snapshot: at most every %u s (up to %u bytes of flash)",
+                              (unsigned) (this->snapshot_interval_ms_ / 1000),
+                              (unsigned) (MAX_SNAPSHOT_CHUNKS * SNAPSHOT_CHUNK_SIZE));
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::on_shutdown()
+        {
+            // OTA and safe reboots: write what changed since the last snapshot
+            if (this->snapshot_interval_ms_ > 0 && this->snapshot_dirty_) {
+                this->save_snapshot_();
+                global_preferences->sync();
             }
         }
 
         // =============================================================================
         // Static Callback
         // =============================================================================
+        // Runs in the Wi-Fi task: copy the frame into the ingest ring and return.
 
+#if ESP_IDF_VERSION_MAJOR >= 5
+        void Now_MQTT_BridgeComponent::static_receive_callback_(const esp_now_recv_info_t *info, const uint8_t *data, int len)
+        {
+            enqueue_frame_(info->src_addr, data, len, info->rx_ctrl != nullptr ? info->rx_ctrl->rssi : 0);
+        }
+#else
         void Now_MQTT_BridgeComponent::static_receive_callback_(const uint8_t *mac, const uint8_t *data, int len)
         {
-            if (instance_ != nullptr) {
-                instance_->on_espnow_receive_(mac, data, len);
+            // RSSI is not exposed by the pre-5.0 receive callback
+            enqueue_frame_(mac, data, len, 0);
+        }
+#endif
+
+        void Now_MQTT_BridgeComponent::enqueue_frame_(const uint8_t *mac, const uint8_t *data, int len, int8_t rssi)
+        {
+            if (instance_ == nullptr || len <= 0) {
+                return;
+            }
+
+            RawFrame *frame = instance_->ingest_.acquire();
+            if (frame == nullptr) {
+                return;  // Counted as a drop by the ring
+            }
+
+            size_t copy_len = std::min<size_t>(len, sizeof(frame->data));
+            memcpy(frame->mac, mac, sizeof(frame->mac));
+            memcpy(frame->data, data, copy_len);
+            frame->len = copy_len;
+            frame->rssi = rssi;
+            frame->rx_us = micros();
+            instance_->ingest_.commit();
+        }
+
+        void Now_MQTT_BridgeComponent::drain_ingest_()
+        {
+            for (uint8_t i = 0; i < this->max_frames_per_loop_; i++) {
+                const RawFrame *frame = this->ingest_.front();
+                if (frame == nullptr) {
+                    break;
+                }
+                ESP_LOGV(TAG, "Frame: %u bytes, RSSI %d dBm", frame->len, frame->rssi);
+                if (this->capture_size_ > 0 && !this->capture_paused_ && this->capture_dump_ == CaptureDump::NONE) {
+                    this->capture_.push(*frame);
+                }
+                this->on_espnow_receive_(*frame);
+                this->ingest_.pop();
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::send_pair_ack_(const uint8_t *node_mac)
+        {
+            if (this->replay_.active) {
+                return;  // Replayed frames are not answered over the air
+            }
+
+            // Broadcast, so no per-node peer entry is needed; the node matches its own MAC
+            uint8_t channel = this->wifi_channel_;
+            wifi_second_chan_t second;
+            esp_wifi_get_channel(&channel, &second);
+
+            uint8_t ack[now_mqtt_protocol::PAIR_ACK_SIZE];
+            size_t len = now_mqtt_protocol::encode_pair_ack(ack, sizeof(ack), node_mac, channel);
+            uint8_t broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+            esp_err_t err = esp_now_send(broadcast, ack, len);
+            if (err != ESP_OK) {
+                ESP_LOGD(TAG, "PAIR_ACK send failed: %s", esp_err_to_name(err));
+                return;
+            }
+            this->pair_acks_sent_++;
+        }
+
+        void Now_MQTT_BridgeComponent::send_schema_request_(uint64_t mac_key, const char *mac_str)
+        {
+            if (this->replay_.active) {
+                return;
+            }
+
+            // Frames already queued at the node reference the same schemas; ask once
+            uint32_t now = millis();
+            if (mac_key == this->last_schema_request_mac_ && now - this->last_schema_request_ms_ < SCHEMA_REQUEST_INTERVAL_MS) {
+                return;
+            }
+            this->last_schema_request_mac_ = mac_key;
+            this->last_schema_request_ms_ = now;
+
+            uint8_t node_mac[6];
+            for (int i = 0; i < 6; i++) {
+                node_mac[i] = (mac_key >> (8 * (5 - i))) & 0xFF;
+            }
+            uint8_t request[now_mqtt_protocol::SCHEMA_REQUEST_SIZE];
+            size_t len = now_mqtt_protocol::encode_schema_request(request, sizeof(request), node_mac);
+            uint8_t broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+            esp_err_t err = esp_now_send(broadcast, request, len);
+            if (err != ESP_OK) {
+                ESP_LOGD(TAG, "SCHEMA_REQUEST send failed: %s", esp_err_to_name(err));
+                return;
             }
+            ESP_LOGD(TAG, "Unknown schema from %s, asking for full frames", mac_str);
+            this->schema_requests_++;
         }
 
         // =============================================================================
         // ESP-NOW Receive Handler
         // =============================================================================
 
-        void Now_MQTT_BridgeComponent::on_espnow_receive_(const uint8_t *mac, const uint8_t *data, int len)
+        void Now_MQTT_BridgeComponent::on_espnow_receive_(const RawFrame &frame)
         {
-            // Convert MAC to string
-            std::string mac_str = this->mac_to_string_(mac);
-            
-            // Copy data to null-terminated buffer
-            char received_string[251];
-            size_t copy_len = std::min(len, 250);
-            memcpy(received_string, data, copy_len);
-            received_string[copy_len] = '\0';
-
-            // Tokenize the received string
-            char *tokens[13];
-            int token_count = split_string_(tokens, 13, received_string, FIELD_DELIMITER);
-
-            // Validate token count
-            if (token_count != EXPECTED_TOKEN_COUNT) {
-                ESP_LOGD(TAG, "Ignoring malformed packet (got %d tokens, expected %d)", 
-                         token_count, EXPECTED_TOKEN_COUNT);
+            uint64_t mac_key = pack_mac_(frame.mac);
+            char mac_str[13];
+            format_mac_(mac_key, mac_str);
+            this->frames_received_++;
+
+            // Control frames: answer a sweeping node's PROBE with our MAC and channel;
+            // anything else (e.g. another bridge's PAIR_ACK) is not for us
+            uint8_t flags = now_mqtt_protocol::frame_flags(frame.data, frame.len);
+            if (flags & now_mqtt_protocol::FLAG_CONTROL) {
+                if (now_mqtt_protocol::is_probe(frame.data, frame.len)) {
+                    ESP_LOGD(TAG, "Channel probe from %s", mac_str);
+                    this->send_pair_ack_(frame.mac);
+                }
+                return;
+            }
+
+            // A fragment is held until its message is complete; the message then goes
+            // through the same path as a frame
+            if (flags & now_mqtt_protocol::FLAG_FRAGMENT) {
+                now_mqtt_protocol::Fragment fragment;
+                if (!now_mqtt_protocol::decode_fragment(frame.data, frame.len, &fragment)) {
+                    ESP_LOGD(TAG, "Ignoring malformed fragment from %s", mac_str);
+                    this->parse_errors_++;
+                    return;
+                }
+                size_t len;
+                const uint8_t *message = this->reassembly_.add(mac_key, fragment, millis(), &len);
+                if (message != nullptr) {
+                    ESP_LOGV(TAG, "Reassembled %u-byte message from %s (%u fragments)", (unsigned) len, mac_str,
+                             fragment.total);
+                    this->handle_message_(frame.mac, mac_key, mac_str, message, len, frame.rssi);
+                    this->record_latency_(frame.rx_us);
+                }
                 return;
             }
 
-            ESP_LOGD(TAG, "Received from %s: %s:%s:%s:%s:%s:%s:...", 
-                     mac_str.c_str(), tokens[0], tokens[1], tokens[2], tokens[3], tokens[4], tokens[5]);
+            this->handle_message_(frame.mac, mac_key, mac_str, frame.data, frame.len, frame.rssi);
+            this->record_latency_(frame.rx_us);
+        }
 
-            // Update device tracking
-            if (strlen(tokens[0]) > 0) {
-                this->update_device_seen_(mac_str, tokens[0]);
+        void Now_MQTT_BridgeComponent::handle_message_(const uint8_t *mac, uint64_t mac_key, const char *mac_str,
+                                                       const uint8_t *data, size_t len, int8_t rssi)
+        {
+            // A retransmission the bridge already heard is dropped here, before any parsing.
+            // Sequenced frames use the node's window; older senders fall back to comparing
+            // against the previous frame's hash.
+            uint8_t flags = now_mqtt_protocol::frame_flags(data, len);
+            uint16_t boot_id = 0, seq = 0;
+            bool sequenced = now_mqtt_protocol::peek_sequence(data, len, &boot_id, &seq);
+            uint32_t frame_hash = sequenced ? 0 : fnv1a_32(FNV1A_32_INIT, data, len);
+            DeviceInfo *device = this->devices_.find(mac_key);
+            if (device != nullptr) {
+                bool duplicate = sequenced ? device->dedup.is_duplicate(boot_id, seq)
+                                           : device->link.last_frame_hash == frame_hash &&
+                                                 millis() - device->last_seen_ms < DUPLICATE_WINDOW_MS;
+                if (duplicate) {
+                    device->link.duplicates++;
+                    this->duplicates_++;
+                    ESP_LOGV(TAG, "Dropping duplicate frame from %s (seq %u)", mac_str, seq);
+                    return;
+                }
             }
+            bool window_updated = device != nullptr;
 
-            // Determine message type and process
-            std::string message_type = tokens[2];
-            
-            if (message_type == "binary_sensor") {
-                this->process_binary_sensor_message_((const char**)tokens, mac_str);
+            bool ok;
+            if (now_mqtt_protocol::is_binary_frame(data, len)) {
+                ok = this->handle_binary_frame_(mac_key, mac_str, data, len);
             } else {
-                this->process_sensor_message_((const char**)tokens, mac_str);
+                ok = this->handle_text_frame_(mac_key, mac_str, data, len);
+            }
+            if (!ok) {
+                this->parse_errors_++;
+            } else if (flags & now_mqtt_protocol::FLAG_PAIR_REQUEST) {
+                this->send_pair_ack_(mac);
+            }
+
+            // Looked up again: a node's first valid frame has just added it
+            device = this->devices_.find(mac_key);
+            if (device != nullptr) {
+                device->link.record(ok, rssi);
+                device->link.last_frame_hash = frame_hash;
+                if (sequenced && !window_updated) {
+                    device->dedup.is_duplicate(boot_id, seq);
+                }
             }
         }
 
         // =============================================================================
-        // Message Processing
+        // Frame Decoding
         // =============================================================================
 
-        void Now_MQTT_BridgeComponent::process_sensor_message_(const char *tokens[], const std::string &mac_str)
+        bool Now_MQTT_BridgeComponent::handle_text_frame_(uint64_t mac_key, const char *mac_str, const uint8_t *data, int len)
         {
-            this->publish_sensor_discovery_(tokens, mac_str);
-            this->publish_sensor_state_(tokens);
+            // Parsed in place (escapes are removed), and the ingest slot is read-only
+            char line[now_mqtt_protocol::MAX_FRAME_SIZE];
+            size_t line_len = std::min<size_t>(len, sizeof(line));
+            memcpy(line, data, line_len);
+
+            now_mqtt_protocol::NodeInfo node;
+            now_mqtt_protocol::Reading reading;
+            std::string_view state;
+            if (!now_mqtt_protocol::parse_text_frame(line, line_len, &node, &reading, &state)) {
+                ESP_LOGD(TAG, "Ignoring malformed v1 packet from %s (expected %u fields)",
+                         mac_str, (unsigned) now_mqtt_protocol::TEXT_FIELD_COUNT);
+                return false;
+            }
+
+            ESP_LOGD(TAG, "Received v1 from %s: %.*s/%.*s = %.*s",
+                     mac_str, (int) node.name.size(), node.name.data(),
+                     (int) reading.name.size(), reading.name.data(), (int) state.size(), state.data());
+
+            if (!node.name.empty()) {
+                this->update_device_seen_(mac_key, mac_str, node);
+            }
+
+            this->process_reading_(mac_key, node, reading, state, mac_str);
+            this->flush_device_discovery_(mac_key, mac_str, node);
+            return true;
         }
 
-        void Now_MQTT_BridgeComponent::process_binary_sensor_message_(const char *tokens[], const std::string &mac_str)
+        bool Now_MQTT_BridgeComponent::handle_binary_frame_(uint64_t mac_key, const char *mac_str, const uint8_t *data, int len)
         {
-            this->publish_binary_sensor_discovery_(tokens, mac_str);
-            this->publish_binary_sensor_state_(tokens);
+            now_mqtt_protocol::FrameReader reader(data, len);
+            if (!reader.valid()) {
+                ESP_LOGD(TAG, "Ignoring malformed v2 frame from %s (%d bytes)", mac_str, len);
+                return false;
+            }
+
+            // A compact frame names its node block by schema ID; a full one teaches it
+            now_mqtt_protocol::NodeInfo compact_node;
+            uint8_t node_scratch[now_mqtt_protocol::MAX_SCHEMA_SIZE];
+            if (reader.compact()) {
+                now_mqtt_protocol::RecordPrefix block;
+                if (!this->find_schema_(mac_key, reader.node_schema(), &block, node_scratch) ||
+                    now_mqtt_protocol::decode_node_block(block.data, block.len, &compact_node) == 0) {
+                    this->send_schema_request_(mac_key, mac_str);
+                    return true;
+                }
+            } else {
+                this->learn_schema_(mac_key, reader.node_block());
+            }
+
+            const now_mqtt_protocol::NodeInfo &node = reader.compact() ? compact_node : reader.node();
+            ESP_LOGD(TAG, "Received v2%s from %s: %.*s, %u reading(s), %d bytes", reader.compact() ? " (compact)" : "",
+                     mac_str, (int) node.name.size(), node.name.data(), reader.count(), len);
+
+            if (!node.name.empty()) {
+                this->update_device_seen_(mac_key, mac_str, node);
+            }
+
+            // The resolved prefix is only needed until the reading is processed
+            uint8_t record_scratch[now_mqtt_protocol::MAX_SCHEMA_SIZE];
+            auto lookup = [this, mac_key, &record_scratch](uint32_t schema, now_mqtt_protocol::RecordPrefix *prefix) {
+                return this->find_schema_(mac_key, schema, prefix, record_scratch);
+            };
+
+            now_mqtt_protocol::Reading reading;
+            while (reader.next(&reading, lookup)) {
+                if (!reader.compact()) {
+                    this->learn_schema_(mac_key, reading.prefix);
+                }
+
+                char value_buf[32];
+                std::string_view state;
+
+                switch (reading.type) {
+                    case now_mqtt_protocol::ReadingType::SENSOR: {
+                        size_t n = now_mqtt_protocol::format_value(value_buf, sizeof(value_buf), reading.value,
+                                                                   reading.meta.has_accuracy ? reading.meta.accuracy : 2);
+                        state = std::string_view(value_buf, n);
+                        break;
+                    }
+                    case now_mqtt_protocol::ReadingType::BINARY_SENSOR:
+                        state = reading.binary_value ? "ON" : "OFF";
+                        break;
+                    case now_mqtt_protocol::ReadingType::TEXT_SENSOR:
+                        state = reading.text;
+                        break;
+                }
+
+                this->process_reading_(mac_key, node, reading, state, mac_str);
+            }
+            this->flush_device_discovery_(mac_key, mac_str, node);
+
+            if (reader.missing_schema() != 0) {
+                // Not malformed: the node will resend in full
+                this->send_schema_request_(mac_key, mac_str);
+                return true;
+            }
+            if (reader.error()) {
+                ESP_LOGD(TAG, "Truncated v2 frame from %s (decoded %u readings)", mac_str, reader.count());
+                return false;
+            }
+            return true;
         }
 
         // =============================================================================
-        // MQTT Publishing - Sensor
+        // Schema Cache
         // =============================================================================
+        // Schemas are learned from every full frame (a cheap hash and lookup once
+        // known) and kept in RAM, backed by one flash preference each so a restarted
+        // bridge can keep decoding compact frames. A schema the cache cannot hold is
+        // read from flash on every use.
 
-        void Now_MQTT_BridgeComponent::publish_sensor_discovery_(const char *tokens[], const std::string &mac_str)
+        void Now_MQTT_BridgeComponent::learn_schema_(uint64_t mac_key, const now_mqtt_protocol::RecordPrefix &schema)
         {
-            DynamicJsonDocument doc(512);
-            
-            if (strlen(tokens[1]) > 0) doc["dev_cla"] = tokens[1];
-            if (strlen(tokens[4]) > 0) doc["unit_of_meas"] = tokens[4];
-            if (strlen(tokens[2]) > 0) doc["stat_cla"] = tokens[2];
-            if (strlen(tokens[3]) > 0) doc["name"] = tokens[3];
-            
-            // Icon (reconstruct from split parts)
-            if (strlen(tokens[6]) > 0 && strlen(tokens[7]) > 0) {
-                std::string icon = std::string(tokens[6]) + ":" + tokens[7];
-                doc["icon"] = icon;
+            if (schema.len == 0 || schema.len > now_mqtt_protocol::MAX_SCHEMA_SIZE) {
+                return;  // Never referenced by a compact frame
             }
-            
-            // State topic
-            std::string state_topic = std::string(tokens[0]) + "/sensor/" + tokens[3] + "/state";
-            doc["stat_t"] = state_topic;
-            
-            // Unique ID
-            std::string unique_id = mac_str + "_" + tokens[3];
-            doc["uniq_id"] = unique_id;
-            
-            // Device info
-            JsonObject dev = doc["dev"].to<JsonObject>();
-            dev["ids"] = mac_str;
-            if (strlen(tokens[0]) > 0) dev["name"] = tokens[0];
-            dev["sw"] = tokens[8];
-            dev["mdl"] = tokens[9];
-            dev["mf"] = "espressif";
-            
-            // Serialize and publish
-            std::string json;
-            serializeJson(doc, json);
-            
-            this->discovery_info_ = mqtt::global_mqtt_client->get_discovery_info();
-            std::string config_topic = this->discovery_info_.prefix + "/sensor/" + tokens[0] + "/" + tokens[3] + "/config";
-            
-            mqtt::global_mqtt_client->publish(config_topic, json, 2, true);
-            ESP_LOGD(TAG, "Published discovery: %s", config_topic.c_str());
+            uint32_t id = now_mqtt_protocol::schema_id(schema.data, schema.len);
+            uint64_t key = SchemaCache::key(mac_key, id);
+            now_mqtt_protocol::RecordPrefix cached;
+            if (this->schemas_.find(key, &cached)) {
+                return;
+            }
+            bool cached_now = this->schemas_.insert(key, schema.data, schema.len, &cached);
+
+            ESPPreferenceObject pref =
+                global_preferences->make_preference<SchemaBlob>(schema_preference_key_(mac_key, id), true);
+            SchemaBlob blob;
+            // With the cache full this runs on every full frame: only write what flash lacks
+            if (!cached_now && pref.load(&blob) && blob.schema == id && blob.len == schema.len &&
+                memcmp(blob.data, schema.data, schema.len) == 0) {
+                return;
+            }
+            blob = {};
+            blob.schema = id;
+            blob.len = schema.len;
+            memcpy(blob.data, schema.data, schema.len);
+            pref.save(&blob);
+        }
+
+        bool Now_MQTT_BridgeComponent::find_schema_(uint64_t mac_key, uint32_t schema,
+                                                    now_mqtt_protocol::RecordPrefix *out, uint8_t *scratch)
+        {
+            uint64_t key = SchemaCache::key(mac_key, schema);
+            if (this->schemas_.find(key, out)) {
+                return true;
+            }
+
+            SchemaBlob blob;
+            ESPPreferenceObject pref =
+                global_preferences->make_preference<SchemaBlob>(schema_preference_key_(mac_key, schema), true);
+            if (!pref.load(&blob) || blob.schema != schema || blob.len > sizeof(blob.data) ||
+                now_mqtt_protocol::schema_id(blob.data, blob.len) != schema) {
+                return false;
+            }
+            if (this->schemas_.insert(key, blob.data, blob.len, out)) {
+                return true;
+            }
+            memcpy(scratch, blob.data, blob.len);
+            *out = {scratch, blob.len};
+            return true;
         }
 
-        void Now_MQTT_BridgeComponent::publish_sensor_state_(const char *tokens[])
+        uint32_t Now_MQTT_BridgeComponent::schema_preference_key_(uint64_t mac_key, uint32_t schema)
         {
-            std::string state_topic = std::string(tokens[0]) + "/sensor/" + tokens[3] + "/state";
-            mqtt::global_mqtt_client->publish(state_topic, tokens[5], 2, true);
-            ESP_LOGD(TAG, "Published state: %s = %s", state_topic.c_str(), tokens[5]);
+            uint32_t hash = fnv1a_32(FNV1A_32_INIT, "now_mqtt_schema", 15);
+            hash = fnv1a_32(hash, &mac_key, sizeof(mac_key));
+            return fnv1a_32(hash, &schema, sizeof(schema));
         }
 
         // =============================================================================
-        // MQTT Publishing - Binary Sensor
+        // Message Processing
         // =============================================================================
 
-        void Now_MQTT_BridgeComponent::publish_binary_sensor_discovery_(const char *tokens[], const std::string &mac_str)
+        void Now_MQTT_BridgeComponent::process_reading_(uint64_t mac_key, const now_mqtt_protocol::NodeInfo &node,
+                                                        const now_mqtt_protocol::Reading &reading,
+                                                        std::string_view state, const char *mac_str)
         {
-            DynamicJsonDocument doc(512);
-            
-            if (strlen(tokens[3]) > 0) doc["name"] = tokens[3];
-            if (strlen(tokens[1]) > 0) doc["dev_cla"] = tokens[1];
-            
-            // State topic
-            std::string state_topic = std::string(tokens[0]) + "/binary_sensor/" + tokens[3] + "/state";
-            doc["stat_t"] = state_topic;
-            
-            // Unique ID
-            std::string unique_id = mac_str + "_" + tokens[3];
-            doc["uniq_id"] = unique_id;
-            
-            // Device info
-            JsonObject dev = doc["dev"].to<JsonObject>();
-            dev["ids"] = mac_str;
-            if (strlen(tokens[0]) > 0) dev["name"] = tokens[0];
-            dev["sw"] = tokens[8];
-            dev["mdl"] = tokens[9];
-            dev["mf"] = "espressif";
-            
-            // Serialize and publish
-            std::string json;
-            serializeJson(doc, json);
-            
-            this->discovery_info_ = mqtt::global_mqtt_client->get_discovery_info();
-            std::string config_topic = this->discovery_info_.prefix + "/binary_sensor/" + tokens[0] + "/" + tokens[3] + "/config";
-            
-            mqtt::global_mqtt_client->publish(config_topic, json, 2, true);
+            if (node.name.empty() || reading.name.empty()) {
+                ESP_LOGD(TAG, "Ignoring reading without node or entity name from %s", mac_str);
+                return;
+            }
+
+            EntityState *entity;
+            bool discover = this->discovery_needed_(node, reading, mac_str, &entity);
+            uint8_t policy_index = entity != nullptr ? entity->policy : this->match_policy_(node, reading);
+            const PublishPolicy &policy = this->policy_(policy_index);
+
+            // Aggregated entities publish windows on a derived topic, raw states only with passthrough
+            uint16_t window = this->aggregate_window_(entity, policy, node, reading, discover);
+            bool raw = window == Aggregator::NONE || policy.passthrough;
+
+            // With device discovery the node's bundle goes out once its frame is done
+            if (discover && !(this->device_discovery_ && this->bundle_entity_(mac_key, node, reading))) {
+                if (window != Aggregator::NONE) {
+                    this->publish_aggregate_discovery_(node, reading, mac_str,
+                                                       this->topics_.get(this->aggregator_.at(window).topic));
+                }
+                if (raw) {
+                    this->publish_entity_discovery_(node, reading, mac_str);
+                }
+            }
+
+            std::string fallback;
+            std::string_view state_topic = this->state_topic_(entity, node, reading, &fallback);
+            bool newest = newest_sample_(entity, reading);
+            if (window != Aggregator::NONE) {
+                this->add_sample_(window, policy, state, newest);
+            }
+            if (newest && raw) {
+                this->publish_state_(entity, policy_index, state_topic, state);
+            }
+
+            // Buffered (store-and-forward) readings also go out with their sample time
+            if (reading.aged) {
+                this->publish_reading_history_(state_topic, reading, state);
+            }
         }
 
-        void Now_MQTT_BridgeComponent::publish_binary_sensor_state_(const char *tokens[])
+        // =============================================================================
+        // Discovery Cache
+        // =============================================================================
+
+        bool Now_MQTT_BridgeComponent::discovery_needed_(const now_mqtt_protocol::NodeInfo &node,
+                                                         const now_mqtt_protocol::Reading &reading,
+                                                         const char *mac_str, EntityState **entity_out)
+        {
+            uint8_t type = static_cast<uint8_t>(reading.type);
+            uint8_t separator = 0;
+            uint64_t key = entity_key_(mac_str, reading.name);
+
+            // Everything that ends up in the discovery payload
+            const std::string_view fields[] = {
+                node.name, node.version, node.board,
+                reading.meta.device_class, reading.meta.state_class, reading.meta.unit, reading.meta.icon,
+            };
+            uint32_t meta_hash = fnv1a_32(FNV1A_32_INIT, &type, 1);
+            for (const auto &field : fields) {
+                meta_hash = fnv1a_32(meta_hash, field.data(), field.size());
+                meta_hash = fnv1a_32(meta_hash, &separator, 1);
+            }
+
+            bool inserted;
+            EntityState *entity = this->entities_.insert(key, &inserted);
+            *entity_out = entity;
+            if (entity == nullptr) {
+                // Cache full: fall back to publishing every time
+                this->discovery_misses_++;
+                return true;
+            }
+
+            if (inserted) {
+                entity->has_sample = false;
+                entity->has_published = false;
+                entity->topic = TopicTable::INVALID;
+                entity->held = Coalescer::NONE;
+                entity->aggregate = Aggregator::NONE;
+            }
+            if (!inserted && entity->meta_hash == meta_hash && this->current_epoch_(entity->epoch)) {
+                this->discovery_hits_++;
+                return false;
+            }
+
+            // A renamed node moves the entity's state topic; render it again on next use
+            if (entity->topic != TopicTable::INVALID &&
+                !this->topics_.matches(entity->topic, {node.name, "/", domain_(reading), "/", reading.name, "/state"})) {
+                entity->topic = TopicTable::INVALID;
+            }
+
+            entity->meta_hash = meta_hash;
+            entity->epoch = this->discovery_epoch_;
+            this->snapshot_dirty_ = true;
+            entity->policy = this->match_policy_(node, reading);
+            this->discovery_misses_++;
+            return true;
+        }
+
+        uint64_t Now_MQTT_BridgeComponent::entity_key_(const char *mac_str, std::string_view name)
         {
-            std::string state_topic = std::string(tokens[0]) + "/binary_sensor/" + tokens[3] + "/state";
-            mqtt::global_mqtt_client->publish(state_topic, tokens[5], 2, true);
+            uint8_t separator = 0;
+            uint64_t key = fnv1a_64(FNV1A_64_INIT, mac_str, strlen(mac_str));
+            key = fnv1a_64(key, &separator, 1);
+            return fnv1a_64(key, name.data(), name.size());
+        }
+
+        bool Now_MQTT_BridgeComponent::newest_sample_(EntityState *entity, const now_mqtt_protocol::Reading &reading)
+        {
+            // Without a cache entry there is nothing to compare against
+            if (entity == nullptr) {
+                return true;
+            }
+            uint32_t sample_ms = millis() - reading.age_s * 1000;
+            if (reading.aged && entity->has_sample && static_cast<int32_t>(sample_ms - entity->sample_ms) < 0) {
+                return false;
+            }
+            entity->sample_ms = sample_ms;
+            entity->has_sample = true;
+            return true;
+        }
+
+        void Now_MQTT_BridgeComponent::invalidate_discovery_(const char *reason)
+        {
+            ESP_LOGD(TAG, "Republishing discovery on next readings (%s)", reason);
+            this->discovery_epoch_++;
+            this->snapshot_current_ = false;
         }
 
         // =============================================================================
-        // Device Tracking
+        // MQTT Publishing - Entity Discovery
         // =============================================================================
+        // One retained config per entity under <prefix>/<domain>/<node>/<entity>/config.
+        // The member writers are shared with device discovery, which lists the same
+        // configs (minus the device block) as components of one payload.
 
-        void Now_MQTT_BridgeComponent::update_device_seen_(const std::string &mac_str, const std::string &name)
+        void Now_MQTT_BridgeComponent::publish_entity_discovery_(const now_mqtt_protocol::NodeInfo &node,
+                                                                 const now_mqtt_protocol::Reading &reading,
+                                                                 const char *mac_str)
         {
-            auto it = this->devices_.find(mac_str);
-            
-            if (it == this->devices_.end()) {
-                // New device
-                DeviceInfo info;
-                info.name = name;
-                info.mac_str = mac_str;
-                info.last_seen_ms = millis();
-                info.online = true;
-                
-                this->devices_[mac_str] = info;
-                
-                ESP_LOGI(TAG, "New device discovered: %s (%s)", name.c_str(), mac_str.c_str());
-                
-                if (this->publish_availability_) {
-                    this->publish_device_availability_(name, true);
-                }
+            JsonWriter json(this->discovery_payload_, sizeof(this->discovery_payload_));
+            json.begin_object();
+            this->write_entity_config_(json, node, reading, mac_str);
+            this->write_discovery_device_(json, node, mac_str);
+            json.end_object();
+
+            std::string config_topic = this->discovery_info_.prefix + "/" + domain_(reading) + "/" +
+                                       std::string(node.name) + "/" + std::string(reading.name) + "/config";
+            if (this->publish_discovery_(config_topic, json)) {
+                ESP_LOGD(TAG, "Published discovery: %s", config_topic.c_str());
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::write_entity_config_(JsonWriter &json, const now_mqtt_protocol::NodeInfo &node,
+                                                            const now_mqtt_protocol::Reading &reading,
+                                                            const char *mac_str)
+        {
+            const now_mqtt_protocol::EntityMeta &meta = reading.meta;
+            if (reading.type == now_mqtt_protocol::ReadingType::BINARY_SENSOR) {
+                json.add("name", reading.name);
+                if (!meta.device_class.empty()) json.add("dev_cla", meta.device_class);
             } else {
-                // Existing device
-                bool was_offline = !it->second.online;
-                
-                it->second.last_seen_ms = millis();
-                it->second.online = true;
-                
-                if (was_offline) {
-                    ESP_LOGI(TAG, "Device back online: %s", name.c_str());
-                    if (this->publish_availability_) {
-                        this->publish_device_availability_(name, true);
-                    }
-                }
+                if (!meta.device_class.empty()) json.add("dev_cla", meta.device_class);
+                if (!meta.unit.empty()) json.add("unit_of_meas", meta.unit);
+                if (!meta.state_class.empty()) json.add("stat_cla", meta.state_class);
+                json.add("name", reading.name);
+                if (!meta.icon.empty()) json.add("icon", meta.icon);
             }
+
+            json.key("stat_t");
+            json.begin_string();
+            json.append(node.name);
+            json.append("/");
+            json.append(domain_(reading));
+            json.append("/");
+            json.append(reading.name);
+            json.append("/state");
+            json.end_string();
+
+            json.key("uniq_id");
+            json.begin_string();
+            json.append(mac_str);
+            json.append("_");
+            json.append(reading.name);
+            json.end_string();
         }
 
-        void Now_MQTT_BridgeComponent::check_device_timeouts_()
+        void Now_MQTT_BridgeComponent::write_discovery_device_(JsonWriter &json, const now_mqtt_protocol::NodeInfo &node,
+                                                               const char *mac_str)
         {
-            uint32_t now = millis();
-            
-            for (auto &pair : this->devices_) {
-                DeviceInfo &info = pair.second;
-                
-                if (info.online && (now - info.last_seen_ms) > DEVICE_TIMEOUT_MS) {
-                    info.online = false;
-                    ESP_LOGW(TAG, "Device offline: %s (no packets for %u ms)", 
-                             info.name.c_str(), DEVICE_TIMEOUT_MS);
-                    
-                    if (this->publish_availability_) {
-                        this->publish_device_availability_(info.name, false);
-                    }
+            json.key("dev");
+            json.begin_object();
+            json.add("ids", mac_str);
+            json.add("name", node.name);
+            json.add("sw", node.version);
+            json.add("mdl", node.board);
+            json.raw(DISCOVERY_MANUFACTURER);
+            json.end_object();
+        }
+
+        bool Now_MQTT_BridgeComponent::publish_discovery_(const std::string &topic, const JsonWriter &json)
+        {
+            if (json.overflow()) {
+                ESP_LOGW(TAG, "Discovery payload for %s exceeds %u bytes, not published", topic.c_str(),
+                         (unsigned) json.capacity());
+                return false;
+            }
+            return this->publish_(topic, json.data(), json.size());
+        }
+
+        // =============================================================================
+        // MQTT Publishing - State
+        // =============================================================================
+        // Each entity's <node>/<domain>/<entity>/state topic is rendered into the topic
+        // table the first time it is needed and reused from then on. Readings without
+        // a discovery cache entry, or arriving once the table is full, get the topic
+        // built in fallback instead.
+
+        std::string_view Now_MQTT_BridgeComponent::state_topic_(EntityState *entity,
+                                                                 const now_mqtt_protocol::NodeInfo &node,
+                                                                 const now_mqtt_protocol::Reading &reading,
+                                                                 std::string *fallback)
+        {
+            const char *domain = domain_(reading);
+            if (entity != nullptr) {
+                if (entity->topic == TopicTable::INVALID) {
+                    entity->topic = this->topics_.add({node.name, "/", domain, "/", reading.name, "/state"});
+                }
+                std::string_view topic = this->topics_.get(entity->topic);
+                if (topic.data() != nullptr) {
+                    return topic;
+                }
+                if (!this->topic_table_full_) {
+                    ESP_LOGW(TAG, "Topic table full (%u bytes); building topics per publish",
+                             (unsigned) this->topics_.capacity());
+                    this->topic_table_full_ = true;
                 }
             }
+            *fallback = std::string(node.name) + "/" + domain + "/" + std::string(reading.name) + "/state";
+            return *fallback;
         }
 
-        void Now_MQTT_BridgeComponent::publish_device_availability_(const std::string &device_name, bool online)
+        // Text sensors are published under the sensor domain, as in v1
+        const char *Now_MQTT_BridgeComponent::domain_(const now_mqtt_protocol::Reading &reading)
         {
-            std::string topic = device_name + "/status";
-            std::string payload = online ? "online" : "offline";
-            mqtt::global_mqtt_client->publish(topic, payload, 2, true);
+            return reading.type == now_mqtt_protocol::ReadingType::BINARY_SENSOR ? "binary_sensor" : "sensor";
         }
 
         // =============================================================================
-        // Utility Methods
+        // Publish Policies
         // =============================================================================
+        // A policy with a minimum interval publishes an entity's state right away if
+        // the interval since its last publish has passed. Otherwise the state is held
+        // and goes out when the interval ends, replaced by any newer state that arrives
+        // first; each replaced state counts as coalesced. Holding needs a discovery
+        // cache entry and a topic in the topic table; without them (or for a state too
+        // long to hold) the state is published immediately.
 
-        std::string Now_MQTT_BridgeComponent::mac_to_string_(const uint8_t *mac)
+        uint8_t Now_MQTT_BridgeComponent::match_policy_(const now_mqtt_protocol::NodeInfo &node,
+                                                        const now_mqtt_protocol::Reading &reading) const
         {
-            char mac_str[18];
-            snprintf(mac_str, sizeof(mac_str), "%02x%02x%02x%02x%02x%02x",
-                     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-            return std::string(mac_str);
+            for (size_t i = 0; i < this->policies_.size() && i < MAX_POLICIES; i++) {
+                const PublishPolicy &policy = this->policies_[i];
+                if ((policy.node.empty() || policy.node == node.name) &&
+                    (policy.entity.empty() || policy.entity == reading.name) &&
+                    (policy.device_class.empty() || policy.device_class == reading.meta.device_class)) {
+                    return i;
+                }
+            }
+            return DEFAULT_POLICY;
         }
 
-        int Now_MQTT_BridgeComponent::split_string_(char **tokens, int max_tokens, char *string, char delimiter)
+        const PublishPolicy &Now_MQTT_BridgeComponent::policy_(uint8_t index) const
         {
-            int count = 0;
-            char *token = string;
-            
-            while (*string && count < max_tokens) {
-                if (*string == delimiter) {
-                    *string = '\0';
-                    tokens[count++] = token;
-                    token = string + 1;
+            // Everything the bridge forwards was retained at QoS 2 before policies existed
+            static const PublishPolicy default_policy{"", "", "", 2, true, 0, 0, false};
+            return index < this->policies_.size() ? this->policies_[index] : default_policy;
+        }
+
+        void Now_MQTT_BridgeComponent::publish_state_(EntityState *entity, uint8_t policy_index, std::string_view topic,
+                                                      std::string_view state)
+        {
+            const PublishPolicy &policy = this->policy_(policy_index);
+            uint32_t now = millis();
+
+            if (policy.min_interval_ms > 0 && entity != nullptr && entity->topic != TopicTable::INVALID) {
+                if (entity->has_published && now - entity->published_ms < policy.min_interval_ms) {
+                    if (entity->held == Coalescer::NONE) {
+                        entity->held = this->coalescer_.acquire(this->entities_.index_of(entity));
+                    }
+                    if (entity->held != Coalescer::NONE && Coalescer::fits(state)) {
+                        if (this->coalescer_.hold(entity->held, state, entity->published_ms + policy.min_interval_ms)) {
+                            this->states_coalesced_++;
+                        }
+                        return;
+                    }
+                }
+                // A state still held is older than this one
+                if (this->coalescer_.drop(entity->held)) {
+                    this->states_coalesced_++;
                 }
-                string++;
             }
-            
-            // Add the last token
-            if (count < max_tokens) {
-                tokens[count++] = token;
+
+            this->publish_(topic, state.data(), state.size(), policy.qos, policy.retain);
+            this->states_published_++;
+            if (entity != nullptr) {
+                entity->published_ms = now;
+                entity->has_published = true;
             }
-            
-            return count;
+            ESP_LOGD(TAG, "Published state: %.*s = %.*s", (int) topic.size(), topic.data(), (int) state.size(),
+                     state.data());
+        }
+
+        void Now_MQTT_BridgeComponent::flush_held_state_(uint16_t entity_index, std::string_view state)
+        {
+            EntityState &entity = this->entities_.at(entity_index);
+            std::string_view topic = this->topics_.get(entity.topic);
+            if (topic.data() == nullptr) {
+                return;
+            }
+            const PublishPolicy &policy = this->policy_(entity.policy);
+            this->publish_(topic, state.data(), state.size(), policy.qos, policy.retain);
+            this->states_published_++;
+            entity.published_ms = millis();
+            entity.has_published = true;
+            ESP_LOGD(TAG, "Published held state: %.*s = %.*s", (int) topic.size(), topic.data(), (int) state.size(),
+                     state.data());
+        }
+
+        // =============================================================================
+        // Aggregation
+        // =============================================================================
+        // Numeric states of entities whose policy sets aggregate_ms are reduced to
+        // tumbling windows and published on <node>/sensor/<entity>/aggregate as
+        // {"mean":21.53,"min":21.4,"max":21.7,"last":21.6,"count":60}, with discovery
+        // for a "<entity> mean" sensor that carries the rest as attributes. Binary and
+        // text sensors, and entities without a cache entry, window or topic, are
+        // published as raw states.
+
+        uint16_t Now_MQTT_BridgeComponent::aggregate_window_(EntityState *entity, const PublishPolicy &policy,
+                                                             const now_mqtt_protocol::NodeInfo &node,
+                                                             const now_mqtt_protocol::Reading &reading, bool discover)
+        {
+            if (policy.aggregate_ms == 0 || entity == nullptr ||
+                reading.type != now_mqtt_protocol::ReadingType::SENSOR) {
+                return Aggregator::NONE;
+            }
+            if (entity->aggregate == Aggregator::NONE) {
+                entity->aggregate = this->aggregator_.acquire(this->entities_.index_of(entity), TopicTable::INVALID);
+                if (entity->aggregate == Aggregator::NONE) {
+                    return Aggregator::NONE;
+                }
+            }
+
+            // Rendered with the window, and again after a node rename
+            Aggregator::Window &window = this->aggregator_.at(entity->aggregate);
+            if (window.topic == TopicTable::INVALID ||
+                (discover && !this->topics_.matches(window.topic, {node.name, "/sensor/", reading.name, "/aggregate"}))) {
+                window.topic = this->topics_.add({node.name, "/sensor/", reading.name, "/aggregate"});
+            }
+            return window.topic == TopicTable::INVALID ? Aggregator::NONE : entity->aggregate;
+        }
+
+        void Now_MQTT_BridgeComponent::add_sample_(uint16_t window, const PublishPolicy &policy, std::string_view state,
+                                                   bool newest)
+        {
+            // States are already formatted; parse them back and keep their precision
+            char buffer[32];
+            if (state.empty() || state.size() >= sizeof(buffer)) {
+                return;
+            }
+            memcpy(buffer, state.data(), state.size());
+            buffer[state.size()] = '\0';
+            char *end;
+            float value = strtof(buffer, &end);
+            if (*end != '\0' || !std::isfinite(value)) {
+                return;
+            }
+            const char *point = strchr(buffer, '.');
+            uint8_t decimals = point != nullptr ? std::min<size_t>(end - point - 1, 6) : 0;
+            this->aggregator_.add(window, value, decimals, newest, millis(), policy.aggregate_ms);
+        }
+
+        void Now_MQTT_BridgeComponent::publish_aggregate_(const Aggregator::Window &window)
+        {
+            std::string_view topic = this->topics_.get(window.topic);
+            if (topic.data() == nullptr || window.count == 0) {
+                return;
+            }
+            char mean[24], min[24], max[24], last[24];
+            now_mqtt_protocol::format_value(mean, sizeof(mean), window.mean(), std::min(window.decimals + 1, 6));
+            now_mqtt_protocol::format_value(min, sizeof(min), window.min, window.decimals);
+            now_mqtt_protocol::format_value(max, sizeof(max), window.max, window.decimals);
+            now_mqtt_protocol::format_value(last, sizeof(last), window.last, window.decimals);
+
+            char json[160];
+            int len = snprintf(json, sizeof(json), "{\"mean\":%s,\"min\":%s,\"max\":%s,\"last\":%s,\"count\":%u}",
+                               mean, min, max, last, (unsigned) window.count);
+            if (len <= 0 || (size_t) len >= sizeof(json)) {
+                return;
+            }
+            const PublishPolicy &policy = this->policy_(this->entities_.at(window.owner).policy);
+            this->publish_(topic, json, len, policy.qos, policy.retain);
+            this->aggregates_published_++;
+            ESP_LOGD(TAG, "Published aggregate: %.*s = %s", (int) topic.size(), topic.data(), json);
+        }
+
+        void Now_MQTT_BridgeComponent::publish_aggregate_discovery_(const now_mqtt_protocol::NodeInfo &node,
+                                                                    const now_mqtt_protocol::Reading &reading,
+                                                                    const char *mac_str, std::string_view topic)
+        {
+            JsonWriter json(this->discovery_payload_, sizeof(this->discovery_payload_));
+            json.begin_object();
+            this->write_aggregate_config_(json, reading, mac_str, topic);
+            this->write_discovery_device_(json, node, mac_str);
+            json.end_object();
+
+            std::string config_topic = this->discovery_info_.prefix + "/sensor/" + std::string(node.name) + "/" +
+                                       std::string(reading.name) + "_mean/config";
+            this->publish_discovery_(config_topic, json);
+        }
+
+        void Now_MQTT_BridgeComponent::write_aggregate_config_(JsonWriter &json, const now_mqtt_protocol::Reading &reading,
+                                                               const char *mac_str, std::string_view topic)
+        {
+            const now_mqtt_protocol::EntityMeta &meta = reading.meta;
+            if (!meta.device_class.empty()) json.add("dev_cla", meta.device_class);
+            if (!meta.unit.empty()) json.add("unit_of_meas", meta.unit);
+            if (!meta.state_class.empty()) json.add("stat_cla", meta.state_class);
+            json.key("name");
+            json.begin_string();
+            json.append(reading.name);
+            json.append(" mean");
+            json.end_string();
+            if (!meta.icon.empty()) json.add("icon", meta.icon);
+            json.add("stat_t", topic);
+            json.raw(",\"val_tpl\":\"{{ value_json.mean }}\"");
+            json.add("json_attr_t", topic);
+            json.key("uniq_id");
+            json.begin_string();
+            json.append(mac_str);
+            json.append("_");
+            json.append(reading.name);
+            json.append("_mean");
+            json.end_string();
+        }
+
+        // =============================================================================
+        // Device Discovery
+        // =============================================================================
+        // With device_discovery, a node's entities are published together as one
+        // retained <prefix>/device/<mac>/config (Home Assistant's device-based schema):
+        // the device block once, then each entity as a component. Each node keeps the
+        // schema IDs of its entities in the component table; the configs themselves
+        // are rebuilt from the schema cache. The bundle is republished after the frame
+        // that changed it: a new entity, new metadata for one, new node info, or a new
+        // discovery epoch (MQTT reconnect). Entities the bundle cannot take (device
+        // table or component table full, oversized metadata) fall back to per-entity
+        // configs.
+
+        bool Now_MQTT_BridgeComponent::bundle_entity_(uint64_t mac_key, const now_mqtt_protocol::NodeInfo &node,
+                                                      const now_mqtt_protocol::Reading &reading)
+        {
+            DeviceInfo *info = this->devices_.find(mac_key);
+            if (info == nullptr || info->bundle_overflow) {
+                return false;
+            }
+
+            // Learned like a v2 schema, so v1 entities can be rebuilt the same way
+            uint8_t encoded[now_mqtt_protocol::MAX_SCHEMA_SIZE];
+            now_mqtt_protocol::RecordPrefix prefix = reading.prefix;
+            if (prefix.len == 0) {
+                prefix = {encoded, now_mqtt_protocol::encode_record_prefix(encoded, sizeof(encoded), reading.type,
+                                                                          reading.name, reading.meta)};
+            }
+            if (prefix.len == 0 || prefix.len > now_mqtt_protocol::MAX_SCHEMA_SIZE) {
+                return false;
+            }
+            this->learn_schema_(mac_key, prefix);
+            uint32_t id = now_mqtt_protocol::schema_id(prefix.data, prefix.len);
+
+            if (this->components_.contains(info->components, id)) {
+                // Only a new epoch or new node info (e.g. a firmware update) changes the bundle
+                uint32_t node_hash = node_hash_(node);
+                if (!this->current_epoch_(info->bundle_epoch) || info->bundle_hash != node_hash) {
+                    info->bundle_dirty = true;
+                }
+                return true;
+            }
+
+            // New metadata for a known entity replaces its old schema
+            uint8_t scratch[now_mqtt_protocol::MAX_SCHEMA_SIZE];
+            for (uint16_t i = 0; i < this->components_.size(info->components); i++) {
+                now_mqtt_protocol::RecordPrefix known;
+                now_mqtt_protocol::Reading entity;
+                if (this->find_schema_(mac_key, this->components_.at(info->components, i), &known, scratch) &&
+                    now_mqtt_protocol::decode_record_prefix(known.data, known.len, &entity) &&
+                    entity.name == reading.name) {
+                    this->components_.set(info->components, i, id);
+                    info->bundle_dirty = true;
+                    return true;
+                }
+            }
+
+            uint16_t list = this->components_.add(info->components, id);
+            if (list == ComponentTable::NONE) {
+                if (!this->component_table_full_) {
+                    ESP_LOGW(TAG, "Component table full (%u bytes); new entities get per-entity discovery",
+                             (unsigned) this->components_.capacity());
+                    this->component_table_full_ = true;
+                }
+                return false;
+            }
+            info->components = list;
+            info->bundle_dirty = true;
+            return true;
+        }
+
+        void Now_MQTT_BridgeComponent::flush_device_discovery_(uint64_t mac_key, const char *mac_str,
+                                                               const now_mqtt_protocol::NodeInfo &node)
+        {
+            if (!this->device_discovery_) {
+                return;
+            }
+            DeviceInfo *info = this->devices_.find(mac_key);
+            if (info == nullptr || !info->bundle_dirty) {
+                return;
+            }
+
+            JsonWriter json(this->device_discovery_payload_, DEVICE_DISCOVERY_SIZE);
+            json.begin_object();
+            this->write_discovery_device_(json, node, mac_str);
+            json.raw(DISCOVERY_ORIGIN);
+            json.key("cmps");
+            json.begin_object();
+
+            uint8_t scratch[now_mqtt_protocol::MAX_SCHEMA_SIZE];
+            uint16_t components = 0;
+            for (uint16_t i = 0; i < this->components_.size(info->components); i++) {
+                now_mqtt_protocol::RecordPrefix prefix;
+                now_mqtt_protocol::Reading reading;
+                if (!this->find_schema_(mac_key, this->components_.at(info->components, i), &prefix, scratch) ||
+                    !now_mqtt_protocol::decode_record_prefix(prefix.data, prefix.len, &reading)) {
+                    continue;
+                }
+
+                // Same split as per-entity discovery: aggregate and / or raw
+                EntityState *entity = this->entities_.find(entity_key_(mac_str, reading.name));
+                std::string_view aggregate_topic;
+                bool passthrough = true;
+                if (entity != nullptr && entity->aggregate != Aggregator::NONE) {
+                    aggregate_topic = this->topics_.get(this->aggregator_.at(entity->aggregate).topic);
+                    passthrough = this->policy_(entity->policy).passthrough;
+                }
+
+                char id[now_mqtt_protocol::MAX_SCHEMA_SIZE + 8];
+                size_t id_len = component_id_(id, reading.name);
+                if (aggregate_topic.data() == nullptr || passthrough) {
+                    json.key(std::string_view(id, id_len));
+                    json.begin_object();
+                    json.add("p", domain_(reading));
+                    this->write_entity_config_(json, node, reading, mac_str);
+                    json.end_object();
+                    components++;
+                }
+                if (aggregate_topic.data() != nullptr) {
+                    memcpy(id + id_len, "_mean", 5);
+                    json.key(std::string_view(id, id_len + 5));
+                    json.begin_object();
+                    json.add("p", "sensor");
+                    this->write_aggregate_config_(json, reading, mac_str, aggregate_topic);
+                    json.end_object();
+                    components++;
+                }
+            }
+            json.end_object();
+            json.end_object();
+
+            std::string config_topic = this->discovery_info_.prefix + "/device/" + mac_str + "/config";
+            if (json.overflow()) {
+                ESP_LOGW(TAG, "Device discovery for %s exceeds %u bytes, using per-entity discovery", mac_str,
+                         (unsigned) json.capacity());
+                this->publish_(config_topic, "", 0);  // Drop a smaller bundle published earlier
+                this->unbundle_device_(mac_key, mac_str, node, info);
+                return;
+            }
+            if (!this->publish_discovery_(config_topic, json)) {
+                return;  // Still dirty: retried after the node's next frame
+            }
+            info->bundle_dirty = false;
+            info->bundle_epoch = this->discovery_epoch_;
+            info->bundle_hash = node_hash_(node);
+            this->snapshot_dirty_ = true;
+            ESP_LOGD(TAG, "Published device discovery: %s (%u components, %u bytes)", config_topic.c_str(),
+                     components, (unsigned) json.size());
+        }
+
+        // The node's entities were counted as discovered through the bundle, so each
+        // gets its per-entity config now; later ones skip the bundle
+        void Now_MQTT_BridgeComponent::unbundle_device_(uint64_t mac_key, const char *mac_str,
+                                                        const now_mqtt_protocol::NodeInfo &node, DeviceInfo *info)
+        {
+            info->bundle_overflow = true;
+            info->bundle_dirty = false;
+            info->bundle_epoch = 0;
+            this->snapshot_dirty_ = true;
+
+            uint8_t scratch[now_mqtt_protocol::MAX_SCHEMA_SIZE];
+            for (uint16_t i = 0; i < this->components_.size(info->components); i++) {
+                now_mqtt_protocol::RecordPrefix prefix;
+                now_mqtt_protocol::Reading reading;
+                if (!this->find_schema_(mac_key, this->components_.at(info->components, i), &prefix, scratch) ||
+                    !now_mqtt_protocol::decode_record_prefix(prefix.data, prefix.len, &reading)) {
+                    continue;
+                }
+                EntityState *entity = this->entities_.find(entity_key_(mac_str, reading.name));
+                bool raw = true;
+                if (entity != nullptr && entity->aggregate != Aggregator::NONE) {
+                    this->publish_aggregate_discovery_(node, reading, mac_str,
+                                                       this->topics_.get(this->aggregator_.at(entity->aggregate).topic));
+                    raw = this->policy_(entity->policy).passthrough;
+                }
+                if (raw) {
+                    this->publish_entity_discovery_(node, reading, mac_str);
+                }
+            }
+        }
+
+        // Entity name as a component ID: anything but [A-Za-z0-9_-] becomes '_'
+        size_t Now_MQTT_BridgeComponent::component_id_(char *out, std::string_view name)
+        {
+            size_t len = 0;
+            for (char c : name) {
+                bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-';
+                out[len++] = keep ? c : '_';
+            }
+            return len;
+        }
+
+        uint32_t Now_MQTT_BridgeComponent::node_hash_(const now_mqtt_protocol::NodeInfo &node)
+        {
+            uint8_t separator = 0;
+            uint32_t hash = FNV1A_32_INIT;
+            for (std::string_view field : {node.name, node.version, node.board}) {
+                hash = fnv1a_32(hash, field.data(), field.size());
+                hash = fnv1a_32(hash, &separator, 1);
+            }
+            return hash;
+        }
+
+        // =============================================================================
+        // MQTT Publishing - Reading History
+        // =============================================================================
+        // <node>/<domain>/<entity>/history gets every buffered reading, oldest first,
+        // as {"state":"21.50","age":1800,"ts":1760601234}. ts (Unix seconds) is only
+        // included once the bridge clock is set, e.g. by an sntp or homeassistant time
+        // source.
+
+        void Now_MQTT_BridgeComponent::publish_reading_history_(std::string_view state_topic,
+                                                                const now_mqtt_protocol::Reading &reading,
+                                                                std::string_view state)
+        {
+            // Same topic as the state, with "history" for the trailing "state"
+            std::string topic(state_topic.substr(0, state_topic.size() - 5));
+            topic += "history";
+
+            // Text sensor states may need escaping; a text record holds at most 255 bytes,
+            // longer v1 states are cut at what fits
+            char escaped[2 * UINT8_MAX];
+            size_t n = 0;
+            for (char c : state) {
+                if (static_cast<uint8_t>(c) < 0x20) {
+                    continue;
+                }
+                bool escape = c == '"' || c == '\\';
+                if (n + (escape ? 2 : 1) > sizeof(escaped)) {
+                    break;
+                }
+                if (escape) {
+                    escaped[n++] = '\\';
+                }
+                escaped[n++] = c;
+            }
+
+            char payload[sizeof(escaped) + 64];
+            size_t len = 0;
+            auto clamp = [&payload](size_t len, int written) {
+                return written < 0 ? len : std::min(len + written, sizeof(payload) - 1);
+            };
+            len = clamp(len, snprintf(payload, sizeof(payload), "{\"state\":\"%.*s\",\"age\":%u", (int) n, escaped,
+                                      (unsigned) reading.age_s));
+            time_t now = ::time(nullptr);
+            if (now >= MIN_VALID_TIME) {
+                len = clamp(len, snprintf(payload + len, sizeof(payload) - len, ",\"ts\":%lld",
+                                          (long long) (now - reading.age_s)));
+            }
+            len = clamp(len, snprintf(payload + len, sizeof(payload) - len, "}"));
+
+            this->publish_(topic, payload, len);
+            ESP_LOGV(TAG, "Published history: %s = %s", topic.c_str(), payload);
+        }
+
+        // =============================================================================
+        // Device Tracking
+        // =============================================================================
+
+        void Now_MQTT_BridgeComponent::update_device_seen_(uint64_t mac_key, const char *mac_str,
+                                                           const now_mqtt_protocol::NodeInfo &node)
+        {
+            bool inserted;
+            DeviceInfo *info = this->devices_.insert(mac_key, &inserted);
+
+            if (info == nullptr) {
+                if (!this->device_table_full_) {
+                    ESP_LOGW(TAG, "Device table full (%u devices); %s not tracked for availability",
+                             this->max_devices_, mac_str);
+                    this->device_table_full_ = true;
+                }
+                return;
+            }
+
+            if (inserted) {
+                info->name = StringPool::INVALID;
+                info->status_topic = TopicTable::INVALID;
+                info->components = ComponentTable::NONE;
+                info->bundle_dirty = false;
+                info->bundle_overflow = false;
+                info->bundle_epoch = 0;
+                info->bundle_hash = 0;
+            }
+            if (this->device_names_.get(info->name) != node.name) {
+                info->name = this->device_names_.intern(node.name);
+                info->status_topic = TopicTable::INVALID;
+                this->snapshot_dirty_ = true;
+                if (info->name == StringPool::INVALID) {
+                    ESP_LOGW(TAG, "Device name pool full; %s not tracked for availability", mac_str);
+                }
+            }
+            const char *device_name = this->device_names_.c_str(info->name);
+
+            uint32_t now = millis();
+            bool was_offline = !info->online;
+
+            // An advertised interval wins; otherwise learn it from the gaps between wake
+            // cycles (smoothed, and capped so a single missed report can't double it)
+            if (node.report_interval_s != 0) {
+                this->snapshot_dirty_ |= info->interval_ms != node.report_interval_s * 1000u;
+                info->interval_ms = node.report_interval_s * 1000;
+                info->interval_advertised = true;
+            } else if (!inserted && !was_offline && !info->interval_advertised) {
+                uint32_t gap = now - info->last_seen_ms;
+                if (gap >= MIN_INTERVAL_SAMPLE_MS) {
+                    if (info->interval_ms == 0) {
+                        info->interval_ms = gap;
+                    } else {
+                        uint32_t sample = std::min(gap, info->interval_ms * 2);
+                        info->interval_ms = info->interval_ms - info->interval_ms / 4 + sample / 4;
+                    }
+                }
+            }
+
+            info->last_seen_ms = now;
+            info->online = true;
+            this->snapshot_dirty_ |= was_offline;
+            this->device_timers_.schedule(this->devices_.index_of(info), now + device_timeout_ms_(*info));
+
+            if (inserted) {
+                ESP_LOGI(TAG, "New device discovered: %s (%s)", device_name, mac_str);
+            } else if (was_offline) {
+                ESP_LOGI(TAG, "Device back online: %s", device_name);
+            }
+
+            if (was_offline && this->publish_availability_) {
+                this->publish_device_availability_(*info, true);
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::on_device_timeout_(uint16_t handle)
+        {
+            DeviceInfo &info = this->devices_.at(handle);
+            info.online = false;
+            this->snapshot_dirty_ = true;
+            const char *device_name = this->device_names_.c_str(info.name);
+            ESP_LOGW(TAG, "Device offline: %s (no packets for %u ms)", device_name,
+                     (unsigned) (millis() - info.last_seen_ms));
+
+            if (this->publish_availability_) {
+                this->publish_device_availability_(info, false);
+            }
+        }
+
+        uint32_t Now_MQTT_BridgeComponent::device_timeout_ms_(const DeviceInfo &info)
+        {
+            if (info.interval_ms == 0) {
+                return DEVICE_TIMEOUT_MS;
+            }
+            uint64_t timeout = uint64_t(info.interval_ms) * MISSED_REPORTS;
+            // Keep well inside the wheel's signed 32-bit deadline range
+            return std::max<uint32_t>(MIN_DEVICE_TIMEOUT_MS, std::min<uint64_t>(timeout, 0x3FFFFFFF));
+        }
+
+        void Now_MQTT_BridgeComponent::publish_device_availability_(DeviceInfo &info, bool online)
+        {
+            std::string_view device_name = this->device_names_.get(info.name);
+            if (device_name.empty()) {
+                return;
+            }
+            if (info.status_topic == TopicTable::INVALID) {
+                info.status_topic = this->topics_.add({device_name, "/status"});
+            }
+            std::string fallback;
+            std::string_view topic = this->topics_.get(info.status_topic);
+            if (topic.data() == nullptr) {
+                fallback = std::string(device_name) + "/status";
+                topic = fallback;
+            }
+            const char *payload = online ? "online" : "offline";
+            this->publish_(topic, payload, strlen(payload));
+        }
+
+        bool Now_MQTT_BridgeComponent::publish_(std::string_view topic, const char *payload, size_t len, uint8_t qos,
+                                                bool retain)
+        {
+            if (this->replay_.active) {
+                this->replay_.publishes++;
+                this->replay_.publish_bytes += topic.size() + len;
+                return true;
+            }
+            this->topic_buffer_.assign(topic.data(), topic.size());
+            bool ok = mqtt::global_mqtt_client->publish(this->topic_buffer_, payload, len, qos, retain);
+            if (!ok) {
+                this->publish_failures_++;
+            }
+            return ok;
+        }
+
+        // =============================================================================
+        // Frame Capture
+        // =============================================================================
+        // With capture_size, every frame taken from the ingest queue is also recorded,
+        // with MAC, RSSI and receive time, into a ring that keeps the most recent ones.
+        // Commands on <topic_prefix>/capture/command:
+        //
+        //   dump          the ring as a trace on <topic_prefix>/capture/trace, in
+        //                 slices; an empty message ends it
+        //   log           the same trace as hex log lines
+        //   clear         empty the ring and resume capturing
+        //   replay <x>    replay the ring at 1, 10 or "max" speed, then publish a
+        //                 report on <topic_prefix>/capture/report
+        //
+        // A trace published to <topic_prefix>/capture/load (in slices of any size)
+        // replaces the ring's contents, so a trace recorded at one site can be replayed
+        // on a bench bridge. Loading and replaying pause capturing until 'clear', so
+        // the same trace can be replayed again.
+
+        void Now_MQTT_BridgeComponent::on_capture_command_(const std::string &command)
+        {
+            if (this->replay_.active || this->capture_dump_ != CaptureDump::NONE) {
+                ESP_LOGW(TAG, "Capture busy; ignoring '%s'", command.c_str());
+                return;
+            }
+            if (command == "dump" || command == "log") {
+                this->capture_encoder_.start(&this->capture_);
+                this->capture_dump_ = command == "dump" ? CaptureDump::MQTT : CaptureDump::LOG;
+                ESP_LOGI(TAG, "Dumping %u captured frame(s) (%u bytes)", (unsigned) this->capture_.count(),
+                         (unsigned) this->capture_.used());
+            } else if (command == "clear") {
+                this->capture_.clear();
+                this->capture_parser_.reset();
+                this->capture_paused_ = false;
+            } else if (command == "replay 1" || command == "replay 10" || command == "replay max") {
+                this->start_replay_(command == "replay max" ? 0 : atoi(command.c_str() + 7));
+            } else {
+                ESP_LOGW(TAG, "Unknown capture command '%s'", command.c_str());
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::on_capture_load_(const std::string &payload)
+        {
+            if (this->replay_.active || this->capture_dump_ != CaptureDump::NONE) {
+                ESP_LOGW(TAG, "Capture busy; ignoring trace slice");
+                return;
+            }
+            // A new trace (not the rest of one) replaces whatever was captured
+            if (this->capture_parser_.idle()) {
+                this->capture_.clear();
+                this->capture_paused_ = true;
+            }
+            const uint8_t *data = reinterpret_cast<const uint8_t *>(payload.data());
+            bool ok = this->capture_parser_.feed(data, payload.size(),
+                                                 [this](const RawFrame &frame) { this->capture_.push(frame); });
+            if (!ok) {
+                ESP_LOGW(TAG, "Malformed trace; discarded");
+                this->capture_.clear();
+                this->capture_parser_.reset();
+                return;
+            }
+            if (this->capture_parser_.idle()) {
+                ESP_LOGI(TAG, "Trace loaded: %u frame(s) (%u bytes)", (unsigned) this->capture_.count(),
+                         (unsigned) this->capture_.used());
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::pump_capture_dump_()
+        {
+            if (this->capture_dump_ == CaptureDump::MQTT) {
+                if (!mqtt::global_mqtt_client->is_connected()) {
+                    return;
+                }
+                std::string topic = mqtt::global_mqtt_client->get_topic_prefix() + "/capture/trace";
+                uint8_t slice[CAPTURE_SLICE_SIZE];
+                for (uint8_t i = 0; i < CAPTURE_SLICES_PER_LOOP; i++) {
+                    size_t len = this->capture_encoder_.read(slice, sizeof(slice));
+                    this->publish_(topic, reinterpret_cast<const char *>(slice), len, 1, false);
+                    if (len == 0) {
+                        break;
+                    }
+                }
+            } else {
+                uint8_t line[CAPTURE_LOG_LINE_BYTES];
+                char hex[CAPTURE_LOG_LINE_BYTES * 2 + 1];
+                for (uint8_t i = 0; i < CAPTURE_SLICES_PER_LOOP * 4; i++) {
+                    size_t len = this->capture_encoder_.read(line, sizeof(line));
+                    if (len == 0) {
+                        break;
+                    }
+                    for (size_t j = 0; j < len; j++) {
+                        snprintf(hex + j * 2, 3, "%02x", line[j]);
+                    }
+                    ESP_LOGI(TAG, "capture: %s", hex);
+                }
+            }
+
+            if (!this->capture_encoder_.active()) {
+                if (this->capture_dump_ == CaptureDump::LOG) {
+                    ESP_LOGI(TAG, "capture end: %u frame(s)", (unsigned) this->capture_.count());
+                }
+                this->capture_dump_ = CaptureDump::NONE;
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::start_replay_(uint8_t speed)
+        {
+            if (this->capture_.count() == 0) {
+                ESP_LOGW(TAG, "Nothing captured to replay");
+                return;
+            }
+            this->capture_paused_ = true;
+            this->replay_ = {};
+            this->replay_.active = true;
+            this->replay_.speed = speed;
+            this->replay_.cursor = this->capture_.begin();
+            this->replay_.parse_errors = this->parse_errors_;
+            this->replay_.duplicates = this->duplicates_;
+
+            // The trace's sequence numbers were seen before (or belong to another bridge)
+            this->devices_.for_each([](uint64_t mac_key, DeviceInfo &info) {
+                info.dedup = DedupWindow{};
+                info.link.last_frame_hash = 0;
+            });
+            ESP_LOGI(TAG, "Replaying %u frame(s) at %s speed", (unsigned) this->capture_.count(),
+                     speed == 0 ? "max" : speed == 1 ? "1x" : "10x");
+        }
+
+        void Now_MQTT_BridgeComponent::pump_replay_()
+        {
+            Replay &replay = this->replay_;
+            for (uint8_t i = 0; i < this->max_frames_per_loop_; i++) {
+                if (!replay.pending) {
+                    if (!this->capture_.read(&replay.cursor, &replay.frame)) {
+                        this->finish_replay_();
+                        return;
+                    }
+                    replay.pending = true;
+                    if (replay.frames == 0) {
+                        replay.first_rx_us = replay.frame.rx_us;
+                        replay.start_us = micros();
+                    }
+                }
+
+                // Latency counts from when the frame was due, so falling behind shows
+                uint32_t now = micros();
+                uint32_t due = now;
+                if (replay.speed != 0) {
+                    due = replay.start_us + (replay.frame.rx_us - replay.first_rx_us) / replay.speed;
+                    if (static_cast<int32_t>(now - due) < 0) {
+                        return;
+                    }
+                }
+                replay.frame.rx_us = due;
+                replay.pending = false;
+                replay.frames++;
+                this->on_espnow_receive_(replay.frame);
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::finish_replay_()
+        {
+            Replay &replay = this->replay_;
+            replay.active = false;
+
+            uint32_t elapsed_us = micros() - replay.start_us;
+            float seconds = elapsed_us / 1e6f;
+            char json[320];
+            int len = snprintf(json, sizeof(json),
+                               "{\"speed\":\"%s\",\"frames\":%u,\"duration_ms\":%u,\"frames_per_s\":%.1f,"
+                               "\"publishes\":%u,\"publish_bytes\":%u,\"parse_errors\":%u,\"duplicates\":%u,"
+                               "\"latency_p50_ms\":%u,\"latency_p95_ms\":%u,\"latency_max_ms\":%u}",
+                               replay.speed == 0 ? "max" : replay.speed == 1 ? "1x" : "10x", (unsigned) replay.frames,
+                               (unsigned) (elapsed_us / 1000), seconds > 0 ? replay.frames / seconds : 0.0f,
+                               (unsigned) replay.publishes, (unsigned) replay.publish_bytes,
+                               (unsigned) (this->parse_errors_ - replay.parse_errors),
+                               (unsigned) (this->duplicates_ - replay.duplicates),
+                               (unsigned) replay.latency.percentile_ms(50), (unsigned) replay.latency.percentile_ms(95),
+                               (unsigned) (replay.latency.max_us() / 1000));
+            ESP_LOGI(TAG, "Replay finished: %s", json);
+            if (len > 0 && len < (int) sizeof(json)) {
+                this->publish_(mqtt::global_mqtt_client->get_topic_prefix() + "/capture/report", json, len, 1, false);
+            }
+
+            // Its discovery and availability went to the stand-in, not the broker
+            this->invalidate_discovery_("capture replay");
+        }
+
+        void Now_MQTT_BridgeComponent::record_latency_(uint32_t rx_us)
+        {
+            uint32_t latency_us = micros() - rx_us;
+            if (this->replay_.active) {
+                this->replay_.latency.record(latency_us);
+            } else {
+                this->latency_.record(latency_us);
+            }
+        }
+
+        // =============================================================================
+        // State Snapshot
+        // =============================================================================
+        // With snapshot_interval, the device table and the discovery cache are written
+        // to flash at most that often (and on a safe shutdown) and restored in setup(),
+        // so a restarted bridge republishes neither discovery nor availability for
+        // nodes it already knew. Schemas have their own preferences. Records:
+        //
+        //   'B' flags                                        (bridge)
+        //   'D' mac_key[8] interval_ms[4] flags bundle_hash[4]
+        //       name_len name[name_len] count[2] schema_id[4]*count
+        //   'E' key[8] meta_hash[4] policy                    (entity)
+        //
+        // Every device is written before any entity, and only all devices or none, so
+        // a restored entity never misses from its device's discovery bundle. Entities
+        // that do not fit are left out and simply rediscovered.
+
+        static constexpr uint8_t SNAPSHOT_BRIDGE = 'B';
+        static constexpr uint8_t SNAPSHOT_DEVICE = 'D';
+        static constexpr uint8_t SNAPSHOT_ENTITY = 'E';
+        static constexpr uint8_t SNAPSHOT_ONLINE = 0x01;
+        static constexpr uint8_t SNAPSHOT_ADVERTISED = 0x02;
+        static constexpr uint8_t SNAPSHOT_BUNDLED = 0x04;    // Device bundle published
+        static constexpr uint8_t SNAPSHOT_TELEMETRY = 0x08;  // Telemetry discovery published
+        static constexpr uint8_t SNAPSHOT_UNBUNDLED = 0x10;  // Bundle overflowed, per-entity discovery
+        static constexpr size_t SNAPSHOT_ENTITY_SIZE = 1 + 8 + 4 + 1;
+
+        void Now_MQTT_BridgeComponent::save_snapshot_()
+        {
+            this->snapshot_dirty_ = false;
+            this->last_snapshot_ms_ = millis();
+
+            auto sink = [](uint16_t index, const SnapshotChunk &chunk) {
+                ESPPreferenceObject pref =
+                    global_preferences->make_preference<SnapshotChunk>(snapshot_preference_key_(index), true);
+                return pref.save(&chunk);
+            };
+            SnapshotWriter<decltype(sink)> writer(MAX_SNAPSHOT_CHUNKS, sink);
+
+            uint8_t bridge_flags = this->current_epoch_(this->telemetry_discovery_epoch_) ? SNAPSHOT_TELEMETRY : 0;
+            writer.put(SNAPSHOT_BRIDGE);
+            writer.put(bridge_flags);
+
+            size_t device_bytes = 0;
+            this->devices_.for_each([this, &device_bytes](uint64_t mac_key, DeviceInfo &info) {
+                device_bytes += 1 + 8 + 4 + 1 + 4 + 1 + std::min<size_t>(this->device_names_.get(info.name).size(), UINT8_MAX) +
+                                2 + this->components_.size(info.components) * sizeof(uint32_t);
+            });
+            bool devices = writer.fits(device_bytes);
+            if (devices) {
+                this->devices_.for_each([this, &writer](uint64_t mac_key, DeviceInfo &info) {
+                    std::string_view name = this->device_names_.get(info.name).substr(0, UINT8_MAX);
+                    uint8_t flags = (info.online ? SNAPSHOT_ONLINE : 0) | (info.interval_advertised ? SNAPSHOT_ADVERTISED : 0) |
+                                    (this->current_epoch_(info.bundle_epoch) && !info.bundle_dirty ? SNAPSHOT_BUNDLED : 0) |
+                                    (this->current_epoch_(info.telemetry_epoch) ? SNAPSHOT_TELEMETRY : 0) |
+                                    (info.bundle_overflow ? SNAPSHOT_UNBUNDLED : 0);
+                    uint8_t name_len = name.size();
+                    uint16_t count = this->components_.size(info.components);
+                    writer.put(SNAPSHOT_DEVICE);
+                    writer.put(mac_key);
+                    writer.put(info.interval_ms);
+                    writer.put(flags);
+                    writer.put(info.bundle_hash);
+                    writer.put(name_len);
+                    writer.put(name.data(), name.size());
+                    writer.put(count);
+                    for (uint16_t i = 0; i < count; i++) {
+                        writer.put(this->components_.at(info.components, i));
+                    }
+                });
+
+                // Only entities whose discovery went out; the rest are rediscovered anyway
+                this->entities_.for_each([this, &writer](uint64_t key, EntityState &entity) {
+                    if (!this->current_epoch_(entity.epoch) || !writer.fits(SNAPSHOT_ENTITY_SIZE)) {
+                        return;
+                    }
+                    writer.put(SNAPSHOT_ENTITY);
+                    writer.put(key);
+                    writer.put(entity.meta_hash);
+                    writer.put(entity.policy);
+                });
+            }
+
+            SnapshotHeader header;
+            if (!writer.finish(this->snapshot_layout_(), &header)) {
+                ESP_LOGW(TAG, "Failed to write state snapshot");
+                return;
+            }
+            ESPPreferenceObject pref =
+                global_preferences->make_preference<SnapshotHeader>(snapshot_preference_key_(SNAPSHOT_HEADER_INDEX), true);
+            pref.save(&header);
+            ESP_LOGD(TAG, "State snapshot: %u bytes in %u chunk(s)%s", (unsigned) header.length, header.chunks,
+                     devices ? "" : ", devices left out (too many to fit)");
+        }
+
+        void Now_MQTT_BridgeComponent::restore_snapshot_()
+        {
+            SnapshotHeader header;
+            ESPPreferenceObject pref =
+                global_preferences->make_preference<SnapshotHeader>(snapshot_preference_key_(SNAPSHOT_HEADER_INDEX), true);
+            if (!pref.load(&header)) {
+                return;  // First boot with snapshots enabled
+            }
+
+            auto source = [](uint16_t index, SnapshotChunk *chunk) {
+                ESPPreferenceObject pref =
+                    global_preferences->make_preference<SnapshotChunk>(snapshot_preference_key_(index), true);
+                return pref.load(chunk);
+            };
+            SnapshotReader<decltype(source)> reader(header, source);
+            if (!reader.verify(this->snapshot_layout_(), MAX_SNAPSHOT_CHUNKS)) {
+                ESP_LOGW(TAG, "State snapshot is stale or damaged; starting without it");
+                return;
+            }
+
+            uint32_t now = millis();
+            size_t device_count = 0;
+            size_t entity_count = 0;
+            bool devices_complete = true;
+            uint8_t tag;
+            while (reader.remaining() > 0 && reader.get(&tag)) {
+                if (tag == SNAPSHOT_BRIDGE) {
+                    uint8_t flags;
+                    if (!reader.get(&flags)) {
+                        break;
+                    }
+                    if (flags & SNAPSHOT_TELEMETRY) {
+                        this->telemetry_discovery_epoch_ = SNAPSHOT_EPOCH;
+                    }
+                } else if (tag == SNAPSHOT_DEVICE) {
+                    uint64_t mac_key;
+                    uint32_t interval_ms, bundle_hash;
+                    uint8_t flags, name_len;
+                    char name[UINT8_MAX];
+                    uint16_t count;
+                    if (!reader.get(&mac_key) || !reader.get(&interval_ms) || !reader.get(&flags) ||
+                        !reader.get(&bundle_hash) || !reader.get(&name_len) || !reader.get(name, name_len) ||
+                        !reader.get(&count)) {
+                        break;
+                    }
+
+                    bool inserted;
+                    DeviceInfo *info = this->devices_.insert(mac_key, &inserted);
+                    if (info == nullptr) {
+                        devices_complete = false;
+                    } else {
+                        info->name = name_len == 0 ? StringPool::INVALID
+                                                   : this->device_names_.intern(std::string_view(name, name_len));
+                        info->status_topic = TopicTable::INVALID;
+                        info->components = ComponentTable::NONE;
+                        info->interval_ms = interval_ms;
+                        info->interval_advertised = flags & SNAPSHOT_ADVERTISED;
+                        info->bundle_hash = bundle_hash;
+                        info->bundle_epoch = (flags & SNAPSHOT_BUNDLED) ? SNAPSHOT_EPOCH : 0;
+                        info->bundle_overflow = flags & SNAPSHOT_UNBUNDLED;
+                        info->bundle_dirty = !(flags & (SNAPSHOT_BUNDLED | SNAPSHOT_UNBUNDLED)) && count > 0;
+                        info->telemetry_epoch = (flags & SNAPSHOT_TELEMETRY) ? SNAPSHOT_EPOCH : 0;
+                        info->last_seen_ms = now;
+                        // Nodes that never come back still go offline, one timeout from now
+                        info->online = flags & SNAPSHOT_ONLINE;
+                        if (info->online) {
+                            this->device_timers_.schedule(this->devices_.index_of(info), now + device_timeout_ms_(*info));
+                        }
+                        device_count++;
+                    }
+                    for (uint16_t i = 0; i < count; i++) {
+                        uint32_t id;
+                        if (!reader.get(&id)) {
+                            break;
+                        }
+                        uint16_t list = info == nullptr ? ComponentTable::NONE : this->components_.add(info->components, id);
+                        if (list == ComponentTable::NONE) {
+                            devices_complete = false;
+                        } else {
+                            info->components = list;
+                        }
+                    }
+                } else if (tag == SNAPSHOT_ENTITY) {
+                    uint64_t key;
+                    uint32_t meta_hash;
+                    uint8_t policy;
+                    if (!reader.get(&key) || !reader.get(&meta_hash) || !reader.get(&policy)) {
+                        break;
+                    }
+                    // A device that did not fit would get an incomplete bundle
+                    if (!devices_complete) {
+                        continue;
+                    }
+                    bool inserted;
+                    EntityState *entity = this->entities_.insert(key, &inserted);
+                    if (entity == nullptr) {
+                        continue;
+                    }
+                    entity->meta_hash = meta_hash;
+                    entity->epoch = SNAPSHOT_EPOCH;
+                    entity->policy = policy;
+                    entity->topic = TopicTable::INVALID;
+                    entity->held = Coalescer::NONE;
+                    entity->aggregate = Aggregator::NONE;
+                    entity_count++;
+                } else {
+                    break;
+                }
+            }
+            if (reader.remaining() > 0) {
+                ESP_LOGW(TAG, "State snapshot ends in an unreadable record; the rest is rediscovered");
+            }
+
+            this->snapshot_current_ = true;
+            ESP_LOGI(TAG, "Restored %u device(s) and %u entities from the state snapshot", (unsigned) device_count,
+                     (unsigned) entity_count);
+        }
+
+        // Everything restored entries depend on: a change starts over without them
+        uint32_t Now_MQTT_BridgeComponent::snapshot_layout_() const
+        {
+            uint8_t separator = 0;
+            uint8_t flags = (this->device_discovery_ ? 1 : 0) | (this->telemetry_discovery_ ? 2 : 0);
+            uint32_t hash = fnv1a_32(FNV1A_32_INIT, &SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+            hash = fnv1a_32(hash, &flags, 1);
+            hash = fnv1a_32(hash, this->discovery_info_.prefix.data(), this->discovery_info_.prefix.size());
+            hash = fnv1a_32(hash, &separator, 1);
+            for (const auto &policy : this->policies_) {
+                for (const std::string *field : {&policy.node, &policy.entity, &policy.device_class}) {
+                    hash = fnv1a_32(hash, field->data(), field->size());
+                    hash = fnv1a_32(hash, &separator, 1);
+                }
+                uint8_t aggregate = (policy.aggregate_ms > 0 ? 1 : 0) | (policy.passthrough ? 2 : 0);
+                hash = fnv1a_32(hash, &aggregate, 1);
+            }
+            return hash;
+        }
+
+        uint32_t Now_MQTT_BridgeComponent::snapshot_preference_key_(uint16_t index)
+        {
+            uint32_t hash = fnv1a_32(FNV1A_32_INIT, "now_mqtt_snapshot", 17);
+            return fnv1a_32(hash, &index, sizeof(index));
+        }
+
+        // =============================================================================
+        // Telemetry
+        // =============================================================================
+        // Bridge counters go to <topic_prefix>/telemetry and each node's link stats to
+        // <node>/telemetry, as compact JSON formatted into stack buffers. Device topics
+        // are spread over loops, TELEMETRY_DEVICES_PER_LOOP at a time.
+
+        void Now_MQTT_BridgeComponent::publish_telemetry_()
+        {
+            uint32_t now = millis();
+            if (this->telemetry_cursor_ == SIZE_MAX) {
+                if (now - this->last_telemetry_ms_ < this->telemetry_interval_ms_) {
+                    return;
+                }
+                this->last_telemetry_ms_ = now;
+                this->publish_bridge_telemetry_();
+                this->telemetry_cursor_ = 0;
+            }
+
+            size_t slots = this->devices_.slot_count();
+            uint8_t published = 0;
+            while (this->telemetry_cursor_ < slots && published < TELEMETRY_DEVICES_PER_LOOP) {
+                size_t index = this->telemetry_cursor_++;
+                uint64_t mac_key = this->devices_.key_at(index);
+                if (mac_key != 0) {
+                    this->publish_device_telemetry_(mac_key, this->devices_.at(index));
+                    published++;
+                }
+            }
+            if (this->telemetry_cursor_ >= slots) {
+                this->telemetry_cursor_ = SIZE_MAX;
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::publish_bridge_telemetry_()
+        {
+            const std::string &prefix = mqtt::global_mqtt_client->get_topic_prefix();
+            std::string state_topic = prefix + "/telemetry";
+
+            if (this->telemetry_discovery_ && !this->current_epoch_(this->telemetry_discovery_epoch_)) {
+                std::string node_id = str_snake_case(App.get_name());
+                std::string ids = get_mac_address();
+                const char *name = App.get_name().c_str();
+                this->publish_telemetry_discovery_(node_id, "espnow_frames", "ESP-NOW frames", state_topic,
+                                                   "frames", nullptr, nullptr, ids.c_str(), name);
+                this->publish_telemetry_discovery_(node_id, "espnow_publish_failures", "MQTT publish failures",
+                                                   state_topic, "publish_failures", nullptr, nullptr, ids.c_str(), name);
+                this->publish_telemetry_discovery_(node_id, "espnow_ingest_dropped", "ESP-NOW frames dropped",
+                                                   state_topic, "ingest_dropped", nullptr, nullptr, ids.c_str(), name);
+                this->publish_telemetry_discovery_(node_id, "espnow_latency_p95", "ESP-NOW publish latency p95",
+                                                   state_topic, "latency_p95_ms", "ms", "duration", ids.c_str(), name);
+                this->telemetry_discovery_epoch_ = this->discovery_epoch_;
+            }
+
+            uint32_t online = 0;
+            this->devices_.for_each([&online](uint64_t mac_key, DeviceInfo &info) {
+                if (info.online) {
+                    online++;
+                }
+            });
+
+            char hist[LatencyHistogram::BUCKETS * 11 + 1];
+            size_t pos = 0;
+            for (size_t i = 0; i < LatencyHistogram::BUCKETS; i++) {
+                pos += snprintf(hist + pos, sizeof(hist) - pos, i == 0 ? "%u" : ",%u",
+                                (unsigned) this->latency_.count(i));
+            }
+
+            char json[640];
+            int len = snprintf(json, sizeof(json),
+                               "{\"devices\":%u,\"online\":%u,\"frames\":%u,\"parse_errors\":%u,"
+                               "\"duplicates\":%u,\"publish_failures\":%u,\"pair_acks\":%u,\"schema_requests\":%u,"
+                               "\"states_published\":%u,\"states_coalesced\":%u,\"aggregates_published\":%u,"
+                               "\"reassembly_failures\":%u,\"reassembly_timeouts\":%u,\"ingest_depth\":%u,\"ingest_high_water\":%u,\"ingest_dropped\":%u,\"latency_p50_ms\":%u,"
+                               "\"latency_p95_ms\":%u,\"latency_max_ms\":%u,\"latency_hist\":[%s]}",
+                               (unsigned) this->devices_.size(), (unsigned) online, (unsigned) this->frames_received_,
+                               (unsigned) this->parse_errors_, (unsigned) this->duplicates_,
+                               (unsigned) this->publish_failures_, (unsigned) this->pair_acks_sent_,
+                               (unsigned) this->schema_requests_, (unsigned) this->states_published_,
+                               (unsigned) this->states_coalesced_, (unsigned) this->aggregates_published_,
+                               (unsigned) this->reassembly_.failures(),
+                               (unsigned) this->reassembly_.timeouts(), (unsigned) this->ingest_.size(),
+                               (unsigned) this->ingest_.high_water(), (unsigned) this->ingest_.dropped(),
+                               (unsigned) this->latency_.percentile_ms(50), (unsigned) this->latency_.percentile_ms(95),
+                               (unsigned) (this->latency_.max_us() / 1000), hist);
+            if (len > 0 && (size_t) len < sizeof(json)) {
+                this->publish_(state_topic, json, len);
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::publish_device_telemetry_(uint64_t mac_key, DeviceInfo &info)
+        {
+            const char *device_name = this->device_names_.c_str(info.name);
+            if (device_name[0] == '\0') {
+                return;
+            }
+            std::string state_topic = std::string(device_name) + "/telemetry";
+
+            if (this->telemetry_discovery_ && !this->current_epoch_(info.telemetry_epoch)) {
+                char mac_str[13];
+                format_mac_(mac_key, mac_str);
+                this->publish_telemetry_discovery_(device_name, "espnow_rssi", "ESP-NOW RSSI", state_topic,
+                                                   "rssi_avg", "dBm", "signal_strength", mac_str, device_name);
+                this->publish_telemetry_discovery_(device_name, "espnow_packets", "ESP-NOW packets", state_topic,
+                                                   "packets", nullptr, nullptr, mac_str, device_name);
+                info.telemetry_epoch = this->discovery_epoch_;
+            }
+
+            const LinkStats &link = info.link;
+            char rssi[48];
+            if (link.has_rssi()) {
+                snprintf(rssi, sizeof(rssi), "%d,\"rssi_avg\":%d,\"rssi_max\":%d",
+                         link.rssi_min, link.rssi_avg_x16 / 16, link.rssi_max);
+            } else {
+                snprintf(rssi, sizeof(rssi), "null,\"rssi_avg\":null,\"rssi_max\":null");
+            }
+
+            char json[256];
+            int len = snprintf(json, sizeof(json),
+                               "{\"packets\":%u,\"parse_errors\":%u,\"duplicates\":%u,\"rssi_min\":%s,"
+                               "\"last_gap_ms\":%u,\"interval_ms\":%u,\"online\":%s}",
+                               (unsigned) link.packets, (unsigned) link.parse_errors, (unsigned) link.duplicates,
+                               rssi, (unsigned) link.last_gap_ms, (unsigned) info.interval_ms,
+                               info.online ? "true" : "false");
+            if (len > 0 && (size_t) len < sizeof(json)) {
+                this->publish_(state_topic, json, len);
+            }
+        }
+
+        void Now_MQTT_BridgeComponent::publish_telemetry_discovery_(const std::string &node_id, const char *object_id,
+                                                                    const char *name, const std::string &state_topic,
+                                                                    const char *value_key, const char *unit,
+                                                                    const char *device_class, const char *device_ids,
+                                                                    const char *device_name)
+        {
+            JsonWriter json(this->discovery_payload_, sizeof(this->discovery_payload_));
+            json.begin_object();
+            json.add("name", name);
+            json.add("stat_t", state_topic);
+            json.key("val_tpl");
+            json.begin_string();
+            json.append("{{ value_json.");
+            json.append(value_key);
+            json.append(" }}");
+            json.end_string();
+            json.key("uniq_id");
+            json.begin_string();
+            json.append(device_ids);
+            json.append("_");
+            json.append(object_id);
+            json.end_string();
+            json.raw(",\"ent_cat\":\"diagnostic\"");
+            if (unit != nullptr) {
+                json.add("unit_of_meas", unit);
+                json.raw(",\"stat_cla\":\"measurement\"");
+            } else {
+                json.raw(",\"stat_cla\":\"total_increasing\"");
+            }
+            if (device_class != nullptr) json.add("dev_cla", device_class);
+            json.key("dev");
+            json.begin_object();
+            json.add("ids", device_ids);
+            json.add("name", device_name);
+            json.end_object();
+            json.end_object();
+
+            std::string config_topic = this->discovery_info_.prefix + "/sensor/" + node_id + "/" + object_id + "/config";
+            this->publish_discovery_(config_topic, json);
+        }
+
+        // =============================================================================
+        // Utility Methods
+        // =============================================================================
+
+        uint64_t Now_MQTT_BridgeComponent::pack_mac_(const uint8_t *mac)
+        {
+            // Bit 48 keeps the key non-zero (0 marks an empty table slot)
+            uint64_t key = 1ULL << 48;
+            for (int i = 0; i < 6; i++) {
+                key |= uint64_t(mac[i]) << (8 * (5 - i));
+            }
+            return key;
+        }
+
+        void Now_MQTT_BridgeComponent::format_mac_(uint64_t mac_key, char *mac_str)
+        {
+            static const char *const HEX = "0123456789abcdef";
+            for (int i = 0; i < 12; i++) {
+                mac_str[i] = HEX[(mac_key >> (4 * (11 - i))) & 0xF];
+            }
+            mac_str[12] = '\0';
         }
 
     } // namespace now_mqtt_bridge
@@ -1,11 +1,32 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/mqtt/mqtt_client.h"
+#include "esphome/components/now_mqtt_protocol/codec.h"
 #include "esp_wifi.h"
 #include "esp_now.h"
-#include <map>
+#include "esp_idf_version.h"
+#include "ingest_ring.h"
+#include "flat_table.h"
+#include "string_pool.h"
+#include "timer_wheel.h"
+#include "telemetry.h"
+#include "dedup_window.h"
+#include "schema_cache.h"
+#include "reassembly.h"
+#include "json_writer.h"
+#include "topic_table.h"
+#include "coalescer.h"
+#include "aggregator.h"
+#include "component_table.h"
+#include "snapshot.h"
+#include "capture.h"
+#include <cstdint>
+#include <ctime>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace esphome
 {
@@ -14,18 +35,108 @@ namespace esphome
         // =============================================================================
         // Constants
         // =============================================================================
-        static constexpr char FIELD_DELIMITER = ':';
-        static constexpr uint8_t EXPECTED_TOKEN_COUNT = 11;
-        static constexpr uint32_t DEVICE_TIMEOUT_MS = 300000;  // 5 minutes
+        static constexpr uint32_t DEVICE_TIMEOUT_MS = 300000;  // 5 minutes, until the interval is known
+        static constexpr uint32_t MIN_DEVICE_TIMEOUT_MS = 10000;
+        static constexpr uint8_t MISSED_REPORTS = 3;           // Intervals without a packet before offline
+        static constexpr uint32_t MIN_INTERVAL_SAMPLE_MS = 2000;  // Shorter gaps are frames of one wake cycle
+        static constexpr uint32_t STATS_INTERVAL_MS = 60000;
+        static constexpr uint32_t DUPLICATE_WINDOW_MS = 1000;  // Unsequenced: identical frames closer than this are retries
+        static constexpr uint8_t TELEMETRY_DEVICES_PER_LOOP = 4;
+        static constexpr size_t INGEST_QUEUE_SIZE = 32;        // Raw frames buffered between Wi-Fi task and loop
+        static constexpr size_t DEVICE_NAME_BYTES = 32;        // Name pool budget per device
+        static constexpr time_t MIN_VALID_TIME = 1577836800;   // 2020-01-01; earlier = clock not synced
+        static constexpr size_t SCHEMA_BYTES_PER_ENTRY = 48;   // Schema arena budget per entity / device
+        static constexpr uint32_t SCHEMA_REQUEST_INTERVAL_MS = 2000;  // Per node; compact frames keep coming until it reacts
+        static constexpr size_t REASSEMBLY_SLOTS = 4;          // Fragmented messages assembled at once
+        static constexpr uint32_t REASSEMBLY_TIMEOUT_MS = 1000;
+        static constexpr size_t TOPIC_BYTES_PER_ENTITY = 48;   // Topic table budget per entity (state topic)
+        static constexpr size_t TOPIC_BYTES_PER_DEVICE = 32;   // ... and per device (status topic)
+        static constexpr size_t DISCOVERY_PAYLOAD_SIZE = 768;  // Rendered config JSON, longest names included
+        static constexpr std::string_view DISCOVERY_MANUFACTURER = ",\"mf\":\"espressif\"";
+        static constexpr std::string_view DISCOVERY_ORIGIN = ",\"o\":{\"name\":\"now_mqtt_bridge\"}";
+        static constexpr size_t DEVICE_DISCOVERY_SIZE = 4096;  // One node's bundled config, ~150 bytes per entity
+        static constexpr size_t COMPONENT_WORDS_PER_ENTITY = 2;  // Component table budget (list growth included)
+        static constexpr size_t MAX_SNAPSHOT_CHUNKS = 64;      // 16 KB of NVS at most
+        static constexpr uint16_t SNAPSHOT_HEADER_INDEX = 0xFFFF;
+        static constexpr uint32_t SNAPSHOT_EPOCH = UINT32_MAX;  // Epoch of entries restored from the snapshot
+        static constexpr size_t CAPTURE_SLICE_SIZE = 1024;    // Trace bytes per MQTT message when dumping
+        static constexpr size_t CAPTURE_LOG_LINE_BYTES = 64;  // ... and per log line
+        static constexpr uint8_t CAPTURE_SLICES_PER_LOOP = 4;
 
         // =============================================================================
         // Device Tracking
         // =============================================================================
+        // Keyed by the packed 48-bit MAC in a flat table; the name is an offset into
+        // the interned name pool. The entry's slot index doubles as its timer handle.
         struct DeviceInfo {
-            std::string name;
-            std::string mac_str;
+            uint16_t name;
             uint32_t last_seen_ms;
+            uint32_t interval_ms;     // Advertised or learned reporting interval, 0 = unknown
+            bool interval_advertised;
             bool online;
+            uint16_t status_topic;     // Topic table handle for <name>/status, rendered on first use
+            uint32_t telemetry_epoch;  // Discovery epoch telemetry entities were published in
+            uint16_t components;       // Component table list of entity schema IDs (device discovery)
+            bool bundle_dirty;         // Components or node info changed since the bundle was published
+            bool bundle_overflow;      // Bundle outgrew its payload buffer; per-entity discovery from then on
+            uint32_t bundle_epoch;     // Discovery epoch the bundle was published in
+            uint32_t bundle_hash;      // Node name / version / board it was published with
+            LinkStats link;
+            DedupWindow dedup;
+        };
+
+        // =============================================================================
+        // Discovery Cache
+        // =============================================================================
+        // One entry per (MAC, entity): hash of the metadata last published as discovery
+        // config, and the cache epoch it was published in. sample_ms is when the reading
+        // last published as state was taken, so a buffered reading that arrives after a
+        // newer one (a retried frame) does not overwrite it. topic is the entity's
+        // rendered state topic in the topic table. policy indexes the publish policies
+        // (resolved whenever discovery is republished), published_ms / held track its
+        // minimum publish interval and aggregate its aggregation window.
+        struct EntityState {
+            uint32_t meta_hash;
+            uint32_t epoch;
+            uint32_t sample_ms;
+            uint32_t published_ms;
+            bool has_sample : 1;
+            bool has_published : 1;
+            uint8_t policy;
+            uint16_t topic;
+            uint16_t held;       // Coalescer buffer, NONE until first needed
+            uint16_t aggregate;  // Aggregator window, NONE until first needed
+        };
+
+        // =============================================================================
+        // Publish Policy
+        // =============================================================================
+        // QoS, retain flag and minimum interval for state topics. The first policy
+        // whose non-empty matchers all equal the reading's node name, entity name and
+        // device class applies; entities no policy matches keep DEFAULT_POLICY.
+        struct PublishPolicy {
+            std::string node;
+            std::string entity;
+            std::string device_class;
+            uint8_t qos;
+            bool retain;
+            uint32_t min_interval_ms;  // 0 = publish every state; else latest state at most this often
+            uint32_t aggregate_ms;     // 0 = off; else numeric states also go out as windowed aggregates
+            bool passthrough;          // With aggregate_ms: keep publishing raw states too
+        };
+
+        static constexpr uint8_t DEFAULT_POLICY = 0xFF;
+        static constexpr size_t MAX_POLICIES = DEFAULT_POLICY;
+
+        // =============================================================================
+        // Persisted Schema
+        // =============================================================================
+        // Flash copy of a schema cache entry, so compact frames still decode after a
+        // restart. One preference per (MAC, schema ID); written only when first learned.
+        struct SchemaBlob {
+            uint32_t schema;
+            uint8_t len;
+            uint8_t data[now_mqtt_protocol::MAX_SCHEMA_SIZE];
         };
 
         // =============================================================================
@@ -36,45 +147,282 @@ namespace esphome
         public:
             void setup() override;
             void loop() override;
+            void dump_config() override;
+            void on_shutdown() override;
             float get_setup_priority() const override;
 
             // Configuration setters
             void set_wifi_channel(uint8_t channel) { this->wifi_channel_ = channel; }
             void set_publish_availability(bool enabled) { this->publish_availability_ = enabled; }
+            void set_max_frames_per_loop(uint8_t frames) { this->max_frames_per_loop_ = frames; }
+            void set_max_entities(uint16_t max_entities) { this->max_entities_ = max_entities; }
+            void set_max_devices(uint16_t max_devices) { this->max_devices_ = max_devices; }
+            void set_use_psram(bool use_psram) { this->use_psram_ = use_psram; }
+            void set_telemetry_interval(uint32_t interval_ms) { this->telemetry_interval_ms_ = interval_ms; }
+            void set_telemetry_discovery(bool enabled) { this->telemetry_discovery_ = enabled; }
+            void set_device_discovery(bool enabled) { this->device_discovery_ = enabled; }
+            void set_snapshot_interval(uint32_t interval_ms) { this->snapshot_interval_ms_ = interval_ms; }
+            void set_capture_size(uint32_t bytes) { this->capture_size_ = bytes; }
+            void add_publish_policy(const std::string &node, const std::string &entity, const std::string &device_class,
+                                    uint8_t qos, bool retain, uint32_t min_interval_ms, uint32_t aggregate_ms,
+                                    bool passthrough)
+            {
+                this->policies_.push_back(
+                    {node, entity, device_class, qos, retain, min_interval_ms, aggregate_ms, passthrough});
+            }
+
+            // Ingest queue statistics
+            uint32_t get_ingest_dropped() const { return this->ingest_.dropped(); }
+            uint32_t get_ingest_high_water() const { return this->ingest_.high_water(); }
+            size_t get_ingest_depth() const { return this->ingest_.size(); }
+
+            // Discovery cache statistics
+            uint32_t get_discovery_hits() const { return this->discovery_hits_; }
+            uint32_t get_discovery_misses() const { return this->discovery_misses_; }
+
+            // Schema cache statistics
+            uint32_t get_schema_requests() const { return this->schema_requests_; }
+
+            // Fragment reassembly statistics
+            uint32_t get_reassembly_failures() const { return this->reassembly_.failures(); }
+            uint32_t get_reassembly_timeouts() const { return this->reassembly_.timeouts(); }
+
+            // Publish policy statistics
+            uint32_t get_states_published() const { return this->states_published_; }
+            uint32_t get_states_coalesced() const { return this->states_coalesced_; }
+            uint32_t get_aggregates_published() const { return this->aggregates_published_; }
+
+            // Bridge-wide telemetry
+            uint32_t get_frames_received() const { return this->frames_received_; }
+            uint32_t get_parse_errors() const { return this->parse_errors_; }
+            uint32_t get_duplicates() const { return this->duplicates_; }
+            uint32_t get_publish_failures() const { return this->publish_failures_; }
+            uint32_t get_pair_acks_sent() const { return this->pair_acks_sent_; }
+            const LatencyHistogram &get_latency() const { return this->latency_; }
 
         protected:
             uint8_t wifi_channel_ = 1;
             bool publish_availability_ = true;
+            uint8_t max_frames_per_loop_ = 8;
+            uint16_t max_entities_ = 256;
+            uint16_t max_devices_ = 128;
+            bool use_psram_ = false;
+            uint32_t telemetry_interval_ms_ = 0;  // 0 = telemetry not published
+            bool telemetry_discovery_ = false;
+            bool device_discovery_ = false;
+            uint32_t snapshot_interval_ms_ = 0;  // 0 = state not persisted
+            uint32_t capture_size_ = 0;          // 0 = no frame capture
 
         private:
+            // Raw frames from the receive callback, drained in loop()
+            SpscRing<RawFrame, INGEST_QUEUE_SIZE> ingest_;
+            uint32_t reported_drops_ = 0;
+
+            // Messages larger than one ESP-NOW payload, assembled from their fragments
+            Reassembler<REASSEMBLY_SLOTS> reassembly_{REASSEMBLY_TIMEOUT_MS};
+
             // Device tracking
-            std::map<std::string, DeviceInfo> devices_;
-            
+            FlatTable<DeviceInfo> devices_;
+            StringPool device_names_;
+            TimerWheel device_timers_;
+            bool device_table_full_ = false;
+            uint32_t last_stats_ms_ = 0;
+
             // MQTT discovery info cache
             mqtt::MQTTDiscoveryInfo discovery_info_;
 
+            // Topics rendered once per entity / device, and the string every topic is
+            // copied into for the MQTT client, which keeps its capacity between publishes
+            TopicTable topics_;
+            std::string topic_buffer_;
+            bool topic_table_full_ = false;
+
+            // Publish policies; rate-limited entities wait in the coalescer
+            std::vector<PublishPolicy> policies_;
+            Coalescer coalescer_;
+            uint32_t states_published_ = 0;
+            uint32_t states_coalesced_ = 0;
+            Aggregator aggregator_;
+            uint32_t aggregates_published_ = 0;
+
+            // Config payloads are rendered here, one at a time, instead of on the heap
+            char discovery_payload_[DISCOVERY_PAYLOAD_SIZE];
+
+            // Device discovery: each node's entities as schema IDs, bundled into one
+            // config rendered into a buffer allocated with the tables
+            ComponentTable components_;
+            char *device_discovery_payload_ = nullptr;
+            bool component_table_full_ = false;
+
+            // Discovery cache; bumping the epoch invalidates every entry at once
+            FlatTable<EntityState> entities_;
+            uint32_t discovery_epoch_ = 1;
+            uint32_t discovery_hits_ = 0;
+            uint32_t discovery_misses_ = 0;
+            bool mqtt_connected_ = false;
+            bool mqtt_connected_once_ = false;
+
+            // State snapshot: entries restored from it count as discovered (SNAPSHOT_EPOCH)
+            // until the first discovery invalidation after the first MQTT session starts
+            bool snapshot_current_ = false;
+            bool snapshot_dirty_ = false;
+            uint32_t last_snapshot_ms_ = 0;
+
+            // Schemas for compact frames: RAM cache in front of flash
+            SchemaCache schemas_;
+            uint32_t schema_requests_ = 0;
+            uint64_t last_schema_request_mac_ = 0;
+            uint32_t last_schema_request_ms_ = 0;
+
+            // Frame capture: received frames are recorded into the ring in the main loop,
+            // except during a dump and after a trace is loaded or replayed (until
+            // 'clear'); dumps go out a few slices per loop
+            enum class CaptureDump : uint8_t { NONE, MQTT, LOG };
+            CaptureRing capture_;
+            TraceEncoder capture_encoder_;
+            TraceParser capture_parser_;
+            CaptureDump capture_dump_ = CaptureDump::NONE;
+            bool capture_paused_ = false;
+
+            // Replay of the capture ring through on_espnow_receive_(). Publishing goes to
+            // a counting stand-in instead of the broker while it runs.
+            struct Replay {
+                bool active;
+                uint8_t speed;  // 0 = as fast as possible
+                bool pending;   // frame is read but not yet due
+                CaptureRing::Cursor cursor;
+                RawFrame frame;
+                uint32_t first_rx_us;
+                uint32_t start_us;
+                uint32_t frames;
+                uint32_t publishes;
+                uint32_t publish_bytes;
+                uint32_t parse_errors;  // Bridge counters when it started
+                uint32_t duplicates;
+                LatencyHistogram latency;
+            };
+            Replay replay_{};
+
+            // Telemetry; device topics are published a few per loop from a slot cursor
+            LatencyHistogram latency_;
+            uint32_t frames_received_ = 0;
+            uint32_t parse_errors_ = 0;
+            uint32_t duplicates_ = 0;
+            uint32_t publish_failures_ = 0;
+            uint32_t pair_acks_sent_ = 0;
+            uint32_t last_telemetry_ms_ = 0;
+            size_t telemetry_cursor_ = SIZE_MAX;  // SIZE_MAX = no device pass in progress
+            uint32_t telemetry_discovery_epoch_ = 0;
+
             // Callback handlers
-            void on_espnow_receive_(const uint8_t *mac, const uint8_t *data, int len);
+            void on_espnow_receive_(const RawFrame &frame);
+            void handle_message_(const uint8_t *mac, uint64_t mac_key, const char *mac_str, const uint8_t *data,
+                                 size_t len, int8_t rssi);
+            bool allocate_tables_();
+#if ESP_IDF_VERSION_MAJOR >= 5
+            static void static_receive_callback_(const esp_now_recv_info_t *info, const uint8_t *data, int len);
+#else
             static void static_receive_callback_(const uint8_t *mac, const uint8_t *data, int len);
+#endif
+            static void enqueue_frame_(const uint8_t *mac, const uint8_t *data, int len, int8_t rssi);
+            void drain_ingest_();
+            void send_pair_ack_(const uint8_t *node_mac);
+            void send_schema_request_(uint64_t mac_key, const char *mac_str);
+
+            // Frame decoding (v1 colon-delimited text, v2 binary)
+            bool handle_text_frame_(uint64_t mac_key, const char *mac_str, const uint8_t *data, int len);
+            bool handle_binary_frame_(uint64_t mac_key, const char *mac_str, const uint8_t *data, int len);
+
+            // Schema cache
+            void learn_schema_(uint64_t mac_key, const now_mqtt_protocol::RecordPrefix &schema);
+            bool find_schema_(uint64_t mac_key, uint32_t schema, now_mqtt_protocol::RecordPrefix *out, uint8_t *scratch);
+            static uint32_t schema_preference_key_(uint64_t mac_key, uint32_t schema);
 
             // Message processing
-            void process_sensor_message_(const char *tokens[], const std::string &mac_str);
-            void process_binary_sensor_message_(const char *tokens[], const std::string &mac_str);
+            void process_reading_(uint64_t mac_key, const now_mqtt_protocol::NodeInfo &node,
+                                  const now_mqtt_protocol::Reading &reading, std::string_view state, const char *mac_str);
+
+            // Discovery cache
+            bool discovery_needed_(const now_mqtt_protocol::NodeInfo &node, const now_mqtt_protocol::Reading &reading,
+                                   const char *mac_str, EntityState **entity_out);
+            static uint64_t entity_key_(const char *mac_str, std::string_view name);
+            static bool newest_sample_(EntityState *entity, const now_mqtt_protocol::Reading &reading);
+            void invalidate_discovery_(const char *reason);
+            bool current_epoch_(uint32_t epoch) const
+            {
+                return epoch == this->discovery_epoch_ || (epoch == SNAPSHOT_EPOCH && this->snapshot_current_);
+            }
 
             // MQTT publishing
-            void publish_sensor_discovery_(const char *tokens[], const std::string &mac_str);
-            void publish_sensor_state_(const char *tokens[]);
-            void publish_binary_sensor_discovery_(const char *tokens[], const std::string &mac_str);
-            void publish_binary_sensor_state_(const char *tokens[]);
-            void publish_device_availability_(const std::string &device_name, bool online);
+            void publish_entity_discovery_(const now_mqtt_protocol::NodeInfo &node, const now_mqtt_protocol::Reading &reading,
+                                           const char *mac_str);
+            void write_entity_config_(JsonWriter &json, const now_mqtt_protocol::NodeInfo &node,
+                                      const now_mqtt_protocol::Reading &reading, const char *mac_str);
+            std::string_view state_topic_(EntityState *entity, const now_mqtt_protocol::NodeInfo &node,
+                                          const now_mqtt_protocol::Reading &reading, std::string *fallback);
+            static const char *domain_(const now_mqtt_protocol::Reading &reading);
+            uint8_t match_policy_(const now_mqtt_protocol::NodeInfo &node, const now_mqtt_protocol::Reading &reading) const;
+            const PublishPolicy &policy_(uint8_t index) const;
+            void publish_state_(EntityState *entity, uint8_t policy, std::string_view topic, std::string_view state);
+            void flush_held_state_(uint16_t entity_index, std::string_view state);
 
-            // Device tracking
-            void update_device_seen_(const std::string &mac_str, const std::string &name);
-            void check_device_timeouts_();
-            std::string mac_to_string_(const uint8_t *mac);
+            // Aggregation
+            uint16_t aggregate_window_(EntityState *entity, const PublishPolicy &policy,
+                                       const now_mqtt_protocol::NodeInfo &node, const now_mqtt_protocol::Reading &reading,
+                                       bool discover);
+            void add_sample_(uint16_t window, const PublishPolicy &policy, std::string_view state, bool newest);
+            void publish_aggregate_(const Aggregator::Window &window);
+            void publish_aggregate_discovery_(const now_mqtt_protocol::NodeInfo &node,
+                                              const now_mqtt_protocol::Reading &reading, const char *mac_str,
+                                              std::string_view topic);
+            void publish_reading_history_(std::string_view state_topic, const now_mqtt_protocol::Reading &reading,
+                                          std::string_view state);
+            void write_aggregate_config_(JsonWriter &json, const now_mqtt_protocol::Reading &reading, const char *mac_str,
+                                         std::string_view topic);
+            void write_discovery_device_(JsonWriter &json, const now_mqtt_protocol::NodeInfo &node, const char *mac_str);
+            bool publish_discovery_(const std::string &topic, const JsonWriter &json);
+            void publish_device_availability_(DeviceInfo &info, bool online);
+            bool publish_(std::string_view topic, const char *payload, size_t len, uint8_t qos = 2, bool retain = true);
+            bool publish_(std::string_view topic, const std::string &payload) { return this->publish_(topic, payload.data(), payload.size()); }
 
-            // String parsing
-            static int split_string_(char **tokens, int max_tokens, char *string, char delimiter);
+            // Device discovery
+            bool bundle_entity_(uint64_t mac_key, const now_mqtt_protocol::NodeInfo &node,
+                                const now_mqtt_protocol::Reading &reading);
+            void flush_device_discovery_(uint64_t mac_key, const char *mac_str, const now_mqtt_protocol::NodeInfo &node);
+            void unbundle_device_(uint64_t mac_key, const char *mac_str, const now_mqtt_protocol::NodeInfo &node,
+                                  DeviceInfo *info);
+            static size_t component_id_(char *out, std::string_view name);
+            static uint32_t node_hash_(const now_mqtt_protocol::NodeInfo &node);
+
+            // State snapshot
+            void save_snapshot_();
+            void restore_snapshot_();
+            uint32_t snapshot_layout_() const;
+            static uint32_t snapshot_preference_key_(uint16_t index);
+
+            // Frame capture and replay
+            void on_capture_command_(const std::string &command);
+            void on_capture_load_(const std::string &payload);
+            void pump_capture_dump_();
+            void start_replay_(uint8_t speed);
+            void pump_replay_();
+            void finish_replay_();
+            void record_latency_(uint32_t rx_us);
+
+            // Telemetry
+            void publish_telemetry_();
+            void publish_bridge_telemetry_();
+            void publish_device_telemetry_(uint64_t mac_key, DeviceInfo &info);
+            void publish_telemetry_discovery_(const std::string &node_id, const char *object_id, const char *name,
+                                              const std::string &state_topic, const char *value_key, const char *unit,
+                                              const char *device_class, const char *device_ids, const char *device_name);
+
+            // Device tracking
+            void update_device_seen_(uint64_t mac_key, const char *mac_str, const now_mqtt_protocol::NodeInfo &node);
+            void on_device_timeout_(uint16_t handle);
+            static uint32_t device_timeout_ms_(const DeviceInfo &info);
+            static uint64_t pack_mac_(const uint8_t *mac);
+            static void format_mac_(uint64_t mac_key, char *mac_str);
 
             // Static instance for callbacks
             static Now_MQTT_BridgeComponent *instance_;
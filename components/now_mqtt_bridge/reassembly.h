@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esphome/components/now_mqtt_protocol/codec.h"
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Fragment Reassembly
+        // =============================================================================
+        // Fixed pool of N message buffers, each keyed by (sender, message id). Every
+        // fragment but the last is full-size, so each lands at index * payload size
+        // and fragments may arrive in any order; a bitmap tracks which are in. A
+        // message still incomplete after timeout_ms is dropped, and a new message
+        // with no free buffer evicts the oldest incomplete one. Completed messages
+        // keep their key for a while so late retries of their fragments are ignored
+        // instead of starting a new message.
+        template<size_t N>
+        class Reassembler
+        {
+        public:
+            explicit Reassembler(uint32_t timeout_ms) : timeout_ms_(timeout_ms) {}
+
+            // Add a fragment from source. Returns the complete message (valid until
+            // the next call) once its last missing fragment arrives, else nullptr.
+            const uint8_t *add(uint64_t source, const now_mqtt_protocol::Fragment &fragment, uint32_t now,
+                               size_t *len)
+            {
+                Slot *slot = this->find_(source, fragment.message_id);
+                if (slot != nullptr && slot->state == State::DONE) {
+                    this->duplicates_++;
+                    return nullptr;
+                }
+                if (slot != nullptr && slot->total != fragment.total) {
+                    // Same id, different message: the sender restarted mid-message
+                    this->failures_++;
+                    slot->state = State::FREE;
+                    slot = nullptr;
+                }
+                if (slot == nullptr) {
+                    slot = this->claim_(now);
+                    slot->source = source;
+                    slot->message_id = fragment.message_id;
+                    slot->total = fragment.total;
+                    slot->received = 0;
+                    slot->len = 0;
+                    slot->started_ms = now;
+                    slot->state = State::ASSEMBLING;
+                }
+
+                uint32_t bit = 1UL << fragment.index;
+                if (slot->received & bit) {
+                    this->duplicates_++;
+                    return nullptr;
+                }
+                size_t offset = fragment.index * now_mqtt_protocol::FRAGMENT_PAYLOAD_SIZE;
+                memcpy(slot->data + offset, fragment.payload, fragment.len);
+                slot->received |= bit;
+                if (fragment.index + 1 == fragment.total) {
+                    slot->len = offset + fragment.len;
+                }
+
+                if (slot->received != (1UL << slot->total) - 1) {
+                    return nullptr;
+                }
+                slot->state = State::DONE;
+                slot->started_ms = now;  // Now counts how long late retries are ignored
+                this->completed_++;
+                *len = slot->len;
+                return slot->data;
+            }
+
+            // Drop messages that did not complete in time
+            void expire(uint32_t now)
+            {
+                for (auto &slot : this->slots_) {
+                    if (slot.state == State::FREE || now - slot.started_ms < this->timeout_ms_) {
+                        continue;
+                    }
+                    if (slot.state == State::ASSEMBLING) {
+                        this->timeouts_++;
+                    }
+                    slot.state = State::FREE;
+                }
+            }
+
+            size_t active() const
+            {
+                size_t count = 0;
+                for (const auto &slot : this->slots_) {
+                    count += slot.state == State::ASSEMBLING;
+                }
+                return count;
+            }
+
+            uint32_t completed() const { return this->completed_; }
+            uint32_t failures() const { return this->failures_; }  // Inconsistent or evicted
+            uint32_t timeouts() const { return this->timeouts_; }
+            uint32_t duplicates() const { return this->duplicates_; }
+            static constexpr size_t memory_usage() { return sizeof(Slot) * N; }
+
+        protected:
+            static_assert(now_mqtt_protocol::MAX_FRAGMENTS <= 32, "received bitmap is 32 bits");
+
+            enum class State : uint8_t { FREE, ASSEMBLING, DONE };
+
+            struct Slot {
+                uint64_t source = 0;
+                uint16_t message_id = 0;
+                uint8_t total = 0;
+                State state = State::FREE;
+                uint32_t received = 0;
+                uint32_t started_ms = 0;
+                size_t len = 0;
+                uint8_t data[now_mqtt_protocol::MAX_MESSAGE_SIZE];
+            };
+
+            Slot *find_(uint64_t source, uint16_t message_id)
+            {
+                for (auto &slot : this->slots_) {
+                    if (slot.state != State::FREE && slot.source == source && slot.message_id == message_id) {
+                        return &slot;
+                    }
+                }
+                return nullptr;
+            }
+
+            // A free buffer, else the oldest completed one, else the oldest incomplete one
+            Slot *claim_(uint32_t now)
+            {
+                Slot *done = nullptr;
+                Slot *assembling = nullptr;
+                for (auto &slot : this->slots_) {
+                    if (slot.state == State::FREE) {
+                        return &slot;
+                    }
+                    Slot *&oldest = slot.state == State::DONE ? done : assembling;
+                    if (oldest == nullptr || now - slot.started_ms > now - oldest->started_ms) {
+                        oldest = &slot;
+                    }
+                }
+                if (done != nullptr) {
+                    return done;
+                }
+                this->failures_++;
+                return assembling;
+            }
+
+            uint32_t timeout_ms_;
+            Slot slots_[N];
+            uint32_t completed_ = 0;
+            uint32_t failures_ = 0;
+            uint32_t timeouts_ = 0;
+            uint32_t duplicates_ = 0;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
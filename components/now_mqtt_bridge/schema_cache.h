@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "esphome/components/now_mqtt_protocol/codec.h"
+#include "flat_table.h"
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Schema Cache
+        // =============================================================================
+        // Node blocks and record prefixes learned from full frames, so compact frames
+        // can refer to them by schema ID. Entries are keyed by (MAC, schema ID) and
+        // copied into an append-only arena; both arena and index are caller-provided.
+        // Nothing is evicted: a full cache makes the caller fall back to flash.
+        class SchemaCache
+        {
+        public:
+            struct Entry {
+                uint16_t offset;
+                uint8_t len;
+            };
+
+            static uint64_t key(uint64_t mac_key, uint32_t schema)
+            {
+                uint64_t hash = fnv1a_64(FNV1A_64_INIT, &mac_key, sizeof(mac_key));
+                return fnv1a_64(hash, &schema, sizeof(schema)) | 1;  // never 0
+            }
+
+            void init(uint8_t *arena, size_t arena_size, FlatTable<Entry>::Slot *index_slots,
+                      size_t index_slot_count, size_t max_schemas)
+            {
+                this->arena_ = arena;
+                this->arena_size_ = arena_size < UINT16_MAX ? arena_size : UINT16_MAX;
+                this->used_ = 0;
+                this->index_.init(index_slots, index_slot_count, max_schemas);
+            }
+
+            bool find(uint64_t key, now_mqtt_protocol::RecordPrefix *schema)
+            {
+                const Entry *entry = this->index_.find(key);
+                if (entry == nullptr) {
+                    return false;
+                }
+                *schema = {this->arena_ + entry->offset, entry->len};
+                return true;
+            }
+
+            // Cache a copy of data; false if it does not fit (an existing entry is kept)
+            bool insert(uint64_t key, const uint8_t *data, size_t len, now_mqtt_protocol::RecordPrefix *schema)
+            {
+                if (this->find(key, schema)) {
+                    return true;
+                }
+                if (len > UINT8_MAX || this->used_ + len > this->arena_size_) {
+                    return false;
+                }
+                bool inserted;
+                Entry *entry = this->index_.insert(key, &inserted);
+                if (entry == nullptr) {
+                    return false;
+                }
+                entry->offset = this->used_;
+                entry->len = len;
+                memcpy(this->arena_ + this->used_, data, len);
+                this->used_ += len;
+                *schema = {this->arena_ + entry->offset, entry->len};
+                return true;
+            }
+
+            size_t size() const { return this->index_.size(); }
+            size_t used() const { return this->used_; }
+            size_t capacity() const { return this->arena_size_; }
+            size_t memory_usage() const { return this->arena_size_ + this->index_.memory_usage(); }
+
+        protected:
+            uint8_t *arena_ = nullptr;
+            size_t arena_size_ = 0;
+            size_t used_ = 0;
+            FlatTable<Entry> index_;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
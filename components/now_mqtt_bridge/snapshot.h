@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "flat_table.h"
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // State Snapshot
+        // =============================================================================
+        // A byte stream of records, stored as fixed-size chunks plus a header that
+        // says how many chunks hold how many bytes and their checksum. The writer
+        // hands each chunk to a sink as it fills and the reader pulls them from a
+        // source, so neither needs the whole stream in RAM. Unchanged leading records
+        // give unchanged chunks, which the preference layer does not rewrite.
+        //
+        // The header is written last and checked first: a torn or stale write fails
+        // the checksum and the snapshot is ignored as a whole.
+        static constexpr uint32_t SNAPSHOT_MAGIC = 0x4E4D5331;  // "NMS1"
+        static constexpr size_t SNAPSHOT_CHUNK_SIZE = 256;
+
+        struct SnapshotHeader {
+            uint32_t magic;
+            uint32_t layout;    // Caller's hash of the settings the records depend on
+            uint32_t length;    // Stream bytes, the last chunk zero-padded
+            uint32_t checksum;  // FNV-1a over the stream
+            uint16_t chunks;
+        };
+
+        struct SnapshotChunk {
+            uint8_t data[SNAPSHOT_CHUNK_SIZE];
+        };
+
+        // sink(index, chunk) stores one chunk and returns false on failure
+        template<typename Sink>
+        class SnapshotWriter
+        {
+        public:
+            SnapshotWriter(size_t max_chunks, Sink sink) : max_chunks_(max_chunks), sink_(sink) {}
+
+            // Whether len more bytes fit; check before starting a record so the
+            // stream never ends in a partial one
+            bool fits(size_t len) const { return this->length_ + len <= this->max_chunks_ * SNAPSHOT_CHUNK_SIZE; }
+
+            void put(const void *data, size_t len)
+            {
+                const uint8_t *in = static_cast<const uint8_t *>(data);
+                if (!this->fits(len)) {
+                    this->failed_ = true;
+                    return;
+                }
+                this->checksum_ = fnv1a_32(this->checksum_, in, len);
+                this->length_ += len;
+                while (len > 0) {
+                    size_t n = std::min(len, SNAPSHOT_CHUNK_SIZE - this->pos_);
+                    memcpy(this->chunk_.data + this->pos_, in, n);
+                    this->pos_ += n;
+                    in += n;
+                    len -= n;
+                    if (this->pos_ == SNAPSHOT_CHUNK_SIZE) {
+                        this->flush_();
+                    }
+                }
+            }
+
+            template<typename T>
+            void put(const T &value) { this->put(&value, sizeof(T)); }
+
+            // Store the last partial chunk; the header to save after it, or false
+            bool finish(uint32_t layout, SnapshotHeader *header)
+            {
+                if (this->pos_ > 0) {
+                    memset(this->chunk_.data + this->pos_, 0, SNAPSHOT_CHUNK_SIZE - this->pos_);
+                    this->flush_();
+                }
+                *header = {SNAPSHOT_MAGIC, layout, this->length_, this->checksum_, this->index_};
+                return !this->failed_;
+            }
+
+        protected:
+            void flush_()
+            {
+                if (!this->sink_(this->index_, this->chunk_)) {
+                    this->failed_ = true;
+                }
+                this->index_++;
+                this->pos_ = 0;
+            }
+
+            size_t max_chunks_;
+            Sink sink_;
+            SnapshotChunk chunk_;
+            size_t pos_ = 0;
+            uint32_t length_ = 0;
+            uint32_t checksum_ = FNV1A_32_INIT;
+            uint16_t index_ = 0;
+            bool failed_ = false;
+        };
+
+        // source(index, chunk) loads one chunk and returns false if it is missing
+        template<typename Source>
+        class SnapshotReader
+        {
+        public:
+            SnapshotReader(const SnapshotHeader &header, Source source) : header_(header), source_(source) {}
+
+            // Read every chunk once and check the stream against the header; nothing
+            // may be read from a snapshot that fails this
+            bool verify(uint32_t layout, size_t max_chunks)
+            {
+                const SnapshotHeader &header = this->header_;
+                if (header.magic != SNAPSHOT_MAGIC || header.layout != layout || header.chunks > max_chunks ||
+                    header.length > size_t(header.chunks) * SNAPSHOT_CHUNK_SIZE ||
+                    header.length + SNAPSHOT_CHUNK_SIZE <= size_t(header.chunks) * SNAPSHOT_CHUNK_SIZE) {
+                    return false;
+                }
+                uint32_t checksum = FNV1A_32_INIT;
+                size_t remaining = header.length;
+                for (uint16_t i = 0; i < header.chunks; i++) {
+                    if (!this->source_(i, &this->chunk_)) {
+                        return false;
+                    }
+                    size_t n = std::min(remaining, SNAPSHOT_CHUNK_SIZE);
+                    checksum = fnv1a_32(checksum, this->chunk_.data, n);
+                    remaining -= n;
+                }
+                this->verified_ = checksum == header.checksum;
+                return this->verified_;
+            }
+
+            bool get(void *data, size_t len)
+            {
+                uint8_t *out = static_cast<uint8_t *>(data);
+                if (!this->verified_ || len > this->remaining()) {
+                    return false;
+                }
+                while (len > 0) {
+                    size_t pos = this->offset_ % SNAPSHOT_CHUNK_SIZE;
+                    if (pos == 0 && !this->source_(this->offset_ / SNAPSHOT_CHUNK_SIZE, &this->chunk_)) {
+                        this->verified_ = false;
+                        return false;
+                    }
+                    size_t n = std::min(len, SNAPSHOT_CHUNK_SIZE - pos);
+                    memcpy(out, this->chunk_.data + pos, n);
+                    this->offset_ += n;
+                    out += n;
+                    len -= n;
+                }
+                return true;
+            }
+
+            template<typename T>
+            bool get(T *value) { return this->get(static_cast<void *>(value), sizeof(T)); }
+
+            size_t remaining() const { return this->header_.length - this->offset_; }
+
+        protected:
+            SnapshotHeader header_;
+            Source source_;
+            SnapshotChunk chunk_;
+            size_t offset_ = 0;
+            bool verified_ = false;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
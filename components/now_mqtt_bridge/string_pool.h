@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "flat_table.h"
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Interned String Pool
+        // =============================================================================
+        // Append-only arena of NUL-terminated strings. Each distinct string is stored
+        // once and referred to by its 16-bit offset; an index keyed by the string's
+        // hash finds existing copies. Both arena and index are caller-provided.
+        class StringPool
+        {
+        public:
+            static constexpr uint16_t INVALID = 0xFFFF;
+
+            void init(char *arena, size_t arena_size, FlatTable<uint16_t>::Slot *index_slots,
+                      size_t index_slot_count, size_t max_strings)
+            {
+                this->arena_ = arena;
+                this->arena_size_ = arena_size < INVALID ? arena_size : INVALID;
+                this->used_ = 0;
+                this->index_.init(index_slots, index_slot_count, max_strings);
+            }
+
+            // Offset of the interned copy of value, or INVALID if the pool is full
+            uint16_t intern(std::string_view value)
+            {
+                uint64_t key = fnv1a_64(FNV1A_64_INIT, value.data(), value.size()) | 1;  // never 0
+
+                // On a (very unlikely) 64-bit hash collision the string is stored unindexed
+                uint16_t *existing = this->index_.find(key);
+                if (existing != nullptr && this->get(*existing) == value) {
+                    return *existing;
+                }
+
+                if (value.find('\0') != std::string_view::npos ||
+                    this->used_ + value.size() + 1 > this->arena_size_) {
+                    return INVALID;
+                }
+
+                uint16_t offset = this->used_;
+                memcpy(this->arena_ + offset, value.data(), value.size());
+                this->arena_[offset + value.size()] = '\0';
+                this->used_ += value.size() + 1;
+
+                if (existing == nullptr) {
+                    bool inserted;
+                    uint16_t *slot = this->index_.insert(key, &inserted);
+                    if (slot != nullptr) {
+                        *slot = offset;
+                    }
+                }
+                return offset;
+            }
+
+            const char *c_str(uint16_t offset) const
+            {
+                return offset < this->used_ ? this->arena_ + offset : "";
+            }
+
+            std::string_view get(uint16_t offset) const { return this->c_str(offset); }
+
+            size_t used() const { return this->used_; }
+            size_t capacity() const { return this->arena_size_; }
+
+        protected:
+            char *arena_ = nullptr;
+            size_t arena_size_ = 0;
+            size_t used_ = 0;
+            FlatTable<uint16_t> index_;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Per-Device Link Statistics
+        // =============================================================================
+        // Counters since boot. RSSI is always negative on ESP-NOW, so rssi_max == 0
+        // means no sample yet (IDF < 5 does not report RSSI).
+        struct LinkStats {
+            uint32_t packets;
+            uint32_t parse_errors;
+            uint32_t duplicates;
+            uint32_t last_gap_ms;      // Time between the last two accepted frames
+            uint32_t last_frame_hash;  // Duplicate detection for frames without a sequence number
+            int16_t rssi_avg_x16;      // Smoothed RSSI in 1/16 dBm
+            int8_t rssi_min;
+            int8_t rssi_max;
+
+            void record(bool ok, int8_t rssi)
+            {
+                this->packets++;
+                if (!ok) {
+                    this->parse_errors++;
+                }
+                if (rssi == 0) {
+                    return;
+                }
+                if (this->rssi_max == 0) {
+                    this->rssi_min = rssi;
+                    this->rssi_max = rssi;
+                    this->rssi_avg_x16 = rssi * 16;
+                    return;
+                }
+                if (rssi < this->rssi_min) this->rssi_min = rssi;
+                if (rssi > this->rssi_max) this->rssi_max = rssi;
+                this->rssi_avg_x16 += (rssi * 16 - this->rssi_avg_x16) / 8;
+            }
+
+            bool has_rssi() const { return this->rssi_max != 0; }
+        };
+
+        // =============================================================================
+        // Latency Histogram
+        // =============================================================================
+        // Receive-to-publish latency in fixed millisecond buckets; the last bucket
+        // counts everything at or above the final bound.
+        class LatencyHistogram
+        {
+        public:
+            static constexpr size_t BUCKETS = 10;
+            static constexpr uint32_t BOUNDS_MS[BUCKETS - 1] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
+
+            void record(uint32_t latency_us)
+            {
+                uint32_t latency_ms = latency_us / 1000;
+                size_t i = 0;
+                while (i < BUCKETS - 1 && latency_ms >= BOUNDS_MS[i]) {
+                    i++;
+                }
+                this->counts_[i]++;
+                this->total_++;
+                if (latency_us > this->max_us_) {
+                    this->max_us_ = latency_us;
+                }
+            }
+
+            // Upper bound (ms) of the bucket holding the given percentile; max for the last bucket
+            uint32_t percentile_ms(uint8_t percent) const
+            {
+                if (this->total_ == 0) {
+                    return 0;
+                }
+                uint64_t target = (uint64_t(this->total_) * percent + 99) / 100;
+                uint64_t seen = 0;
+                for (size_t i = 0; i < BUCKETS - 1; i++) {
+                    seen += this->counts_[i];
+                    if (seen >= target) {
+                        return BOUNDS_MS[i];
+                    }
+                }
+                return this->max_us_ / 1000;
+            }
+
+            uint32_t count(size_t bucket) const { return this->counts_[bucket]; }
+            uint32_t total() const { return this->total_; }
+            uint32_t max_us() const { return this->max_us_; }
+
+        protected:
+            uint32_t counts_[BUCKETS] = {};
+            uint32_t total_ = 0;
+            uint32_t max_us_ = 0;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Timer Wheel
+        // =============================================================================
+        // Hashed timing wheel of 1 s ticks. Timers are addressed by a 16-bit handle into
+        // a caller-provided array and linked into per-tick buckets, so (re)arming and
+        // cancelling are O(1) and advance() only visits the buckets whose tick has
+        // passed. Deadlines further out than one revolution stay linked and are
+        // re-bucketed each time their bucket comes round.
+        class TimerWheel
+        {
+        public:
+            static constexpr uint16_t NONE = 0xFFFF;
+            static constexpr uint32_t TICK_MS = 1000;
+            static constexpr size_t BUCKETS = 256;
+
+            struct Timer {
+                uint32_t deadline_ms;
+                uint16_t prev;
+                uint16_t next;
+                uint16_t bucket;  // NONE = not armed
+            };
+
+            void init(Timer *timers, size_t count, uint32_t now)
+            {
+                this->timers_ = timers;
+                this->count_ = count < NONE ? count : NONE;
+                for (size_t i = 0; i < this->count_; i++) {
+                    this->timers_[i].bucket = NONE;
+                }
+                for (size_t i = 0; i < BUCKETS; i++) {
+                    this->buckets_[i] = NONE;
+                }
+                this->cursor_ = 0;
+                this->next_tick_ms_ = now;
+                this->armed_ = 0;
+            }
+
+            // Arm (or re-arm) handle to expire at deadline_ms
+            void schedule(uint16_t handle, uint32_t deadline_ms)
+            {
+                if (handle >= this->count_) {
+                    return;
+                }
+                this->cancel(handle);
+
+                int32_t delay = static_cast<int32_t>(deadline_ms - this->next_tick_ms_);
+                uint32_t ticks = delay <= 0 ? 0 : (static_cast<uint32_t>(delay) + TICK_MS - 1) / TICK_MS;
+                if (ticks >= BUCKETS) {
+                    ticks = BUCKETS - 1;
+                }
+                uint16_t bucket = (this->cursor_ + ticks) % BUCKETS;
+
+                Timer &timer = this->timers_[handle];
+                timer.deadline_ms = deadline_ms;
+                timer.bucket = bucket;
+                timer.prev = NONE;
+                timer.next = this->buckets_[bucket];
+                if (timer.next != NONE) {
+                    this->timers_[timer.next].prev = handle;
+                }
+                this->buckets_[bucket] = handle;
+                this->armed_++;
+            }
+
+            void cancel(uint16_t handle)
+            {
+                if (handle >= this->count_ || this->timers_[handle].bucket == NONE) {
+                    return;
+                }
+                Timer &timer = this->timers_[handle];
+                if (timer.prev != NONE) {
+                    this->timers_[timer.prev].next = timer.next;
+                } else {
+                    this->buckets_[timer.bucket] = timer.next;
+                }
+                if (timer.next != NONE) {
+                    this->timers_[timer.next].prev = timer.prev;
+                }
+                timer.bucket = NONE;
+                this->armed_--;
+            }
+
+            bool armed(uint16_t handle) const
+            {
+                return handle < this->count_ && this->timers_[handle].bucket != NONE;
+            }
+
+            // Fire expired(handle) for every timer whose deadline is at or before now.
+            // A fired timer is disarmed before the callback, which may re-arm (only) that
+            // same handle.
+            template<typename F>
+            size_t advance(uint32_t now, F &&expired)
+            {
+                size_t fired = 0;
+                while (static_cast<int32_t>(now - this->next_tick_ms_) >= 0) {
+                    // Detach the bucket so re-armed timers can land anywhere, including here
+                    uint16_t handle = this->buckets_[this->cursor_];
+                    this->buckets_[this->cursor_] = NONE;
+                    this->cursor_ = (this->cursor_ + 1) % BUCKETS;
+                    this->next_tick_ms_ += TICK_MS;
+
+                    while (handle != NONE) {
+                        Timer &timer = this->timers_[handle];
+                        uint16_t next = timer.next;
+                        timer.bucket = NONE;
+                        this->armed_--;
+
+                        if (static_cast<int32_t>(timer.deadline_ms - now) <= 0) {
+                            fired++;
+                            expired(handle);
+                        } else {
+                            this->schedule(handle, timer.deadline_ms);
+                        }
+                        handle = next;
+                    }
+                }
+                return fired;
+            }
+
+            size_t armed_count() const { return this->armed_; }
+
+        protected:
+            Timer *timers_ = nullptr;
+            size_t count_ = 0;
+            uint16_t buckets_[BUCKETS];
+            uint16_t cursor_ = 0;
+            uint32_t next_tick_ms_ = 0;
+            size_t armed_ = 0;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
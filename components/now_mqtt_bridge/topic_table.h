@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string_view>
+
+namespace esphome
+{
+    namespace now_mqtt_bridge
+    {
+        // =============================================================================
+        // Topic Table
+        // =============================================================================
+        // Append-only arena of pre-rendered MQTT topics over a caller-provided buffer.
+        // A topic is stored once, as the concatenation of its parts, and referred to
+        // by a 16-bit handle kept by its owner (an entity or device entry). Entries
+        // are 4-byte aligned and the handle counts 4-byte units, so up to 256 KB of
+        // topics are addressable:
+        //
+        //   len[2] topic[len] pad
+        //
+        // Nothing is freed; a topic whose owner changes name is simply stored again.
+        class TopicTable
+        {
+        public:
+            static constexpr uint16_t INVALID = 0xFFFF;
+            static constexpr size_t MAX_ARENA_SIZE = size_t(INVALID) * 4;
+
+            void init(char *arena, size_t arena_size)
+            {
+                this->arena_ = arena;
+                this->arena_size_ = (arena_size < MAX_ARENA_SIZE ? arena_size : MAX_ARENA_SIZE) & ~size_t(3);
+                this->used_ = 0;
+                this->count_ = 0;
+            }
+
+            // Store the concatenation of parts; INVALID if the arena is full
+            uint16_t add(std::initializer_list<std::string_view> parts)
+            {
+                size_t len = 0;
+                for (const auto &part : parts) {
+                    len += part.size();
+                }
+                size_t size = (2 + len + 3) & ~size_t(3);
+                if (len > UINT16_MAX || this->used_ + size > this->arena_size_) {
+                    return INVALID;
+                }
+
+                char *out = this->arena_ + this->used_;
+                out[0] = len & 0xFF;
+                out[1] = len >> 8;
+                out += 2;
+                for (const auto &part : parts) {
+                    memcpy(out, part.data(), part.size());
+                    out += part.size();
+                }
+
+                uint16_t handle = this->used_ / 4;
+                this->used_ += size;
+                this->count_++;
+                return handle;
+            }
+
+            // Whether handle holds exactly the concatenation of parts
+            bool matches(uint16_t handle, std::initializer_list<std::string_view> parts) const
+            {
+                std::string_view topic = this->get(handle);
+                if (topic.data() == nullptr) {
+                    return false;
+                }
+                for (const auto &part : parts) {
+                    if (topic.substr(0, part.size()) != part) {
+                        return false;
+                    }
+                    topic.remove_prefix(part.size());
+                }
+                return topic.empty();
+            }
+
+            // The stored topic, or an empty view with no data for INVALID
+            std::string_view get(uint16_t handle) const
+            {
+                size_t offset = size_t(handle) * 4;
+                if (handle == INVALID || offset + 2 > this->used_) {
+                    return {};
+                }
+                const uint8_t *in = reinterpret_cast<const uint8_t *>(this->arena_ + offset);
+                return {this->arena_ + offset + 2, size_t(in[0] | (in[1] << 8))};
+            }
+
+            size_t size() const { return this->count_; }
+            size_t used() const { return this->used_; }
+            size_t capacity() const { return this->arena_size_; }
+
+        protected:
+            char *arena_ = nullptr;
+            size_t arena_size_ = 0;
+            size_t used_ = 0;
+            size_t count_ = 0;
+        };
+
+    } // namespace now_mqtt_bridge
+} // namespace esphome
@@ -0,0 +1,7 @@
+import esphome.config_validation as cv
+
+# =============================================================================
+# Shared ESP-NOW wire format codec
+# =============================================================================
+# Auto-loaded by now_mqtt and now_mqtt_bridge; has no user configuration.
+CONFIG_SCHEMA = cv.Schema({})
@@ -0,0 +1,859 @@
+#include "codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace esphome
+{
+    namespace now_mqtt_protocol
+    {
+        // =============================================================================
+        // Float Encoding
+        // =============================================================================
+
+        static void encode_float(uint8_t *out, float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            out[0] = bits & 0xFF;
+            out[1] = (bits >> 8) & 0xFF;
+            out[2] = (bits >> 16) & 0xFF;
+            out[3] = (bits >> 24) & 0xFF;
+        }
+
+        static float decode_float(const uint8_t *in)
+        {
+            uint32_t bits = uint32_t(in[0]) | (uint32_t(in[1]) << 8) |
+                            (uint32_t(in[2]) << 16) | (uint32_t(in[3]) << 24);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        // =============================================================================
+        // Frame Writer
+        // =============================================================================
+
+        bool FrameWriter::begin(const NodeInfo &node, uint8_t flags)
+        {
+            this->pos_ = 0;
+            if (this->capacity_ < FRAME_HEADER_SIZE) {
+                return false;
+            }
+
+            this->buffer_[0] = FRAME_MAGIC;
+            this->buffer_[1] = FRAME_VERSION;
+            this->buffer_[2] = flags;
+            this->buffer_[3] = 0;  // record count
+            this->pos_ = FRAME_HEADER_SIZE;
+
+            // Sequence placeholder, stamped per frame by set_sequence()
+            static const uint8_t NO_SEQUENCE[SEQUENCE_SIZE] = {};
+            if ((flags & FLAG_SEQUENCE) && !this->put_bytes_(NO_SEQUENCE, SEQUENCE_SIZE)) {
+                return false;
+            }
+
+            if (!this->put_str_(node.name)) {
+                return false;
+            }
+
+            // Node metadata block
+            size_t meta_start = this->pos_;
+            if (!this->put_u8_(0)) {
+                return false;
+            }
+            if (!node.version.empty() && !this->put_tlv_(META_VERSION, node.version)) {
+                return false;
+            }
+            if (!node.board.empty() && !this->put_tlv_(META_BOARD, node.board)) {
+                return false;
+            }
+            if (node.report_interval_s != 0) {
+                uint8_t interval[4];
+                for (int i = 0; i < 4; i++) {
+                    interval[i] = (node.report_interval_s >> (8 * i)) & 0xFF;
+                }
+                if (!this->put_tlv_(META_INTERVAL, std::string_view(reinterpret_cast<const char *>(interval), 4))) {
+                    return false;
+                }
+            }
+            size_t meta_len = this->pos_ - meta_start - 1;
+            if (meta_len > UINT8_MAX) {
+                return false;
+            }
+            this->buffer_[meta_start] = meta_len;
+            return true;
+        }
+
+        bool FrameWriter::begin(const uint8_t *header, size_t len)
+        {
+            this->pos_ = 0;
+            if (len < FRAME_HEADER_SIZE || len > this->capacity_ || header[0] != FRAME_MAGIC) {
+                return false;
+            }
+
+            memcpy(this->buffer_, header, len);
+            this->buffer_[3] = 0;  // record count
+            this->pos_ = len;
+            return true;
+        }
+
+        bool FrameWriter::begin_compact(uint32_t node_schema, uint8_t flags)
+        {
+            this->pos_ = 0;
+            flags |= FLAG_COMPACT;
+            size_t len = FRAME_HEADER_SIZE + ((flags & FLAG_SEQUENCE) ? SEQUENCE_SIZE : 0) + 4;
+            if (this->capacity_ < len) {
+                return false;
+            }
+
+            memset(this->buffer_, 0, len);
+            this->buffer_[0] = FRAME_MAGIC;
+            this->buffer_[1] = FRAME_VERSION;
+            this->buffer_[2] = flags;
+            uint8_t *out = this->buffer_ + len - 4;
+            for (int i = 0; i < 4; i++) {
+                out[i] = (node_schema >> (8 * i)) & 0xFF;
+            }
+            this->pos_ = len;
+            return true;
+        }
+
+        bool FrameWriter::set_sequence(uint16_t boot_id, uint16_t seq)
+        {
+            if (this->pos_ < FRAME_HEADER_SIZE + SEQUENCE_SIZE || !(this->buffer_[2] & FLAG_SEQUENCE)) {
+                return false;
+            }
+            uint8_t *out = this->buffer_ + FRAME_HEADER_SIZE;
+            out[0] = boot_id & 0xFF;
+            out[1] = boot_id >> 8;
+            out[2] = seq & 0xFF;
+            out[3] = seq >> 8;
+            return true;
+        }
+
+        void FrameWriter::set_flag(uint8_t flag, bool enabled)
+        {
+            if (this->pos_ < FRAME_HEADER_SIZE) {
+                return;
+            }
+            if (enabled) {
+                this->buffer_[2] |= flag;
+            } else {
+                this->buffer_[2] &= ~flag;
+            }
+        }
+
+        bool FrameWriter::add_sensor(std::string_view name, const EntityMeta &meta, float value)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(ReadingType::SENSOR, name, meta) && this->put_float_(value);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::add_binary_sensor(std::string_view name, const EntityMeta &meta, bool value)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(ReadingType::BINARY_SENSOR, name, meta) &&
+                      this->put_u8_(value ? 1 : 0);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::add_text_sensor(std::string_view name, const EntityMeta &meta, std::string_view value)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(ReadingType::TEXT_SENSOR, name, meta) &&
+                      this->put_str_(value);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::add_sensor(const RecordPrefix &prefix, float value)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(prefix) && this->put_float_(value);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::add_binary_sensor(const RecordPrefix &prefix, bool value)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(prefix) && this->put_u8_(value ? 1 : 0);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::add_text_sensor(const RecordPrefix &prefix, std::string_view value)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(prefix) && this->put_str_(value);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::add_sensor(const RecordPrefix &prefix, float value, uint32_t age_s)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(prefix) && this->put_float_(value) && this->put_age_(record_start, age_s);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::add_binary_sensor(const RecordPrefix &prefix, bool value, uint32_t age_s)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(prefix) && this->put_u8_(value ? 1 : 0) &&
+                      this->put_age_(record_start, age_s);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::add_text_sensor(const RecordPrefix &prefix, std::string_view value, uint32_t age_s)
+        {
+            size_t record_start = this->pos_;
+            bool ok = this->begin_record_(prefix) && this->put_str_(value) && this->put_age_(record_start, age_s);
+            return this->end_record_(record_start, ok);
+        }
+
+        bool FrameWriter::begin_record_(ReadingType type, std::string_view name, const EntityMeta &meta)
+        {
+            if (this->pos_ < FRAME_HEADER_SIZE || this->buffer_[3] == UINT8_MAX) {
+                return false;
+            }
+
+            size_t len = encode_record_prefix(this->buffer_ + this->pos_, this->capacity_ - this->pos_, type, name, meta);
+            this->pos_ += len;
+            return len > 0;
+        }
+
+        bool FrameWriter::begin_record_(const RecordPrefix &prefix)
+        {
+            if (this->pos_ < FRAME_HEADER_SIZE || this->buffer_[3] == UINT8_MAX) {
+                return false;
+            }
+            return this->put_bytes_(prefix.data, prefix.len);
+        }
+
+        bool FrameWriter::end_record_(size_t record_start, bool ok)
+        {
+            if (!ok) {
+                this->pos_ = record_start;
+                return false;
+            }
+            this->buffer_[3]++;
+            return true;
+        }
+
+        bool FrameWriter::put_age_(size_t record_start, uint32_t age_s)
+        {
+            if (this->pos_ + RECORD_AGE_SIZE > this->capacity_) {
+                return false;
+            }
+            this->buffer_[record_start] |= RECORD_AGED;
+            uint8_t *out = this->buffer_ + this->pos_;
+            for (size_t i = 0; i < RECORD_AGE_SIZE; i++) {
+                out[i] = (age_s >> (8 * i)) & 0xFF;
+            }
+            this->pos_ += RECORD_AGE_SIZE;
+            return true;
+        }
+
+        bool FrameWriter::put_u8_(uint8_t value)
+        {
+            if (this->pos_ >= this->capacity_) {
+                return false;
+            }
+            this->buffer_[this->pos_++] = value;
+            return true;
+        }
+
+        bool FrameWriter::put_bytes_(const void *data, size_t len)
+        {
+            if (this->pos_ + len > this->capacity_) {
+                return false;
+            }
+            memcpy(this->buffer_ + this->pos_, data, len);
+            this->pos_ += len;
+            return true;
+        }
+
+        bool FrameWriter::put_str_(std::string_view value)
+        {
+            if (value.size() > UINT8_MAX) {
+                return false;
+            }
+            return this->put_u8_(value.size()) && this->put_bytes_(value.data(), value.size());
+        }
+
+        bool FrameWriter::put_tlv_(uint8_t tag, std::string_view value)
+        {
+            return this->put_u8_(tag) && this->put_str_(value);
+        }
+
+        bool FrameWriter::put_float_(float value)
+        {
+            if (this->pos_ + 4 > this->capacity_) {
+                return false;
+            }
+            encode_float(this->buffer_ + this->pos_, value);
+            this->pos_ += 4;
+            return true;
+        }
+
+        // =============================================================================
+        // Frame Reader
+        // =============================================================================
+
+        FrameReader::FrameReader(const uint8_t *data, size_t len) : data_(data), len_(len)
+        {
+            if (!is_binary_frame(data, len) || len < FRAME_HEADER_SIZE || data[1] != FRAME_VERSION ||
+                (data[2] & (FLAG_CONTROL | FLAG_FRAGMENT))) {
+                return;
+            }
+
+            this->flags_ = data[2];
+            this->count_ = data[3];
+            this->pos_ = FRAME_HEADER_SIZE;
+
+            if (this->flags_ & FLAG_SEQUENCE) {
+                if (!peek_sequence(data, len, &this->boot_id_, &this->seq_)) {
+                    return;
+                }
+                this->pos_ += SEQUENCE_SIZE;
+            }
+
+            if (this->flags_ & FLAG_COMPACT) {
+                if (this->pos_ + 4 > len) {
+                    return;
+                }
+                const uint8_t *p = data + this->pos_;
+                this->node_schema_ = p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+                this->pos_ += 4;
+                this->valid_ = true;
+                return;
+            }
+
+            size_t block_len = decode_node_block(data + this->pos_, len - this->pos_, &this->node_);
+            if (block_len == 0) {
+                return;
+            }
+            this->node_block_ = {data + this->pos_, block_len};
+            this->pos_ += block_len;
+            this->valid_ = true;
+        }
+
+        bool FrameReader::next(Reading *reading)
+        {
+            if (!this->valid_ || this->error_ || this->read_ >= this->count_) {
+                return false;
+            }
+            // Compact records need the caller's schema lookup
+            if (this->compact()) {
+                return this->fail_();
+            }
+
+            // The prefix is everything up to the value: type, name, metadata block
+            size_t start = this->pos_;
+            uint8_t type;
+            std::string_view name;
+            const uint8_t *meta;
+            size_t meta_len;
+            if (!this->read_u8_(&type) || !this->read_str_(&name) || !this->read_block_(&meta, &meta_len)) {
+                return this->fail_();
+            }
+            RecordPrefix prefix = {this->data_ + start, this->pos_ - start};
+            return this->read_record_(reading, prefix, type & RECORD_AGED);
+        }
+
+        bool FrameReader::read_schema_ref_(uint32_t *schema, bool *aged)
+        {
+            if (!this->valid_ || this->error_ || this->read_ >= this->count_) {
+                return false;
+            }
+            if (this->pos_ + SCHEMA_REF_SIZE > this->len_) {
+                return this->fail_();
+            }
+            const uint8_t *p = this->data_ + this->pos_;
+            uint32_t ref = (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+            *aged = ref & 0x80000000;
+            *schema = ref & 0x7FFFFFFF;
+            this->pos_ += SCHEMA_REF_SIZE;
+            return true;
+        }
+
+        bool FrameReader::read_record_(Reading *reading, const RecordPrefix &prefix, bool aged)
+        {
+            // Type, name and entity TLVs come from the prefix (in the frame, or cached)
+            if (!decode_record_prefix(prefix.data, prefix.len, reading)) {
+                return this->fail_();
+            }
+            reading->prefix = prefix;
+
+            switch (reading->type) {
+                case ReadingType::SENSOR:
+                    if (this->pos_ + 4 > this->len_) {
+                        return this->fail_();
+                    }
+                    reading->value = decode_float(this->data_ + this->pos_);
+                    this->pos_ += 4;
+                    break;
+                case ReadingType::BINARY_SENSOR: {
+                    uint8_t value;
+                    if (!this->read_u8_(&value)) {
+                        return this->fail_();
+                    }
+                    reading->binary_value = value != 0;
+                    break;
+                }
+                case ReadingType::TEXT_SENSOR:
+                    if (!this->read_str_(&reading->text)) {
+                        return this->fail_();
+                    }
+                    break;
+            }
+
+            if (aged) {
+                if (this->pos_ + RECORD_AGE_SIZE > this->len_) {
+                    return this->fail_();
+                }
+                const uint8_t *p = this->data_ + this->pos_;
+                reading->age_s = p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+                reading->aged = true;
+                this->pos_ += RECORD_AGE_SIZE;
+            }
+
+            this->read_++;
+            return true;
+        }
+
+        bool FrameReader::read_u8_(uint8_t *value)
+        {
+            if (this->pos_ >= this->len_) {
+                return false;
+            }
+            *value = this->data_[this->pos_++];
+            return true;
+        }
+
+        bool FrameReader::read_str_(std::string_view *value)
+        {
+            uint8_t len;
+            if (!this->read_u8_(&len) || this->pos_ + len > this->len_) {
+                return false;
+            }
+            *value = std::string_view(reinterpret_cast<const char *>(this->data_ + this->pos_), len);
+            this->pos_ += len;
+            return true;
+        }
+
+        bool FrameReader::read_block_(const uint8_t **block, size_t *block_len)
+        {
+            uint8_t len;
+            if (!this->read_u8_(&len) || this->pos_ + len > this->len_) {
+                return false;
+            }
+            *block = this->data_ + this->pos_;
+            *block_len = len;
+            this->pos_ += len;
+            return true;
+        }
+
+        bool FrameReader::fail_()
+        {
+            this->error_ = true;
+            return false;
+        }
+
+        // =============================================================================
+        // Helpers
+        // =============================================================================
+
+        size_t encode_record_prefix(uint8_t *buffer, size_t capacity, ReadingType type,
+                                    std::string_view name, const EntityMeta &meta)
+        {
+            // Bounds-checked cursor over the caller's buffer
+            size_t pos = 0;
+            auto put_u8 = [&](uint8_t value) {
+                if (pos >= capacity) {
+                    return false;
+                }
+                buffer[pos++] = value;
+                return true;
+            };
+            auto put_str = [&](std::string_view value) {
+                if (value.size() > UINT8_MAX || pos + 1 + value.size() > capacity) {
+                    return false;
+                }
+                buffer[pos++] = value.size();
+                memcpy(buffer + pos, value.data(), value.size());
+                pos += value.size();
+                return true;
+            };
+            auto put_tlv = [&](uint8_t tag, std::string_view value) {
+                return value.empty() || (put_u8(tag) && put_str(value));
+            };
+
+            if (!put_u8(static_cast<uint8_t>(type)) || !put_str(name)) {
+                return 0;
+            }
+
+            size_t meta_start = pos;
+            if (!put_u8(0) ||
+                !put_tlv(META_DEVICE_CLASS, meta.device_class) ||
+                !put_tlv(META_STATE_CLASS, meta.state_class) ||
+                !put_tlv(META_UNIT, meta.unit) ||
+                !put_tlv(META_ICON, meta.icon)) {
+                return 0;
+            }
+            if (meta.has_accuracy) {
+                char accuracy = static_cast<char>(meta.accuracy);
+                if (!put_tlv(META_ACCURACY, std::string_view(&accuracy, 1))) {
+                    return 0;
+                }
+            }
+
+            size_t meta_len = pos - meta_start - 1;
+            if (meta_len > UINT8_MAX) {
+                return 0;
+            }
+            buffer[meta_start] = meta_len;
+            return pos;
+        }
+
+        bool decode_record_prefix(const uint8_t *data, size_t len, Reading *reading)
+        {
+            *reading = Reading{};
+            if (len < 3) {
+                return false;
+            }
+            uint8_t type = data[0] & ~RECORD_AGED;
+            if (type < static_cast<uint8_t>(ReadingType::SENSOR) || type > static_cast<uint8_t>(ReadingType::TEXT_SENSOR)) {
+                // Unknown type: the value width is unknown too, so nothing after it can be trusted
+                return false;
+            }
+            reading->type = static_cast<ReadingType>(type);
+
+            size_t name_len = data[1];
+            if (2 + name_len + 1 > len) {
+                return false;
+            }
+            reading->name = std::string_view(reinterpret_cast<const char *>(data + 2), name_len);
+            const uint8_t *meta = data + 2 + name_len + 1;
+            size_t meta_len = data[2 + name_len];
+            if (3 + name_len + meta_len != len) {
+                return false;
+            }
+
+            // Entity TLVs
+            size_t i = 0;
+            while (i + 2 <= meta_len) {
+                uint8_t tag = meta[i];
+                uint8_t tlv_len = meta[i + 1];
+                if (i + 2 + tlv_len > meta_len) {
+                    return false;
+                }
+                std::string_view value(reinterpret_cast<const char *>(meta + i + 2), tlv_len);
+                switch (tag) {
+                    case META_DEVICE_CLASS: reading->meta.device_class = value; break;
+                    case META_STATE_CLASS: reading->meta.state_class = value; break;
+                    case META_UNIT: reading->meta.unit = value; break;
+                    case META_ICON: reading->meta.icon = value; break;
+                    case META_ACCURACY:
+                        if (tlv_len == 1) {
+                            reading->meta.accuracy = static_cast<int8_t>(meta[i + 2]);
+                            reading->meta.has_accuracy = true;
+                        }
+                        break;
+                    default: break;
+                }
+                i += 2 + tlv_len;
+            }
+            return true;
+        }
+
+        size_t decode_node_block(const uint8_t *data, size_t len, NodeInfo *node)
+        {
+            *node = NodeInfo{};
+            if (len < 2 || size_t(data[0]) + 2 > len) {
+                return 0;
+            }
+            size_t name_len = data[0];
+            node->name = std::string_view(reinterpret_cast<const char *>(data + 1), name_len);
+            const uint8_t *meta = data + 1 + name_len + 1;
+            size_t meta_len = data[1 + name_len];
+            size_t block_len = 1 + name_len + 1 + meta_len;
+            if (block_len > len) {
+                return 0;
+            }
+
+            // Node TLVs
+            size_t i = 0;
+            while (i + 2 <= meta_len) {
+                uint8_t tag = meta[i];
+                uint8_t tlv_len = meta[i + 1];
+                if (i + 2 + tlv_len > meta_len) {
+                    return 0;
+                }
+                std::string_view value(reinterpret_cast<const char *>(meta + i + 2), tlv_len);
+                if (tag == META_VERSION) {
+                    node->version = value;
+                } else if (tag == META_BOARD) {
+                    node->board = value;
+                } else if (tag == META_INTERVAL && tlv_len == 4) {
+                    const uint8_t *p = meta + i + 2;
+                    node->report_interval_s = p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+                }
+                i += 2 + tlv_len;
+            }
+            return block_len;
+        }
+
+        uint32_t schema_id(const uint8_t *data, size_t len)
+        {
+            // FNV-1a, 32 bit
+            uint32_t hash = 2166136261UL;
+            for (size_t i = 0; i < len; i++) {
+                hash ^= i == 0 ? (data[i] & ~RECORD_AGED) : data[i];
+                hash *= 16777619UL;
+            }
+            hash &= 0x7FFFFFFF;
+            return hash != 0 ? hash : 1;
+        }
+
+        size_t encode_schema_ref(uint8_t *buffer, size_t capacity, uint32_t schema)
+        {
+            if (capacity < SCHEMA_REF_SIZE) {
+                return 0;
+            }
+            schema &= 0x7FFFFFFF;
+            buffer[0] = schema >> 24;
+            buffer[1] = (schema >> 16) & 0xFF;
+            buffer[2] = (schema >> 8) & 0xFF;
+            buffer[3] = schema & 0xFF;
+            return SCHEMA_REF_SIZE;
+        }
+
+        bool is_binary_frame(const uint8_t *data, size_t len)
+        {
+            return len > 0 && data[0] == FRAME_MAGIC;
+        }
+
+        uint8_t frame_flags(const uint8_t *data, size_t len)
+        {
+            if (len < FRAME_HEADER_SIZE || data[0] != FRAME_MAGIC || data[1] != FRAME_VERSION) {
+                return 0;
+            }
+            return data[2];
+        }
+
+        size_t encode_pair_ack(uint8_t *buffer, size_t capacity, const uint8_t *node_mac, uint8_t channel)
+        {
+            if (capacity < PAIR_ACK_SIZE) {
+                return 0;
+            }
+            buffer[0] = FRAME_MAGIC;
+            buffer[1] = FRAME_VERSION;
+            buffer[2] = FLAG_CONTROL;
+            buffer[3] = static_cast<uint8_t>(ControlType::PAIR_ACK);
+            memcpy(buffer + FRAME_HEADER_SIZE, node_mac, 6);
+            buffer[FRAME_HEADER_SIZE + 6] = channel;
+            return PAIR_ACK_SIZE;
+        }
+
+        bool decode_pair_ack(const uint8_t *data, size_t len, uint8_t *node_mac, uint8_t *channel)
+        {
+            if (len < PAIR_ACK_SIZE || !(frame_flags(data, len) & FLAG_CONTROL) ||
+                data[3] != static_cast<uint8_t>(ControlType::PAIR_ACK)) {
+                return false;
+            }
+            memcpy(node_mac, data + FRAME_HEADER_SIZE, 6);
+            *channel = data[FRAME_HEADER_SIZE + 6];
+            return true;
+        }
+
+        size_t encode_probe(uint8_t *buffer, size_t capacity)
+        {
+            if (capacity < PROBE_SIZE) {
+                return 0;
+            }
+            buffer[0] = FRAME_MAGIC;
+            buffer[1] = FRAME_VERSION;
+            buffer[2] = FLAG_CONTROL;
+            buffer[3] = static_cast<uint8_t>(ControlType::PROBE);
+            return PROBE_SIZE;
+        }
+
+        bool is_probe(const uint8_t *data, size_t len)
+        {
+            return (frame_flags(data, len) & FLAG_CONTROL) && data[3] == static_cast<uint8_t>(ControlType::PROBE);
+        }
+
+        size_t encode_schema_request(uint8_t *buffer, size_t capacity, const uint8_t *node_mac)
+        {
+            if (capacity < SCHEMA_REQUEST_SIZE) {
+                return 0;
+            }
+            buffer[0] = FRAME_MAGIC;
+            buffer[1] = FRAME_VERSION;
+            buffer[2] = FLAG_CONTROL;
+            buffer[3] = static_cast<uint8_t>(ControlType::SCHEMA_REQUEST);
+            memcpy(buffer + FRAME_HEADER_SIZE, node_mac, 6);
+            return SCHEMA_REQUEST_SIZE;
+        }
+
+        bool decode_schema_request(const uint8_t *data, size_t len, uint8_t *node_mac)
+        {
+            if (len < SCHEMA_REQUEST_SIZE || !(frame_flags(data, len) & FLAG_CONTROL) ||
+                data[3] != static_cast<uint8_t>(ControlType::SCHEMA_REQUEST)) {
+                return false;
+            }
+            memcpy(node_mac, data + FRAME_HEADER_SIZE, 6);
+            return true;
+        }
+
+        size_t fragment_count(size_t len)
+        {
+            if (len <= MAX_FRAME_SIZE) {
+                return 1;
+            }
+            return (len + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE;
+        }
+
+        size_t encode_fragment(uint8_t *buffer, size_t capacity, uint16_t message_id, const uint8_t *message,
+                               size_t len, uint8_t index)
+        {
+            size_t total = fragment_count(len);
+            size_t offset = size_t(index) * FRAGMENT_PAYLOAD_SIZE;
+            if (len > MAX_MESSAGE_SIZE || index >= total || offset >= len) {
+                return 0;
+            }
+            size_t payload = std::min(FRAGMENT_PAYLOAD_SIZE, len - offset);
+            if (capacity < FRAGMENT_HEADER_SIZE + payload) {
+                return 0;
+            }
+            buffer[0] = FRAME_MAGIC;
+            buffer[1] = FRAME_VERSION;
+            buffer[2] = FLAG_FRAGMENT;
+            buffer[3] = index;
+            buffer[4] = message_id & 0xFF;
+            buffer[5] = message_id >> 8;
+            buffer[6] = total;
+            memcpy(buffer + FRAGMENT_HEADER_SIZE, message + offset, payload);
+            return FRAGMENT_HEADER_SIZE + payload;
+        }
+
+        bool decode_fragment(const uint8_t *data, size_t len, Fragment *fragment)
+        {
+            if (len <= FRAGMENT_HEADER_SIZE || !(frame_flags(data, len) & FLAG_FRAGMENT)) {
+                return false;
+            }
+            fragment->index = data[3];
+            fragment->message_id = data[4] | (data[5] << 8);
+            fragment->total = data[6];
+            fragment->payload = data + FRAGMENT_HEADER_SIZE;
+            fragment->len = len - FRAGMENT_HEADER_SIZE;
+
+            // Every fragment but the last is full, so each one knows its offset
+            if (fragment->total < 2 || fragment->total > MAX_FRAGMENTS || fragment->index >= fragment->total) {
+                return false;
+            }
+            bool last = fragment->index + 1 == fragment->total;
+            return last ? (fragment->len <= FRAGMENT_PAYLOAD_SIZE &&
+                           fragment->index * FRAGMENT_PAYLOAD_SIZE + fragment->len <= MAX_MESSAGE_SIZE)
+                        : fragment->len == FRAGMENT_PAYLOAD_SIZE;
+        }
+
+        bool peek_sequence(const uint8_t *data, size_t len, uint16_t *boot_id, uint16_t *seq)
+        {
+            if (len < FRAME_HEADER_SIZE + SEQUENCE_SIZE || data[0] != FRAME_MAGIC || data[1] != FRAME_VERSION ||
+                !(data[2] & FLAG_SEQUENCE)) {
+                return false;
+            }
+            const uint8_t *in = data + FRAME_HEADER_SIZE;
+            *boot_id = in[0] | (in[1] << 8);
+            *seq = in[2] | (in[3] << 8);
+            return true;
+        }
+
+        size_t split_fields(char *data, size_t len, char delimiter, std::string_view *fields, size_t max_fields)
+        {
+            // Bytes only move once an escape has been removed (out trails in)
+            size_t count = 0;
+            size_t out = 0;
+            size_t field_start = 0;
+            for (size_t in = 0; in < len; in++) {
+                char c = data[in];
+                if (c == delimiter) {
+                    if (count == max_fields) {
+                        return max_fields + 1;
+                    }
+                    fields[count++] = std::string_view(data + field_start, out - field_start);
+                    field_start = out + 1;
+                } else if (c == TEXT_FIELD_ESCAPE) {
+                    if (in + 1 < len && (data[in + 1] == delimiter || data[in + 1] == TEXT_FIELD_ESCAPE)) {
+                        c = data[++in];
+                    }
+                } else if (c == '\0') {
+                    break;
+                }
+                data[out++] = c;
+            }
+
+            if (count == max_fields) {
+                return max_fields + 1;
+            }
+            fields[count++] = std::string_view(data + field_start, out - field_start);
+            return count;
+        }
+
+        bool parse_text_frame(char *data, size_t len, NodeInfo *node, Reading *reading, std::string_view *state)
+        {
+            std::string_view fields[TEXT_FIELD_COUNT];
+            if (split_fields(data, len, TEXT_FIELD_DELIMITER, fields, TEXT_FIELD_COUNT) != TEXT_FIELD_COUNT) {
+                return false;
+            }
+
+            *node = NodeInfo();
+            node->name = fields[0];
+            node->version = fields[8];
+            node->board = fields[9];
+
+            *reading = Reading();
+            reading->name = fields[3];
+            reading->meta.device_class = fields[1];
+            reading->meta.unit = fields[4];
+
+            // Field 2 carries the state class, or "binary_sensor" for binary sensors
+            if (fields[2] == "binary_sensor") {
+                reading->type = ReadingType::BINARY_SENSOR;
+            } else {
+                reading->meta.state_class = fields[2];
+            }
+
+            // Icon prefix and name are separated by one delimiter in data, so one view
+            // spans both. A sender that escapes the icon's ':' sends it whole in field 6.
+            if (!fields[6].empty() && !fields[7].empty()) {
+                reading->meta.icon = std::string_view(fields[6].data(), fields[6].size() + 1 + fields[7].size());
+            } else if (fields[7].empty()) {
+                reading->meta.icon = fields[6];
+            }
+
+            *state = fields[5];
+            return true;
+        }
+
+        size_t format_value(char *buffer, size_t size, float value, int8_t accuracy)
+        {
+            if (accuracy < 0) {
+                float divisor = powf(10.0f, -accuracy);
+                value = roundf(value / divisor) * divisor;
+                accuracy = 0;
+            }
+
+            int len = snprintf(buffer, size, "%.*f", accuracy, value);
+            if (len < 0) {
+                buffer[0] = '\0';
+                return 0;
+            }
+            return std::min(static_cast<size_t>(len), size - 1);
+        }
+
+    } // namespace now_mqtt_protocol
+} // namespace esphome
@@ -0,0 +1,371 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Plain C++ codec for the ESP-NOW wire format shared by now_mqtt (sender)
+// and now_mqtt_bridge (receiver). No ESPHome or ESP-IDF dependencies.
+//
+// Frame (v2):
+//
+//   magic version flags count                 4-byte header
+//   boot_id seq                               uint16 LE each, only with FLAG_SEQUENCE
+//   node_len node[node_len]                   node (app) name
+//   meta_len meta[meta_len]                   node TLVs (version, board, interval)
+//   record[count]
+//
+// Record:
+//
+//   type name_len name[name_len]              type tag + entity name
+//   meta_len meta[meta_len]                   entity TLVs (device class, unit, ...)
+//   value                                     SENSOR: float32 LE
+//                                             BINARY_SENSOR: uint8 (0/1)
+//                                             TEXT_SENSOR: len + bytes
+//   age                                       uint32 LE seconds, only if RECORD_AGED
+//                                             is set in type (buffered reading)
+//
+// TLV: tag len value[len]. Unknown tags are skipped by the reader.
+//
+// Compact frames (FLAG_COMPACT) refer to metadata the bridge has already seen
+// by schema ID, a 31-bit hash of the encoded node block or record prefix:
+//
+//   magic version flags count [boot_id seq]
+//   node_schema                               uint32 LE, replaces node block
+//   record[count]:
+//     schema                                  uint32 BE; bit 31 is RECORD_AGED, so
+//                                             it sits where a full record's type does
+//     value [age]                             as above, typed by the cached prefix
+//
+// Fragments (FLAG_FRAGMENT) carry one piece of a message that does not fit a
+// single ESP-NOW payload; the message is itself a v2 frame of up to
+// MAX_MESSAGE_SIZE bytes. The count byte holds the fragment index:
+//
+//   magic version flags index
+//   message_id                                uint16 LE, per sender
+//   total                                     fragment count
+//   payload                                   FRAGMENT_PAYLOAD_SIZE bytes, the last
+//                                             fragment may be shorter
+//
+// Control frames (FLAG_CONTROL) carry no node block or records: the count byte
+// holds the ControlType and the payload follows the header.
+//
+//   PAIR_ACK: node_mac[6] channel            bridge -> node, broadcast
+//   PROBE:    (no payload)                   node -> any bridge during a channel sweep
+//   SCHEMA_REQUEST: node_mac[6]              bridge -> node, broadcast: a compact frame
+//                                            used a schema the bridge does not know
+//
+// v1 frames are the legacy colon-delimited ASCII lines. They always start with
+// a printable character, so the magic byte is enough to tell them apart:
+//
+//   node:device_class:state_class:name:unit:state:icon_prefix:icon:version:board:reserved
+//
+// state_class is "binary_sensor" for binary sensors. The icon ("mdi:thermometer")
+// contains the delimiter, hence the two icon fields. A field may escape the
+// delimiter as "\:" (and a backslash as "\\"); the escape is removed on parsing.
+
+namespace esphome
+{
+    namespace now_mqtt_protocol
+    {
+        // =============================================================================
+        // Constants
+        // =============================================================================
+        static constexpr uint8_t FRAME_MAGIC = 0xA5;
+        static constexpr uint8_t FRAME_VERSION = 2;
+        static constexpr size_t FRAME_HEADER_SIZE = 4;
+        static constexpr size_t SEQUENCE_SIZE = 4;
+
+        // Header flags
+        static constexpr uint8_t FLAG_SEQUENCE = 0x01;      // boot id + sequence number follow the header
+        static constexpr uint8_t FLAG_CONTROL = 0x02;       // control frame, see ControlType
+        static constexpr uint8_t FLAG_PAIR_REQUEST = 0x04;  // unpaired sender asks the bridge for its MAC
+        static constexpr uint8_t FLAG_COMPACT = 0x08;       // node block and prefixes replaced by schema IDs
+        static constexpr uint8_t FLAG_FRAGMENT = 0x10;      // one piece of a larger message
+
+        enum class ControlType : uint8_t {
+            PAIR_ACK = 1,
+            PROBE = 2,
+            SCHEMA_REQUEST = 3,
+        };
+
+        static constexpr size_t PAIR_ACK_SIZE = FRAME_HEADER_SIZE + 7;
+        static constexpr size_t PROBE_SIZE = FRAME_HEADER_SIZE;
+        static constexpr size_t SCHEMA_REQUEST_SIZE = FRAME_HEADER_SIZE + 6;
+        static constexpr size_t SCHEMA_REF_SIZE = 4;
+        static constexpr size_t MAX_SCHEMA_SIZE = 128;  // Longer node blocks / prefixes always go out in full
+        static constexpr size_t MAX_FRAME_SIZE = 250;  // ESP-NOW payload limit
+        static constexpr size_t FRAGMENT_HEADER_SIZE = FRAME_HEADER_SIZE + 3;
+        static constexpr size_t FRAGMENT_PAYLOAD_SIZE = MAX_FRAME_SIZE - FRAGMENT_HEADER_SIZE;
+        static constexpr size_t MAX_MESSAGE_SIZE = 1024;  // Largest fragmented message
+        static constexpr size_t MAX_FRAGMENTS = (MAX_MESSAGE_SIZE + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE;
+        static constexpr char TEXT_FIELD_DELIMITER = ':';
+        static constexpr char TEXT_FIELD_ESCAPE = '\\';
+        static constexpr size_t TEXT_FIELD_COUNT = 11;
+
+        enum class ReadingType : uint8_t {
+            SENSOR = 1,
+            BINARY_SENSOR = 2,
+            TEXT_SENSOR = 3,
+        };
+
+        // Record type bit: the reading was taken age seconds before the frame was sent
+        static constexpr uint8_t RECORD_AGED = 0x80;
+        static constexpr size_t RECORD_AGE_SIZE = 4;
+
+        enum MetaTag : uint8_t {
+            META_DEVICE_CLASS = 1,
+            META_STATE_CLASS = 2,
+            META_UNIT = 3,
+            META_ICON = 4,
+            META_ACCURACY = 5,
+            META_VERSION = 6,
+            META_BOARD = 7,
+            META_INTERVAL = 8,  // node reporting interval, uint32 LE seconds
+        };
+
+        // =============================================================================
+        // Decoded Types
+        // =============================================================================
+        // All string views point into the caller's buffer.
+        struct NodeInfo {
+            std::string_view name;
+            std::string_view version;
+            std::string_view board;
+            uint32_t report_interval_s = 0;  // 0 = not advertised
+        };
+
+        struct EntityMeta {
+            std::string_view device_class;
+            std::string_view state_class;
+            std::string_view unit;
+            std::string_view icon;
+            int8_t accuracy = 0;
+            bool has_accuracy = false;
+        };
+
+        // Pre-encoded record prefix: type, name and metadata block, everything but the value
+        struct RecordPrefix {
+            const uint8_t *data;
+            size_t len;
+        };
+
+        struct Reading {
+            ReadingType type = ReadingType::SENSOR;
+            std::string_view name;
+            EntityMeta meta;
+            float value = 0.0f;
+            bool binary_value = false;
+            std::string_view text;
+            uint32_t age_s = 0;
+            bool aged = false;
+            RecordPrefix prefix = {nullptr, 0};  // The encoded prefix the reading was decoded from
+        };
+
+        struct Fragment {
+            uint16_t message_id;
+            uint8_t index;
+            uint8_t total;
+            const uint8_t *payload;
+            size_t len;
+        };
+
+        // =============================================================================
+        // Frame Writer
+        // =============================================================================
+        // Encodes into a caller-provided buffer. A record that does not fit is rolled
+        // back and the add_* call returns false; the frame stays valid.
+        class FrameWriter
+        {
+        public:
+            FrameWriter(uint8_t *buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+            bool begin(const NodeInfo &node, uint8_t flags = 0);
+            // Compact frame header referring to the node block by schema ID
+            bool begin_compact(uint32_t node_schema, uint8_t flags = 0);
+            // Start from a header previously produced by begin(NodeInfo) (record count is reset)
+            bool begin(const uint8_t *header, size_t len);
+
+            // Stamp the frame's boot id and sequence number (FLAG_SEQUENCE frames only)
+            bool set_sequence(uint16_t boot_id, uint16_t seq);
+            // Set or clear a header flag on the frame being built
+            void set_flag(uint8_t flag, bool enabled);
+
+            bool add_sensor(std::string_view name, const EntityMeta &meta, float value);
+            bool add_binary_sensor(std::string_view name, const EntityMeta &meta, bool value);
+            bool add_text_sensor(std::string_view name, const EntityMeta &meta, std::string_view value);
+
+            // Hot-path variants: copy a prefix from encode_record_prefix() (or, in a compact
+            // frame, a reference from encode_schema_ref()) and append the value
+            bool add_sensor(const RecordPrefix &prefix, float value);
+            bool add_binary_sensor(const RecordPrefix &prefix, bool value);
+            bool add_text_sensor(const RecordPrefix &prefix, std::string_view value);
+
+            // Buffered readings: as above, marked RECORD_AGED with the reading's age
+            bool add_sensor(const RecordPrefix &prefix, float value, uint32_t age_s);
+            bool add_binary_sensor(const RecordPrefix &prefix, bool value, uint32_t age_s);
+            bool add_text_sensor(const RecordPrefix &prefix, std::string_view value, uint32_t age_s);
+
+            const uint8_t *data() const { return this->buffer_; }
+            size_t size() const { return this->pos_; }
+            uint8_t count() const { return this->pos_ >= FRAME_HEADER_SIZE ? this->buffer_[3] : 0; }
+
+        protected:
+            bool begin_record_(ReadingType type, std::string_view name, const EntityMeta &meta);
+            bool begin_record_(const RecordPrefix &prefix);
+            bool put_age_(size_t record_start, uint32_t age_s);
+            bool put_float_(float value);
+            bool end_record_(size_t record_start, bool ok);
+            bool put_u8_(uint8_t value);
+            bool put_bytes_(const void *data, size_t len);
+            bool put_str_(std::string_view value);
+            bool put_tlv_(uint8_t tag, std::string_view value);
+
+            uint8_t *buffer_;
+            size_t capacity_;
+            size_t pos_ = 0;
+        };
+
+        // =============================================================================
+        // Frame Reader
+        // =============================================================================
+        class FrameReader
+        {
+        public:
+            FrameReader(const uint8_t *data, size_t len);
+
+            // Header and node block parsed successfully
+            bool valid() const { return this->valid_; }
+            // A record failed to decode (truncated or inconsistent)
+            bool error() const { return this->error_; }
+
+            // Empty for compact frames until resolved by the caller
+            const NodeInfo &node() const { return this->node_; }
+            // Encoded node block (full frames), for schema_id()
+            RecordPrefix node_block() const { return this->node_block_; }
+            bool compact() const { return this->flags_ & FLAG_COMPACT; }
+            uint32_t node_schema() const { return this->node_schema_; }
+            // Schema ID that stopped decoding of a compact frame, 0 if none
+            uint32_t missing_schema() const { return this->missing_schema_; }
+            uint8_t flags() const { return this->flags_; }
+            uint8_t count() const { return this->count_; }
+            bool has_sequence() const { return this->flags_ & FLAG_SEQUENCE; }
+            uint16_t boot_id() const { return this->boot_id_; }
+            uint16_t sequence() const { return this->seq_; }
+
+            // Decode the next record; false once all records are read or on error
+            bool next(Reading *reading);
+
+            // Same, resolving compact records through lookup(schema_id, RecordPrefix *) -> bool.
+            // An unknown schema ends decoding: the value's width is not known.
+            template<typename Lookup>
+            bool next(Reading *reading, Lookup &&lookup)
+            {
+                if (!this->compact()) {
+                    return this->next(reading);
+                }
+                uint32_t schema;
+                bool aged;
+                if (!this->read_schema_ref_(&schema, &aged)) {
+                    return false;
+                }
+                RecordPrefix prefix;
+                if (!lookup(schema, &prefix)) {
+                    this->missing_schema_ = schema;
+                    return this->fail_();
+                }
+                return this->read_record_(reading, prefix, aged);
+            }
+
+        protected:
+            bool read_schema_ref_(uint32_t *schema, bool *aged);
+            bool read_record_(Reading *reading, const RecordPrefix &prefix, bool aged);
+            bool read_u8_(uint8_t *value);
+            bool read_str_(std::string_view *value);
+            bool read_block_(const uint8_t **block, size_t *block_len);
+            bool fail_();
+
+            const uint8_t *data_;
+            size_t len_;
+            size_t pos_ = 0;
+            uint8_t flags_ = 0;
+            uint8_t count_ = 0;
+            uint8_t read_ = 0;
+            uint16_t boot_id_ = 0;
+            uint16_t seq_ = 0;
+            bool valid_ = false;
+            bool error_ = false;
+            NodeInfo node_;
+            RecordPrefix node_block_ = {nullptr, 0};
+            uint32_t node_schema_ = 0;
+            uint32_t missing_schema_ = 0;
+        };
+
+        // =============================================================================
+        // Helpers
+        // =============================================================================
+        // Encode a record's type, name and metadata block. Returns bytes written, 0 if it
+        // does not fit in capacity.
+        size_t encode_record_prefix(uint8_t *buffer, size_t capacity, ReadingType type,
+                                    std::string_view name, const EntityMeta &meta);
+
+        // Decode a record prefix into reading's type, name and metadata (the value is
+        // left unset). False if malformed or of an unknown type.
+        bool decode_record_prefix(const uint8_t *data, size_t len, Reading *reading);
+
+        // Decode a node block (name + node TLVs). Returns bytes consumed, 0 if malformed.
+        size_t decode_node_block(const uint8_t *data, size_t len, NodeInfo *node);
+
+        // Schema ID of an encoded node block or record prefix: never 0, top bit clear.
+        // Bit 7 of the first byte is ignored, so an aged record hashes like a fresh one.
+        uint32_t schema_id(const uint8_t *data, size_t len);
+        // Reference to a schema in a compact record. Returns SCHEMA_REF_SIZE, 0 if it does not fit.
+        size_t encode_schema_ref(uint8_t *buffer, size_t capacity, uint32_t schema);
+
+        // True if the payload carries the v2 magic (anything else is treated as v1 text)
+        bool is_binary_frame(const uint8_t *data, size_t len);
+
+        // Header flags of a v2 frame (0 for anything else)
+        uint8_t frame_flags(const uint8_t *data, size_t len);
+
+        // PAIR_ACK control frame: tells node_mac which bridge answered and on which channel.
+        // encode returns bytes written (PAIR_ACK_SIZE), 0 if capacity is too small.
+        size_t encode_pair_ack(uint8_t *buffer, size_t capacity, const uint8_t *node_mac, uint8_t channel);
+        bool decode_pair_ack(const uint8_t *data, size_t len, uint8_t *node_mac, uint8_t *channel);
+
+        // PROBE control frame, answered by any bridge on the channel with a PAIR_ACK
+        size_t encode_probe(uint8_t *buffer, size_t capacity);
+        bool is_probe(const uint8_t *data, size_t len);
+
+        // SCHEMA_REQUEST control frame: node_mac should resend its full metadata
+        size_t encode_schema_request(uint8_t *buffer, size_t capacity, const uint8_t *node_mac);
+        bool decode_schema_request(const uint8_t *data, size_t len, uint8_t *node_mac);
+
+        // Fragments needed for a message of len bytes (1 if it fits a single frame)
+        size_t fragment_count(size_t len);
+        // Fragment index of message into buffer. Returns bytes written, 0 if it does not fit.
+        size_t encode_fragment(uint8_t *buffer, size_t capacity, uint16_t message_id, const uint8_t *message,
+                               size_t len, uint8_t index);
+        // Validates the header and the payload length for its position in the message
+        bool decode_fragment(const uint8_t *data, size_t len, Fragment *fragment);
+
+        // Read boot id and sequence number straight from the header, without decoding
+        // the frame. False for v1 frames and v2 frames without FLAG_SEQUENCE.
+        bool peek_sequence(const uint8_t *data, size_t len, uint16_t *boot_id, uint16_t *seq);
+
+        // Split data into views at unescaped delimiters in one pass, stopping at len or
+        // a NUL. Escapes are removed in place, so data must be writable; fields without
+        // one are not moved. Returns the field count, or max_fields + 1 as soon as
+        // there are more fields than that (the rest is not scanned).
+        size_t split_fields(char *data, size_t len, char delimiter, std::string_view *fields, size_t max_fields);
+
+        // Parse a v1 text line in place. The decoded views (and state) point into data.
+        // False if the field count is wrong.
+        bool parse_text_frame(char *data, size_t len, NodeInfo *node, Reading *reading, std::string_view *state);
+
+        // Format a sensor value the same way ESPHome's value_accuracy_to_string does.
+        // Returns the number of characters written (excluding the terminator).
+        size_t format_value(char *buffer, size_t size, float value, int8_t accuracy);
+
+    } // namespace now_mqtt_protocol
+} // namespace esphome
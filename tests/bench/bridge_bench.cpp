@@ -0,0 +1,141 @@
+#include <benchmark/benchmark.h>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt_bridge/now_mqtt_bridge.h"
+
+using namespace esphome;
+using esphome::now_mqtt_bridge::Now_MQTT_BridgeComponent;
+
+// Frames go in through the ESP-NOW receive callback and out of loop() as
+// publishes, as on the chip: ingest ring, decoding, discovery, state topics.
+
+namespace
+{
+    std::unique_ptr<Now_MQTT_BridgeComponent> start_bridge(bool device_discovery)
+    {
+        host::reset();
+        host::clear_preferences();
+        host::set_log_level(host::LOG_LEVEL_NONE);
+        host::set_record_publishes(false);
+        auto bridge = std::make_unique<Now_MQTT_BridgeComponent>();
+        bridge->set_device_discovery(device_discovery);
+        bridge->setup();
+        bridge->loop();
+        return bridge;
+    }
+
+    host::V2Frame node_frame()
+    {
+        now_mqtt_protocol::NodeInfo node = {"garden", "2024.6.0", "esp32dev", 60};
+        host::V2Frame frame(node, now_mqtt_protocol::FLAG_SEQUENCE);
+        now_mqtt_protocol::EntityMeta meta;
+        meta.device_class = "temperature";
+        meta.state_class = "measurement";
+        meta.unit = "°C";
+        meta.accuracy = 1;
+        meta.has_accuracy = true;
+        frame.writer().add_sensor("temperature", meta, 21.5f);
+        meta.device_class = "humidity";
+        meta.unit = "%";
+        frame.writer().add_sensor("humidity", meta, 48.0f);
+        frame.writer().add_binary_sensor("door", {}, false);
+        return frame;
+    }
+} // namespace
+
+static void BM_ReceiveV1(benchmark::State &state)
+{
+    auto bridge = start_bridge(false);
+    host::V1Fields fields;
+    fields.device_class = "temperature";
+    fields.unit = "°C";
+    fields.icon = "mdi:thermometer";
+    std::string frame = host::v1_frame(fields);
+    uint8_t mac[6];
+    host::mac_for(1, mac);
+    for (auto _ : state) {
+        host::advance_ms(now_mqtt_bridge::DUPLICATE_WINDOW_MS);  // Not a retry
+        host::receive(mac, frame);
+        bridge->loop();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReceiveV1);
+
+static void BM_ReceiveV2(benchmark::State &state)
+{
+    auto bridge = start_bridge(false);
+    host::V2Frame frame = node_frame();
+    uint8_t *data = const_cast<uint8_t *>(frame.data());
+    uint8_t mac[6];
+    host::mac_for(1, mac);
+    uint16_t seq = 0;
+    for (auto _ : state) {
+        frame.writer().set_sequence(1, seq++);  // Not a duplicate
+        host::receive(mac, data, frame.size());
+        bridge->loop();
+    }
+    state.SetItemsProcessed(state.iterations() * 3);
+}
+BENCHMARK(BM_ReceiveV2);
+
+// Every frame after a Home Assistant restart: discovery config rendered and published
+static void BM_ReceiveV1WithDiscovery(benchmark::State &state)
+{
+    auto bridge = start_bridge(false);
+    std::string frame = host::v1_frame({});
+    uint8_t mac[6];
+    host::mac_for(1, mac);
+    for (auto _ : state) {
+        host::deliver_mqtt("homeassistant/status", "online");
+        host::advance_ms(now_mqtt_bridge::DUPLICATE_WINDOW_MS);
+        host::receive(mac, frame);
+        bridge->loop();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReceiveV1WithDiscovery);
+
+static void BM_ReceiveV2WithDeviceDiscovery(benchmark::State &state)
+{
+    auto bridge = start_bridge(true);
+    host::V2Frame frame = node_frame();
+    uint8_t *data = const_cast<uint8_t *>(frame.data());
+    uint8_t mac[6];
+    host::mac_for(1, mac);
+    uint16_t seq = 0;
+    for (auto _ : state) {
+        host::deliver_mqtt("homeassistant/status", "online");
+        frame.writer().set_sequence(1, seq++);
+        host::receive(mac, data, frame.size());
+        bridge->loop();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReceiveV2WithDeviceDiscovery);
+
+// A burst from many nodes at once, as after a shared wake-up
+static void BM_ReceiveBurst(benchmark::State &state)
+{
+    auto bridge = start_bridge(false);
+    int nodes = state.range(0);
+    std::vector<std::string> frames;
+    for (int i = 0; i < nodes; i++) {
+        host::V1Fields fields;
+        fields.node = "node" + std::to_string(i);
+        frames.push_back(host::v1_frame(fields));
+    }
+    uint8_t mac[6];
+    for (auto _ : state) {
+        host::advance_ms(now_mqtt_bridge::DUPLICATE_WINDOW_MS);
+        for (int i = 0; i < nodes; i++) {
+            host::mac_for(i, mac);
+            host::receive(mac, frames[i]);
+        }
+        while (bridge->get_ingest_depth() > 0) {
+            bridge->loop();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * nodes);
+}
+BENCHMARK(BM_ReceiveBurst)->Arg(8)->Arg(30);
@@ -0,0 +1,205 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "esphome/components/now_mqtt_bridge/now_mqtt_bridge.h"
+
+using namespace esphome::now_mqtt_bridge;
+
+// The per-frame device lookup at 10, 100 and 1000 nodes: the packed-MAC flat
+// table with interned names against the std::map keyed by the formatted MAC
+// string that it replaced. Frames arrive from the nodes in a fixed random order.
+
+namespace
+{
+    // The tracking entry before the flat table
+    struct LegacyDeviceInfo {
+        std::string name;
+        std::string mac_str;
+        uint32_t last_seen_ms;
+        bool online;
+    };
+
+    struct Node {
+        uint8_t mac[6];
+        std::string name;
+    };
+
+    std::vector<Node> make_nodes(size_t count)
+    {
+        std::vector<Node> nodes(count);
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t mac[6] = {0x24, 0x6f, 0x28, uint8_t(i >> 16), uint8_t(i >> 8), uint8_t(i)};
+            memcpy(nodes[i].mac, mac, sizeof(mac));
+            nodes[i].name = "node-" + std::to_string(i);
+        }
+        return nodes;
+    }
+
+    std::vector<uint32_t> arrival_order(size_t count)
+    {
+        std::mt19937 rng(1);
+        std::vector<uint32_t> order(4096);
+        for (auto &index : order) {
+            index = rng() % count;
+        }
+        return order;
+    }
+
+    // The bridge's pack_mac_() / format_mac_()
+    uint64_t pack_mac(const uint8_t *mac)
+    {
+        uint64_t key = 1ULL << 48;
+        for (int i = 0; i < 6; i++) {
+            key |= uint64_t(mac[i]) << (8 * (5 - i));
+        }
+        return key;
+    }
+
+    void format_mac(uint64_t mac_key, char *mac_str)
+    {
+        static const char *const HEX = "0123456789abcdef";
+        for (int i = 0; i < 12; i++) {
+            mac_str[i] = HEX[(mac_key >> (4 * (11 - i))) & 0xF];
+        }
+        mac_str[12] = '\0';
+    }
+
+    // As setup() sizes them for max_devices
+    struct FlatDevices {
+        explicit FlatDevices(size_t max_devices)
+            : slots(FlatTable<DeviceInfo>::slots_for(max_devices)),
+              names_arena(max_devices * DEVICE_NAME_BYTES),
+              names_index(FlatTable<DeviceInfo>::slots_for(max_devices))
+        {
+            this->table.init(this->slots.data(), this->slots.size(), max_devices);
+            this->names.init(this->names_arena.data(), this->names_arena.size(), this->names_index.data(),
+                             this->names_index.size(), max_devices);
+        }
+
+        // update_device_seen_(), minus timers, intervals and publishing
+        void seen(const Node &node, uint32_t now)
+        {
+            uint64_t mac_key = pack_mac(node.mac);
+            char mac_str[13];
+            format_mac(mac_key, mac_str);
+            benchmark::DoNotOptimize(mac_str);
+
+            bool inserted;
+            DeviceInfo *info = this->table.insert(mac_key, &inserted);
+            if (info == nullptr) {
+                return;
+            }
+            if (inserted) {
+                info->name = StringPool::INVALID;
+            }
+            if (this->names.get(info->name) != node.name) {
+                info->name = this->names.intern(node.name);
+            }
+            info->last_seen_ms = now;
+            info->online = true;
+        }
+
+        std::vector<FlatTable<DeviceInfo>::Slot> slots;
+        std::vector<char> names_arena;
+        std::vector<FlatTable<uint16_t>::Slot> names_index;
+        FlatTable<DeviceInfo> table;
+        StringPool names;
+    };
+
+    // The old update_device_seen_(), with mac_to_string_() in front of it
+    struct LegacyDevices {
+        void seen(const Node &node, uint32_t now)
+        {
+            char buffer[18];
+            snprintf(buffer, sizeof(buffer), "%02x%02x%02x%02x%02x%02x", node.mac[0], node.mac[1], node.mac[2],
+                     node.mac[3], node.mac[4], node.mac[5]);
+            std::string mac_str(buffer);
+            std::string name(node.name);  // tokens[0] became a std::string at the call
+
+            auto it = this->devices.find(mac_str);
+            if (it == this->devices.end()) {
+                LegacyDeviceInfo info;
+                info.name = name;
+                info.mac_str = mac_str;
+                info.last_seen_ms = now;
+                info.online = true;
+                this->devices[mac_str] = info;
+            } else {
+                it->second.last_seen_ms = now;
+                it->second.online = true;
+            }
+        }
+
+        std::map<std::string, LegacyDeviceInfo> devices;
+    };
+} // namespace
+
+// A frame from a known node
+static void BM_FlatTableSeen(benchmark::State &state)
+{
+    std::vector<Node> nodes = make_nodes(state.range(0));
+    std::vector<uint32_t> order = arrival_order(nodes.size());
+    FlatDevices devices(nodes.size());
+    for (const Node &node : nodes) {
+        devices.seen(node, 0);
+    }
+    uint32_t now = 0;
+    for (auto _ : state) {
+        devices.seen(nodes[order[now % order.size()]], now);
+        now++;
+    }
+    state.counters["bytes"] = devices.table.memory_usage() + devices.names.capacity() +
+                              devices.names_index.size() * sizeof(FlatTable<uint16_t>::Slot);
+}
+BENCHMARK(BM_FlatTableSeen)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_LegacyMapSeen(benchmark::State &state)
+{
+    std::vector<Node> nodes = make_nodes(state.range(0));
+    std::vector<uint32_t> order = arrival_order(nodes.size());
+    LegacyDevices devices;
+    for (const Node &node : nodes) {
+        devices.seen(node, 0);
+    }
+    uint32_t now = 0;
+    for (auto _ : state) {
+        devices.seen(nodes[order[now % order.size()]], now);
+        now++;
+    }
+}
+BENCHMARK(BM_LegacyMapSeen)->Arg(10)->Arg(100)->Arg(1000);
+
+// Every node's first frame, into an empty table
+static void BM_FlatTableFill(benchmark::State &state)
+{
+    std::vector<Node> nodes = make_nodes(state.range(0));
+    for (auto _ : state) {
+        FlatDevices devices(nodes.size());
+        for (const Node &node : nodes) {
+            devices.seen(node, 0);
+        }
+        benchmark::DoNotOptimize(devices.table.size());
+    }
+    state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+BENCHMARK(BM_FlatTableFill)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_LegacyMapFill(benchmark::State &state)
+{
+    std::vector<Node> nodes = make_nodes(state.range(0));
+    for (auto _ : state) {
+        LegacyDevices devices;
+        for (const Node &node : nodes) {
+            devices.seen(node, 0);
+        }
+        benchmark::DoNotOptimize(devices.devices.size());
+    }
+    state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+BENCHMARK(BM_LegacyMapFill)->Arg(10)->Arg(100)->Arg(1000);
@@ -0,0 +1,181 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <string_view>
+
+#include "esphome/components/now_mqtt_bridge/json_writer.h"
+
+using esphome::now_mqtt_bridge::JsonWriter;
+
+// A sensor's discovery config rendered with JsonWriter into a fixed buffer, as
+// the bridge does, against what it replaced: std::string temporaries for the
+// topics and IDs, serialized into a growing std::string. ArduinoJson is not part
+// of the host build, so the reference is a plain serializer with its member
+// order and escaping rather than DynamicJsonDocument itself.
+
+namespace
+{
+    struct SensorConfig {
+        std::string_view node;
+        std::string_view name;
+        std::string_view device_class;
+        std::string_view state_class;
+        std::string_view unit;
+        std::string_view icon;
+        std::string_view version;
+        std::string_view board;
+    };
+
+    const SensorConfig PLAIN = {"garden", "temperature", "temperature", "measurement", "°C", "mdi:thermometer",
+                                "2024.6.0", "esp32dev"};
+    const SensorConfig ESCAPED = {"garden", "say \"hi\" \\ now", "temperature", "measurement", "a\tb\nc",
+                                  "mdi:thermometer", "2024.6.0", "esp32dev"};
+    const char *const MAC = "246f28000001";
+
+    // The bridge's write_entity_config_() and write_discovery_device_() for a sensor
+    void write_config(JsonWriter &json, const SensorConfig &config)
+    {
+        json.begin_object();
+        if (!config.device_class.empty()) json.add("dev_cla", config.device_class);
+        if (!config.unit.empty()) json.add("unit_of_meas", config.unit);
+        if (!config.state_class.empty()) json.add("stat_cla", config.state_class);
+        json.add("name", config.name);
+        if (!config.icon.empty()) json.add("icon", config.icon);
+
+        json.key("stat_t");
+        json.begin_string();
+        json.append(config.node);
+        json.append("/sensor/");
+        json.append(config.name);
+        json.append("/state");
+        json.end_string();
+
+        json.key("uniq_id");
+        json.begin_string();
+        json.append(MAC);
+        json.append("_");
+        json.append(config.name);
+        json.end_string();
+
+        json.key("dev");
+        json.begin_object();
+        json.add("ids", MAC);
+        json.add("name", config.node);
+        json.add("sw", config.version);
+        json.add("mdl", config.board);
+        json.raw(",\"mf\":\"espressif\"");
+        json.end_object();
+        json.end_object();
+    }
+
+    void append_string(std::string &out, const std::string &value)
+    {
+        out += '"';
+        for (char c : value) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\b': out += "\\b"; break;
+                case '\f': out += "\\f"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                case '\0': out += "\\u0000"; break;
+                default:
+                    out += c;
+                    break;
+            }
+        }
+        out += '"';
+    }
+
+    void append_member(std::string &out, const char *key, const std::string &value)
+    {
+        if (out.back() != '{') {
+            out += ',';
+        }
+        append_string(out, key);
+        out += ':';
+        append_string(out, value);
+    }
+
+    // publish_sensor_discovery_() as it was, with the document serialized in member order
+    std::string build_config(const SensorConfig &config)
+    {
+        std::string node(config.node);
+        std::string name(config.name);
+        std::string mac_str(MAC);
+
+        std::string json = "{";
+        if (!config.device_class.empty()) append_member(json, "dev_cla", std::string(config.device_class));
+        if (!config.unit.empty()) append_member(json, "unit_of_meas", std::string(config.unit));
+        if (!config.state_class.empty()) append_member(json, "stat_cla", std::string(config.state_class));
+        if (!name.empty()) append_member(json, "name", name);
+        if (!config.icon.empty()) {
+            std::string icon = std::string(config.icon);
+            append_member(json, "icon", icon);
+        }
+        std::string state_topic = node + "/sensor/" + name + "/state";
+        append_member(json, "stat_t", state_topic);
+        std::string unique_id = mac_str + "_" + name;
+        append_member(json, "uniq_id", unique_id);
+
+        json += ",\"dev\":{";
+        append_member(json, "ids", mac_str);
+        if (!node.empty()) append_member(json, "name", node);
+        append_member(json, "sw", std::string(config.version));
+        append_member(json, "mdl", std::string(config.board));
+        append_member(json, "mf", "espressif");
+        json += "}}";
+        return json;
+    }
+
+    bool same_output(const SensorConfig &config)
+    {
+        char buffer[512];
+        JsonWriter json(buffer, sizeof(buffer));
+        write_config(json, config);
+        return !json.overflow() && std::string(json.data(), json.size()) == build_config(config);
+    }
+
+    void run_writer(benchmark::State &state, const SensorConfig &config)
+    {
+        if (!same_output(config)) {
+            state.SkipWithError("JsonWriter and the reference disagree");
+            return;
+        }
+        size_t bytes = 0;
+        for (auto _ : state) {
+            char buffer[512];
+            JsonWriter json(buffer, sizeof(buffer));
+            write_config(json, config);
+            benchmark::DoNotOptimize(buffer);
+            bytes += json.size();
+        }
+        state.SetBytesProcessed(bytes);
+    }
+
+    void run_reference(benchmark::State &state, const SensorConfig &config)
+    {
+        size_t bytes = 0;
+        for (auto _ : state) {
+            std::string json = build_config(config);
+            benchmark::DoNotOptimize(json);
+            bytes += json.size();
+        }
+        state.SetBytesProcessed(bytes);
+    }
+} // namespace
+
+static void BM_JsonWriterSensorConfig(benchmark::State &state) { run_writer(state, PLAIN); }
+BENCHMARK(BM_JsonWriterSensorConfig);
+
+static void BM_StringSensorConfig(benchmark::State &state) { run_reference(state, PLAIN); }
+BENCHMARK(BM_StringSensorConfig);
+
+// Names and units that need escaping
+static void BM_JsonWriterSensorConfigEscaped(benchmark::State &state) { run_writer(state, ESCAPED); }
+BENCHMARK(BM_JsonWriterSensorConfigEscaped);
+
+static void BM_StringSensorConfigEscaped(benchmark::State &state) { run_reference(state, ESCAPED); }
+BENCHMARK(BM_StringSensorConfigEscaped);
@@ -0,0 +1,146 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <string>
+
+#include "harness.h"
+
+using namespace esphome;
+
+// The v1 text tokenizer against the one it replaced: split_string_() cut a
+// NUL-terminated stack copy into char * tokens, and every consumer measured
+// them with strlen and built std::string temporaries (the icon was split at its
+// ':' and glued back together by hand).
+
+namespace
+{
+    // The bridge's split_string_(), as it was
+    int split_string(char **tokens, int max_tokens, char *string, char delimiter)
+    {
+        int count = 0;
+        char *token = string;
+
+        while (*string && count < max_tokens) {
+            if (*string == delimiter) {
+                *string = '\0';
+                tokens[count++] = token;
+                token = string + 1;
+            }
+            string++;
+        }
+
+        // Add the last token
+        if (count < max_tokens) {
+            tokens[count++] = token;
+        }
+
+        return count;
+    }
+
+    std::string sample_frame()
+    {
+        host::V1Fields fields;
+        fields.device_class = "temperature";
+        fields.unit = "°C";
+        fields.icon = "mdi:thermometer";
+        return host::v1_frame(fields);
+    }
+} // namespace
+
+static void BM_SplitString(benchmark::State &state)
+{
+    std::string frame = sample_frame();
+    for (auto _ : state) {
+        char received_string[251];
+        size_t copy_len = std::min<size_t>(frame.size(), 250);
+        memcpy(received_string, frame.data(), copy_len);
+        received_string[copy_len] = '\0';
+
+        char *tokens[13];
+        int count = split_string(tokens, 13, received_string, ':');
+        if (count != 11) {
+            state.SkipWithError("unexpected token count");
+            break;
+        }
+        // What the publishers did with the tokens
+        std::string icon = std::string(tokens[6]) + ":" + tokens[7];
+        size_t lengths = 0;
+        for (int i = 0; i < count; i++) {
+            lengths += strlen(tokens[i]);
+        }
+        benchmark::DoNotOptimize(icon);
+        benchmark::DoNotOptimize(lengths);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_SplitString);
+
+static void BM_ParseTextFrame(benchmark::State &state)
+{
+    std::string frame = sample_frame();
+    for (auto _ : state) {
+        char line[now_mqtt_protocol::MAX_FRAME_SIZE];
+        size_t line_len = std::min(frame.size(), sizeof(line));
+        memcpy(line, frame.data(), line_len);
+
+        now_mqtt_protocol::NodeInfo node;
+        now_mqtt_protocol::Reading reading;
+        std::string_view value;
+        if (!now_mqtt_protocol::parse_text_frame(line, line_len, &node, &reading, &value)) {
+            state.SkipWithError("frame did not parse");
+            break;
+        }
+        benchmark::DoNotOptimize(reading.meta.icon);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_ParseTextFrame);
+
+// A sender escaping the icon's ':' (a new sender; the bridge still accepts the split form)
+static void BM_ParseTextFrameEscaped(benchmark::State &state)
+{
+    host::V1Fields fields;
+    fields.device_class = "temperature";
+    fields.unit = "°C";
+    fields.icon = "mdi\\:thermometer:";
+    std::string frame = host::v1_frame(fields);
+    for (auto _ : state) {
+        char line[now_mqtt_protocol::MAX_FRAME_SIZE];
+        size_t line_len = std::min(frame.size(), sizeof(line));
+        memcpy(line, frame.data(), line_len);
+
+        now_mqtt_protocol::NodeInfo node;
+        now_mqtt_protocol::Reading reading;
+        std::string_view value;
+        if (!now_mqtt_protocol::parse_text_frame(line, line_len, &node, &reading, &value)) {
+            state.SkipWithError("frame did not parse");
+            break;
+        }
+        benchmark::DoNotOptimize(reading.meta.icon);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_ParseTextFrameEscaped);
+
+// The field splitter alone, on a line of n-byte fields
+static void BM_SplitFields(benchmark::State &state)
+{
+    std::string field(state.range(0), 'x');
+    std::string frame;
+    for (size_t i = 0; i < now_mqtt_protocol::TEXT_FIELD_COUNT; i++) {
+        frame += (i > 0 ? ":" : "") + field;
+    }
+    for (auto _ : state) {
+        char line[1024];
+        memcpy(line, frame.data(), frame.size());
+        std::string_view fields[now_mqtt_protocol::TEXT_FIELD_COUNT];
+        size_t count = now_mqtt_protocol::split_fields(line, frame.size(), now_mqtt_protocol::TEXT_FIELD_DELIMITER,
+                                                       fields, now_mqtt_protocol::TEXT_FIELD_COUNT);
+        benchmark::DoNotOptimize(count);
+        benchmark::DoNotOptimize(fields);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_SplitFields)->Arg(4)->Arg(20);
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt/now_mqtt.h"
+#include "esphome/core/application.h"
+
+using namespace esphome;
+using esphome::now_mqtt::Now_MQTTComponent;
+
+// A sensor update through the sender: record encoding, frame and send queue,
+// up to esp_now_send and its completion.
+
+namespace
+{
+    struct Node {
+        sensor::Sensor temperature;
+        binary_sensor::BinarySensor door;
+        std::unique_ptr<Now_MQTTComponent> component;
+
+        Node(uint32_t batch_window_ms, bool compact)
+        {
+            host::reset();
+            host::set_log_level(host::LOG_LEVEL_NONE);
+            this->temperature.set_name("Temperature");
+            this->temperature.set_unit_of_measurement("°C");
+            this->temperature.set_state_class(sensor::STATE_CLASS_MEASUREMENT);
+            this->temperature.set_device_class("temperature");
+            this->door.set_name("Door");
+            App.set_name("garden");
+            App.register_sensor(&this->temperature);
+            App.register_binary_sensor(&this->door);
+            this->component = std::make_unique<Now_MQTTComponent>();
+            this->component->set_batch_window(batch_window_ms);
+            this->component->set_compact_frames(compact);
+            this->component->set_pairing(false);
+            this->component->setup();
+        }
+
+        void cycle()
+        {
+            this->component->loop();
+            host::complete_sends(true);
+            this->component->loop();
+            host::sends().clear();
+        }
+    };
+} // namespace
+
+static void BM_SensorUpdate(benchmark::State &state)
+{
+    Node node(0, false);
+    float value = 0.0f;
+    for (auto _ : state) {
+        node.temperature.publish_state(value += 0.5f);
+        node.cycle();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SensorUpdate);
+
+static void BM_BatchedUpdates(benchmark::State &state)
+{
+    Node node(1000, false);
+    float value = 0.0f;
+    for (auto _ : state) {
+        node.temperature.publish_state(value += 0.5f);
+        node.door.publish_state(!node.door.state);
+        host::advance_ms(1000);
+        node.cycle();
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_BatchedUpdates);
@@ -0,0 +1,50 @@
+#include "frame_seeds.h"
+#include "fuzz.h"
+#include "harness.h"
+#include "esphome/components/now_mqtt_bridge/now_mqtt_bridge.h"
+
+using namespace esphome;
+using esphome::now_mqtt_bridge::Now_MQTT_BridgeComponent;
+
+// The bridge's whole receive path: the ESP-NOW callback, ingest ring, decoding,
+// device table, discovery (per entity and per device) and state publishes. Each
+// input arrives from one of a few nodes a second after the previous one, and
+// Home Assistant restarts now and then so discovery is rendered again.
+
+namespace
+{
+    Now_MQTT_BridgeComponent *start_bridge()
+    {
+        host::reset();
+        host::clear_preferences();
+        host::set_log_level(host::LOG_LEVEL_NONE);
+        host::set_record_publishes(false);
+        auto *bridge = new Now_MQTT_BridgeComponent();  // Lives as long as the process, like on the chip
+        bridge->set_device_discovery(true);
+        bridge->setup();
+        bridge->loop();
+        return bridge;
+    }
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static Now_MQTT_BridgeComponent *bridge = start_bridge();
+    static uint32_t inputs = 0;
+    if (size > now_mqtt_protocol::MAX_FRAME_SIZE) {
+        return 0;  // Not an ESP-NOW payload
+    }
+
+    if (++inputs % 64 == 0) {
+        host::deliver_mqtt("homeassistant/status", "online");
+    }
+    host::advance_ms(1000);
+    uint8_t mac[6];
+    host::mac_for(size % 4, mac);
+    host::receive(mac, data, size);
+    bridge->loop();
+    FUZZ_CHECK(bridge->get_ingest_depth() == 0);
+    return 0;
+}
+
+std::vector<std::vector<uint8_t>> fuzz_seeds() { return host::frame_seeds(); }
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "frame_seeds.h"
+#include "fuzz.h"
+#include "esphome/components/now_mqtt_bridge/reassembly.h"
+#include "esphome/components/now_mqtt_protocol/codec.h"
+
+using namespace esphome;
+using namespace esphome::now_mqtt_protocol;
+
+// Every decoder the bridge runs on a received payload, on the same bytes: the
+// v1 tokenizer and text parser, v2 frames (full and compact), fragments through
+// a reassembler, and the control frames. Decoded views must stay inside the
+// buffer they came from, and the tokenizer must agree with a plain split.
+
+namespace
+{
+    static constexpr size_t MAX_TEST_FIELDS = 16;
+
+    bool within(std::string_view view, const void *begin, size_t len)
+    {
+        const char *start = static_cast<const char *>(begin);
+        return view.empty() || (view.data() >= start && view.data() + view.size() <= start + len);
+    }
+
+    void check_reading(const Reading &reading, const uint8_t *data, size_t len, const RecordPrefix &known)
+    {
+        // Names and metadata come from the frame, or from the cached prefix of a compact record
+        const uint8_t *source = reading.prefix.data == known.data ? known.data : data;
+        size_t source_len = reading.prefix.data == known.data ? known.len : len;
+        FUZZ_CHECK(within(reading.name, source, source_len));
+        FUZZ_CHECK(within(reading.meta.device_class, source, source_len));
+        FUZZ_CHECK(within(reading.meta.state_class, source, source_len));
+        FUZZ_CHECK(within(reading.meta.unit, source, source_len));
+        FUZZ_CHECK(within(reading.meta.icon, source, source_len));
+        FUZZ_CHECK(within(reading.text, data, len));
+        if (reading.prefix.data != known.data && reading.prefix.len != 0) {
+            FUZZ_CHECK(reading.prefix.data >= data && reading.prefix.data + reading.prefix.len <= data + len);
+        }
+    }
+
+    // A temperature record prefix, as learned from an earlier full frame
+    RecordPrefix known_prefix()
+    {
+        static uint8_t buffer[64];
+        static size_t len = 0;
+        if (len == 0) {
+            EntityMeta meta;
+            meta.device_class = "temperature";
+            meta.unit = "°C";
+            len = encode_record_prefix(buffer, sizeof(buffer), ReadingType::SENSOR, "temperature", meta);
+        }
+        return {buffer, len};
+    }
+
+    void fuzz_frame_reader(const uint8_t *data, size_t len)
+    {
+        RecordPrefix known = known_prefix();
+        FrameReader reader(data, len);
+        if (!reader.valid()) {
+            return;
+        }
+        FUZZ_CHECK(within(reader.node().name, data, len));
+        FUZZ_CHECK(within(reader.node().version, data, len));
+        FUZZ_CHECK(within(reader.node().board, data, len));
+
+        // Odd schema IDs are known, even ones are not
+        auto lookup = [&known](uint32_t schema, RecordPrefix *prefix) {
+            *prefix = known;
+            return (schema & 1) != 0;
+        };
+        Reading reading;
+        size_t records = 0;
+        while (reader.next(&reading, lookup)) {
+            check_reading(reading, data, len, known);
+            FUZZ_CHECK(++records <= reader.count());
+        }
+        if (reader.compact() && reader.missing_schema() != 0) {
+            FUZZ_CHECK((reader.missing_schema() & 1) == 0);
+        }
+    }
+
+    void fuzz_text(const uint8_t *data, size_t len)
+    {
+        // As the bridge does: a stack copy of at most one frame, parsed in place
+        char line[MAX_FRAME_SIZE];
+        size_t line_len = std::min(len, sizeof(line));
+        memcpy(line, data, line_len);
+        NodeInfo node;
+        Reading reading;
+        std::string_view state;
+        if (parse_text_frame(line, line_len, &node, &reading, &state)) {
+            FUZZ_CHECK(within(node.name, line, line_len));
+            FUZZ_CHECK(within(reading.name, line, line_len));
+            FUZZ_CHECK(within(reading.meta.icon, line, line_len));
+            FUZZ_CHECK(within(state, line, line_len));
+        }
+
+        // Tokenizer against a plain split, where there is nothing to unescape
+        std::string input(reinterpret_cast<const char *>(data), len);
+        std::string copy = input;
+        std::string_view fields[MAX_TEST_FIELDS];
+        size_t count = split_fields(copy.data(), copy.size(), TEXT_FIELD_DELIMITER, fields, MAX_TEST_FIELDS);
+        FUZZ_CHECK(count >= 1 && count <= MAX_TEST_FIELDS + 1);
+        for (size_t i = 0; i < std::min(count, MAX_TEST_FIELDS); i++) {
+            FUZZ_CHECK(within(fields[i], copy.data(), copy.size()));
+        }
+        if (input.find(TEXT_FIELD_ESCAPE) == std::string::npos && input.find('\0') == std::string::npos) {
+            size_t expected = 1 + std::count(input.begin(), input.end(), TEXT_FIELD_DELIMITER);
+            FUZZ_CHECK(count == std::min(expected, MAX_TEST_FIELDS + 1));
+            size_t start = 0;
+            for (size_t i = 0; i < expected && i < count && count <= MAX_TEST_FIELDS; i++) {
+                size_t end = input.find(TEXT_FIELD_DELIMITER, start);
+                end = end == std::string::npos ? input.size() : end;
+                FUZZ_CHECK(fields[i] == std::string_view(input).substr(start, end - start));
+                start = end + 1;
+            }
+        }
+
+        // Escaping the fields and joining them gives back the same fields
+        if (count <= MAX_TEST_FIELDS) {
+            std::string joined;
+            for (size_t i = 0; i < count; i++) {
+                if (i > 0) {
+                    joined += TEXT_FIELD_DELIMITER;
+                }
+                for (char c : fields[i]) {
+                    if (c == TEXT_FIELD_DELIMITER || c == TEXT_FIELD_ESCAPE) {
+                        joined += TEXT_FIELD_ESCAPE;
+                    }
+                    joined += c;
+                }
+            }
+            std::string_view again[MAX_TEST_FIELDS];
+            FUZZ_CHECK(split_fields(joined.data(), joined.size(), TEXT_FIELD_DELIMITER, again, MAX_TEST_FIELDS) ==
+                       count);
+            for (size_t i = 0; i < count; i++) {
+                FUZZ_CHECK(again[i] == fields[i]);
+            }
+        }
+    }
+
+    void fuzz_fragment(const uint8_t *data, size_t len)
+    {
+        static now_mqtt_bridge::Reassembler<4> reassembler(1000);
+        static uint32_t now = 0;
+
+        Fragment fragment;
+        if (!decode_fragment(data, len, &fragment)) {
+            return;
+        }
+        FUZZ_CHECK(fragment.index < fragment.total && fragment.total <= MAX_FRAGMENTS);
+        FUZZ_CHECK(fragment.payload >= data && fragment.payload + fragment.len <= data + len);
+
+        // A few senders, so fragments of different inputs meet in one slot
+        size_t message_len = 0;
+        const uint8_t *message = reassembler.add(len % 3, fragment, now++, &message_len);
+        reassembler.expire(now);
+        if (message != nullptr) {
+            FUZZ_CHECK(message_len <= MAX_MESSAGE_SIZE);
+            fuzz_frame_reader(message, message_len);
+        }
+    }
+
+    void fuzz_control(const uint8_t *data, size_t len)
+    {
+        uint8_t mac[6];
+        uint8_t channel;
+        if (decode_pair_ack(data, len, mac, &channel)) {
+            uint8_t ack[PAIR_ACK_SIZE];
+            FUZZ_CHECK(encode_pair_ack(ack, sizeof(ack), mac, channel) == PAIR_ACK_SIZE);
+            uint8_t mac_again[6];
+            uint8_t channel_again;
+            FUZZ_CHECK(decode_pair_ack(ack, sizeof(ack), mac_again, &channel_again));
+            FUZZ_CHECK(memcmp(mac, mac_again, 6) == 0 && channel == channel_again);
+        }
+        decode_schema_request(data, len, mac);
+        is_probe(data, len);
+        uint16_t boot_id, seq;
+        peek_sequence(data, len, &boot_id, &seq);
+        frame_flags(data, len);
+    }
+
+    void fuzz_format(const uint8_t *data, size_t len)
+    {
+        if (len < 5) {
+            return;
+        }
+        float value;
+        memcpy(&value, data, sizeof(value));
+        char buffer[32];
+        size_t n = format_value(buffer, sizeof(buffer), value, static_cast<int8_t>(data[4]));
+        FUZZ_CHECK(n < sizeof(buffer) && strlen(buffer) == n);
+    }
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (is_binary_frame(data, size)) {
+        fuzz_frame_reader(data, size);
+        fuzz_fragment(data, size);
+        fuzz_control(data, size);
+    }
+    fuzz_text(data, size);
+    fuzz_format(data, size);
+    return 0;
+}
+
+std::vector<std::vector<uint8_t>> fuzz_seeds() { return host::frame_seeds(); }
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "esphome/core/helpers.h"
+
+using esphome::delay;
+using esphome::micros;
+using esphome::millis;
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host stand-in for ESP-IDF: the version picks the ESP-NOW receive callback
+// signature, so the components build against both (-DESP_IDF_VERSION_MAJOR=5)
+#ifndef ESP_IDF_VERSION_MAJOR
+#define ESP_IDF_VERSION_MAJOR 4
+#endif
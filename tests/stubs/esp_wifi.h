@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Host stand-in for the ESP-IDF Wi-Fi driver; host.h has what the calls do
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_STATE 0x103
+#define ESP_ERR_ESPNOW_NO_MEM 0x3067
+#define ESP_ERR_ESPNOW_NOT_FOUND 0x3069
+#define ESP_ERR_ESPNOW_EXIST 0x306a
+#define ESP_ERROR_CHECK(x) (void) (x)
+
+typedef struct {
+    int unused;
+} wifi_init_config_t;
+#define WIFI_INIT_CONFIG_DEFAULT() wifi_init_config_t{0}
+
+typedef enum { WIFI_STORAGE_RAM } wifi_storage_t;
+typedef enum { WIFI_MODE_STA, WIFI_MODE_APSTA } wifi_mode_t;
+typedef enum { WIFI_SECOND_CHAN_NONE } wifi_second_chan_t;
+typedef enum { WIFI_IF_STA, WIFI_IF_AP } wifi_interface_t;
+#define WIFI_PROTOCOL_LR 8
+
+typedef struct {
+    int rssi;
+} wifi_pkt_rx_ctrl_t;
+
+const char *esp_err_to_name(esp_err_t err);
+esp_err_t esp_netif_init();
+esp_err_t esp_event_loop_create_default();
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_start();
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second);
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second);
+esp_err_t esp_wifi_set_protocol(wifi_interface_t ifx, uint8_t protocol);
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t *mac);
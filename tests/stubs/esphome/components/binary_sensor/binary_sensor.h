@@ -0,0 +1,31 @@
+#pragma once
+
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome
+{
+    namespace binary_sensor
+    {
+        class BinarySensor : public EntityBase
+        {
+        public:
+            bool has_state() const { return this->has_state_; }
+            void add_on_state_callback(std::function<void(bool)> &&callback) { this->callback_.add(std::move(callback)); }
+
+            void publish_state(bool state)
+            {
+                this->state = state;
+                this->has_state_ = true;
+                this->callback_.call(state);
+            }
+
+            bool state = false;
+
+        protected:
+            bool has_state_ = false;
+            CallbackManager<void(bool)> callback_;
+        };
+
+    } // namespace binary_sensor
+} // namespace esphome
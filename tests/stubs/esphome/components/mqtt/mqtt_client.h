@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome
+{
+    namespace mqtt
+    {
+        struct MQTTDiscoveryInfo {
+            std::string prefix;
+            bool retain;
+            bool clean;
+        };
+
+        using mqtt_callback_t = std::function<void(const std::string &, const std::string &)>;
+
+        // Publishes and subscriptions go to the host harness (host.h)
+        class MQTTClientComponent
+        {
+        public:
+            bool publish(const std::string &topic, const std::string &payload, uint8_t qos = 0, bool retain = false);
+            bool publish(const std::string &topic, const char *payload, size_t payload_length, uint8_t qos = 0,
+                         bool retain = false);
+            const MQTTDiscoveryInfo &get_discovery_info() const;
+            bool is_connected();
+            void subscribe(const std::string &topic, mqtt_callback_t callback, uint8_t qos = 0);
+            const std::string &get_topic_prefix() const;
+        };
+
+        extern MQTTClientComponent *global_mqtt_client;
+
+    } // namespace mqtt
+} // namespace esphome
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome
+{
+    namespace sensor
+    {
+        enum StateClass : uint8_t {
+            STATE_CLASS_NONE = 0,
+            STATE_CLASS_MEASUREMENT,
+            STATE_CLASS_TOTAL_INCREASING,
+            STATE_CLASS_TOTAL,
+        };
+
+        std::string state_class_to_string(StateClass state_class);
+
+        class Sensor : public EntityBase
+        {
+        public:
+            int8_t get_accuracy_decimals() { return this->accuracy_decimals_; }
+            StateClass get_state_class() { return this->state_class_; }
+            std::string get_unit_of_measurement() { return this->unit_of_measurement_; }
+            bool has_state() const { return this->has_state_; }
+            void add_on_state_callback(std::function<void(float)> &&callback) { this->callback_.add(std::move(callback)); }
+
+            void set_accuracy_decimals(int8_t accuracy_decimals) { this->accuracy_decimals_ = accuracy_decimals; }
+            void set_state_class(StateClass state_class) { this->state_class_ = state_class; }
+            void set_unit_of_measurement(const std::string &unit) { this->unit_of_measurement_ = unit; }
+            void publish_state(float state)
+            {
+                this->state = state;
+                this->has_state_ = true;
+                this->callback_.call(state);
+            }
+
+            float state = 0.0f;
+
+        protected:
+            int8_t accuracy_decimals_ = 2;
+            StateClass state_class_ = STATE_CLASS_NONE;
+            std::string unit_of_measurement_;
+            bool has_state_ = false;
+            CallbackManager<void(float)> callback_;
+        };
+
+    } // namespace sensor
+
+    using sensor::state_class_to_string;
+
+} // namespace esphome
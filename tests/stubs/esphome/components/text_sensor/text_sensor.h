@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "esphome/core/entity_base.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome
+{
+    namespace text_sensor
+    {
+        class TextSensor : public EntityBase
+        {
+        public:
+            bool has_state() { return this->has_state_; }
+            void add_on_state_callback(std::function<void(std::string)> &&callback)
+            {
+                this->callback_.add(std::move(callback));
+            }
+
+            void publish_state(const std::string &state)
+            {
+                this->state = state;
+                this->has_state_ = true;
+                this->callback_.call(state);
+            }
+
+            std::string state;
+
+        protected:
+            bool has_state_ = false;
+            CallbackManager<void(std::string)> callback_;
+        };
+
+    } // namespace text_sensor
+} // namespace esphome
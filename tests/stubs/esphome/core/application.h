@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+
+namespace esphome
+{
+    class Application
+    {
+    public:
+        const std::string &get_name() const { return this->name_; }
+        const std::vector<sensor::Sensor *> &get_sensors() { return this->sensors_; }
+        const std::vector<binary_sensor::BinarySensor *> &get_binary_sensors() { return this->binary_sensors_; }
+        const std::vector<text_sensor::TextSensor *> &get_text_sensors() { return this->text_sensors_; }
+
+        void set_name(const std::string &name) { this->name_ = name; }
+        void register_sensor(sensor::Sensor *obj) { this->sensors_.push_back(obj); }
+        void register_binary_sensor(binary_sensor::BinarySensor *obj) { this->binary_sensors_.push_back(obj); }
+        void register_text_sensor(text_sensor::TextSensor *obj) { this->text_sensors_.push_back(obj); }
+        void clear()
+        {
+            this->sensors_.clear();
+            this->binary_sensors_.clear();
+            this->text_sensors_.clear();
+        }
+
+    protected:
+        std::string name_ = "host";
+        std::vector<sensor::Sensor *> sensors_;
+        std::vector<binary_sensor::BinarySensor *> binary_sensors_;
+        std::vector<text_sensor::TextSensor *> text_sensors_;
+    };
+
+    extern Application App;
+
+} // namespace esphome
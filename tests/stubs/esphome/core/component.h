@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// On the chip the framework's prefix header brings in the ESP-IDF types
+#include "esp_now.h"
+
+namespace esphome
+{
+    namespace setup_priority
+    {
+        extern const float AFTER_WIFI;
+        extern const float AFTER_CONNECTION;
+        extern const float DATA;
+        extern const float LATE;
+    } // namespace setup_priority
+
+    class Component
+    {
+    public:
+        virtual ~Component() = default;
+        virtual void setup() {}
+        virtual void loop() {}
+        virtual void dump_config() {}
+        virtual float get_setup_priority() const { return 0.0f; }
+        virtual void on_shutdown() {}
+        virtual void on_safe_shutdown() {}
+        virtual bool teardown() { return true; }
+
+        void mark_failed() { this->failed_ = true; }
+        bool is_failed() const { return this->failed_; }
+
+    protected:
+        bool failed_ = false;
+    };
+
+    class PollingComponent : public Component
+    {
+    };
+
+} // namespace esphome
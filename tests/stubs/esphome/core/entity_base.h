@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome
+{
+    class EntityBase
+    {
+    public:
+        const std::string &get_name() const { return this->name_; }
+        std::string get_icon() const { return this->icon_; }
+        std::string get_device_class() { return this->device_class_; }
+
+        void set_name(const std::string &name) { this->name_ = name; }
+        void set_icon(const std::string &icon) { this->icon_ = icon; }
+        void set_device_class(const std::string &device_class) { this->device_class_ = device_class; }
+
+    protected:
+        std::string name_;
+        std::string icon_;
+        std::string device_class_;
+    };
+
+} // namespace esphome
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define ESPHOME_BOARD "host"
+
+namespace esphome
+{
+    // Clock and MAC come from the host harness (host.h)
+    uint32_t millis();
+    uint32_t micros();
+    void delay(uint32_t ms);
+    uint32_t random_uint32();
+    std::string get_mac_address();
+    std::string str_snake_case(const std::string &str);
+    uint32_t fnv1_hash(const std::string &str);
+
+    template<class T>
+    class RAMAllocator
+    {
+    public:
+        enum Flags { NONE = 0, ALLOC_EXTERNAL = 1, ALLOC_INTERNAL = 2, ALLOW_FAILURE = 4 };
+
+        RAMAllocator() = default;
+        explicit RAMAllocator(uint8_t flags) {}
+
+        T *allocate(size_t n) { return static_cast<T *>(::operator new(n * sizeof(T))); }
+        void deallocate(T *p, size_t n) { ::operator delete(p); }
+    };
+
+    template<typename... Ts>
+    class CallbackManager;
+
+    template<typename... Ts>
+    class CallbackManager<void(Ts...)>
+    {
+    public:
+        void add(std::function<void(Ts...)> callback) { this->callbacks_.push_back(std::move(callback)); }
+        void call(Ts... args)
+        {
+            for (auto &callback : this->callbacks_) {
+                callback(args...);
+            }
+        }
+        size_t size() const { return this->callbacks_.size(); }
+
+    protected:
+        std::vector<std::function<void(Ts...)>> callbacks_;
+    };
+
+} // namespace esphome
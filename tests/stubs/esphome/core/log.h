@@ -0,0 +1,21 @@
+#pragma once
+
+namespace esphome
+{
+    namespace host
+    {
+        enum LogLevel { LOG_LEVEL_NONE = 0, LOG_LEVEL_ERROR, LOG_LEVEL_WARN, LOG_LEVEL_INFO, LOG_LEVEL_DEBUG, LOG_LEVEL_VERBOSE };
+
+        void log(int level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+    } // namespace host
+} // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_INFO, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ::esphome::host::log(::esphome::host::LOG_LEVEL_VERBOSE, tag, __VA_ARGS__)
+#define ESP_LOGVV ESP_LOGV
+#define ESP_LOGCONFIG ESP_LOGI
+#define YESNO(b) ((b) ? "YES" : "NO")
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome
+{
+    // Backed by an in-memory map in the host harness, keyed by type; host.h can
+    // inspect and corrupt it
+    class ESPPreferenceObject
+    {
+    public:
+        ESPPreferenceObject() = default;
+        explicit ESPPreferenceObject(uint32_t type) : type_(type), valid_(true) {}
+
+        template<typename T>
+        bool save(const T *src) { return this->save_(src, sizeof(T)); }
+
+        template<typename T>
+        bool load(T *dest) { return this->load_(dest, sizeof(T)); }
+
+    protected:
+        bool save_(const void *data, size_t len);
+        bool load_(void *data, size_t len);
+
+        uint32_t type_ = 0;
+        bool valid_ = false;
+    };
+
+    class ESPPreferences
+    {
+    public:
+        template<typename T>
+        ESPPreferenceObject make_preference(uint32_t type, bool in_flash) { return ESPPreferenceObject(type); }
+
+        template<typename T>
+        ESPPreferenceObject make_preference(uint32_t type) { return ESPPreferenceObject(type); }
+
+        bool sync() { return true; }
+    };
+
+    extern ESPPreferences *global_preferences;
+
+} // namespace esphome
@@ -0,0 +1,3 @@
+#pragma once
+
+#define ESPHOME_VERSION "2024.6.0"
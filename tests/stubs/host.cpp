@@ -0,0 +1,371 @@
+#include "host.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "esp_now.h"
+#include "esp_wifi.h"
+#include "esphome/components/mqtt/mqtt_client.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/application.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome
+{
+    namespace host
+    {
+        struct Subscription {
+            std::string topic;
+            mqtt::mqtt_callback_t callback;
+        };
+
+        static uint64_t now_us = 0;
+        static int log_level = LOG_LEVEL_WARN;
+        static uint32_t warning_count = 0;
+        static bool mqtt_connected = true;
+        static bool record_publishes = true;
+        static uint32_t publish_total = 0;
+        static std::vector<Publish> publish_log;
+        static std::vector<Subscription> subscriptions;
+        static bool record_sends = true;
+        static uint32_t send_total = 0;
+        static std::vector<Send> send_log;
+        static size_t sends_completed = 0;
+        static uint8_t unrecorded_mac[6];
+        static uint32_t unrecorded_pending = 0;
+        static esp_now_send_cb_t send_callback = nullptr;
+        static esp_now_recv_cb_t receive_callback = nullptr;
+        static uint8_t wifi_channel = 1;
+        static std::map<uint32_t, std::vector<uint8_t>> preference_store;
+        static uint32_t preference_write_count = 0;
+        static uint32_t random_state = 1;
+
+        void reset()
+        {
+            now_us = 0;
+            warning_count = 0;
+            mqtt_connected = true;
+            record_publishes = true;
+            publish_total = 0;
+            publish_log.clear();
+            subscriptions.clear();
+            record_sends = true;
+            send_total = 0;
+            send_log.clear();
+            sends_completed = 0;
+            unrecorded_pending = 0;
+            send_callback = nullptr;
+            receive_callback = nullptr;
+            wifi_channel = 1;
+            preference_write_count = 0;
+            random_state = 1;
+            App.clear();
+        }
+
+        void set_time_us(uint64_t us) { now_us = us; }
+        void advance_ms(uint32_t ms) { now_us += uint64_t(ms) * 1000; }
+
+        void set_log_level(int level) { log_level = level; }
+        uint32_t warnings() { return warning_count; }
+
+        void log(int level, const char *tag, const char *format, ...)
+        {
+            if (level <= LOG_LEVEL_WARN) {
+                warning_count++;
+            }
+            if (level > log_level) {
+                return;
+            }
+            static const char LEVELS[] = "-EWIDV";
+            fprintf(stderr, "[%c][%s] ", LEVELS[level], tag);
+            va_list args;
+            va_start(args, format);
+            vfprintf(stderr, format, args);
+            va_end(args);
+            fputc('\n', stderr);
+        }
+
+        void set_mqtt_connected(bool connected) { mqtt_connected = connected; }
+        void set_record_publishes(bool record) { record_publishes = record; }
+        std::vector<Publish> &publishes() { return publish_log; }
+        uint32_t publish_count() { return publish_total; }
+
+        const Publish *last_publish(const std::string &topic)
+        {
+            for (auto it = publish_log.rbegin(); it != publish_log.rend(); ++it) {
+                if (it->topic == topic) {
+                    return &*it;
+                }
+            }
+            return nullptr;
+        }
+
+        bool deliver_mqtt(const std::string &topic, const std::string &payload)
+        {
+            for (auto &subscription : subscriptions) {
+                if (subscription.topic == topic) {
+                    subscription.callback(topic, payload);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void set_record_sends(bool record) { record_sends = record; }
+        std::vector<Send> &sends() { return send_log; }
+        uint32_t send_count() { return send_total; }
+
+        void complete_sends(bool success)
+        {
+            // A callback may send again; those complete on the next call
+            size_t end = send_log.size();
+            uint32_t unrecorded = unrecorded_pending;
+            unrecorded_pending = 0;
+            while (sends_completed < end || unrecorded > 0) {
+                uint8_t mac[6];
+                if (sends_completed < end) {
+                    memcpy(mac, send_log[sends_completed++].mac, 6);
+                } else {
+                    memcpy(mac, unrecorded_mac, 6);
+                    unrecorded--;
+                }
+                if (send_callback != nullptr) {
+                    send_callback(mac, success ? ESP_NOW_SEND_SUCCESS : ESP_NOW_SEND_FAIL);
+                }
+            }
+        }
+
+        void lose_sends()
+        {
+            sends_completed = send_log.size();
+            unrecorded_pending = 0;
+        }
+
+        void receive(const uint8_t *mac, const uint8_t *data, size_t len, int8_t rssi)
+        {
+            if (receive_callback == nullptr) {
+                return;
+            }
+#if ESP_IDF_VERSION_MAJOR >= 5
+            uint8_t src[6];
+            memcpy(src, mac, 6);
+            wifi_pkt_rx_ctrl_t rx_ctrl = {rssi};
+            esp_now_recv_info_t info = {src, nullptr, &rx_ctrl};
+            receive_callback(&info, data, len);
+#else
+            receive_callback(mac, data, len);
+#endif
+        }
+
+        uint8_t channel() { return wifi_channel; }
+
+        std::map<uint32_t, std::vector<uint8_t>> &preferences() { return preference_store; }
+        uint32_t preference_writes() { return preference_write_count; }
+        void clear_preferences() { preference_store.clear(); }
+
+    } // namespace host
+
+    // =============================================================================
+    // ESPHome Core
+    // =============================================================================
+
+    namespace setup_priority
+    {
+        const float AFTER_WIFI = 250.0f;
+        const float AFTER_CONNECTION = 100.0f;
+        const float DATA = 600.0f;
+        const float LATE = -100.0f;
+    } // namespace setup_priority
+
+    Application App;
+
+    uint32_t millis() { return host::now_us / 1000; }
+    uint32_t micros() { return host::now_us; }
+    void delay(uint32_t ms) { host::advance_ms(ms); }
+
+    uint32_t random_uint32()
+    {
+        // xorshift32: deterministic runs
+        uint32_t x = host::random_state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return host::random_state = x;
+    }
+
+    std::string get_mac_address() { return "0200000000fe"; }
+
+    std::string str_snake_case(const std::string &str)
+    {
+        std::string result = str;
+        for (char &c : result) {
+            c = c == ' ' ? '_' : static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+        return result;
+    }
+
+    uint32_t fnv1_hash(const std::string &str)
+    {
+        uint32_t hash = 2166136261UL;
+        for (char c : str) {
+            hash *= 16777619UL;
+            hash ^= static_cast<uint8_t>(c);
+        }
+        return hash;
+    }
+
+    namespace sensor
+    {
+        std::string state_class_to_string(StateClass state_class)
+        {
+            switch (state_class) {
+                case STATE_CLASS_MEASUREMENT:
+                    return "measurement";
+                case STATE_CLASS_TOTAL_INCREASING:
+                    return "total_increasing";
+                case STATE_CLASS_TOTAL:
+                    return "total";
+                default:
+                    return "";
+            }
+        }
+    } // namespace sensor
+
+    // =============================================================================
+    // Preferences
+    // =============================================================================
+
+    static ESPPreferences preferences_instance;
+    ESPPreferences *global_preferences = &preferences_instance;
+
+    bool ESPPreferenceObject::save_(const void *data, size_t len)
+    {
+        if (!this->valid_) {
+            return false;
+        }
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        host::preference_store[this->type_].assign(bytes, bytes + len);
+        host::preference_write_count++;
+        return true;
+    }
+
+    bool ESPPreferenceObject::load_(void *data, size_t len)
+    {
+        auto it = host::preference_store.find(this->type_);
+        if (!this->valid_ || it == host::preference_store.end() || it->second.size() != len) {
+            return false;
+        }
+        memcpy(data, it->second.data(), len);
+        return true;
+    }
+
+    // =============================================================================
+    // MQTT Client
+    // =============================================================================
+
+    namespace mqtt
+    {
+        static MQTTClientComponent client_instance;
+        MQTTClientComponent *global_mqtt_client = &client_instance;
+
+        static const MQTTDiscoveryInfo DISCOVERY_INFO = {"homeassistant", true, false};
+        static const std::string TOPIC_PREFIX = "bridge";
+
+        bool MQTTClientComponent::publish(const std::string &topic, const std::string &payload, uint8_t qos, bool retain)
+        {
+            return this->publish(topic, payload.data(), payload.size(), qos, retain);
+        }
+
+        bool MQTTClientComponent::publish(const std::string &topic, const char *payload, size_t payload_length,
+                                          uint8_t qos, bool retain)
+        {
+            if (!host::mqtt_connected) {
+                return false;
+            }
+            host::publish_total++;
+            if (host::record_publishes) {
+                host::publish_log.push_back({topic, std::string(payload, payload_length), qos, retain});
+            }
+            return true;
+        }
+
+        const MQTTDiscoveryInfo &MQTTClientComponent::get_discovery_info() const { return DISCOVERY_INFO; }
+        bool MQTTClientComponent::is_connected() { return host::mqtt_connected; }
+        const std::string &MQTTClientComponent::get_topic_prefix() const { return TOPIC_PREFIX; }
+
+        void MQTTClientComponent::subscribe(const std::string &topic, mqtt_callback_t callback, uint8_t qos)
+        {
+            host::subscriptions.push_back({topic, std::move(callback)});
+        }
+    } // namespace mqtt
+} // namespace esphome
+
+// =============================================================================
+// ESP-IDF
+// =============================================================================
+
+using namespace esphome;
+
+const char *esp_err_to_name(esp_err_t err) { return err == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+esp_err_t esp_netif_init() { return ESP_OK; }
+esp_err_t esp_event_loop_create_default() { return ESP_OK; }
+esp_err_t esp_wifi_init(const wifi_init_config_t *config) { return ESP_OK; }
+esp_err_t esp_wifi_set_storage(wifi_storage_t storage) { return ESP_OK; }
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) { return ESP_OK; }
+esp_err_t esp_wifi_start() { return ESP_OK; }
+esp_err_t esp_wifi_set_protocol(wifi_interface_t ifx, uint8_t protocol) { return ESP_OK; }
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+    host::wifi_channel = primary;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second)
+{
+    *primary = host::wifi_channel;
+    *second = WIFI_SECOND_CHAN_NONE;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t *mac)
+{
+    static const uint8_t HOST_MAC[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    memcpy(mac, HOST_MAC, 6);
+    return ESP_OK;
+}
+
+esp_err_t esp_now_init() { return ESP_OK; }
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer) { return ESP_OK; }
+esp_err_t esp_now_del_peer(const uint8_t *mac) { return ESP_OK; }
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t callback)
+{
+    host::send_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t callback)
+{
+    host::receive_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t *mac, const uint8_t *data, size_t len)
+{
+    host::send_total++;
+    if (!host::record_sends) {
+        memcpy(host::unrecorded_mac, mac, 6);
+        host::unrecorded_pending++;
+        return ESP_OK;
+    }
+    host::Send send;
+    memcpy(send.mac, mac, 6);
+    send.data.assign(data, data + len);
+    host::send_log.push_back(std::move(send));
+    return ESP_OK;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esp_now.h"
+
+namespace esphome
+{
+    namespace host
+    {
+        // =============================================================================
+        // Host Harness
+        // =============================================================================
+        // What the stubs record and how tests drive them. State is global like on the
+        // chip; reset() puts all of it back, except preferences (flash survives a
+        // restart unless clear_preferences() is called).
+
+        struct Publish {
+            std::string topic;
+            std::string payload;
+            uint8_t qos;
+            bool retain;
+        };
+
+        struct Send {
+            uint8_t mac[6];
+            std::vector<uint8_t> data;
+        };
+
+        void reset();
+
+        // Clock: millis() / micros() only move when told to
+        void set_time_us(uint64_t us);
+        void advance_ms(uint32_t ms);
+
+        // Logging: lines at or below the level are printed, all warnings are counted
+        void set_log_level(int level);
+        uint32_t warnings();
+
+        // MQTT: publishes are recorded (or only counted, which is cheaper)
+        void set_mqtt_connected(bool connected);
+        void set_record_publishes(bool record);
+        std::vector<Publish> &publishes();
+        uint32_t publish_count();
+        const Publish *last_publish(const std::string &topic);
+        // Delivers a message to the matching subscription; false if there is none
+        bool deliver_mqtt(const std::string &topic, const std::string &payload);
+
+        // ESP-NOW: sends are recorded (or only counted, which does not allocate) and
+        // complete from complete_sends()
+        void set_record_sends(bool record);
+        std::vector<Send> &sends();
+        uint32_t send_count();
+        void complete_sends(bool success);
+        // Marks the outstanding sends complete without a callback, as if it got lost
+        void lose_sends();
+        // Hands a frame to the registered receive callback, as the Wi-Fi task would
+        void receive(const uint8_t *mac, const uint8_t *data, size_t len, int8_t rssi = -60);
+        uint8_t channel();
+
+        // Flash: the preference store, by type
+        std::map<uint32_t, std::vector<uint8_t>> &preferences();
+        uint32_t preference_writes();
+        void clear_preferences();
+
+    } // namespace host
+} // namespace esphome
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "esphome/components/now_mqtt_protocol/codec.h"
+
+namespace esphome
+{
+    namespace host
+    {
+        // One of each kind of payload the bridge receives, for fuzzers to start from
+        inline std::vector<std::vector<uint8_t>> frame_seeds()
+        {
+            using namespace now_mqtt_protocol;
+            std::vector<std::vector<uint8_t>> seeds;
+            auto add = [&seeds](const uint8_t *data, size_t len) { seeds.emplace_back(data, data + len); };
+            auto add_text = [&seeds](const std::string &line) { seeds.emplace_back(line.begin(), line.end()); };
+
+            add_text("garden:temperature:measurement:temperature:°C:21.50:mdi:thermometer:2024.6.0:esp32dev:");
+            add_text("garden::binary_sensor:door::ON:mdi:door:2024.6.0:esp32dev:");
+            add_text("garden\\:shed:::mode::eco\\:night:mdi:leaf:2024.6.0:esp32dev:");
+            add_text("not:enough:fields");
+
+            uint8_t buffer[MAX_MESSAGE_SIZE];
+            NodeInfo node = {"garden", "2024.6.0", "esp32dev", 60};
+            EntityMeta meta;
+            meta.device_class = "temperature";
+            meta.state_class = "measurement";
+            meta.unit = "°C";
+            meta.accuracy = 1;
+            meta.has_accuracy = true;
+
+            FrameWriter full(buffer, MAX_FRAME_SIZE);
+            full.begin(node, FLAG_SEQUENCE | FLAG_PAIR_REQUEST);
+            full.set_sequence(1, 2);
+            full.add_sensor("temperature", meta, 21.5f);
+            full.add_binary_sensor("door", {}, true);
+            full.add_text_sensor("mode", {}, "eco");
+            add(full.data(), full.size());
+
+            uint8_t prefix_data[64];
+            EntityMeta known;
+            known.device_class = "temperature";
+            RecordPrefix prefix = {prefix_data, encode_record_prefix(prefix_data, sizeof(prefix_data),
+                                                                     ReadingType::SENSOR, "temperature", known)};
+            FrameWriter compact(buffer, MAX_FRAME_SIZE);
+            compact.begin_compact(schema_id(prefix.data, prefix.len) | 1);
+            uint8_t ref[SCHEMA_REF_SIZE];
+            encode_schema_ref(ref, sizeof(ref), schema_id(prefix.data, prefix.len) | 1);
+            compact.add_sensor({ref, sizeof(ref)}, 20.0f);
+            compact.add_sensor({ref, sizeof(ref)}, 19.0f, 300);
+            add(compact.data(), compact.size());
+
+            // A message over several fragments
+            FrameWriter large(buffer, sizeof(buffer));
+            large.begin(node);
+            for (int i = 0; i < 40 && large.add_sensor("sensor_" + std::to_string(i), meta, i); i++) {
+            }
+            uint8_t fragment[MAX_FRAME_SIZE];
+            for (size_t i = 0; i < fragment_count(large.size()); i++) {
+                add(fragment, encode_fragment(fragment, sizeof(fragment), 7, large.data(), large.size(), i));
+            }
+
+            static const uint8_t MAC[6] = {0x24, 0x6F, 0x28, 0x01, 0x02, 0x03};
+            uint8_t control[PAIR_ACK_SIZE];
+            add(control, encode_pair_ack(control, sizeof(control), MAC, 6));
+            add(control, encode_schema_request(control, sizeof(control), MAC));
+            add(control, encode_probe(control, sizeof(control)));
+            return seeds;
+        }
+
+    } // namespace host
+} // namespace esphome
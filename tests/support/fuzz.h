@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// =============================================================================
+// Fuzz Targets
+// =============================================================================
+// Each fuzz/<name>.cpp defines the libFuzzer entry point and a seed corpus of
+// valid inputs. Built with clang it becomes a libFuzzer binary; everywhere it is
+// also linked into <name>_test, which replays the seeds, seeded mutations of them
+// and random buffers (see unit/fuzz_driver.cpp). A broken invariant aborts, which
+// both report as a crash with the input that caused it.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+std::vector<std::vector<uint8_t>> fuzz_seeds();
+
+#define FUZZ_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: fuzz invariant failed: %s\n", __FILE__, __LINE__, #condition); \
+            abort(); \
+        } \
+    } while (0)
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "host.h"
+#include "esphome/core/log.h"
+#include "esphome/components/now_mqtt_protocol/codec.h"
+
+namespace esphome
+{
+    namespace host
+    {
+        // =============================================================================
+        // Frames
+        // =============================================================================
+
+        struct V1Fields {
+            std::string node = "garden";
+            std::string device_class;
+            std::string state_class = "measurement";
+            std::string name = "temperature";
+            std::string unit;
+            std::string state = "21.50";
+            std::string icon;  // "mdi:thermometer", split over two fields
+            std::string version = "2024.6.0";
+            std::string board = "esp32dev";
+        };
+
+        // node:device_class:state_class:name:unit:state:icon_prefix:icon:version:board:reserved
+        inline std::string v1_frame(const V1Fields &f)
+        {
+            std::string icon = f.icon.find(':') == std::string::npos ? f.icon + ":" : f.icon;
+            return f.node + ":" + f.device_class + ":" + f.state_class + ":" + f.name + ":" + f.unit + ":" + f.state +
+                   ":" + icon + ":" + f.version + ":" + f.board + ":";
+        }
+
+        // A v2 frame built record by record; begin() once, then add through writer()
+        class V2Frame
+        {
+        public:
+            explicit V2Frame(const now_mqtt_protocol::NodeInfo &node, uint8_t flags = 0)
+                : writer_(this->buffer_, sizeof(this->buffer_))
+            {
+                this->writer_.begin(node, flags);
+            }
+
+            now_mqtt_protocol::FrameWriter &writer() { return this->writer_; }
+            const uint8_t *data() const { return this->writer_.data(); }
+            size_t size() const { return this->writer_.size(); }
+
+        protected:
+            uint8_t buffer_[now_mqtt_protocol::MAX_MESSAGE_SIZE];
+            now_mqtt_protocol::FrameWriter writer_;
+        };
+
+        inline void mac_for(uint32_t index, uint8_t *mac)
+        {
+            mac[0] = 0x24;
+            mac[1] = 0x6F;
+            mac[2] = 0x28;
+            mac[3] = index >> 16;
+            mac[4] = index >> 8;
+            mac[5] = index;
+        }
+
+        inline void receive(const uint8_t *mac, const std::string &frame)
+        {
+            receive(mac, reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+        }
+
+        inline size_t count_publishes(const std::string &suffix)
+        {
+            size_t count = 0;
+            for (const auto &publish : publishes()) {
+                if (publish.topic.size() >= suffix.size() &&
+                    publish.topic.compare(publish.topic.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                    count++;
+                }
+            }
+            return count;
+        }
+
+    } // namespace host
+} // namespace esphome
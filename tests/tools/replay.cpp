@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt_bridge/capture.h"
+#include "esphome/components/now_mqtt_bridge/now_mqtt_bridge.h"
+
+using namespace esphome;
+using namespace esphome::now_mqtt_bridge;
+
+// Replays a capture trace (capture.h) through a host bridge at 1x, 10x and as
+// fast as loop() drains it, against the stub MQTT client. Frames go in through
+// the ESP-NOW receive callback, so on_espnow_receive_ runs from loop() behind the
+// ingest ring as on the chip. The host clock follows the trace; latency is wall
+// time from when a frame was due to the end of the loop() that handled it.
+//
+//   replay [--speed 1|10|max|all] [trace files...]
+//
+// Files are read in order as slices of one stream, like capture/load. Without
+// any, a synthetic trace of v1 and sequenced v2 nodes is replayed.
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct TraceFrame {
+        RawFrame frame;
+        uint64_t time_us;  // Since the first frame
+    };
+
+    struct Result {
+        size_t frames = 0;
+        uint32_t publishes = 0;
+        double seconds = 0;
+        std::vector<double> latency_us;
+    };
+
+    static constexpr int NODES = 24;
+    static constexpr int ROUNDS = 16;
+    static constexpr uint32_t FRAME_SPACING_US = 2500;
+
+    bool load_trace(const std::vector<uint8_t> &stream, std::vector<TraceFrame> *frames)
+    {
+        TraceParser parser;
+        parser.reset();
+        uint32_t last_rx_us = 0;
+        uint64_t time_us = 0;
+        bool ok = parser.feed(stream.data(), stream.size(), [&](const RawFrame &frame) {
+            // A trace that follows another starts over at 0
+            time_us += frame.rx_us >= last_rx_us ? frame.rx_us - last_rx_us : frame.rx_us;
+            last_rx_us = frame.rx_us;
+            frames->push_back({frame, time_us});
+        });
+        return ok && parser.idle();
+    }
+
+    bool read_file(const char *path, std::vector<uint8_t> *stream)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        stream->insert(stream->end(), std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    // Every fourth node speaks v1, one frame per reading; the rest send three
+    // readings per sequenced v2 frame. Encoded through a capture ring, like a dump.
+    std::vector<uint8_t> synthetic_trace()
+    {
+        std::vector<uint8_t> ring_buffer(NODES * ROUNDS * TRACE_MAX_RECORD_SIZE);
+        CaptureRing ring;
+        ring.init(ring_buffer.data(), ring_buffer.size());
+        uint32_t rx_us = 0;
+        for (int round = 0; round < ROUNDS; round++) {
+            for (int node = 0; node < NODES; node++) {
+                RawFrame frame;
+                host::mac_for(node + 1, frame.mac);
+                frame.rssi = -40 - node;
+                frame.rx_us = rx_us;
+                rx_us += FRAME_SPACING_US;
+                char name[16];
+                snprintf(name, sizeof(name), "node%02d", node);
+                float value = 20.0f + node + round * 0.25f;
+                if (node % 4 == 0) {
+                    host::V1Fields fields;
+                    fields.node = name;
+                    fields.device_class = "temperature";
+                    fields.unit = "°C";
+                    char state[16];
+                    snprintf(state, sizeof(state), "%.2f", value);
+                    fields.state = state;
+                    std::string line = host::v1_frame(fields);
+                    frame.len = line.size();
+                    memcpy(frame.data, line.data(), line.size());
+                } else {
+                    now_mqtt_protocol::NodeInfo info = {name, "2024.6.0", "esp32dev", 60};
+                    host::V2Frame v2(info, now_mqtt_protocol::FLAG_SEQUENCE);
+                    v2.writer().set_sequence(node, round);
+                    now_mqtt_protocol::EntityMeta meta;
+                    meta.device_class = "temperature";
+                    meta.state_class = "measurement";
+                    meta.unit = "°C";
+                    v2.writer().add_sensor("temperature", meta, value);
+                    meta.device_class = "humidity";
+                    meta.unit = "%";
+                    v2.writer().add_sensor("humidity", meta, 40.0f + round);
+                    v2.writer().add_binary_sensor("door", {}, round % 2 == 0);
+                    frame.len = v2.size();
+                    memcpy(frame.data, v2.data(), v2.size());
+                }
+                ring.push(frame);
+            }
+        }
+
+        std::vector<uint8_t> stream;
+        TraceEncoder encoder;
+        encoder.start(&ring);
+        uint8_t slice[1024];
+        while (size_t len = encoder.read(slice, sizeof(slice))) {
+            stream.insert(stream.end(), slice, slice + len);
+        }
+        return stream;
+    }
+
+    double elapsed_us(Clock::time_point start, Clock::time_point at)
+    {
+        return std::chrono::duration<double, std::micro>(at - start).count();
+    }
+
+    // Sleeps most of the way, then spins, so frames go in close to their due time
+    void wait_until(Clock::time_point due)
+    {
+        auto spin = std::chrono::microseconds(200);
+        if (due - Clock::now() > spin) {
+            std::this_thread::sleep_until(due - spin);
+        }
+        while (Clock::now() < due) {
+        }
+    }
+
+    // speed 0: as fast as loop() drains the ingest ring
+    Result replay(const std::vector<TraceFrame> &frames, uint32_t speed)
+    {
+        host::reset();
+        host::clear_preferences();
+        host::set_log_level(host::LOG_LEVEL_NONE);
+        host::set_record_publishes(false);
+        auto bridge = std::make_unique<Now_MQTT_BridgeComponent>();
+        bridge->setup();
+        bridge->loop();
+        uint64_t base_us = 1000000;  // Past anything the bridge did during setup
+        uint32_t base_publishes = host::publish_count();
+
+        Result result;
+        std::vector<double> due_us;  // Per frame handed in, oldest first
+        due_us.reserve(frames.size());
+        size_t handled = 0;
+        Clock::time_point start = Clock::now();
+        size_t next = 0;
+        while (next < frames.size() || handled < next) {
+            // Hand in what is due, without overrunning the ring: a slow bridge makes the replay late, not lossy
+            if (speed != 0 && next < frames.size() && bridge->get_ingest_depth() == 0) {
+                wait_until(start + std::chrono::microseconds(frames[next].time_us / speed));
+            }
+            double now_us = elapsed_us(start, Clock::now());
+            while (next < frames.size() && bridge->get_ingest_depth() < INGEST_QUEUE_SIZE) {
+                double due = speed == 0 ? now_us : double(frames[next].time_us) / speed;
+                if (due > now_us) {
+                    break;
+                }
+                const RawFrame &frame = frames[next].frame;
+                host::set_time_us(base_us + frames[next].time_us);
+                host::receive(frame.mac, frame.data, frame.len, frame.rssi);
+                due_us.push_back(due);
+                next++;
+            }
+            bridge->loop();
+            double done_us = elapsed_us(start, Clock::now());
+            for (size_t drained = next - bridge->get_ingest_depth(); handled < drained; handled++) {
+                result.latency_us.push_back(done_us - due_us[handled]);
+            }
+        }
+        result.seconds = elapsed_us(start, Clock::now()) / 1e6;
+        result.frames = handled;
+        result.publishes = host::publish_count() - base_publishes;
+        if (bridge->get_ingest_dropped() != 0) {
+            fprintf(stderr, "replay: %u frames dropped by the ingest ring\n", bridge->get_ingest_dropped());
+        }
+        return result;
+    }
+
+    double percentile(const std::vector<double> &sorted, double p)
+    {
+        if (sorted.empty()) {
+            return 0;
+        }
+        size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[rank];
+    }
+
+    void print(const char *label, Result result)
+    {
+        std::sort(result.latency_us.begin(), result.latency_us.end());
+        printf("%-6s %8zu %10u %9.3f %12.0f %10.1f %10.1f %10.1f\n", label, result.frames, result.publishes,
+               result.seconds, result.publishes / result.seconds, percentile(result.latency_us, 0.50),
+               percentile(result.latency_us, 0.95), percentile(result.latency_us, 0.99));
+    }
+
+    int usage()
+    {
+        fprintf(stderr, "usage: replay [--speed 1|10|max|all] [trace files...]\n");
+        return 2;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string speed = "all";
+    std::vector<uint8_t> stream;
+    bool have_files = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = argv[++i];
+            if (speed != "1" && speed != "10" && speed != "max" && speed != "all") {
+                return usage();
+            }
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            if (!read_file(argv[i], &stream)) {
+                fprintf(stderr, "replay: cannot read %s\n", argv[i]);
+                return 1;
+            }
+            have_files = true;
+        }
+    }
+    if (!have_files) {
+        stream = synthetic_trace();
+    }
+
+    std::vector<TraceFrame> frames;
+    if (!load_trace(stream, &frames)) {
+        fprintf(stderr, "replay: not a complete trace (%zu frames read)\n", frames.size());
+        return 1;
+    }
+    printf("%zu frames over %.3f s\n", frames.size(), frames.empty() ? 0.0 : frames.back().time_us / 1e6);
+    printf("%-6s %8s %10s %9s %12s %10s %10s %10s\n", "speed", "frames", "publishes", "seconds", "msgs/s",
+           "p50_us", "p95_us", "p99_us");
+    if (speed == "1" || speed == "all") {
+        print("1x", replay(frames, 1));
+    }
+    if (speed == "10" || speed == "all") {
+        print("10x", replay(frames, 10));
+    }
+    if (speed == "max" || speed == "all") {
+        print("max", replay(frames, 0));
+    }
+    return 0;
+}
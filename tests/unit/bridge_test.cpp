@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt_bridge/now_mqtt_bridge.h"
+
+using namespace esphome;
+using esphome::now_mqtt_bridge::Now_MQTT_BridgeComponent;
+
+namespace
+{
+    class BridgeTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            host::reset();
+            host::clear_preferences();
+            this->bridge = std::make_unique<Now_MQTT_BridgeComponent>();
+            this->bridge->setup();
+            this->bridge->loop();
+            host::mac_for(1, this->mac);
+        }
+
+        void receive(const std::string &frame)
+        {
+            host::receive(this->mac, frame);
+            this->bridge->loop();
+        }
+
+        void receive(const host::V2Frame &frame)
+        {
+            host::receive(this->mac, frame.data(), frame.size());
+            this->bridge->loop();
+        }
+
+        std::unique_ptr<Now_MQTT_BridgeComponent> bridge;
+        uint8_t mac[6];
+    };
+
+    TEST_F(BridgeTest, V1FramePublishesDiscoveryAndState)
+    {
+        host::V1Fields fields;
+        fields.device_class = "temperature";
+        fields.unit = "°C";
+        fields.icon = "mdi:thermometer";
+        this->receive(host::v1_frame(fields));
+
+        const host::Publish *config = host::last_publish("homeassistant/sensor/garden/temperature/config");
+        ASSERT_NE(config, nullptr);
+        EXPECT_TRUE(config->retain);
+        EXPECT_NE(config->payload.find("\"icon\":\"mdi:thermometer\""), std::string::npos);
+        EXPECT_NE(config->payload.find("\"stat_t\":\"garden/sensor/temperature/state\""), std::string::npos);
+
+        const host::Publish *state = host::last_publish("garden/sensor/temperature/state");
+        ASSERT_NE(state, nullptr);
+        EXPECT_EQ(state->payload, "21.50");
+
+        const host::Publish *status = host::last_publish("garden/status");
+        ASSERT_NE(status, nullptr);
+        EXPECT_EQ(status->payload, "online");
+        EXPECT_EQ(this->bridge->get_frames_received(), 1u);
+    }
+
+    TEST_F(BridgeTest, V1EscapedDelimitersAreKept)
+    {
+        host::V1Fields fields;
+        fields.name = "mode";
+        fields.state = "12\\:30";
+        fields.icon = "mdi\\:clock:";
+        this->receive(host::v1_frame(fields));
+
+        const host::Publish *config = host::last_publish("homeassistant/sensor/garden/mode/config");
+        ASSERT_NE(config, nullptr);
+        EXPECT_NE(config->payload.find("\"icon\":\"mdi:clock\""), std::string::npos);
+        ASSERT_NE(host::last_publish("garden/sensor/mode/state"), nullptr);
+        EXPECT_EQ(host::last_publish("garden/sensor/mode/state")->payload, "12:30");
+    }
+
+    TEST_F(BridgeTest, V2FramePublishesEveryReading)
+    {
+        now_mqtt_protocol::NodeInfo node = {"porch", "2024.6.0", "esp32dev", 60};
+        host::V2Frame frame(node);
+        now_mqtt_protocol::EntityMeta meta;
+        meta.device_class = "humidity";
+        meta.unit = "%";
+        meta.accuracy = 1;
+        meta.has_accuracy = true;
+        ASSERT_TRUE(frame.writer().add_sensor("humidity", meta, 48.25f));
+        ASSERT_TRUE(frame.writer().add_binary_sensor("door", {}, true));
+        ASSERT_TRUE(frame.writer().add_text_sensor("mode", {}, "eco"));
+        this->receive(frame);
+
+        ASSERT_NE(host::last_publish("porch/sensor/humidity/state"), nullptr);
+        EXPECT_EQ(host::last_publish("porch/sensor/humidity/state")->payload, "48.2");
+        ASSERT_NE(host::last_publish("porch/binary_sensor/door/state"), nullptr);
+        EXPECT_EQ(host::last_publish("porch/binary_sensor/door/state")->payload, "ON");
+        // Home Assistant shows text readings as sensors with a string state
+        ASSERT_NE(host::last_publish("porch/sensor/mode/state"), nullptr);
+        EXPECT_EQ(host::last_publish("porch/sensor/mode/state")->payload, "eco");
+        EXPECT_EQ(host::count_publishes("/config"), 3u);
+    }
+
+    TEST_F(BridgeTest, DiscoveryIsCachedUntilHomeAssistantRestarts)
+    {
+        // Unsequenced v1 frames repeat only after the retry window
+        std::string frame = host::v1_frame({});
+        this->receive(frame);
+        host::advance_ms(now_mqtt_bridge::DUPLICATE_WINDOW_MS);
+        this->receive(frame);
+        EXPECT_EQ(host::count_publishes("/config"), 1u);
+        EXPECT_EQ(host::count_publishes("/state"), 2u);
+
+        ASSERT_TRUE(host::deliver_mqtt("homeassistant/status", "online"));
+        host::advance_ms(now_mqtt_bridge::DUPLICATE_WINDOW_MS);
+        this->receive(frame);
+        EXPECT_EQ(host::count_publishes("/config"), 2u);
+    }
+
+    TEST_F(BridgeTest, PairRequestIsAnswered)
+    {
+        now_mqtt_protocol::NodeInfo node = {"attic", "2024.6.0", "esp32dev", 0};
+        host::V2Frame frame(node, now_mqtt_protocol::FLAG_PAIR_REQUEST);
+        ASSERT_TRUE(frame.writer().add_sensor("temperature", {}, 18.0f));
+        this->receive(frame);
+
+        ASSERT_EQ(host::sends().size(), 1u);
+        uint8_t node_mac[6];
+        uint8_t channel;
+        const std::vector<uint8_t> &ack = host::sends()[0].data;
+        ASSERT_TRUE(now_mqtt_protocol::decode_pair_ack(ack.data(), ack.size(), node_mac, &channel));
+        EXPECT_EQ(memcmp(node_mac, this->mac, 6), 0);
+        EXPECT_EQ(this->bridge->get_pair_acks_sent(), 1u);
+    }
+
+    TEST_F(BridgeTest, MalformedFramesAreCounted)
+    {
+        this->receive("not:enough:fields");
+        EXPECT_EQ(this->bridge->get_parse_errors(), 1u);
+        EXPECT_EQ(host::count_publishes("/state"), 0u);
+    }
+
+} // namespace
@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt/channel_scanner.h"
+#include "esphome/components/now_mqtt/now_mqtt.h"
+#include "esphome/core/application.h"
+
+using namespace esphome;
+using esphome::now_mqtt::ChannelScanner;
+using esphome::now_mqtt::Now_MQTTComponent;
+
+// The channel search against a simulated radio: a bridge sits on one channel and
+// hears a probe only when the node is tuned there, and replies get lost at a
+// given rate. The scanner is driven on its own first, then inside the sender.
+// Runs are seeded, so a failure replays exactly.
+
+namespace
+{
+    static constexpr uint32_t DWELL_MS = 60;
+    static constexpr uint32_t TICK_MS = 10;
+
+    // A bridge on one channel; replies arrive within the dwell or not at all
+    struct SimulatedRadio {
+        uint8_t bridge_channel;
+        double loss = 0.0;
+        std::mt19937 rng{1};
+
+        bool answers(uint8_t tuned)
+        {
+            return tuned == this->bridge_channel && std::uniform_real_distribution<>(0, 1)(this->rng) >= this->loss;
+        }
+    };
+
+    struct ScanResult {
+        std::vector<uint8_t> probed;
+        uint32_t elapsed_ms = 0;
+    };
+
+    ScanResult run_scan(ChannelScanner &scanner, SimulatedRadio &radio, uint8_t first_channel)
+    {
+        ScanResult result;
+        uint32_t now = 1000;
+        scanner.start(first_channel, now);
+        while (scanner.scanning()) {
+            uint8_t channel = scanner.poll(now);
+            if (channel != 0) {
+                result.probed.push_back(channel);
+                if (radio.answers(channel)) {
+                    scanner.on_reply(radio.bridge_channel);
+                }
+            }
+            now += TICK_MS;
+        }
+        result.elapsed_ms = now - 1000;
+        return result;
+    }
+
+    std::vector<uint8_t> channels(std::initializer_list<std::pair<uint8_t, uint8_t>> ranges)
+    {
+        std::vector<uint8_t> out;
+        for (const auto &range : ranges) {
+            for (uint8_t channel = range.first; channel <= range.second; channel++) {
+                out.push_back(channel);
+            }
+        }
+        return out;
+    }
+
+    TEST(ChannelScannerTest, SweepOrderWrapsFromTheStartChannel)
+    {
+        SimulatedRadio radio{0};  // Nobody answers
+        ChannelScanner scanner({DWELL_MS, 1});
+
+        EXPECT_EQ(run_scan(scanner, radio, 5).probed, channels({{5, 13}, {1, 4}}));
+        EXPECT_EQ(run_scan(scanner, radio, 1).probed, channels({{1, 13}}));
+        EXPECT_EQ(run_scan(scanner, radio, 13).probed, channels({{13, 13}, {1, 12}}));
+        // Channel 14 is swept only by a scan that starts there
+        EXPECT_EQ(run_scan(scanner, radio, 14).probed, channels({{14, 14}, {1, 13}}));
+        EXPECT_EQ(scanner.last_channel(), 14);
+        // An invalid start channel sweeps from 1
+        EXPECT_EQ(run_scan(scanner, radio, 0).probed, channels({{1, 13}}));
+        EXPECT_EQ(run_scan(scanner, radio, 15).probed, channels({{1, 13}}));
+    }
+
+    TEST(ChannelScannerTest, FindsTheBridgeFromAnyStartChannel)
+    {
+        for (uint8_t bridge = 1; bridge <= ChannelScanner::MAX_CHANNEL; bridge++) {
+            for (uint8_t first = 1; first <= ChannelScanner::MAX_CHANNEL; first++) {
+                SimulatedRadio radio{bridge};
+                ChannelScanner scanner({DWELL_MS, 2});
+                ScanResult result = run_scan(scanner, radio, first);
+                if (bridge == 14 && first != 14) {
+                    EXPECT_TRUE(scanner.exhausted()) << "bridge " << +bridge << ", first " << +first;
+                    continue;
+                }
+                ASSERT_TRUE(scanner.found()) << "bridge " << +bridge << ", first " << +first;
+                EXPECT_EQ(scanner.result(), bridge);
+                EXPECT_EQ(result.probed.back(), bridge);
+                // Within the first sweep, and never the same channel twice
+                uint8_t count = first == 14 ? 14 : 13;
+                EXPECT_EQ(result.probed.size(), 1u + (bridge - first + count) % count);
+            }
+        }
+    }
+
+    TEST(ChannelScannerTest, ExhaustsAfterMaxSweeps)
+    {
+        SimulatedRadio radio{0};
+        ChannelScanner scanner({DWELL_MS, 3});
+        ScanResult result = run_scan(scanner, radio, 7);
+        EXPECT_TRUE(scanner.exhausted());
+        EXPECT_FALSE(scanner.found());
+        EXPECT_EQ(result.probed.size(), 3u * 13);
+        EXPECT_EQ(scanner.probes(), 3u * 13);
+        // Every channel got its full dwell
+        EXPECT_GE(result.elapsed_ms, 3u * 13 * DWELL_MS);
+        EXPECT_EQ(scanner.poll(UINT32_MAX / 2), 0);
+
+        // A late reply does not turn it into a find
+        scanner.on_reply(7);
+        EXPECT_TRUE(scanner.exhausted());
+    }
+
+    TEST(ChannelScannerTest, RepliesOutsideAScanAreIgnored)
+    {
+        ChannelScanner scanner({DWELL_MS, 2});
+        scanner.on_reply(6);
+        EXPECT_FALSE(scanner.found());
+
+        scanner.start(3, 0);
+        scanner.on_reply(6);  // Before the first probe
+        EXPECT_TRUE(scanner.scanning());
+        EXPECT_EQ(scanner.poll(0), 3);
+        scanner.cancel();
+        scanner.on_reply(3);
+        EXPECT_FALSE(scanner.found());
+    }
+
+    TEST(ChannelScannerTest, ReplyNamesTheBridgeChannel)
+    {
+        // Adjacent channels overlap: a bridge on 7 can hear a probe sent on 6
+        ChannelScanner scanner({DWELL_MS, 2});
+        scanner.start(6, 0);
+        EXPECT_EQ(scanner.poll(0), 6);
+        scanner.on_reply(7);
+        ASSERT_TRUE(scanner.found());
+        EXPECT_EQ(scanner.result(), 7);
+
+        // No channel in the reply: the probed one
+        scanner.start(6, 0);
+        EXPECT_EQ(scanner.poll(0), 6);
+        scanner.on_reply(0);
+        EXPECT_EQ(scanner.result(), 6);
+    }
+
+    TEST(ChannelScannerTest, LossyRepliesAreFoundOnALaterSweep)
+    {
+        static constexpr int RUNS = 2000;
+        static constexpr uint8_t SWEEPS = 3;
+        SimulatedRadio radio{9, 0.5};
+        int found = 0;
+        for (int run = 0; run < RUNS; run++) {
+            ChannelScanner scanner({DWELL_MS, SWEEPS});
+            uint8_t first = 1 + run % 14;
+            ScanResult result = run_scan(scanner, radio, first);
+            ASSERT_LE(result.probed.size(), SWEEPS * (first == 14 ? 14u : 13u));
+            if (scanner.found()) {
+                EXPECT_EQ(scanner.result(), 9);
+                found++;
+            } else {
+                EXPECT_TRUE(scanner.exhausted());
+                EXPECT_EQ(std::count(result.probed.begin(), result.probed.end(), 9), SWEEPS);
+            }
+        }
+        // Each scan gets three tries at a one-in-two reply: 7 in 8 find the bridge
+        EXPECT_NEAR(found / double(RUNS), 0.875, 0.03);
+    }
+
+    // =============================================================================
+    // In the sender
+    // =============================================================================
+    // The node tunes the (stub) radio itself; the simulated bridge answers probes it
+    // hears with a PAIR_ACK. RTC link state lives as long as the process, so each
+    // test starts on its own wifi_channel.
+
+    class SenderScanTest : public ::testing::Test
+    {
+    protected:
+        static constexpr uint8_t BRIDGE_MAC[6] = {0x24, 0x6F, 0x28, 0xAA, 0xBB, 0xCC};
+
+        void start(uint8_t channel, SimulatedRadio radio)
+        {
+            host::reset();
+            this->radio = radio;
+            this->sensor.set_name("Temperature");
+            App.set_name("garden");
+            App.register_sensor(&this->sensor);
+            this->node = std::make_unique<Now_MQTTComponent>();
+            this->node->set_wifi_channel(channel);
+            this->node->set_unpair_after_failures(1);
+            this->node->setup();
+        }
+
+        // One unanswered reading starts the search; long enough for every sweep
+        void search()
+        {
+            this->sensor.publish_state(20.0f);
+            this->node->loop();
+            host::complete_sends(true);
+            uint32_t longest_ms = now_mqtt::SCAN_SWEEPS * ChannelScanner::MAX_CHANNEL * now_mqtt::SCAN_DWELL_MS;
+            for (uint32_t elapsed = 0; elapsed < 2 * longest_ms && !this->node->is_paired(); elapsed += TICK_MS) {
+                host::advance_ms(TICK_MS);
+                this->node->loop();
+                this->answer_probes();
+                host::complete_sends(true);
+            }
+        }
+
+        void answer_probes()
+        {
+            for (; this->seen_ < host::sends().size(); this->seen_++) {
+                const host::Send &send = host::sends()[this->seen_];
+                if (!now_mqtt_protocol::is_probe(send.data.data(), send.data.size())) {
+                    continue;
+                }
+                this->probed.push_back(host::channel());
+                if (this->radio.answers(host::channel())) {
+                    uint8_t own_mac[6];
+                    esp_wifi_get_mac(WIFI_IF_STA, own_mac);
+                    uint8_t ack[now_mqtt_protocol::PAIR_ACK_SIZE];
+                    size_t len = now_mqtt_protocol::encode_pair_ack(ack, sizeof(ack), own_mac,
+                                                                    this->radio.bridge_channel);
+                    host::receive(BRIDGE_MAC, ack, len);
+                }
+            }
+        }
+
+        sensor::Sensor sensor;
+        std::unique_ptr<Now_MQTTComponent> node;
+        SimulatedRadio radio{0};
+        std::vector<uint8_t> probed;
+        size_t seen_ = 0;
+    };
+
+    TEST_F(SenderScanTest, PairsOnTheBridgeChannel)
+    {
+        this->start(9, SimulatedRadio{4});
+        this->search();
+        ASSERT_TRUE(this->node->is_paired());
+        EXPECT_EQ(host::channel(), 4);
+        EXPECT_EQ(this->probed, channels({{9, 13}, {1, 4}}));
+    }
+
+    TEST_F(SenderScanTest, StartingOnChannel14SweepsIt)
+    {
+        this->start(14, SimulatedRadio{6});
+        this->search();
+        ASSERT_TRUE(this->node->is_paired());
+        EXPECT_EQ(host::channel(), 6);
+        EXPECT_EQ(this->probed, channels({{14, 14}, {1, 6}}));
+    }
+
+    TEST_F(SenderScanTest, UnreachableBridgeExhaustsAndStays)
+    {
+        // A bridge on 14 is out of reach of a sweep that starts elsewhere
+        this->start(5, SimulatedRadio{14});
+        this->search();
+        EXPECT_FALSE(this->node->is_paired());
+        EXPECT_EQ(host::channel(), 5);
+        EXPECT_EQ(this->probed.size(), now_mqtt::SCAN_SWEEPS * 13u);
+        EXPECT_EQ(std::count(this->probed.begin(), this->probed.end(), 14), 0);
+    }
+
+    TEST_F(SenderScanTest, LossyRepliesStillPair)
+    {
+        SimulatedRadio radio{2, 0.5};
+        radio.rng.seed(3);
+        this->start(11, radio);
+        this->search();
+        ASSERT_TRUE(this->node->is_paired());
+        EXPECT_EQ(host::channel(), 2);
+        // The seed loses the first reply; the second sweep gets through
+        EXPECT_EQ(this->probed, channels({{11, 13}, {1, 13}, {1, 2}}));
+    }
+
+} // namespace
@@ -0,0 +1,561 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt_protocol/codec.h"
+
+using namespace esphome;
+using namespace esphome::now_mqtt_protocol;
+
+// The wire format on its own: whatever FrameWriter encodes, FrameReader gives
+// back, for every record type, with and without metadata, aged, compact and
+// fragmented; truncated or inconsistent input is rejected; v1 lines parse with
+// their escapes removed. And v2 is the smaller of the two.
+
+namespace
+{
+    const NodeInfo NODE = {"garden", "2024.6.0", "esp32dev", 300};
+
+    EntityMeta temperature_meta()
+    {
+        EntityMeta meta;
+        meta.device_class = "temperature";
+        meta.state_class = "measurement";
+        meta.unit = "°C";
+        meta.icon = "mdi:thermometer";
+        meta.accuracy = 1;
+        meta.has_accuracy = true;
+        return meta;
+    }
+
+    void expect_meta(const EntityMeta &actual, const EntityMeta &expected)
+    {
+        EXPECT_EQ(actual.device_class, expected.device_class);
+        EXPECT_EQ(actual.state_class, expected.state_class);
+        EXPECT_EQ(actual.unit, expected.unit);
+        EXPECT_EQ(actual.icon, expected.icon);
+        EXPECT_EQ(actual.has_accuracy, expected.has_accuracy);
+        if (expected.has_accuracy) {
+            EXPECT_EQ(actual.accuracy, expected.accuracy);
+        }
+    }
+
+    // A prefix encoded once, as the sender does in setup()
+    struct Prefix {
+        Prefix(ReadingType type, std::string_view name, const EntityMeta &meta)
+        {
+            this->len = encode_record_prefix(this->data, sizeof(this->data), type, name, meta);
+        }
+        RecordPrefix get() const { return {this->data, this->len}; }
+
+        uint8_t data[MAX_SCHEMA_SIZE];
+        size_t len;
+    };
+
+    // =============================================================================
+    // Full Frames
+    // =============================================================================
+
+    TEST(CodecTest, EveryRecordTypeRoundTrips)
+    {
+        uint8_t buffer[MAX_FRAME_SIZE];
+        FrameWriter writer(buffer, sizeof(buffer));
+        ASSERT_TRUE(writer.begin(NODE, FLAG_SEQUENCE));
+        ASSERT_TRUE(writer.set_sequence(0xBEEF, 513));
+        EntityMeta door;
+        door.device_class = "door";
+        EntityMeta none;
+        ASSERT_TRUE(writer.add_sensor("temperature", temperature_meta(), -12.75f));
+        ASSERT_TRUE(writer.add_binary_sensor("door", door, true));
+        ASSERT_TRUE(writer.add_text_sensor("mode", none, "eco: quiet"));
+        ASSERT_TRUE(writer.add_text_sensor("empty", none, ""));
+        EXPECT_EQ(writer.count(), 4);
+
+        FrameReader reader(writer.data(), writer.size());
+        ASSERT_TRUE(reader.valid());
+        EXPECT_TRUE(reader.has_sequence());
+        EXPECT_EQ(reader.boot_id(), 0xBEEF);
+        EXPECT_EQ(reader.sequence(), 513);
+        EXPECT_EQ(reader.count(), 4);
+        EXPECT_EQ(reader.node().name, "garden");
+        EXPECT_EQ(reader.node().version, "2024.6.0");
+        EXPECT_EQ(reader.node().board, "esp32dev");
+        EXPECT_EQ(reader.node().report_interval_s, 300u);
+
+        Reading reading;
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_EQ(reading.type, ReadingType::SENSOR);
+        EXPECT_EQ(reading.name, "temperature");
+        EXPECT_FLOAT_EQ(reading.value, -12.75f);
+        EXPECT_FALSE(reading.aged);
+        expect_meta(reading.meta, temperature_meta());
+
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_EQ(reading.type, ReadingType::BINARY_SENSOR);
+        EXPECT_EQ(reading.name, "door");
+        EXPECT_TRUE(reading.binary_value);
+        expect_meta(reading.meta, door);
+
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_EQ(reading.type, ReadingType::TEXT_SENSOR);
+        EXPECT_EQ(reading.text, "eco: quiet");
+        expect_meta(reading.meta, none);
+
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_EQ(reading.name, "empty");
+        EXPECT_EQ(reading.text, "");
+
+        EXPECT_FALSE(reader.next(&reading));
+        EXPECT_FALSE(reader.error());
+    }
+
+    TEST(CodecTest, PrefixedAndAgedRecordsRoundTrip)
+    {
+        Prefix sensor(ReadingType::SENSOR, "temperature", temperature_meta());
+        Prefix binary(ReadingType::BINARY_SENSOR, "motion", EntityMeta());
+        Prefix text(ReadingType::TEXT_SENSOR, "mode", EntityMeta());
+        ASSERT_GT(sensor.len, 0u);
+
+        uint8_t buffer[MAX_FRAME_SIZE];
+        FrameWriter writer(buffer, sizeof(buffer));
+        ASSERT_TRUE(writer.begin(NODE));
+        ASSERT_TRUE(writer.add_sensor(sensor.get(), 1.5f));
+        ASSERT_TRUE(writer.add_sensor(sensor.get(), 2.5f, 3600));
+        ASSERT_TRUE(writer.add_binary_sensor(binary.get(), false, 1));
+        ASSERT_TRUE(writer.add_text_sensor(text.get(), "away", UINT32_MAX));
+
+        FrameReader reader(writer.data(), writer.size());
+        ASSERT_TRUE(reader.valid());
+        Reading reading;
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_FALSE(reading.aged);
+        EXPECT_FLOAT_EQ(reading.value, 1.5f);
+        expect_meta(reading.meta, temperature_meta());
+        // The decoded prefix is the one the sender encoded
+        ASSERT_EQ(reading.prefix.len, sensor.len);
+        EXPECT_EQ(memcmp(reading.prefix.data, sensor.data, sensor.len), 0);
+
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_TRUE(reading.aged);
+        EXPECT_EQ(reading.age_s, 3600u);
+        EXPECT_FLOAT_EQ(reading.value, 2.5f);
+        EXPECT_EQ(reading.type, ReadingType::SENSOR);  // RECORD_AGED is not part of the type
+        // ...nor of the schema
+        EXPECT_EQ(schema_id(reading.prefix.data, reading.prefix.len), schema_id(sensor.data, sensor.len));
+
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_EQ(reading.type, ReadingType::BINARY_SENSOR);
+        EXPECT_TRUE(reading.aged);
+        EXPECT_EQ(reading.age_s, 1u);
+        EXPECT_FALSE(reading.binary_value);
+
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_EQ(reading.type, ReadingType::TEXT_SENSOR);
+        EXPECT_EQ(reading.age_s, UINT32_MAX);
+        EXPECT_EQ(reading.text, "away");
+        EXPECT_FALSE(reader.next(&reading));
+        EXPECT_FALSE(reader.error());
+    }
+
+    TEST(CodecTest, PrefixDecodesToItsMetadata)
+    {
+        Prefix prefix(ReadingType::SENSOR, "temperature", temperature_meta());
+        Reading reading;
+        ASSERT_TRUE(decode_record_prefix(prefix.data, prefix.len, &reading));
+        EXPECT_EQ(reading.name, "temperature");
+        expect_meta(reading.meta, temperature_meta());
+        EXPECT_FALSE(decode_record_prefix(prefix.data, prefix.len - 1, &reading));
+
+        uint8_t tiny[8];
+        EXPECT_EQ(encode_record_prefix(tiny, sizeof(tiny), ReadingType::SENSOR, "temperature", temperature_meta()), 0u);
+    }
+
+    TEST(CodecTest, HeaderReuseResetsTheRecordCount)
+    {
+        uint8_t header[MAX_FRAME_SIZE];
+        FrameWriter first(header, sizeof(header));
+        ASSERT_TRUE(first.begin(NODE, FLAG_SEQUENCE));
+        size_t header_len = first.size();
+
+        uint8_t buffer[MAX_FRAME_SIZE];
+        FrameWriter writer(buffer, sizeof(buffer));
+        for (uint16_t seq = 0; seq < 3; seq++) {
+            ASSERT_TRUE(writer.begin(header, header_len));
+            ASSERT_TRUE(writer.set_sequence(7, seq));
+            ASSERT_TRUE(writer.add_sensor("temperature", EntityMeta(), seq));
+            FrameReader reader(writer.data(), writer.size());
+            ASSERT_TRUE(reader.valid());
+            EXPECT_EQ(reader.count(), 1);
+            EXPECT_EQ(reader.sequence(), seq);
+        }
+    }
+
+    TEST(CodecTest, UnknownMetadataTagsAreSkipped)
+    {
+        // type, name, then a meta block with an unknown tag ahead of the unit
+        const uint8_t prefix[] = {uint8_t(ReadingType::SENSOR), 1, 't',  9,   0x7E, 2,
+                                  'x', 'y', META_UNIT, 3, 'k', 'P', 'a'};
+        Reading reading;
+        ASSERT_TRUE(decode_record_prefix(prefix, sizeof(prefix), &reading));
+        EXPECT_EQ(reading.name, "t");
+        EXPECT_EQ(reading.meta.unit, "kPa");
+    }
+
+    // =============================================================================
+    // Compact Frames
+    // =============================================================================
+
+    TEST(CodecTest, CompactRecordsResolveThroughTheirSchema)
+    {
+        Prefix sensor(ReadingType::SENSOR, "temperature", temperature_meta());
+        Prefix text(ReadingType::TEXT_SENSOR, "mode", EntityMeta());
+        uint32_t sensor_schema = schema_id(sensor.data, sensor.len);
+        uint32_t text_schema = schema_id(text.data, text.len);
+        EXPECT_NE(sensor_schema, 0u);
+        EXPECT_EQ(sensor_schema & 0x80000000u, 0u);
+        EXPECT_NE(sensor_schema, text_schema);
+
+        uint8_t node_block[MAX_FRAME_SIZE];
+        FrameWriter full(node_block, sizeof(node_block));
+        ASSERT_TRUE(full.begin(NODE));
+        FrameReader full_reader(full.data(), full.size());
+        ASSERT_TRUE(full_reader.valid());
+        uint32_t node_schema = schema_id(full_reader.node_block().data, full_reader.node_block().len);
+
+        uint8_t sensor_ref[SCHEMA_REF_SIZE], text_ref[SCHEMA_REF_SIZE];
+        ASSERT_EQ(encode_schema_ref(sensor_ref, sizeof(sensor_ref), sensor_schema), SCHEMA_REF_SIZE);
+        ASSERT_EQ(encode_schema_ref(text_ref, sizeof(text_ref), text_schema), SCHEMA_REF_SIZE);
+
+        uint8_t buffer[MAX_FRAME_SIZE];
+        FrameWriter writer(buffer, sizeof(buffer));
+        ASSERT_TRUE(writer.begin_compact(node_schema, FLAG_SEQUENCE));
+        ASSERT_TRUE(writer.add_sensor({sensor_ref, SCHEMA_REF_SIZE}, 20.25f));
+        ASSERT_TRUE(writer.add_sensor({sensor_ref, SCHEMA_REF_SIZE}, 19.0f, 600));
+        ASSERT_TRUE(writer.add_text_sensor({text_ref, SCHEMA_REF_SIZE}, "eco"));
+
+        auto lookup = [&](uint32_t schema, RecordPrefix *prefix) {
+            if (schema == sensor_schema) {
+                *prefix = sensor.get();
+            } else if (schema == text_schema) {
+                *prefix = text.get();
+            } else {
+                return false;
+            }
+            return true;
+        };
+        FrameReader reader(writer.data(), writer.size());
+        ASSERT_TRUE(reader.valid());
+        EXPECT_TRUE(reader.compact());
+        EXPECT_EQ(reader.node_schema(), node_schema);
+
+        Reading reading;
+        ASSERT_TRUE(reader.next(&reading, lookup));
+        EXPECT_EQ(reading.name, "temperature");
+        EXPECT_FLOAT_EQ(reading.value, 20.25f);
+        EXPECT_FALSE(reading.aged);
+        expect_meta(reading.meta, temperature_meta());
+        ASSERT_TRUE(reader.next(&reading, lookup));
+        EXPECT_TRUE(reading.aged);
+        EXPECT_EQ(reading.age_s, 600u);
+        EXPECT_FLOAT_EQ(reading.value, 19.0f);
+        ASSERT_TRUE(reader.next(&reading, lookup));
+        EXPECT_EQ(reading.text, "eco");
+        EXPECT_FALSE(reader.next(&reading, lookup));
+        EXPECT_EQ(reader.missing_schema(), 0u);
+
+        // A schema the bridge does not know ends decoding, and is reported
+        FrameReader unknown(writer.data(), writer.size());
+        auto forgetful = [](uint32_t, RecordPrefix *) { return false; };
+        EXPECT_FALSE(unknown.next(&reading, forgetful));
+        EXPECT_TRUE(unknown.error());
+        EXPECT_EQ(unknown.missing_schema(), sensor_schema);
+    }
+
+    // =============================================================================
+    // Fragments
+    // =============================================================================
+
+    TEST(CodecTest, FragmentsCarryTheWholeMessage)
+    {
+        std::vector<uint8_t> message(MAX_MESSAGE_SIZE);
+        for (size_t i = 0; i < message.size(); i++) {
+            message[i] = i * 13;
+        }
+        EXPECT_EQ(fragment_count(MAX_FRAME_SIZE), 1u);
+        EXPECT_EQ(fragment_count(MAX_FRAME_SIZE + 1), 2u);
+        EXPECT_EQ(fragment_count(MAX_MESSAGE_SIZE), MAX_FRAGMENTS);
+
+        for (size_t len : {MAX_FRAME_SIZE + 1, 2 * FRAGMENT_PAYLOAD_SIZE, MAX_MESSAGE_SIZE}) {
+            size_t total = fragment_count(len);
+            std::vector<uint8_t> joined;
+            for (size_t index = 0; index < total; index++) {
+                uint8_t frame[MAX_FRAME_SIZE];
+                size_t frame_len = encode_fragment(frame, sizeof(frame), 42, message.data(), len, index);
+                ASSERT_GT(frame_len, 0u);
+                EXPECT_TRUE(frame_flags(frame, frame_len) & FLAG_FRAGMENT);
+
+                Fragment fragment;
+                ASSERT_TRUE(decode_fragment(frame, frame_len, &fragment));
+                EXPECT_EQ(fragment.message_id, 42);
+                EXPECT_EQ(fragment.index, index);
+                EXPECT_EQ(fragment.total, total);
+                joined.insert(joined.end(), fragment.payload, fragment.payload + fragment.len);
+
+                // A fragment cut short is not a fragment
+                EXPECT_FALSE(decode_fragment(frame, frame_len - 1, &fragment) && index + 1 < total);
+            }
+            EXPECT_EQ(joined, std::vector<uint8_t>(message.begin(), message.begin() + len)) << len;
+        }
+
+        uint8_t frame[MAX_FRAME_SIZE];
+        EXPECT_EQ(encode_fragment(frame, sizeof(frame), 1, message.data(), MAX_MESSAGE_SIZE, MAX_FRAGMENTS), 0u);
+        EXPECT_EQ(encode_fragment(frame, sizeof(frame), 1, message.data(), MAX_MESSAGE_SIZE + 1, 0), 0u);
+    }
+
+    // =============================================================================
+    // Control Frames
+    // =============================================================================
+
+    TEST(CodecTest, ControlFramesRoundTrip)
+    {
+        const uint8_t node_mac[6] = {1, 2, 3, 4, 5, 6};
+        uint8_t frame[MAX_FRAME_SIZE];
+        uint8_t mac[6];
+        uint8_t channel;
+
+        size_t len = encode_pair_ack(frame, sizeof(frame), node_mac, 11);
+        ASSERT_EQ(len, PAIR_ACK_SIZE);
+        ASSERT_TRUE(decode_pair_ack(frame, len, mac, &channel));
+        EXPECT_EQ(memcmp(mac, node_mac, 6), 0);
+        EXPECT_EQ(channel, 11);
+        EXPECT_FALSE(decode_pair_ack(frame, len - 1, mac, &channel));
+        EXPECT_FALSE(is_probe(frame, len));
+
+        len = encode_probe(frame, sizeof(frame));
+        ASSERT_EQ(len, PROBE_SIZE);
+        EXPECT_TRUE(is_probe(frame, len));
+        EXPECT_FALSE(decode_pair_ack(frame, len, mac, &channel));
+
+        len = encode_schema_request(frame, sizeof(frame), node_mac);
+        ASSERT_EQ(len, SCHEMA_REQUEST_SIZE);
+        ASSERT_TRUE(decode_schema_request(frame, len, mac));
+        EXPECT_EQ(memcmp(mac, node_mac, 6), 0);
+        EXPECT_TRUE(frame_flags(frame, len) & FLAG_CONTROL);
+
+        // A control frame is not a data frame
+        FrameReader reader(frame, len);
+        EXPECT_FALSE(reader.valid());
+    }
+
+    // =============================================================================
+    // Rejection
+    // =============================================================================
+
+    TEST(CodecTest, EveryTruncationIsRejected)
+    {
+        uint8_t buffer[MAX_FRAME_SIZE];
+        FrameWriter writer(buffer, sizeof(buffer));
+        ASSERT_TRUE(writer.begin(NODE, FLAG_SEQUENCE));
+        ASSERT_TRUE(writer.add_sensor("temperature", temperature_meta(), 1.0f));
+        ASSERT_TRUE(writer.add_text_sensor("mode", EntityMeta(), "eco"));
+
+        for (size_t len = 0; len < writer.size(); len++) {
+            FrameReader reader(buffer, len);
+            Reading reading;
+            size_t records = 0;
+            while (reader.next(&reading)) {
+                records++;
+            }
+            // Never both records, and a cut inside a record is an error rather than the end
+            EXPECT_LT(records, 2u) << len;
+            EXPECT_TRUE(!reader.valid() || reader.error()) << len;
+        }
+    }
+
+    TEST(CodecTest, MalformedLengthsAreRejected)
+    {
+        uint8_t buffer[MAX_FRAME_SIZE];
+        FrameWriter writer(buffer, sizeof(buffer));
+        ASSERT_TRUE(writer.begin(NODE));
+        size_t header_len = writer.size();
+        ASSERT_TRUE(writer.add_text_sensor("mode", EntityMeta(), "eco"));
+
+        Reading reading;
+        // Node name longer than the frame
+        {
+            std::vector<uint8_t> frame(buffer, buffer + writer.size());
+            frame[FRAME_HEADER_SIZE] = 0xF0;
+            EXPECT_FALSE(FrameReader(frame.data(), frame.size()).valid());
+        }
+        // Text value longer than what is left
+        {
+            std::vector<uint8_t> frame(buffer, buffer + writer.size());
+            frame[frame.size() - 4] = 4;
+            FrameReader reader(frame.data(), frame.size());
+            ASSERT_TRUE(reader.valid());
+            EXPECT_FALSE(reader.next(&reading));
+            EXPECT_TRUE(reader.error());
+        }
+        // More records announced than present
+        {
+            std::vector<uint8_t> frame(buffer, buffer + writer.size());
+            frame[3] = 2;
+            FrameReader reader(frame.data(), frame.size());
+            ASSERT_TRUE(reader.next(&reading));
+            EXPECT_FALSE(reader.next(&reading));
+            EXPECT_TRUE(reader.error());
+        }
+        // Unknown record type
+        {
+            std::vector<uint8_t> frame(buffer, buffer + writer.size());
+            frame[header_len] = 0x7F;
+            FrameReader reader(frame.data(), frame.size());
+            EXPECT_FALSE(reader.next(&reading));
+            EXPECT_TRUE(reader.error());
+        }
+        // Wrong version, wrong magic
+        {
+            std::vector<uint8_t> frame(buffer, buffer + writer.size());
+            frame[1] = FRAME_VERSION + 1;
+            EXPECT_FALSE(FrameReader(frame.data(), frame.size()).valid());
+            frame[0] = 'g';
+            EXPECT_FALSE(is_binary_frame(frame.data(), frame.size()));
+        }
+    }
+
+    TEST(CodecTest, WriterRollsBackWhatDoesNotFit)
+    {
+        uint8_t buffer[64];
+        FrameWriter writer(buffer, sizeof(buffer));
+        ASSERT_TRUE(writer.begin(NODE));
+        size_t records = 0;
+        while (writer.add_sensor("temperature", EntityMeta(), 1.0f)) {
+            records++;
+        }
+        size_t full = writer.size();
+        EXPECT_GT(records, 0u);
+        EXPECT_FALSE(writer.add_text_sensor("mode", EntityMeta(), std::string(60, 'x')));
+        EXPECT_EQ(writer.size(), full);
+        EXPECT_EQ(writer.count(), records);
+
+        FrameReader reader(writer.data(), writer.size());
+        Reading reading;
+        size_t read = 0;
+        while (reader.next(&reading)) {
+            read++;
+        }
+        EXPECT_EQ(read, records);
+        EXPECT_FALSE(reader.error());
+    }
+
+    // =============================================================================
+    // v1 Text
+    // =============================================================================
+
+    TEST(CodecTest, TextFrameParsesWithEscapes)
+    {
+        std::string line = "gar\\:den:temperature:measurement:temp:°C:12\\:30:mdi:thermometer:2024.6.0:esp32dev:";
+        NodeInfo node;
+        Reading reading;
+        std::string_view state;
+        ASSERT_TRUE(parse_text_frame(line.data(), line.size(), &node, &reading, &state));
+        EXPECT_EQ(node.name, "gar:den");
+        EXPECT_EQ(node.version, "2024.6.0");
+        EXPECT_EQ(node.board, "esp32dev");
+        EXPECT_EQ(reading.type, ReadingType::SENSOR);
+        EXPECT_EQ(reading.name, "temp");
+        EXPECT_EQ(reading.meta.device_class, "temperature");
+        EXPECT_EQ(reading.meta.unit, "°C");
+        EXPECT_EQ(reading.meta.icon, "mdi:thermometer");
+        EXPECT_EQ(state, "12:30");
+
+        // An escaped icon with an empty second icon field, and an escaped backslash
+        line = "garden::binary_sensor:door\\\\1::ON:mdi\\:door::2024.6.0:esp32dev:";
+        ASSERT_TRUE(parse_text_frame(line.data(), line.size(), &node, &reading, &state));
+        EXPECT_EQ(reading.type, ReadingType::BINARY_SENSOR);
+        EXPECT_EQ(reading.name, "door\\1");
+        EXPECT_EQ(reading.meta.icon, "mdi:door");
+        EXPECT_EQ(state, "ON");
+
+        // Too few and too many fields
+        line = "garden:temperature:measurement:temp";
+        EXPECT_FALSE(parse_text_frame(line.data(), line.size(), &node, &reading, &state));
+        line = "a:b:c:d:e:f:g:h:i:j:k:l";
+        EXPECT_FALSE(parse_text_frame(line.data(), line.size(), &node, &reading, &state));
+    }
+
+    TEST(CodecTest, SplitFieldsStopsAtNulAndCountsOverflow)
+    {
+        char line[] = "a:b\\:c:d\0e:f";
+        std::string_view fields[4];
+        ASSERT_EQ(split_fields(line, sizeof(line) - 1, ':', fields, 4), 3u);
+        EXPECT_EQ(fields[0], "a");
+        EXPECT_EQ(fields[1], "b:c");
+        EXPECT_EQ(fields[2], "d");
+
+        char many[] = "1:2:3:4:5";
+        EXPECT_EQ(split_fields(many, sizeof(many) - 1, ':', fields, 4), 5u);
+    }
+
+    TEST(CodecTest, ValuesFormatLikeEsphome)
+    {
+        char buffer[32];
+        EXPECT_EQ(format_value(buffer, sizeof(buffer), 21.456f, 2), 5u);
+        EXPECT_STREQ(buffer, "21.46");
+        format_value(buffer, sizeof(buffer), 21.5f, 0);
+        EXPECT_STREQ(buffer, "22");
+        format_value(buffer, sizeof(buffer), -0.04f, 1);
+        EXPECT_STREQ(buffer, "-0.0");
+        format_value(buffer, sizeof(buffer), 1234.0f, -2);
+        EXPECT_STREQ(buffer, "1200");
+    }
+
+    // =============================================================================
+    // Size
+    // =============================================================================
+
+    // The same readings as v1 lines (one per reading, metadata repeated in each) and
+    // as v2 frames. Most frames a node sends are compact: once the bridge has
+    // acknowledged a full frame, a reading is its schema ID and value. The full frame
+    // sent first costs about what the v1 lines did, while also carrying the sequence
+    // number, accuracy and reporting interval.
+    TEST(CodecTest, V2FrameIsSmallerThanTheV1Line)
+    {
+        static const char *const NAMES[] = {"temperature", "humidity"};
+        host::V1Fields fields;
+        fields.device_class = "temperature";
+        fields.unit = "°C";
+        fields.icon = "mdi:thermometer";
+        size_t v1_line = host::v1_frame(fields).size();
+        size_t v1_size = 0;
+        for (const char *name : NAMES) {
+            fields.name = name;
+            v1_size += host::v1_frame(fields).size();
+        }
+
+        uint8_t buffer[MAX_FRAME_SIZE];
+        FrameWriter full(buffer, sizeof(buffer));
+        ASSERT_TRUE(full.begin(NODE, FLAG_SEQUENCE));
+        for (const char *name : NAMES) {
+            ASSERT_TRUE(full.add_sensor(name, temperature_meta(), 21.5f));
+        }
+        EXPECT_LT(full.size(), v1_size + v1_size / 10);
+
+        uint8_t compact_buffer[MAX_FRAME_SIZE];
+        FrameWriter compact(compact_buffer, sizeof(compact_buffer));
+        ASSERT_TRUE(compact.begin_compact(1, FLAG_SEQUENCE));
+        for (const char *name : NAMES) {
+            Prefix prefix(ReadingType::SENSOR, name, temperature_meta());
+            uint8_t ref[SCHEMA_REF_SIZE];
+            ASSERT_EQ(encode_schema_ref(ref, sizeof(ref), schema_id(prefix.data, prefix.len)), SCHEMA_REF_SIZE);
+            ASSERT_TRUE(compact.add_sensor({ref, sizeof(ref)}, 21.5f));
+        }
+        EXPECT_EQ(compact.size(), FRAME_HEADER_SIZE + SEQUENCE_SIZE + SCHEMA_REF_SIZE + 2 * (SCHEMA_REF_SIZE + 4));
+        EXPECT_LT(compact.size(), v1_line);
+        EXPECT_LT(compact.size() * 5, v1_size);
+    }
+
+} // namespace
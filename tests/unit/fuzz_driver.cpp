@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <random>
+
+#include "fuzz.h"
+#include "esphome/components/now_mqtt_protocol/codec.h"
+
+// Replays a fuzz target without libFuzzer: its seeds, seeded mutations of them
+// and random buffers. FUZZ_ITERATIONS overrides the number of generated inputs.
+
+namespace
+{
+    using Input = std::vector<uint8_t>;
+
+    static constexpr size_t MAX_INPUT_SIZE = 300;  // A little past the ESP-NOW limit
+
+    size_t iterations()
+    {
+        const char *value = getenv("FUZZ_ITERATIONS");
+        return value != nullptr ? strtoul(value, nullptr, 10) : 20000;
+    }
+
+    void mutate(Input &input, const std::vector<Input> &seeds, std::mt19937 &rng)
+    {
+        static const uint8_t INTERESTING[] = {0x00, 0x01, 0x7F, 0x80, 0xFF, ':', '\\'};
+        auto position = [&]() { return input.empty() ? 0 : rng() % input.size(); };
+        int mutations = 1 + rng() % 4;
+        for (int i = 0; i < mutations; i++) {
+            switch (rng() % 7) {
+                case 0:
+                    if (!input.empty()) {
+                        input[position()] ^= 1 << (rng() % 8);
+                    }
+                    break;
+                case 1:
+                    if (!input.empty()) {
+                        input[position()] = rng();
+                    }
+                    break;
+                case 2:
+                    if (!input.empty()) {
+                        input[position()] = INTERESTING[rng() % sizeof(INTERESTING)];
+                    }
+                    break;
+                case 3:
+                    input.insert(input.begin() + position(), static_cast<uint8_t>(rng()));
+                    break;
+                case 4:
+                    if (!input.empty()) {
+                        input.erase(input.begin() + position());
+                    }
+                    break;
+                case 5:
+                    input.resize(position());
+                    break;
+                case 6: {
+                    // Splice the tail of another seed in
+                    const Input &other = seeds[rng() % seeds.size()];
+                    size_t from = other.empty() ? 0 : rng() % other.size();
+                    input.resize(position());
+                    input.insert(input.end(), other.begin() + from, other.end());
+                    break;
+                }
+            }
+        }
+        if (input.size() > MAX_INPUT_SIZE) {
+            input.resize(MAX_INPUT_SIZE);
+        }
+    }
+
+    void run(const Input &input) { LLVMFuzzerTestOneInput(input.data(), input.size()); }
+
+    TEST(FuzzTest, Seeds)
+    {
+        std::vector<Input> seeds = fuzz_seeds();
+        ASSERT_FALSE(seeds.empty());
+        run({});
+        for (const Input &seed : seeds) {
+            run(seed);
+        }
+    }
+
+    TEST(FuzzTest, MutatedSeeds)
+    {
+        std::vector<Input> seeds = fuzz_seeds();
+        std::mt19937 rng(1);
+        for (size_t i = 0; i < iterations(); i++) {
+            Input input = seeds[i % seeds.size()];
+            mutate(input, seeds, rng);
+            run(input);
+        }
+    }
+
+    TEST(FuzzTest, RandomInputs)
+    {
+        std::mt19937 rng(2);
+        for (size_t i = 0; i < iterations() / 4; i++) {
+            Input input(rng() % MAX_INPUT_SIZE);
+            for (auto &byte : input) {
+                byte = rng();
+            }
+            // Give most a v2 header so decoding gets past the magic
+            if (input.size() >= 2 && rng() % 2 == 0) {
+                input[0] = esphome::now_mqtt_protocol::FRAME_MAGIC;
+                input[1] = esphome::now_mqtt_protocol::FRAME_VERSION;
+            }
+            run(input);
+        }
+    }
+
+} // namespace
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+#include "esphome/components/now_mqtt_bridge/ingest_ring.h"
+#include "esphome/components/now_mqtt_bridge/now_mqtt_bridge.h"
+
+using esphome::now_mqtt_bridge::RawFrame;
+using esphome::now_mqtt_bridge::SpscRing;
+
+// The ring between the Wi-Fi task and loop(), with a real producer and consumer
+// thread. Every frame carries its sequence number and a pattern derived from it,
+// so a frame read twice, skipped, reordered or read half-written shows up.
+// STRESS_FRAMES overrides the number of frames per run.
+
+namespace
+{
+    using IngestRing = SpscRing<RawFrame, esphome::now_mqtt_bridge::INGEST_QUEUE_SIZE>;
+
+    uint32_t stress_frames()
+    {
+        const char *value = getenv("STRESS_FRAMES");
+        return value != nullptr ? strtoul(value, nullptr, 10) : 200000;
+    }
+
+    void fill(RawFrame *frame, uint32_t seq)
+    {
+        frame->rx_us = seq;
+        frame->len = 1 + seq % sizeof(frame->data);
+        frame->rssi = -static_cast<int8_t>(seq % 100);
+        for (size_t i = 0; i < sizeof(frame->mac); i++) {
+            frame->mac[i] = seq >> (i * 4);
+        }
+        for (size_t i = 0; i < frame->len; i++) {
+            frame->data[i] = seq * 31 + i;
+        }
+    }
+
+    bool intact(const RawFrame &frame)
+    {
+        uint32_t seq = frame.rx_us;
+        if (frame.len != 1 + seq % sizeof(frame.data) || frame.rssi != -static_cast<int8_t>(seq % 100)) {
+            return false;
+        }
+        for (size_t i = 0; i < sizeof(frame.mac); i++) {
+            if (frame.mac[i] != static_cast<uint8_t>(seq >> (i * 4))) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < frame.len; i++) {
+            if (frame.data[i] != static_cast<uint8_t>(seq * 31 + i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A ring whose indices start just short of wrapping
+    template<typename T, size_t N>
+    class WrappingRing : public SpscRing<T, N>
+    {
+    public:
+        explicit WrappingRing(uint32_t start)
+        {
+            this->head_.store(start);
+            this->tail_.store(start);
+        }
+    };
+
+    TEST(SpscRingTest, DropsWhenFullAndRecovers)
+    {
+        IngestRing ring;
+        EXPECT_EQ(ring.front(), nullptr);
+        for (uint32_t seq = 0; seq < IngestRing::capacity(); seq++) {
+            RawFrame *slot = ring.acquire();
+            ASSERT_NE(slot, nullptr);
+            fill(slot, seq);
+            ring.commit();
+        }
+        EXPECT_EQ(ring.acquire(), nullptr);
+        EXPECT_EQ(ring.dropped(), 1u);
+        EXPECT_EQ(ring.size(), IngestRing::capacity());
+        EXPECT_EQ(ring.high_water(), IngestRing::capacity());
+
+        ASSERT_NE(ring.front(), nullptr);
+        EXPECT_EQ(ring.front()->rx_us, 0u);
+        ring.pop();
+        RawFrame *slot = ring.acquire();
+        ASSERT_NE(slot, nullptr);
+        fill(slot, IngestRing::capacity());
+        ring.commit();
+
+        for (uint32_t seq = 1; seq <= IngestRing::capacity(); seq++) {
+            const RawFrame *frame = ring.front();
+            ASSERT_NE(frame, nullptr);
+            EXPECT_EQ(frame->rx_us, seq);
+            EXPECT_TRUE(intact(*frame));
+            ring.pop();
+        }
+        EXPECT_EQ(ring.front(), nullptr);
+        EXPECT_EQ(ring.dropped(), 1u);
+    }
+
+    TEST(SpscRingTest, IndicesWrapAround)
+    {
+        WrappingRing<uint32_t, 4> ring(UINT32_MAX - 5);
+        uint32_t next = 0;
+        uint32_t expected = 0;
+        for (int round = 0; round < 8; round++) {
+            for (int i = 0; i < 3; i++) {
+                uint32_t *slot = ring.acquire();
+                ASSERT_NE(slot, nullptr);
+                *slot = next++;
+                ring.commit();
+            }
+            EXPECT_EQ(ring.size(), 3u);
+            for (int i = 0; i < 3; i++) {
+                ASSERT_NE(ring.front(), nullptr);
+                EXPECT_EQ(*ring.front(), expected++);
+                ring.pop();
+            }
+            EXPECT_EQ(ring.size(), 0u);
+        }
+        EXPECT_EQ(ring.dropped(), 0u);
+        EXPECT_EQ(ring.high_water(), 3u);
+    }
+
+    // The producer drops what does not fit, as the receive callback does
+    TEST(SpscRingTest, ConcurrentProducerDropsButNeverCorrupts)
+    {
+        static IngestRing ring;
+        const uint32_t frames = stress_frames();
+        std::atomic<bool> done{false};
+        uint32_t producer_drops = 0;
+
+        std::thread producer([&]() {
+            for (uint32_t seq = 0; seq < frames; seq++) {
+                RawFrame *slot = ring.acquire();
+                if (slot == nullptr) {
+                    producer_drops++;
+                    if (seq % 64 == 0) {
+                        std::this_thread::yield();
+                    }
+                    continue;
+                }
+                fill(slot, seq);
+                ring.commit();
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        uint32_t received = 0;
+        uint32_t corrupt = 0;
+        int64_t last = -1;
+        bool ordered = true;
+        while (true) {
+            const RawFrame *frame = ring.front();
+            if (frame == nullptr) {
+                if (done.load(std::memory_order_acquire) && ring.front() == nullptr) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            corrupt += intact(*frame) ? 0 : 1;
+            ordered = ordered && static_cast<int64_t>(frame->rx_us) > last;
+            last = frame->rx_us;
+            received++;
+            ring.pop();
+        }
+        producer.join();
+
+        EXPECT_EQ(corrupt, 0u);
+        EXPECT_TRUE(ordered);
+        EXPECT_EQ(received + producer_drops, frames);
+        EXPECT_EQ(ring.dropped(), producer_drops);
+        EXPECT_LE(ring.high_water(), IngestRing::capacity());
+        EXPECT_EQ(ring.size(), 0u);
+    }
+
+    // A producer that waits for space delivers every frame, in order
+    TEST(SpscRingTest, ConcurrentProducerWaitingForSpaceLosesNothing)
+    {
+        static SpscRing<RawFrame, 4> ring;
+        const uint32_t frames = stress_frames();
+
+        std::thread producer([&]() {
+            for (uint32_t seq = 0; seq < frames; seq++) {
+                RawFrame *slot;
+                while ((slot = ring.acquire()) == nullptr) {
+                    std::this_thread::yield();
+                }
+                fill(slot, seq);
+                ring.commit();
+            }
+        });
+
+        uint32_t expected = 0;
+        uint32_t mismatched = 0;
+        while (expected < frames) {
+            const RawFrame *frame = ring.front();
+            if (frame == nullptr) {
+                std::this_thread::yield();
+                continue;
+            }
+            mismatched += (frame->rx_us == expected && intact(*frame)) ? 0 : 1;
+            expected++;
+            ring.pop();
+        }
+        producer.join();
+
+        EXPECT_EQ(mismatched, 0u);
+        EXPECT_EQ(ring.front(), nullptr);
+        EXPECT_LE(ring.high_water(), 4u);
+    }
+
+} // namespace
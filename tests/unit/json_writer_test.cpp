@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt_bridge/json_writer.h"
+#include "esphome/components/now_mqtt_bridge/now_mqtt_bridge.h"
+
+using namespace esphome;
+using esphome::now_mqtt_bridge::JsonWriter;
+using esphome::now_mqtt_bridge::Now_MQTT_BridgeComponent;
+
+// Discovery payloads rendered by the bridge, byte for byte against golden/.
+// The per-entity configs are what the DynamicJsonDocument code produced for
+// the same v1 lines: its member order, ArduinoJson's escaping, UTF-8 verbatim.
+// The device bundle has no older counterpart; its golden file pins the format.
+
+namespace
+{
+    std::string golden(const std::string &name)
+    {
+        std::ifstream file(std::string(GOLDEN_DIR) + "/" + name);
+        EXPECT_TRUE(file.good()) << "missing golden file " << name;
+        std::stringstream content;
+        content << file.rdbuf();
+        std::string text = content.str();
+        if (!text.empty() && text.back() == '\n') {
+            text.pop_back();
+        }
+        return text;
+    }
+
+    class DiscoveryGoldenTest : public ::testing::Test
+    {
+    protected:
+        void start(bool device_discovery)
+        {
+            host::reset();
+            host::clear_preferences();
+            this->bridge = std::make_unique<Now_MQTT_BridgeComponent>();
+            this->bridge->set_device_discovery(device_discovery);
+            this->bridge->setup();
+            this->bridge->loop();
+            host::mac_for(1, this->mac);
+        }
+
+        std::string config_for(const host::V1Fields &fields, const std::string &topic)
+        {
+            host::receive(this->mac, host::v1_frame(fields));
+            this->bridge->loop();
+            const host::Publish *config = host::last_publish(topic);
+            return config != nullptr ? config->payload : "(not published)";
+        }
+
+        std::unique_ptr<Now_MQTT_BridgeComponent> bridge;
+        uint8_t mac[6];
+    };
+
+    TEST_F(DiscoveryGoldenTest, Sensor)
+    {
+        this->start(false);
+        host::V1Fields fields;
+        fields.device_class = "temperature";
+        fields.unit = "°C";
+        fields.icon = "mdi:thermometer";
+        EXPECT_EQ(this->config_for(fields, "homeassistant/sensor/garden/temperature/config"), golden("sensor.json"));
+    }
+
+    TEST_F(DiscoveryGoldenTest, SensorWithoutOptionalMembers)
+    {
+        this->start(false);
+        host::V1Fields fields;
+        fields.state_class = "";
+        fields.name = "plain";
+        EXPECT_EQ(this->config_for(fields, "homeassistant/sensor/garden/plain/config"), golden("sensor_minimal.json"));
+    }
+
+    TEST_F(DiscoveryGoldenTest, BinarySensor)
+    {
+        this->start(false);
+        host::V1Fields fields;
+        fields.state_class = "binary_sensor";
+        fields.device_class = "door";
+        fields.name = "door";
+        fields.state = "ON";
+        EXPECT_EQ(this->config_for(fields, "homeassistant/binary_sensor/garden/door/config"),
+                  golden("binary_sensor.json"));
+    }
+
+    TEST_F(DiscoveryGoldenTest, BinarySensorWithoutDeviceClass)
+    {
+        this->start(false);
+        host::V1Fields fields;
+        fields.state_class = "binary_sensor";
+        fields.name = "motion";
+        fields.state = "OFF";
+        EXPECT_EQ(this->config_for(fields, "homeassistant/binary_sensor/garden/motion/config"),
+                  golden("binary_sensor_minimal.json"));
+    }
+
+    TEST_F(DiscoveryGoldenTest, EscapedStrings)
+    {
+        this->start(false);
+        host::V1Fields fields;
+        fields.name = "say \"hi\" \\\\ now";  // v1 escapes the backslash
+        fields.unit = "a\tb";
+        EXPECT_EQ(this->config_for(fields, "homeassistant/sensor/garden/say \"hi\" \\ now/config"),
+                  golden("sensor_escaped.json"));
+    }
+
+    TEST_F(DiscoveryGoldenTest, DeviceBundle)
+    {
+        this->start(true);
+        now_mqtt_protocol::NodeInfo node = {"porch", "2024.6.0", "esp32dev", 60};
+        host::V2Frame frame(node);
+        now_mqtt_protocol::EntityMeta meta;
+        meta.device_class = "humidity";
+        meta.state_class = "measurement";
+        meta.unit = "%";
+        meta.accuracy = 1;
+        meta.has_accuracy = true;
+        ASSERT_TRUE(frame.writer().add_sensor("humidity", meta, 48.25f));
+        now_mqtt_protocol::EntityMeta door;
+        door.device_class = "door";
+        ASSERT_TRUE(frame.writer().add_binary_sensor("door", door, true));
+        now_mqtt_protocol::EntityMeta mode;
+        mode.icon = "mdi:leaf";
+        ASSERT_TRUE(frame.writer().add_text_sensor("mode", mode, "eco"));
+        host::receive(this->mac, frame.data(), frame.size());
+        this->bridge->loop();
+
+        const host::Publish *config = host::last_publish("homeassistant/device/246f28000001/config");
+        ASSERT_NE(config, nullptr);
+        EXPECT_EQ(config->payload, golden("device_bundle.json"));
+    }
+
+    // =============================================================================
+    // JsonWriter
+    // =============================================================================
+
+    TEST(JsonWriterTest, EscapesLikeArduinoJson)
+    {
+        char buffer[128];
+        JsonWriter json(buffer, sizeof(buffer));
+        json.begin_object();
+        json.add("s", std::string_view("q\"b\\\b\f\n\r\t\x01/\xC2\xB0\0z", 15));
+        json.end_object();
+        EXPECT_FALSE(json.overflow());
+        EXPECT_EQ(std::string(json.data(), json.size()),
+                  "{\"s\":\"q\\\"b\\\\\\b\\f\\n\\r\\t\x01/\xC2\xB0\\u0000z\"}");
+    }
+
+    TEST(JsonWriterTest, NestingAndSeparators)
+    {
+        char buffer[128];
+        JsonWriter json(buffer, sizeof(buffer));
+        json.begin_object();
+        json.add("a", "1");
+        json.key("b");
+        json.begin_object();
+        json.key("c");
+        json.begin_object();
+        json.end_object();
+        json.add("d", std::string_view());
+        json.end_object();
+        json.key("e");
+        json.begin_string();
+        json.append("x");
+        json.append("\"");
+        json.end_string();
+        json.raw(",\"f\":true");
+        json.key("g");
+        json.raw_value("[1,2]");
+        json.end_object();
+        EXPECT_STREQ(json.data(), "{\"a\":\"1\",\"b\":{\"c\":{},\"d\":null},\"e\":\"x\\\"\",\"f\":true,\"g\":[1,2]}");
+    }
+
+    TEST(JsonWriterTest, OverflowStopsWritingAndStaysTerminated)
+    {
+        char buffer[16];
+        memset(buffer, 'X', sizeof(buffer));
+        JsonWriter json(buffer, sizeof(buffer));
+        json.begin_object();
+        json.add("name", "temperature");
+        EXPECT_TRUE(json.overflow());
+        json.end_object();
+        EXPECT_LT(json.size(), sizeof(buffer));
+        EXPECT_EQ(strlen(buffer), json.size());
+        EXPECT_STREQ(buffer, "{\"name\":\"");
+
+        char none[1];
+        JsonWriter empty(none, 0);
+        empty.begin_object();
+        EXPECT_TRUE(empty.overflow());
+        EXPECT_EQ(empty.size(), 0u);
+    }
+
+} // namespace
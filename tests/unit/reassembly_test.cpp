@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "esphome/components/now_mqtt_bridge/reassembly.h"
+
+using namespace esphome;
+using esphome::now_mqtt_bridge::Reassembler;
+using now_mqtt_protocol::Fragment;
+
+// Fragments go over the air and are decoded as the bridge does; the radio loses,
+// repeats and reorders them. Runs are seeded, so a failure replays exactly.
+
+namespace
+{
+    static constexpr uint32_t TIMEOUT_MS = 1000;
+    static constexpr size_t SLOTS = 4;
+
+    using Frame = std::vector<uint8_t>;
+
+    // Anything that fits one frame is sent whole, so at least two fragments
+    std::vector<uint8_t> random_message(std::mt19937 &rng, size_t min_len = now_mqtt_protocol::MAX_FRAME_SIZE + 1)
+    {
+        std::uniform_int_distribution<size_t> length(min_len, now_mqtt_protocol::MAX_MESSAGE_SIZE);
+        std::vector<uint8_t> message(length(rng));
+        for (auto &byte : message) {
+            byte = rng();
+        }
+        return message;
+    }
+
+    std::vector<Frame> fragment(uint16_t message_id, const std::vector<uint8_t> &message)
+    {
+        std::vector<Frame> frames;
+        size_t count = now_mqtt_protocol::fragment_count(message.size());
+        for (size_t index = 0; index < count; index++) {
+            Frame frame(now_mqtt_protocol::MAX_FRAME_SIZE);
+            size_t len = now_mqtt_protocol::encode_fragment(frame.data(), frame.size(), message_id, message.data(),
+                                                            message.size(), index);
+            EXPECT_GT(len, 0u);
+            frame.resize(len);
+            frames.push_back(std::move(frame));
+        }
+        return frames;
+    }
+
+    // One frame through decode and the reassembler; the completed message, if any
+    template<size_t N>
+    bool add(Reassembler<N> &reassembler, uint64_t source, const Frame &frame, uint32_t now,
+             std::vector<uint8_t> *message)
+    {
+        Fragment fragment;
+        if (!now_mqtt_protocol::decode_fragment(frame.data(), frame.size(), &fragment)) {
+            ADD_FAILURE() << "fragment did not decode";
+            return false;
+        }
+        size_t len = 0;
+        const uint8_t *data = reassembler.add(source, fragment, now, &len);
+        if (data == nullptr) {
+            return false;
+        }
+        message->assign(data, data + len);
+        return true;
+    }
+
+    TEST(ReassemblyTest, InOrderMessageCompletes)
+    {
+        std::mt19937 rng(1);
+        Reassembler<SLOTS> reassembler(TIMEOUT_MS);
+        std::vector<uint8_t> message = random_message(rng);
+        std::vector<Frame> frames = fragment(7, message);
+
+        std::vector<uint8_t> out;
+        for (size_t i = 0; i + 1 < frames.size(); i++) {
+            EXPECT_FALSE(add(reassembler, 1, frames[i], 0, &out));
+        }
+        ASSERT_TRUE(add(reassembler, 1, frames.back(), 0, &out));
+        EXPECT_EQ(out, message);
+        EXPECT_EQ(reassembler.completed(), 1u);
+        EXPECT_EQ(reassembler.active(), 0u);
+    }
+
+    TEST(ReassemblyTest, ShuffledAndRepeatedFragmentsCompleteOnce)
+    {
+        std::mt19937 rng(2);
+        Reassembler<SLOTS> reassembler(TIMEOUT_MS);
+        uint32_t now = 0;
+        uint32_t expected_duplicates = 0;
+        for (uint16_t id = 0; id < 500; id++) {
+            std::vector<uint8_t> message = random_message(rng);
+            std::vector<Frame> frames = fragment(id, message);
+            size_t distinct = frames.size();
+            // Retries: some fragments go out again, anywhere in the stream
+            for (size_t i = 0; i < distinct; i++) {
+                if (rng() % 4 == 0) {
+                    frames.push_back(frames[i]);
+                }
+            }
+            std::shuffle(frames.begin(), frames.end(), rng);
+
+            size_t completions = 0;
+            std::vector<uint8_t> out;
+            for (const Frame &frame : frames) {
+                if (add(reassembler, 1, frame, now++, &out)) {
+                    completions++;
+                    EXPECT_EQ(out, message) << "message " << id;
+                }
+            }
+            // Each repeat is dropped, whether it came before or after completion
+            expected_duplicates += frames.size() - distinct;
+            EXPECT_EQ(completions, 1u) << "message " << id;
+        }
+        EXPECT_EQ(reassembler.completed(), 500u);
+        EXPECT_EQ(reassembler.duplicates(), expected_duplicates);
+        EXPECT_EQ(reassembler.failures(), 0u);
+    }
+
+    TEST(ReassemblyTest, LostFragmentNeverCompletesAndTimesOut)
+    {
+        std::mt19937 rng(3);
+        Reassembler<SLOTS> reassembler(TIMEOUT_MS);
+        uint32_t now = 0;
+        for (uint16_t id = 0; id < 200; id++) {
+            std::vector<uint8_t> message = random_message(rng);
+            std::vector<Frame> frames = fragment(id, message);
+            frames.erase(frames.begin() + rng() % frames.size());
+            std::shuffle(frames.begin(), frames.end(), rng);
+
+            std::vector<uint8_t> out;
+            for (const Frame &frame : frames) {
+                EXPECT_FALSE(add(reassembler, 1, frame, now, &out)) << "message " << id;
+            }
+            EXPECT_EQ(reassembler.active(), 1u);
+            now += TIMEOUT_MS;
+            reassembler.expire(now);
+            EXPECT_EQ(reassembler.active(), 0u);
+        }
+        EXPECT_EQ(reassembler.completed(), 0u);
+        EXPECT_EQ(reassembler.timeouts(), 200u);
+    }
+
+    TEST(ReassemblyTest, InterleavedSendersWithLossAndReorder)
+    {
+        // Up to SLOTS senders at once, their fragments mixed on the air; every
+        // message that lost nothing comes out intact, none that did comes out at all
+        std::mt19937 rng(4);
+        Reassembler<SLOTS> reassembler(TIMEOUT_MS);
+        uint32_t now = 0;
+        uint32_t expected_completed = 0;
+        uint32_t expected_timeouts = 0;
+        for (int round = 0; round < 300; round++) {
+            struct Pending {
+                uint64_t source;
+                std::vector<uint8_t> message;
+                bool lossy;
+            };
+            std::vector<Pending> pending;
+            std::vector<std::pair<size_t, Frame>> air;
+            size_t senders = 1 + rng() % SLOTS;
+            for (size_t s = 0; s < senders; s++) {
+                uint64_t source = 0x246F28000000ULL + s;
+                Pending message = {source, random_message(rng), false};
+                std::vector<Frame> frames = fragment(round, message.message);
+                for (Frame &frame : frames) {
+                    if (rng() % 10 == 0) {
+                        message.lossy = true;
+                        continue;
+                    }
+                    air.emplace_back(pending.size(), std::move(frame));
+                }
+                expected_completed += !message.lossy;
+                pending.push_back(std::move(message));
+            }
+            std::shuffle(air.begin(), air.end(), rng);
+
+            std::vector<bool> completed(pending.size(), false);
+            std::vector<uint8_t> out;
+            for (const auto &entry : air) {
+                const Pending &message = pending[entry.first];
+                if (add(reassembler, message.source, entry.second, now, &out)) {
+                    EXPECT_FALSE(message.lossy);
+                    EXPECT_EQ(out, message.message);
+                    completed[entry.first] = true;
+                }
+            }
+            for (size_t i = 0; i < pending.size(); i++) {
+                EXPECT_EQ(completed[i], !pending[i].lossy) << "round " << round << ", sender " << i;
+                // Lost every fragment: nothing was started, nothing times out
+                bool started = std::any_of(air.begin(), air.end(), [i](const auto &e) { return e.first == i; });
+                expected_timeouts += pending[i].lossy && started;
+            }
+            now += TIMEOUT_MS;
+            reassembler.expire(now);
+        }
+        EXPECT_EQ(reassembler.completed(), expected_completed);
+        EXPECT_EQ(reassembler.timeouts(), expected_timeouts);
+        EXPECT_EQ(reassembler.failures(), 0u);
+    }
+
+    TEST(ReassemblyTest, LateRetryDoesNotStartNewMessage)
+    {
+        std::mt19937 rng(5);
+        Reassembler<SLOTS> reassembler(TIMEOUT_MS);
+        std::vector<uint8_t> message = random_message(rng);
+        std::vector<Frame> frames = fragment(9, message);
+        std::vector<uint8_t> out;
+        for (const Frame &frame : frames) {
+            add(reassembler, 1, frame, 0, &out);
+        }
+        ASSERT_EQ(reassembler.completed(), 1u);
+
+        EXPECT_FALSE(add(reassembler, 1, frames[0], TIMEOUT_MS - 1, &out));
+        EXPECT_EQ(reassembler.active(), 0u);
+        EXPECT_EQ(reassembler.duplicates(), 1u);
+    }
+
+    TEST(ReassemblyTest, FullPoolEvictsOldestIncompleteMessage)
+    {
+        std::mt19937 rng(6);
+        Reassembler<2> reassembler(TIMEOUT_MS);
+        std::vector<std::vector<Frame>> messages;
+        std::vector<uint8_t> out;
+        for (uint64_t source = 0; source < 3; source++) {
+            messages.push_back(fragment(1, random_message(rng)));
+            EXPECT_FALSE(add(reassembler, source, messages.back()[0], source, &out));
+        }
+        EXPECT_EQ(reassembler.failures(), 1u);
+        EXPECT_EQ(reassembler.active(), 2u);
+
+        for (uint64_t source = 1; source < 3; source++) {
+            bool done = false;
+            for (size_t i = 1; i < messages[source].size(); i++) {
+                done = add(reassembler, source, messages[source][i], 3, &out);
+            }
+            EXPECT_TRUE(done) << "sender " << source;
+        }
+        // The first sender's message was evicted: the rest of it never completes
+        for (size_t i = 1; i < messages[0].size(); i++) {
+            EXPECT_FALSE(add(reassembler, 0, messages[0][i], 4, &out));
+        }
+        EXPECT_EQ(reassembler.completed(), 2u);
+        EXPECT_EQ(reassembler.failures(), 1u);
+    }
+
+    TEST(ReassemblyTest, SenderRestartMidMessageDropsOldFragments)
+    {
+        std::mt19937 rng(7);
+        Reassembler<SLOTS> reassembler(TIMEOUT_MS);
+        std::vector<uint8_t> old_message = random_message(rng, 3 * now_mqtt_protocol::FRAGMENT_PAYLOAD_SIZE + 1);
+        std::vector<Frame> old_frames = fragment(3, old_message);
+        std::vector<uint8_t> message(now_mqtt_protocol::MAX_FRAME_SIZE + 1, 0x5A);
+        std::vector<Frame> new_frames = fragment(3, message);
+        ASSERT_NE(old_frames.size(), new_frames.size());
+
+        std::vector<uint8_t> out;
+        EXPECT_FALSE(add(reassembler, 1, old_frames[0], 0, &out));
+        EXPECT_FALSE(add(reassembler, 1, new_frames[1], 1, &out));
+        EXPECT_EQ(reassembler.failures(), 1u);
+        ASSERT_TRUE(add(reassembler, 1, new_frames[0], 2, &out));
+        EXPECT_EQ(out, message);
+    }
+
+} // namespace
@@ -0,0 +1,432 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt/now_mqtt.h"
+#include "esphome/components/now_mqtt/send_queue.h"
+#include "esphome/core/application.h"
+
+using namespace esphome;
+using esphome::now_mqtt::Now_MQTTComponent;
+using esphome::now_mqtt::SendQueue;
+
+// The send queue against a scripted radio: frames go on the air in order and the
+// test decides, per frame, whether its completion reports success, failure, or
+// never shows up. Then the same through the sender, with the host esp_now_send
+// and send callback stubs, down to on_send_success / on_send_failure.
+
+namespace
+{
+    static constexpr uint32_t RETRY_DELAY_MS = 10;
+    static constexpr uint32_t TIMEOUT_MS = 100;
+
+    using Queue = SendQueue<4, 16>;
+
+    // Frames are one byte, their id, which is also their tag
+    struct Radio {
+        explicit Radio(uint8_t max_retries = 2) : queue({max_retries, RETRY_DELAY_MS, TIMEOUT_MS}) {}
+
+        bool enqueue(uint8_t id) { return this->queue.enqueue(&id, 1, this->now, id); }
+
+        void process()
+        {
+            this->queue.process(
+                this->now,
+                [this](const uint8_t *data, size_t len) {
+                    if (this->refuse) {
+                        return false;
+                    }
+                    EXPECT_EQ(len, 1u);
+                    this->air.push_back(data[0]);
+                    this->transmits.push_back(data[0]);
+                    return true;
+                },
+                [this](bool success, uint32_t tag) { this->results.emplace_back(tag, success); });
+        }
+
+        // The oldest frame on the air completes (or its completion is lost)
+        void complete(bool success)
+        {
+            ASSERT_FALSE(this->air.empty());
+            this->air.pop_front();
+            this->queue.on_send_complete(success);
+        }
+        void lose()
+        {
+            ASSERT_FALSE(this->air.empty());
+            this->air.pop_front();
+        }
+
+        void advance(uint32_t ms)
+        {
+            this->now += ms;
+            this->process();
+        }
+
+        Queue queue;
+        uint32_t now = 1000;
+        bool refuse = false;
+        std::deque<uint8_t> air;
+        std::vector<uint8_t> transmits;
+        std::vector<std::pair<uint32_t, bool>> results;
+    };
+
+    using Results = std::vector<std::pair<uint32_t, bool>>;
+
+    TEST(SendQueueTest, SeveralFramesInFlight)
+    {
+        Radio radio;
+        for (uint8_t id = 1; id <= 4; id++) {
+            ASSERT_TRUE(radio.enqueue(id));
+        }
+        EXPECT_FALSE(radio.enqueue(5));
+        radio.process();
+        EXPECT_EQ(radio.transmits, (std::vector<uint8_t>{1, 2, 3, 4}));
+        EXPECT_EQ(radio.queue.in_flight(), 4u);
+        EXPECT_EQ(radio.queue.available(), 0u);
+
+        // Completions reach the queue in the Wi-Fi task; frames finish in the loop
+        radio.complete(true);
+        radio.complete(true);
+        EXPECT_TRUE(radio.results.empty());
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{1, true}, {2, true}}));
+        EXPECT_EQ(radio.queue.in_flight(), 2u);
+
+        // Freed slots take new frames while the others are still out
+        ASSERT_TRUE(radio.enqueue(5));
+        radio.process();
+        EXPECT_EQ(radio.queue.in_flight(), 3u);
+        radio.complete(true);
+        radio.complete(true);
+        radio.complete(true);
+        radio.process();
+        EXPECT_EQ(radio.results.size(), 5u);
+        EXPECT_TRUE(radio.queue.idle());
+    }
+
+    TEST(SendQueueTest, EachCompletionFinishesItsOwnFrame)
+    {
+        Radio radio;
+        for (uint8_t id = 1; id <= 3; id++) {
+            radio.enqueue(id);
+        }
+        radio.process();
+        radio.complete(false);
+        radio.complete(true);
+        radio.complete(true);
+        radio.process();
+        // Frame 1 goes back for a retry, so its neighbours finish first
+        EXPECT_EQ(radio.results, (Results{{2, true}, {3, true}}));
+
+        radio.enqueue(4);
+        radio.advance(RETRY_DELAY_MS);
+        EXPECT_EQ(radio.transmits, (std::vector<uint8_t>{1, 2, 3, 1, 4}));
+        radio.complete(true);
+        radio.complete(false);
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{2, true}, {3, true}, {1, true}}));
+        radio.advance(RETRY_DELAY_MS);
+        radio.complete(true);
+        radio.process();
+        EXPECT_EQ(radio.results.back(), (std::pair<uint32_t, bool>{4, true}));
+    }
+
+    TEST(SendQueueTest, RetriesBackOffThenReportFailure)
+    {
+        Radio radio;
+        radio.enqueue(1);
+        radio.process();
+        for (int attempt = 0; attempt < 3; attempt++) {
+            ASSERT_EQ(radio.transmits.size(), size_t(attempt + 1));
+            radio.complete(false);
+            radio.process();
+            if (attempt < 2) {
+                // Not before the retry delay
+                radio.advance(RETRY_DELAY_MS - 1);
+                EXPECT_EQ(radio.transmits.size(), size_t(attempt + 1));
+                radio.advance(1);
+            }
+        }
+        EXPECT_EQ(radio.transmits, (std::vector<uint8_t>{1, 1, 1}));
+        EXPECT_EQ(radio.results, (Results{{1, false}}));
+        EXPECT_TRUE(radio.queue.idle());
+    }
+
+    TEST(SendQueueTest, RefusedTransmitIsAFailedAttempt)
+    {
+        Radio radio;
+        radio.enqueue(1);
+        radio.enqueue(2);
+        radio.refuse = true;
+        radio.process();
+        // The rest waits for the next pass rather than hitting a busy radio again
+        EXPECT_TRUE(radio.transmits.empty());
+        EXPECT_EQ(radio.queue.pending(), 2u);
+
+        radio.refuse = false;
+        radio.advance(RETRY_DELAY_MS);
+        EXPECT_EQ(radio.transmits, (std::vector<uint8_t>{1, 2}));
+        radio.complete(true);
+        radio.complete(true);
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{1, true}, {2, true}}));
+    }
+
+    TEST(SendQueueTest, FrameWithoutCompletionTimesOut)
+    {
+        Radio radio(0);
+        radio.enqueue(1);
+        radio.process();
+        radio.lose();
+        radio.advance(TIMEOUT_MS - 1);
+        EXPECT_TRUE(radio.results.empty());
+        radio.advance(1);
+        EXPECT_EQ(radio.results, (Results{{1, false}}));
+    }
+
+    // Before the resync, every completion after a lost one landed on the frame
+    // before its own
+    TEST(SendQueueTest, LostCompletionDoesNotShiftLaterOnes)
+    {
+        Radio radio(0);
+        radio.enqueue(1);
+        radio.process();
+        radio.lose();
+        radio.advance(TIMEOUT_MS);
+        ASSERT_EQ(radio.results, (Results{{1, false}}));
+
+        for (int round = 0; round < 3; round++) {
+            radio.results.clear();
+            radio.enqueue(2);
+            radio.enqueue(3);
+            radio.process();
+            radio.complete(true);
+            radio.complete(false);
+            radio.process();
+            EXPECT_EQ(radio.results, (Results{{2, true}, {3, false}})) << round;
+        }
+    }
+
+    TEST(SendQueueTest, LostCompletionAmongFramesInFlight)
+    {
+        Radio radio(1);
+        for (uint8_t id = 1; id <= 3; id++) {
+            radio.enqueue(id);
+        }
+        radio.process();
+        // Frame 2's completion never comes. Until the timeout the others are matched
+        // by position, so frame 3's success is credited to 2.
+        radio.complete(true);
+        radio.lose();
+        radio.complete(true);
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{1, true}, {2, true}}));
+
+        // Frame 3 times out, is retried, and that completion is matched to it
+        radio.advance(TIMEOUT_MS);
+        radio.advance(RETRY_DELAY_MS);
+        EXPECT_EQ(radio.transmits.back(), 3);
+        radio.complete(true);
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{1, true}, {2, true}, {3, true}}));
+
+        radio.results.clear();
+        radio.enqueue(4);
+        radio.enqueue(5);
+        radio.process();
+        radio.complete(false);
+        radio.complete(true);
+        radio.process();
+        radio.advance(RETRY_DELAY_MS);
+        radio.complete(true);
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{5, true}, {4, true}}));
+    }
+
+    TEST(SendQueueTest, LateCompletionIsDropped)
+    {
+        Radio radio(0);
+        radio.enqueue(1);
+        radio.process();
+        radio.advance(TIMEOUT_MS);
+        ASSERT_EQ(radio.results, (Results{{1, false}}));
+
+        // Its completion turns up after all, before or after the next frame went out
+        radio.complete(true);
+        radio.process();
+        radio.enqueue(2);
+        radio.process();
+        radio.complete(false);
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{1, false}, {2, false}}));
+
+        // Late completions that arrive once the next frame is out cannot be told apart
+        // from its own: frame 5 is credited with 3's. The surplus one realigns the rest.
+        radio.enqueue(3);
+        radio.enqueue(4);
+        radio.process();
+        radio.advance(TIMEOUT_MS);
+        radio.enqueue(5);
+        radio.process();
+        radio.complete(true);  // 3, late
+        radio.complete(true);  // 4, late
+        radio.complete(false);  // 5
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{1, false}, {2, false}, {3, false}, {4, false}, {5, true}}));
+        radio.enqueue(6);
+        radio.process();
+        radio.complete(false);
+        radio.process();
+        EXPECT_EQ(radio.results.back(), (std::pair<uint32_t, bool>{6, false}));
+        EXPECT_TRUE(radio.queue.idle());
+    }
+
+    TEST(SendQueueTest, SkippedTicketKeepsCompletionsAligned)
+    {
+        Radio radio;
+        radio.enqueue(1);
+        radio.process();
+        // A probe sent around the queue completes in between
+        radio.queue.skip_ticket();
+        radio.air.push_back(0);
+        radio.enqueue(2);
+        radio.process();
+        radio.complete(true);
+        radio.complete(false);
+        radio.complete(true);
+        radio.process();
+        EXPECT_EQ(radio.results, (Results{{1, true}, {2, true}}));
+    }
+
+    // =============================================================================
+    // In the sender
+    // =============================================================================
+    // RTC memory lives as long as the process, so each test pairs on its own channel.
+
+    class SenderSendTest : public ::testing::Test
+    {
+    protected:
+        static constexpr uint8_t BRIDGE_MAC[6] = {0x24, 0x6F, 0x28, 0xAA, 0xBB, 0xCC};
+
+        void start(uint8_t channel)
+        {
+            host::reset();
+            this->sensor.set_name("Temperature");
+            this->sensor.set_accuracy_decimals(2);
+            App.set_name("garden");
+            App.register_sensor(&this->sensor);
+            this->node = std::make_unique<Now_MQTTComponent>();
+            this->node->set_wifi_channel(channel);
+            this->node->add_on_send_success_callback([this]() { this->successes++; });
+            this->node->add_on_send_failure_callback([this]() { this->failures++; });
+            this->node->setup();
+
+            this->sensor.publish_state(0.0f);
+            this->node->loop();
+            host::complete_sends(true);
+            this->node->loop();
+            uint8_t own_mac[6];
+            esp_wifi_get_mac(WIFI_IF_STA, own_mac);
+            uint8_t ack[now_mqtt_protocol::PAIR_ACK_SIZE];
+            size_t len = now_mqtt_protocol::encode_pair_ack(ack, sizeof(ack), own_mac, channel);
+            host::receive(BRIDGE_MAC, ack, len);
+            this->node->loop();
+            ASSERT_TRUE(this->node->is_paired());
+            this->successes = 0;
+        }
+
+        sensor::Sensor sensor;
+        std::unique_ptr<Now_MQTTComponent> node;
+        uint32_t successes = 0;
+        uint32_t failures = 0;
+    };
+
+    TEST_F(SenderSendTest, CallbacksFireFromLoop)
+    {
+        this->start(4);
+        this->sensor.publish_state(21.0f);
+        this->node->loop();
+        host::complete_sends(true);
+        EXPECT_EQ(this->successes, 0u);  // The send callback only hands the status over
+        this->node->loop();
+        EXPECT_EQ(this->successes, 1u);
+
+        this->sensor.publish_state(22.0f);
+        this->node->loop();
+        for (int attempt = 0; attempt < now_mqtt::MAX_RETRIES; attempt++) {
+            host::complete_sends(false);
+            this->node->loop();
+            host::advance_ms(now_mqtt::RETRY_DELAY_MS);
+            this->node->loop();
+        }
+        host::complete_sends(false);
+        EXPECT_EQ(this->failures, 0u);
+        this->node->loop();
+        EXPECT_EQ(this->failures, 1u);
+        EXPECT_EQ(this->successes, 1u);
+        EXPECT_EQ(this->node->get_failed(), 1u);
+    }
+
+    TEST_F(SenderSendTest, LostCompletionIsRetriedAndLaterSendsMatch)
+    {
+        this->start(5);
+        this->sensor.publish_state(21.0f);
+        this->node->loop();
+        host::lose_sends();
+        host::advance_ms(now_mqtt::SEND_TIMEOUT_MS);
+        this->node->loop();
+        host::advance_ms(now_mqtt::RETRY_DELAY_MS);
+        this->node->loop();
+        host::complete_sends(true);
+        this->node->loop();
+        EXPECT_EQ(this->successes, 1u);
+        EXPECT_EQ(this->failures, 0u);
+
+        for (int i = 0; i < 10; i++) {
+            this->sensor.publish_state(22.0f + i);
+            this->node->loop();
+            host::complete_sends(true);
+            this->node->loop();
+        }
+        EXPECT_EQ(this->successes, 11u);
+        EXPECT_EQ(this->failures, 0u);
+    }
+
+    // From publish_state() to on_send_success, with the radio answering at once:
+    // what the component itself adds to a reading's trip
+    TEST_F(SenderSendTest, CallbackLatency)
+    {
+        static constexpr int READINGS = 2000;
+        this->start(6);
+        host::set_log_level(host::LOG_LEVEL_NONE);
+        std::vector<double> latency_us;
+        latency_us.reserve(READINGS);
+        for (int i = 0; i < READINGS; i++) {
+            uint32_t before = this->successes;
+            auto start = std::chrono::steady_clock::now();
+            this->sensor.publish_state(20.0f + i * 0.01f);
+            this->node->loop();
+            host::complete_sends(true);
+            this->node->loop();
+            auto end = std::chrono::steady_clock::now();
+            ASSERT_EQ(this->successes, before + 1) << i;
+            latency_us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        std::sort(latency_us.begin(), latency_us.end());
+        double p50 = latency_us[READINGS / 2];
+        double p99 = latency_us[READINGS * 99 / 100];
+        printf("publish_state -> on_send_success: p50 %.1f us, p99 %.1f us\n", p50, p99);
+        RecordProperty("p50_us", static_cast<int>(p50));
+        RecordProperty("p99_us", static_cast<int>(p99));
+        // Generous: sanitizer builds and busy CI machines included
+        EXPECT_LT(p50, 1000.0);
+    }
+
+} // namespace
@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt/now_mqtt.h"
+#include "esphome/core/application.h"
+
+using namespace esphome;
+using esphome::now_mqtt::Now_MQTTComponent;
+
+// After setup() the sender must not touch the heap: every buffer it needs is
+// sized up front. Global operator new is replaced with a counting version that
+// counts only between start_counting() and stop_counting(), and readings go
+// through the sensor callbacks into plain, compact and aged records. Sends are
+// only counted by the stubs, since recording them allocates.
+
+namespace
+{
+    std::atomic<bool> counting{false};
+    std::atomic<size_t> allocations{0};
+
+    void *counted_alloc(size_t size)
+    {
+        if (counting.load(std::memory_order_relaxed)) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        void *ptr = malloc(size == 0 ? 1 : size);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void *counted_aligned_alloc(size_t size, std::align_val_t align)
+    {
+        if (counting.load(std::memory_order_relaxed)) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        size_t alignment = static_cast<size_t>(align);
+        void *ptr = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+} // namespace
+
+void *operator new(size_t size) { return counted_alloc(size); }
+void *operator new[](size_t size) { return counted_alloc(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return malloc(size == 0 ? 1 : size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return malloc(size == 0 ? 1 : size); }
+void *operator new(size_t size, std::align_val_t align) { return counted_aligned_alloc(size, align); }
+void *operator new[](size_t size, std::align_val_t align) { return counted_aligned_alloc(size, align); }
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept { free(ptr); }
+
+namespace
+{
+    static constexpr int ROUNDS = 50;
+
+    // RTC memory lives as long as the process, so each test pairs on its own channel
+    class SenderAllocTest : public ::testing::Test
+    {
+    protected:
+        static constexpr uint8_t BRIDGE_MAC[6] = {0x24, 0x6F, 0x28, 0xAA, 0xBB, 0xCC};
+
+        // Unpaired nodes broadcast full frames; compact ones need a paired bridge
+        void start(uint8_t channel, bool pairing, uint8_t upload_every = 0)
+        {
+            host::reset();
+            host::set_log_level(host::LOG_LEVEL_NONE);
+            this->temperature.set_name("Temperature");
+            this->temperature.set_unit_of_measurement("°C");
+            this->temperature.set_device_class("temperature");
+            this->temperature.set_state_class(sensor::STATE_CLASS_MEASUREMENT);
+            this->door.set_name("Door");
+            this->mode.set_name("Mode");
+            App.set_name("garden");
+            App.register_sensor(&this->temperature);
+            App.register_binary_sensor(&this->door);
+            App.register_text_sensor(&this->mode);
+            this->node = std::make_unique<Now_MQTTComponent>();
+            this->node->set_wifi_channel(channel);
+            this->node->set_report_interval(1);
+            this->node->set_pairing(pairing);
+            this->node->set_upload_every(upload_every);
+            this->node->setup();
+        }
+
+        void pair(uint8_t channel)
+        {
+            this->temperature.publish_state(0.0f);
+            this->cycle();
+            uint8_t own_mac[6];
+            esp_wifi_get_mac(WIFI_IF_STA, own_mac);
+            uint8_t ack[now_mqtt_protocol::PAIR_ACK_SIZE];
+            size_t len = now_mqtt_protocol::encode_pair_ack(ack, sizeof(ack), own_mac, channel);
+            host::receive(BRIDGE_MAC, ack, len);
+            this->node->loop();
+            ASSERT_TRUE(this->node->is_paired());
+        }
+
+        // One reading per entity type; short text stays in std::string's own buffer
+        void publish(int round)
+        {
+            this->temperature.publish_state(20.0f + round * 0.25f);
+            this->door.publish_state(round % 2 == 0);
+            this->mode.publish_state(round % 2 == 0 ? "eco" : "comfort");
+        }
+
+        void cycle()
+        {
+            this->node->loop();
+            host::complete_sends(true);
+            this->node->loop();
+        }
+
+        // Flags and records of the last frame sent
+        now_mqtt_protocol::FrameReader last_frame() const
+        {
+            const host::Send &send = host::sends().back();
+            return now_mqtt_protocol::FrameReader(send.data.data(), send.data.size());
+        }
+
+        void start_counting()
+        {
+            host::set_record_sends(false);
+            allocations = 0;
+            counting = true;
+        }
+
+        size_t stop_counting()
+        {
+            counting = false;
+            host::set_record_sends(true);
+            return allocations;
+        }
+
+        sensor::Sensor temperature;
+        binary_sensor::BinarySensor door;
+        text_sensor::TextSensor mode;
+        std::unique_ptr<Now_MQTTComponent> node;
+    };
+
+    TEST_F(SenderAllocTest, CounterSeesAllocations)
+    {
+        this->start_counting();
+        auto *probe = new int(1);
+        delete probe;
+        EXPECT_EQ(this->stop_counting(), 1u);
+    }
+
+    TEST_F(SenderAllocTest, PlainRecords)
+    {
+        this->start(7, false);
+        this->publish(0);
+        this->cycle();
+        ASSERT_FALSE(this->last_frame().compact());
+        EXPECT_EQ(this->last_frame().count(), 1);
+
+        this->start_counting();
+        for (int round = 1; round <= ROUNDS; round++) {
+            this->publish(round);
+            this->cycle();
+        }
+        uint32_t sent = host::send_count();
+        EXPECT_EQ(this->stop_counting(), 0u);
+        EXPECT_GE(sent, uint32_t(3 * ROUNDS));
+    }
+
+    TEST_F(SenderAllocTest, CompactRecords)
+    {
+        this->start(8, true);
+        this->pair(8);
+        // The paired bridge acknowledges a full frame with every entity in it
+        this->publish(1);
+        this->cycle();
+        this->publish(2);
+        this->cycle();
+        ASSERT_TRUE(this->last_frame().compact());
+
+        this->start_counting();
+        for (int round = 3; round < 3 + ROUNDS; round++) {
+            this->publish(round);
+            this->cycle();
+        }
+        EXPECT_EQ(this->stop_counting(), 0u);
+        this->publish(0);
+        this->cycle();
+        EXPECT_TRUE(this->last_frame().compact());
+    }
+
+    // The store goes out early once it is three quarters full, so a node kept
+    // awake uploads every few dozen rounds
+    TEST_F(SenderAllocTest, AgedRecords)
+    {
+        this->start(9, false, 1);
+        int round = 0;
+        while (host::sends().empty() && round < 1000) {
+            this->publish(round++);
+            this->cycle();
+        }
+        ASSERT_FALSE(host::sends().empty());
+        now_mqtt_protocol::FrameReader reader = this->last_frame();
+        now_mqtt_protocol::Reading reading;
+        ASSERT_TRUE(reader.next(&reading));
+        ASSERT_TRUE(reading.aged);
+
+        this->start_counting();
+        for (int end = round + 4 * round; round < end; round++) {
+            this->publish(round);
+            this->cycle();
+        }
+        uint32_t sent = host::send_count();
+        EXPECT_EQ(this->stop_counting(), 0u);
+        EXPECT_GE(sent, 4u);
+    }
+
+} // namespace
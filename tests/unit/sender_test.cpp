@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt/now_mqtt.h"
+#include "esphome/components/now_mqtt_bridge/dedup_window.h"
+#include "esphome/core/application.h"
+
+using namespace esphome;
+using esphome::now_mqtt::Now_MQTTComponent;
+
+namespace
+{
+    // RTC memory lives as long as the process, like across deep sleep. Each test
+    // uses its own wifi_channel, which makes the link state of the others stale.
+    class SenderTest : public ::testing::Test
+    {
+    protected:
+        void start(uint8_t channel, uint8_t unpair_after_failures = 3)
+        {
+            host::reset();
+            this->sensor.set_name("Temperature");
+            this->sensor.set_unit_of_measurement("°C");
+            this->sensor.set_state_class(sensor::STATE_CLASS_MEASUREMENT);
+            this->sensor.set_accuracy_decimals(1);
+            App.set_name("garden");
+            App.register_sensor(&this->sensor);
+            this->node = std::make_unique<Now_MQTTComponent>();
+            this->node->set_wifi_channel(channel);
+            this->node->set_unpair_after_failures(unpair_after_failures);
+            this->node->setup();
+        }
+
+        // One reading through the send queue; the radio reports the outcome
+        void send_reading(float value, bool success = true)
+        {
+            this->sensor.publish_state(value);
+            this->node->loop();
+            host::complete_sends(success);
+            this->node->loop();
+        }
+
+        size_t probes() const
+        {
+            size_t count = 0;
+            for (const auto &send : host::sends()) {
+                count += now_mqtt_protocol::is_probe(send.data.data(), send.data.size());
+            }
+            return count;
+        }
+
+        sensor::Sensor sensor;
+        std::unique_ptr<Now_MQTTComponent> node;
+    };
+
+    TEST_F(SenderTest, ReadingGoesOutAsV2Frame)
+    {
+        this->start(1);
+        this->send_reading(21.5f);
+
+        ASSERT_EQ(host::sends().size(), 1u);
+        const std::vector<uint8_t> &data = host::sends()[0].data;
+        now_mqtt_protocol::FrameReader reader(data.data(), data.size());
+        ASSERT_TRUE(reader.valid());
+        EXPECT_TRUE(reader.flags() & now_mqtt_protocol::FLAG_PAIR_REQUEST);
+        EXPECT_EQ(reader.node().name, "garden");
+
+        now_mqtt_protocol::Reading reading;
+        ASSERT_TRUE(reader.next(&reading));
+        EXPECT_EQ(reading.name, "temperature");
+        EXPECT_EQ(reading.meta.unit, "°C");
+        EXPECT_FLOAT_EQ(reading.value, 21.5f);
+        EXPECT_FALSE(reader.next(&reading));
+    }
+
+    TEST_F(SenderTest, PairAckSwitchesToUnicast)
+    {
+        this->start(2);
+        this->send_reading(20.0f);
+
+        static const uint8_t BRIDGE_MAC[6] = {0x24, 0x6F, 0x28, 0xAA, 0xBB, 0xCC};
+        uint8_t own_mac[6];
+        esp_wifi_get_mac(WIFI_IF_STA, own_mac);
+        uint8_t ack[now_mqtt_protocol::PAIR_ACK_SIZE];
+        size_t len = now_mqtt_protocol::encode_pair_ack(ack, sizeof(ack), own_mac, 2);
+        host::receive(BRIDGE_MAC, ack, len);
+        this->node->loop();
+        ASSERT_TRUE(this->node->is_paired());
+
+        this->send_reading(20.5f);
+        EXPECT_EQ(memcmp(host::sends().back().mac, BRIDGE_MAC, 6), 0);
+        EXPECT_EQ(this->node->get_delivered(), 2u);  // The broadcast counts as sent too
+    }
+
+    TEST_F(SenderTest, UnansweredPairingStopsScanning)
+    {
+        // A bridge that never sends PAIR_ACK: a few sweeps, then broadcasts only
+        this->start(3, 1);
+        for (int i = 0; i < 40; i++) {
+            this->send_reading(i);
+            for (int tick = 0; tick < 100; tick++) {
+                host::advance_ms(10);
+                host::complete_sends(true);  // Broadcasts always go out
+                this->node->loop();
+            }
+        }
+        size_t per_scan = now_mqtt::SCAN_SWEEPS * now_mqtt::ChannelScanner::SWEEP_MAX_CHANNEL;
+        EXPECT_EQ(this->probes(), now_mqtt::MAX_UNANSWERED_SCANS * per_scan);
+        EXPECT_EQ(host::channel(), 3);
+    }
+
+    // A deep sleep wake is a new component over the same RTC memory
+    TEST(SenderWakeTest, SequenceCarriesAcrossWakes)
+    {
+        now_mqtt_bridge::DedupWindow window;
+        uint16_t boot_id = 0;
+        uint16_t expected = 0;
+        for (int wake = 0; wake < 3; wake++) {
+            host::reset();
+            sensor::Sensor sensor;
+            sensor.set_name("Temperature");
+            App.set_name("garden");
+            App.register_sensor(&sensor);
+            Now_MQTTComponent node;
+            node.set_wifi_channel(4);
+            node.set_pairing(false);
+            node.setup();
+
+            for (int reading = 0; reading < 2; reading++) {
+                sensor.publish_state(20.0f + wake * 2 + reading);
+                node.loop();
+                host::complete_sends(true);
+                node.loop();
+                const std::vector<uint8_t> &data = host::sends().back().data;
+                now_mqtt_protocol::FrameReader reader(data.data(), data.size());
+                ASSERT_TRUE(reader.has_sequence());
+                if (wake == 0 && reading == 0) {
+                    boot_id = reader.boot_id();
+                    expected = reader.sequence();
+                }
+                EXPECT_EQ(reader.boot_id(), boot_id) << wake;
+                EXPECT_EQ(reader.sequence(), expected++) << wake;
+                EXPECT_FALSE(window.is_duplicate(reader.boot_id(), reader.sequence())) << wake;
+            }
+            node.on_shutdown();
+        }
+    }
+
+} // namespace
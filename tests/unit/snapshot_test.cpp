@@ -0,0 +1,303 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+#include "harness.h"
+#include "esphome/components/now_mqtt_bridge/now_mqtt_bridge.h"
+#include "esphome/components/now_mqtt_bridge/snapshot.h"
+
+using namespace esphome;
+using namespace esphome::now_mqtt_bridge;
+
+// The state snapshot on its own (chunks in a map standing in for flash), then
+// through a bridge restart: what was saved on shutdown comes back, and anything
+// torn, missing or stale is ignored as a whole.
+
+namespace
+{
+    static constexpr uint32_t LAYOUT = 0x1234;
+    static constexpr size_t MAX_CHUNKS = 8;
+
+    struct Flash {
+        std::map<uint16_t, SnapshotChunk> chunks;
+        SnapshotHeader header{};
+        bool fail_writes = false;
+
+        // Writes the stream and, if that worked, the header
+        bool save(const std::vector<uint8_t> &stream, uint32_t layout = LAYOUT)
+        {
+            auto sink = [this](uint16_t index, const SnapshotChunk &chunk) {
+                if (this->fail_writes) {
+                    return false;
+                }
+                this->chunks[index] = chunk;
+                return true;
+            };
+            SnapshotWriter<decltype(sink)> writer(MAX_CHUNKS, sink);
+            writer.put(stream.data(), stream.size());
+            SnapshotHeader written;
+            if (!writer.finish(layout, &written)) {
+                return false;
+            }
+            this->header = written;
+            return true;
+        }
+
+        auto source()
+        {
+            return [this](uint16_t index, SnapshotChunk *chunk) {
+                auto it = this->chunks.find(index);
+                if (it == this->chunks.end()) {
+                    return false;
+                }
+                *chunk = it->second;
+                return true;
+            };
+        }
+
+        // The stream back, or nothing if it does not verify
+        bool load(std::vector<uint8_t> *stream, uint32_t layout = LAYOUT)
+        {
+            SnapshotReader<decltype(this->source())> reader(this->header, this->source());
+            if (!reader.verify(layout, MAX_CHUNKS)) {
+                return false;
+            }
+            stream->resize(reader.remaining());
+            return reader.get(stream->data(), stream->size()) && reader.remaining() == 0;
+        }
+    };
+
+    std::vector<uint8_t> pattern(size_t len)
+    {
+        std::vector<uint8_t> stream(len);
+        for (size_t i = 0; i < len; i++) {
+            stream[i] = i * 7 + 3;
+        }
+        return stream;
+    }
+
+    TEST(SnapshotTest, RoundTrip)
+    {
+        for (size_t len : {size_t(0), size_t(1), SNAPSHOT_CHUNK_SIZE - 1, SNAPSHOT_CHUNK_SIZE, SNAPSHOT_CHUNK_SIZE + 1,
+                           3 * SNAPSHOT_CHUNK_SIZE + 17, MAX_CHUNKS * SNAPSHOT_CHUNK_SIZE}) {
+            Flash flash;
+            std::vector<uint8_t> stream = pattern(len);
+            ASSERT_TRUE(flash.save(stream)) << len;
+            EXPECT_EQ(flash.header.length, len);
+            EXPECT_EQ(flash.header.chunks, (len + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE);
+            EXPECT_EQ(flash.chunks.size(), flash.header.chunks);
+
+            std::vector<uint8_t> loaded;
+            ASSERT_TRUE(flash.load(&loaded)) << len;
+            EXPECT_EQ(loaded, stream);
+        }
+    }
+
+    TEST(SnapshotTest, RecordsReadBackInOrder)
+    {
+        Flash flash;
+        auto sink = [&flash](uint16_t index, const SnapshotChunk &chunk) {
+            flash.chunks[index] = chunk;
+            return true;
+        };
+        SnapshotWriter<decltype(sink)> writer(MAX_CHUNKS, sink);
+        for (uint32_t i = 0; i < 100; i++) {
+            writer.put(uint8_t(i));
+            writer.put(uint64_t(i) << 40 | i);
+        }
+        ASSERT_TRUE(writer.finish(LAYOUT, &flash.header));
+
+        SnapshotReader<decltype(flash.source())> reader(flash.header, flash.source());
+        uint8_t tag;
+        EXPECT_FALSE(reader.get(&tag));  // Nothing before verify()
+        ASSERT_TRUE(reader.verify(LAYOUT, MAX_CHUNKS));
+        for (uint32_t i = 0; i < 100; i++) {
+            uint64_t key;
+            ASSERT_TRUE(reader.get(&tag));
+            ASSERT_TRUE(reader.get(&key));
+            EXPECT_EQ(tag, i);
+            EXPECT_EQ(key, uint64_t(i) << 40 | i);
+        }
+        EXPECT_EQ(reader.remaining(), 0u);
+        EXPECT_FALSE(reader.get(&tag));
+    }
+
+    TEST(SnapshotTest, WriterStopsAtCapacity)
+    {
+        Flash flash;
+        flash.header.magic = 0;
+        EXPECT_FALSE(flash.save(pattern(MAX_CHUNKS * SNAPSHOT_CHUNK_SIZE + 1)));
+        EXPECT_EQ(flash.header.magic, 0u);  // No header for a stream that did not fit
+
+        flash.fail_writes = true;
+        EXPECT_FALSE(flash.save(pattern(10)));
+    }
+
+    TEST(SnapshotTest, FlippedByteIsRejected)
+    {
+        Flash flash;
+        ASSERT_TRUE(flash.save(pattern(600)));
+        for (size_t offset : {size_t(0), size_t(255), size_t(256), size_t(599)}) {
+            Flash damaged = flash;
+            damaged.chunks[offset / SNAPSHOT_CHUNK_SIZE].data[offset % SNAPSHOT_CHUNK_SIZE] ^= 0x10;
+            std::vector<uint8_t> loaded;
+            EXPECT_FALSE(damaged.load(&loaded)) << offset;
+        }
+        // The padding after the stream is not part of it
+        Flash padded = flash;
+        padded.chunks[2].data[SNAPSHOT_CHUNK_SIZE - 1] ^= 0x10;
+        std::vector<uint8_t> loaded;
+        EXPECT_TRUE(padded.load(&loaded));
+    }
+
+    TEST(SnapshotTest, MissingChunkIsRejected)
+    {
+        Flash flash;
+        ASSERT_TRUE(flash.save(pattern(600)));
+        for (uint16_t index = 0; index < flash.header.chunks; index++) {
+            Flash damaged = flash;
+            damaged.chunks.erase(index);
+            std::vector<uint8_t> loaded;
+            EXPECT_FALSE(damaged.load(&loaded)) << index;
+        }
+    }
+
+    TEST(SnapshotTest, HeaderMismatchIsRejected)
+    {
+        Flash flash;
+        ASSERT_TRUE(flash.save(pattern(600)));
+        std::vector<uint8_t> loaded;
+
+        // Saved under other settings
+        EXPECT_FALSE(flash.load(&loaded, LAYOUT + 1));
+
+        Flash magic = flash;
+        magic.header.magic ^= 1;
+        EXPECT_FALSE(magic.load(&loaded));
+
+        // Lengths that disagree with the stream or with the chunk count
+        for (size_t length : {size_t(flash.header.length + 1), size_t(flash.header.length - 1), 2 * SNAPSHOT_CHUNK_SIZE,
+                              3 * SNAPSHOT_CHUNK_SIZE + 1}) {
+            Flash damaged = flash;
+            damaged.header.length = length;
+            EXPECT_FALSE(damaged.load(&loaded)) << length;
+        }
+        Flash chunks = flash;
+        chunks.header.chunks = MAX_CHUNKS + 1;
+        chunks.header.length = MAX_CHUNKS * SNAPSHOT_CHUNK_SIZE + 1;
+        EXPECT_FALSE(chunks.load(&loaded));
+    }
+
+    TEST(SnapshotTest, StaleHeaderIsRejected)
+    {
+        // New chunks went out, then power failed before the header did
+        Flash flash;
+        ASSERT_TRUE(flash.save(pattern(600)));
+        SnapshotHeader old_header = flash.header;
+        std::vector<uint8_t> newer = pattern(600);
+        newer[300] ^= 0xFF;
+        ASSERT_TRUE(flash.save(newer));
+        flash.header = old_header;
+        std::vector<uint8_t> loaded;
+        EXPECT_FALSE(flash.load(&loaded));
+    }
+
+    // =============================================================================
+    // Bridge Restart
+    // =============================================================================
+    // host::reset() keeps preferences, like flash across a reboot.
+
+    class SnapshotRestartTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            host::reset();
+            host::clear_preferences();
+            host::mac_for(1, this->mac);
+        }
+
+        void boot(bool device_discovery = false)
+        {
+            host::reset();
+            this->bridge = std::make_unique<Now_MQTT_BridgeComponent>();
+            this->bridge->set_snapshot_interval(60000);
+            this->bridge->set_device_discovery(device_discovery);
+            this->bridge->setup();
+            this->bridge->loop();
+        }
+
+        void receive()
+        {
+            host::V1Fields fields;
+            fields.device_class = "temperature";
+            fields.unit = "°C";
+            host::receive(this->mac, host::v1_frame(fields));
+            this->bridge->loop();
+        }
+
+        static uint32_t chunk_key(uint16_t index)
+        {
+            uint32_t hash = fnv1a_32(FNV1A_32_INIT, "now_mqtt_snapshot", 17);
+            return fnv1a_32(hash, &index, sizeof(index));
+        }
+
+        // Discovery went out for the reading, and its state
+        void first_run(bool device_discovery = false)
+        {
+            this->boot(device_discovery);
+            this->receive();
+            ASSERT_NE(host::last_publish(CONFIG_TOPIC), nullptr);
+            this->bridge->on_shutdown();
+            ASSERT_EQ(host::preferences().count(chunk_key(SNAPSHOT_HEADER_INDEX)), 1u);
+            ASSERT_EQ(host::preferences().count(chunk_key(0)), 1u);
+        }
+
+        static constexpr const char *CONFIG_TOPIC = "homeassistant/sensor/garden/temperature/config";
+        static constexpr const char *STATE_TOPIC = "garden/sensor/temperature/state";
+
+        std::unique_ptr<Now_MQTT_BridgeComponent> bridge;
+        uint8_t mac[6];
+    };
+
+    TEST_F(SnapshotRestartTest, DiscoveryIsNotRepublished)
+    {
+        this->first_run();
+        this->boot();
+        EXPECT_EQ(host::warnings(), 0u);
+        this->receive();
+        EXPECT_EQ(host::last_publish(CONFIG_TOPIC), nullptr);
+        ASSERT_NE(host::last_publish(STATE_TOPIC), nullptr);
+        EXPECT_EQ(host::last_publish(STATE_TOPIC)->payload, "21.50");
+    }
+
+    TEST_F(SnapshotRestartTest, DamagedSnapshotIsIgnored)
+    {
+        this->first_run();
+        host::preferences()[chunk_key(0)][20] ^= 0x01;
+        this->boot();
+        EXPECT_GE(host::warnings(), 1u);
+        this->receive();
+        EXPECT_NE(host::last_publish(CONFIG_TOPIC), nullptr);
+    }
+
+    TEST_F(SnapshotRestartTest, MissingChunkIsIgnored)
+    {
+        this->first_run();
+        host::preferences().erase(chunk_key(0));
+        this->boot();
+        EXPECT_GE(host::warnings(), 1u);
+        this->receive();
+        EXPECT_NE(host::last_publish(CONFIG_TOPIC), nullptr);
+    }
+
+    TEST_F(SnapshotRestartTest, ChangedSettingsStartOver)
+    {
+        this->first_run();
+        this->boot(true);  // Device discovery now: the saved discovery state does not apply
+        this->receive();
+        EXPECT_NE(host::last_publish("homeassistant/device/246f28000001/config"), nullptr);
+    }
+
+} // namespace